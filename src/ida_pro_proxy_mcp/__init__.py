@@ -10,6 +10,7 @@ from .models import ProxySession, ProcessInfo, ProxyConfig
 from .process_manager import ProcessManager
 from .session_manager import SessionManager
 from .router import RequestRouter
+from .api import LocalProxy, ToolError
 from .server import ProxyMcpServer
 
 __all__ = [
@@ -19,5 +20,7 @@ __all__ = [
     "ProcessManager",
     "SessionManager",
     "RequestRouter",
+    "LocalProxy",
+    "ToolError",
     "ProxyMcpServer",
 ]
@@ -0,0 +1,340 @@
+"""In-process API for IDA Pro Proxy MCP"""
+
+import json
+import logging
+from typing import Any, Callable, Dict, List, Optional
+
+from .cancellation import CancelToken
+from .cgroups import CgroupManager
+from .elf_tools import ElfTools
+from .fanout import MapRun, expand_inputs
+from .func_index import FunctionIndex
+from .journal import SessionJournal
+from .memory import MIB
+from .metrics import Metrics
+from .models import ProxyConfig, ProxySession
+from .placement import PlacementPolicy
+from .process_manager import ProcessManager
+from .rebalancer import Rebalancer
+from .result_cache import ResultCache
+from .router import RequestRouter
+from .scan import Scanner
+from .similarity import SimilarityIndex
+from .session_manager import SessionManager
+from .summary import BinarySummarizer
+from .warmer import CacheWarmer
+from .watcher import FileWatcher
+
+logger = logging.getLogger(__name__)
+
+
+class ToolError(RuntimeError):
+    """Raised when a tool call returns an error."""
+
+
+class LocalProxy:
+    """The proxy's session and process management, used without HTTP.
+    
+    Builds the same ProcessManager, SessionManager and RequestRouter stack
+    the HTTP server runs, so calls get the same process pool, LRU eviction,
+    crash recovery, result cache and metrics. Use it as a context manager,
+    or call close() to stop the idalib-mcp processes it started:
+        
+        with LocalProxy(ProxyConfig(max_processes=4)) as proxy:
+            session = proxy.open("/samples/libfoo.so")
+            funcs = proxy.call("list_funcs", {"queries": "*"}, session=session.session_id)
+    
+    Attributes:
+        config: Configuration the stack was built from
+        process_manager: Manages the idalib-mcp processes
+        cgroups: Places each child in its own cgroup, if enabled
+        placement: Pins each child to a core set, if enabled
+        session_manager: Manages sessions across the processes
+        router: Routes tool calls to sessions
+        index: Symbol index across the opened binaries, if enabled
+        similarity: Function similarity search, if the index is enabled
+        summarizer: Gathers binary summaries at open time, if enabled
+        warmer: Decompiles functions into the result cache while idle and
+            prefetches the neighbours of decompiled functions, if enabled
+            (it needs the result cache and the function index)
+        rebalancer: Moves busy sessions off shared processes with deep
+            queues, if enabled
+        metrics: Latencies and counters of the calls made
+    """
+    
+    def __init__(
+        self,
+        config: Optional[ProxyConfig] = None,
+        journal: Optional[SessionJournal] = None,
+        child_log_dir: Optional[str] = None,
+    ):
+        """Initialize the proxy stack.
+        
+        Args:
+            config: Configuration (defaults if omitted)
+            journal: Where to persist the session table, if anywhere
+            child_log_dir: If set, children log here and outlive this instance
+        """
+        self.config = config or ProxyConfig()
+        self.config.validate()
+        
+        self.cgroups = (
+            CgroupManager(self.config.cgroup_root, self.config.cgroup_memory_max_mb * MIB)
+            if self.config.cgroups else None
+        )
+        self.placement = (
+            PlacementPolicy(
+                self.config.max_processes,
+                cores_per_child=self.config.cores_per_child,
+                proxy_cores=self.config.proxy_cores,
+                membind=self.config.numa_membind,
+            )
+            if self.config.cpu_affinity else None
+        )
+        if self.placement is not None:
+            self.placement.pin_proxy()
+        self.process_manager = ProcessManager(
+            host=self.config.host,
+            request_timeout=self.config.request_timeout,
+            breaker_failure_threshold=self.config.breaker_failure_threshold,
+            breaker_timeout_threshold=self.config.breaker_timeout_threshold,
+            breaker_reset_timeout=self.config.breaker_reset_timeout,
+            breaker_probe_timeout=self.config.breaker_probe_timeout,
+            cancel_grace=self.config.cancel_grace,
+            child_log_dir=child_log_dir,
+            cgroups=self.cgroups,
+            placement=self.placement,
+        )
+        self.result_cache = (
+            ResultCache(self.config.result_cache_size) if self.config.result_cache_size else None
+        )
+        self.watcher = FileWatcher() if self.config.watch_binaries else None
+        self.index = FunctionIndex(self.process_manager) if self.config.function_index else None
+        self.similarity = (
+            SimilarityIndex(self.index, self.config.similarity_workers) if self.index else None
+        )
+        self.summarizer = (
+            BinarySummarizer(self.process_manager) if self.config.open_summary else None
+        )
+        self.session_manager = SessionManager(
+            max_processes=self.config.max_processes,
+            process_manager=self.process_manager,
+            journal=journal,
+            result_cache=self.result_cache,
+            watcher=self.watcher,
+            reopen_on_change=self.config.reopen_on_change,
+            index=self.index,
+            summarizer=self.summarizer,
+            memory_budget=self.config.memory_budget_mb * MIB,
+            memory_reserve=self.config.memory_reserve_mb * MIB,
+            pack_binary_size=self.config.pack_binary_mb * MIB,
+            pack_max_sessions=self.config.pack_max_sessions,
+            pack_memory=self.config.pack_memory_mb * MIB,
+            pack_max_load=self.config.pack_max_load,
+            warm_sessions=self.config.warm_sessions,
+        )
+        self.warmer = (
+            CacheWarmer(
+                self.session_manager,
+                self.result_cache,
+                self.index,
+                limit=self.config.warm_limit if self.config.warm_cache else 0,
+                prefetch_depth=self.config.prefetch_depth,
+            )
+            if (self.config.warm_cache or self.config.prefetch_depth)
+            and self.result_cache is not None and self.index is not None
+            else None
+        )
+        self.rebalancer = (
+            Rebalancer(
+                self.session_manager,
+                interval=self.config.rebalance_interval,
+                threshold=self.config.rebalance_queue_depth,
+            )
+            if self.config.rebalance_interval
+            else None
+        )
+        self.elf_tools = ElfTools(self.config.elf_cache_size)
+        self.scanner = Scanner(self.config.scan_workers)
+        self.metrics = Metrics()
+        self.metrics.add_collector("elf_tools", self.elf_tools.to_dict)
+        self.metrics.add_collector("memory", self.session_manager.memory_to_dict)
+        if self.cgroups is not None:
+            self.metrics.add_collector("cgroups", self.cgroups.to_dict)
+        if self.placement is not None:
+            self.metrics.add_collector("placement", self.placement.to_dict)
+        if self.config.pack_binary_mb:
+            self.metrics.add_collector("packing", self.session_manager.packing_to_dict)
+        if self.rebalancer is not None:
+            self.metrics.add_collector("rebalancer", self.rebalancer.to_dict)
+        if self.config.warm_sessions:
+            self.metrics.add_collector("hibernation", self.session_manager.hibernation_to_dict)
+        if self.result_cache is not None:
+            self.metrics.add_collector("result_cache", self.result_cache.to_dict)
+        if self.warmer is not None:
+            self.metrics.add_collector("warmer", self.warmer.to_dict)
+        if self.summarizer is not None:
+            self.metrics.add_collector("summaries", self.summarizer.to_dict)
+        if self.index is not None:
+            self.metrics.add_collector("function_index", self.index.to_dict)
+            self.metrics.add_collector("similarity", self.similarity.to_dict)
+        self.router = RequestRouter(
+            self.session_manager,
+            metrics=self.metrics,
+            hedging=self.config.hedging,
+            hedge_percentile=self.config.hedge_percentile,
+            hedge_min_samples=self.config.hedge_min_samples,
+            result_cache=self.result_cache,
+            similarity=self.similarity,
+            elf_tools=self.elf_tools,
+            scanner=self.scanner,
+            warmer=self.warmer,
+        )
+    
+    def __enter__(self) -> "LocalProxy":
+        return self
+    
+    def __exit__(self, *exc) -> None:
+        self.close()
+    
+    def open(self, binary_path: str, run_auto_analysis: bool = True) -> ProxySession:
+        """Open a binary, or return its session if it is already open.
+        
+        Raises:
+            FileNotFoundError: If the binary doesn't exist
+            RuntimeError: If the binary could not be opened
+        """
+        return self.session_manager.open_session(binary_path, run_auto_analysis)
+    
+    def close_session(self, session_id: str) -> bool:
+        """Close a session, keeping its process for reuse.
+        
+        Returns:
+            True if the session was open
+        """
+        return self.session_manager.close_session(session_id)
+    
+    def call(
+        self,
+        tool_name: str,
+        arguments: Optional[Dict[str, Any]] = None,
+        session: Optional[str] = None,
+        timeout: Optional[float] = None,
+        cancel_token: Optional[CancelToken] = None,
+    ) -> Any:
+        """Call an analysis tool.
+        
+        Args:
+            tool_name: Tool to call, e.g. "decompile"
+            arguments: Tool arguments
+            session: Session ID (the current session if omitted)
+            timeout: Seconds after which the call fails with a deadline error
+            cancel_token: Cancels the call in the child when cancelled
+        
+        Returns:
+            The tool's structured result, or its text content parsed as
+            JSON if it has none (the raw text if that isn't JSON)
+        
+        Raises:
+            ToolError: If the tool call failed
+        """
+        arguments = dict(arguments or {})
+        if session is not None:
+            arguments["session"] = session
+        params: Dict[str, Any] = {"name": tool_name, "arguments": arguments}
+        if timeout is not None:
+            params["_meta"] = {"timeout": timeout}
+        request = {"jsonrpc": "2.0", "id": None, "method": "tools/call", "params": params}
+        return self.unwrap(self.router.route(request, cancel_token=cancel_token))
+    
+    def map(
+        self,
+        inputs: List[str],
+        tool_name: str,
+        arguments: Optional[Dict[str, Any]] = None,
+        parallelism: Optional[int] = None,
+        keep_open: bool = False,
+        on_result: Optional[Callable[[Dict[str, Any]], None]] = None,
+    ) -> List[Dict[str, Any]]:
+        """Call one tool on many binaries; see the idalib_map tool.
+        
+        Args:
+            inputs: Binary paths or glob patterns
+            tool_name: Tool to call on each binary
+            arguments: Tool arguments
+            parallelism: Binaries worked on at once (default: max_processes)
+            keep_open: Keep binaries opened for the map open afterwards
+            on_result: Called with each binary's result as it completes
+        
+        Returns:
+            Per-binary results in input order
+        
+        Raises:
+            ToolError: If no binaries match
+        """
+        paths = expand_inputs(inputs)
+        if not paths:
+            raise ToolError(f"No binaries match {inputs}")
+        max_processes = self.config.max_processes
+        
+        def call_tool(session_id: str, tool_args: Dict[str, Any]) -> Dict[str, Any]:
+            tool_args["session"] = session_id
+            request = {
+                "jsonrpc": "2.0",
+                "id": None,
+                "method": "tools/call",
+                "params": {"name": tool_name, "arguments": tool_args},
+            }
+            return self.router.route(request)
+        
+        run = MapRun(
+            self.session_manager,
+            call_tool,
+            arguments or {},
+            min(parallelism or max_processes, max_processes),
+            keep_open=keep_open,
+        )
+        return run.run(paths, on_result)
+    
+    @staticmethod
+    def unwrap(response: Dict[str, Any]) -> Any:
+        """Extract the result of a tools/call response.
+        
+        Raises:
+            ToolError: If the response carries an error
+        """
+        if "error" in response:
+            raise ToolError(response["error"].get("message", "Tool call failed"))
+        result = response.get("result", {})
+        structured = result.get("structuredContent")
+        if result.get("isError"):
+            if isinstance(structured, dict) and "error" in structured:
+                raise ToolError(str(structured["error"]))
+            content = result.get("content") or [{}]
+            raise ToolError(content[0].get("text", "Tool call failed"))
+        if structured is not None:
+            return structured
+        content = result.get("content") or []
+        text = "".join(item.get("text", "") for item in content if item.get("type") == "text")
+        try:
+            return json.loads(text)
+        except ValueError:
+            return text
+    
+    def close(self) -> None:
+        """Close all sessions and stop the processes."""
+        if self.warmer:
+            self.warmer.close()
+        if self.rebalancer:
+            self.rebalancer.close()
+        try:
+            self.session_manager.close_all()
+        finally:
+            self.process_manager.stop_all()
+            if self.watcher:
+                self.watcher.close()
+            if self.index:
+                self.index.close()
+            if self.similarity:
+                self.similarity.close()
+            self.scanner.close()
@@ -0,0 +1,346 @@
+"""Offline batch runner for IDA Pro Proxy MCP"""
+
+import argparse
+import json
+import logging
+import os
+import sys
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Set, TextIO
+
+from .api import LocalProxy, ToolError
+from .models import ProxyConfig
+
+logger = logging.getLogger(__name__)
+
+
+@dataclass
+class BatchJob:
+    """One tool call read from a jobs file.
+    
+    Attributes:
+        job_id: Identifies the job in the results file; its line number
+            unless the job has an "id"
+        binary: Binary to call the tool on
+        tool: Analysis tool name
+        arguments: Tool arguments
+    """
+    job_id: str
+    binary: str
+    tool: str
+    arguments: Dict[str, Any] = field(default_factory=dict)
+
+
+@dataclass
+class BatchSummary:
+    """Outcome of a batch run."""
+    total: int = 0
+    skipped: int = 0  # Already in the results file
+    succeeded: int = 0
+    failed: int = 0
+    interrupted: bool = False
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Convert to dictionary for JSON serialization."""
+        return {
+            "total": self.total,
+            "skipped": self.skipped,
+            "succeeded": self.succeeded,
+            "failed": self.failed,
+            "interrupted": self.interrupted,
+        }
+
+
+def read_jobs(path: str) -> List[BatchJob]:
+    """Read a JSONL jobs file.
+    
+    Each line is an object with "binary", "tool" and optionally
+    "arguments" and "id". Blank lines are skipped.
+    
+    Raises:
+        ValueError: If a line is not a valid job, naming the line
+    """
+    jobs = []
+    seen: Set[str] = set()
+    with open(path, "r", encoding="utf-8") as f:
+        for line_no, line in enumerate(f, 1):
+            if not line.strip():
+                continue
+            try:
+                data = json.loads(line)
+            except json.JSONDecodeError as e:
+                raise ValueError(f"{path}:{line_no}: invalid JSON: {e}")
+            if not isinstance(data, dict) or not data.get("binary") or not data.get("tool"):
+                raise ValueError(f"{path}:{line_no}: a job needs \"binary\" and \"tool\"")
+            job_id = str(data.get("id", line_no))
+            if job_id in seen:
+                raise ValueError(f"{path}:{line_no}: duplicate job id {job_id}")
+            seen.add(job_id)
+            jobs.append(BatchJob(
+                job_id=job_id,
+                binary=str(Path(os.path.expanduser(data["binary"])).resolve()),
+                tool=data["tool"],
+                arguments=data.get("arguments") or {},
+            ))
+    return jobs
+
+
+def load_checkpoint(path: str, retry_failed: bool = False) -> Set[str]:
+    """Read the IDs of jobs a previous run recorded in a results file.
+    
+    A last line cut short by a crash is truncated away, so the file is
+    safe to append to.
+    
+    Args:
+        path: Results file
+        retry_failed: Whether failed jobs should run again
+    
+    Returns:
+        IDs of jobs not to run again
+    """
+    done: Set[str] = set()
+    try:
+        with open(path, "rb+") as f:
+            data = f.read()
+            complete = data.rfind(b"\n") + 1
+            if complete < len(data):
+                logger.warning(f"Truncating incomplete last record of {path}")
+                f.truncate(complete)
+    except FileNotFoundError:
+        return done
+    
+    for line in data[:complete].splitlines():
+        try:
+            record = json.loads(line)
+        except json.JSONDecodeError:
+            continue
+        if "error" in record and retry_failed:
+            continue
+        done.add(str(record.get("id")))
+    return done
+
+
+class BatchRunner:
+    """Runs a batch of tool jobs on a LocalProxy and records the results.
+    
+    Jobs are grouped by binary content. Up to parallelism binaries are
+    worked on at once, each opened once for all of its jobs. Every result
+    is appended to the results file as it completes, which doubles as the
+    checkpoint: a rerun skips the jobs already recorded there.
+    """
+    
+    # Results written between fsyncs of the results file
+    SYNC_EVERY = 32
+    
+    def __init__(self, proxy: LocalProxy, parallelism: Optional[int] = None):
+        """Initialize the runner.
+        
+        Args:
+            proxy: Proxy stack to run jobs on
+            parallelism: Binaries worked on at once (default: max_processes)
+        """
+        self.proxy = proxy
+        max_processes = proxy.config.max_processes
+        self.parallelism = max(1, min(parallelism or max_processes, max_processes))
+        self._stop = threading.Event()
+        self._write_lock = threading.Lock()
+        self._unsynced = 0
+    
+    def stop(self) -> None:
+        """Finish the jobs already running and start no others."""
+        self._stop.set()
+    
+    def run(
+        self, jobs: List[BatchJob], results_path: str, retry_failed: bool = False
+    ) -> BatchSummary:
+        """Run the jobs not yet recorded in the results file.
+        
+        Args:
+            jobs: Jobs to run
+            results_path: JSONL file results are appended to
+            retry_failed: Run jobs again whose recorded result is an error
+        
+        Returns:
+            Counts of the jobs run, skipped and failed
+        """
+        summary = BatchSummary(total=len(jobs))
+        done = load_checkpoint(results_path, retry_failed)
+        # Jobs by binary content, so copies of a binary share one open
+        pending: Dict[str, List[BatchJob]] = {}
+        for job in jobs:
+            if job.job_id in done:
+                summary.skipped += 1
+                continue
+            try:
+                key = self.proxy.session_manager.content_hash(job.binary)
+            except OSError:
+                key = job.binary  # Reported when the binary fails to open
+            pending.setdefault(key, []).append(job)
+        if summary.skipped:
+            logger.info(f"Resuming: {summary.skipped} of {len(jobs)} jobs already done")
+        
+        with open(results_path, "a", encoding="utf-8") as out:
+            pool = ThreadPoolExecutor(max_workers=self.parallelism, thread_name_prefix="batch")
+            futures = [
+                pool.submit(self._run_binary, binary_jobs, out, summary)
+                for binary_jobs in pending.values()
+            ]
+            try:
+                for future in as_completed(futures):
+                    future.result()
+            except KeyboardInterrupt:
+                logger.warning("Interrupted, finishing the jobs already running")
+                self.stop()
+            finally:
+                pool.shutdown(wait=True)
+                self._sync(out)
+        summary.interrupted = self._stop.is_set()
+        return summary
+    
+    def _run_binary(self, jobs: List[BatchJob], out: TextIO, summary: BatchSummary) -> None:
+        """Open a binary once and run all of its jobs in order."""
+        if self._stop.is_set():
+            return
+        binary = jobs[0].binary
+        session_manager = self.proxy.session_manager
+        already_open = session_manager.get_session_by_binary(binary) is not None
+        try:
+            session = session_manager.open_session(
+                binary, make_current=False, pin=True, session_class="background"
+            )
+        except (OSError, RuntimeError) as e:
+            for job in jobs:
+                self._record(out, summary, job, error=f"Failed to open binary: {e}")
+            return
+        
+        try:
+            for job in jobs:
+                if self._stop.is_set():
+                    return
+                started = time.monotonic()
+                try:
+                    result = self.proxy.call(job.tool, job.arguments, session=session.session_id)
+                except ToolError as e:
+                    self._record(out, summary, job, error=str(e), started=started)
+                else:
+                    self._record(out, summary, job, result=result, started=started)
+        finally:
+            session_manager.unpin(session.session_id)
+            if not already_open:
+                session_manager.close_session(session.session_id)
+    
+    def _record(
+        self,
+        out: TextIO,
+        summary: BatchSummary,
+        job: BatchJob,
+        result: Any = None,
+        error: Optional[str] = None,
+        started: Optional[float] = None,
+    ) -> None:
+        """Append one job's outcome to the results file."""
+        record: Dict[str, Any] = {"id": job.job_id, "binary": job.binary, "tool": job.tool}
+        if error is not None:
+            record["error"] = error
+        else:
+            record["result"] = result
+        if started is not None:
+            record["elapsed"] = round(time.monotonic() - started, 3)
+        line = json.dumps(record, default=str) + "\n"
+        
+        with self._write_lock:
+            out.write(line)
+            out.flush()
+            if error is not None:
+                summary.failed += 1
+            else:
+                summary.succeeded += 1
+            self._unsynced += 1
+            if self._unsynced >= self.SYNC_EVERY:
+                self._sync(out)
+    
+    def _sync(self, out: TextIO) -> None:
+        """Make the results written so far durable."""
+        out.flush()
+        os.fsync(out.fileno())
+        self._unsynced = 0
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    """Entry point of ``ida-proxy-mcp batch``.
+    
+    Returns:
+        Exit status: 0 if every job succeeded, 1 if any failed, 130 if
+        interrupted
+    """
+    parser = argparse.ArgumentParser(
+        prog="ida-proxy-mcp batch",
+        description="Run tool jobs from a JSONL file without the HTTP server",
+    )
+    parser.add_argument("jobs", help="JSONL file of {\"binary\", \"tool\", \"arguments\", \"id\"} jobs")
+    parser.add_argument(
+        "--output", "-o",
+        type=str,
+        default=None,
+        help="JSONL results file, also used to resume (default: <jobs>.results.jsonl)",
+    )
+    parser.add_argument(
+        "--config",
+        type=str,
+        default=None,
+        help="Path to configuration file",
+    )
+    parser.add_argument(
+        "--max-processes",
+        type=int,
+        default=None,
+        help="Maximum number of concurrent idalib-mcp processes",
+    )
+    parser.add_argument(
+        "--parallelism",
+        type=int,
+        default=None,
+        help="Binaries worked on at once (default: max processes)",
+    )
+    parser.add_argument(
+        "--retry-failed",
+        action="store_true",
+        help="Run jobs again whose recorded result is an error",
+    )
+    parser.add_argument(
+        "--verbose", "-v",
+        action="store_true",
+        help="Enable verbose logging",
+    )
+    args = parser.parse_args(argv)
+    
+    logging.basicConfig(
+        level=logging.DEBUG if args.verbose else logging.INFO,
+        format="%(asctime)s - %(name)s - %(levelname)s - %(message)s",
+    )
+    
+    from .server import load_config
+    config = load_config(args.config) if args.config else ProxyConfig()
+    if args.max_processes is not None:
+        config.max_processes = args.max_processes
+    # Nothing here outlives the run, so there is nothing to watch for
+    config.watch_binaries = False
+    
+    try:
+        jobs = read_jobs(args.jobs)
+    except (OSError, ValueError) as e:
+        parser.error(str(e))
+    output = args.output or f"{os.path.splitext(args.jobs)[0]}.results.jsonl"
+    
+    with LocalProxy(config) as proxy:
+        runner = BatchRunner(proxy, args.parallelism)
+        summary = runner.run(jobs, output, retry_failed=args.retry_failed)
+    
+    print(json.dumps(summary.to_dict()), file=sys.stderr)
+    if summary.interrupted:
+        return 130
+    return 1 if summary.failed else 0
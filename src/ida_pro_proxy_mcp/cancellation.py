@@ -0,0 +1,153 @@
+"""Cancellation tokens and deadlines for IDA Pro Proxy MCP requests"""
+
+import logging
+import select
+import socket
+import threading
+import time
+from typing import Any, Callable, Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+
+class DeadlineExceededError(RuntimeError):
+    """Raised when a request's deadline passes before it could complete."""
+
+
+class Deadline:
+    """Point in time by which the requester needs an answer.
+    
+    Clients send it in the request's ``_meta`` either as an absolute
+    ``deadline`` (Unix time, seconds) or a relative ``timeout`` (seconds).
+    Internally it is kept on the monotonic clock.
+    """
+    
+    def __init__(self, remaining: float):
+        """Initialize a deadline.
+        
+        Args:
+            remaining: Seconds from now until the deadline
+        """
+        self._at = time.monotonic() + remaining
+    
+    @classmethod
+    def from_meta(cls, meta: Optional[Dict[str, Any]]) -> Optional["Deadline"]:
+        """Parse a deadline from an MCP ``_meta`` object.
+        
+        Args:
+            meta: The request's ``_meta`` dictionary
+        
+        Returns:
+            Deadline, or None if the client did not send one
+        """
+        if not isinstance(meta, dict):
+            return None
+        try:
+            if meta.get("deadline") is not None:
+                return cls(float(meta["deadline"]) - time.time())
+            if meta.get("timeout") is not None:
+                return cls(float(meta["timeout"]))
+        except (TypeError, ValueError):
+            logger.debug(f"Ignoring malformed deadline in _meta: {meta}")
+        return None
+    
+    def remaining(self) -> float:
+        """Seconds left until the deadline (negative once expired)."""
+        return self._at - time.monotonic()
+    
+    def expired(self) -> bool:
+        """Whether the deadline has passed."""
+        return self.remaining() <= 0
+
+
+class CancelToken:
+    """Signals that the requester of a call has gone away.
+    
+    Callbacks registered with add_callback() run once, on the thread that
+    calls cancel(). A callback added after cancellation runs immediately.
+    
+    Attributes:
+        escalate: Whether a cancelled child call that never drains should get
+            its process restarted. Off for work that is merely redundant,
+            such as the losing side of a hedged call.
+    """
+    
+    def __init__(self, escalate: bool = True):
+        self.escalate = escalate
+        self._event = threading.Event()
+        self._callbacks: List[Callable[[], None]] = []
+        self._lock = threading.Lock()
+        self.reason: Optional[str] = None
+    
+    @property
+    def cancelled(self) -> bool:
+        """Whether the token has been cancelled."""
+        return self._event.is_set()
+    
+    def add_callback(self, callback: Callable[[], None]) -> None:
+        """Register a callback to run on cancellation."""
+        with self._lock:
+            if not self._event.is_set():
+                self._callbacks.append(callback)
+                return
+        callback()
+    
+    def remove_callback(self, callback: Callable[[], None]) -> None:
+        """Unregister a previously added callback."""
+        with self._lock:
+            if callback in self._callbacks:
+                self._callbacks.remove(callback)
+    
+    def cancel(self, reason: str = "cancelled") -> None:
+        """Cancel the token and run registered callbacks."""
+        with self._lock:
+            if self._event.is_set():
+                return
+            self.reason = reason
+            self._event.set()
+            callbacks = list(self._callbacks)
+            self._callbacks.clear()
+        
+        for callback in callbacks:
+            try:
+                callback()
+            except Exception as e:
+                logger.warning(f"Cancellation callback failed: {e}")
+
+
+class DisconnectWatcher:
+    """Cancels a token when the client side of a socket hangs up.
+    
+    Polls the socket while a request is being processed. A readable socket
+    that yields no data means the peer closed the connection.
+    """
+    
+    POLL_INTERVAL = 0.5
+    
+    def __init__(self, sock: socket.socket, token: CancelToken):
+        self._sock = sock
+        self._token = token
+        self._done = threading.Event()
+        self._thread = threading.Thread(target=self._run, name="disconnect-watcher", daemon=True)
+    
+    def __enter__(self) -> "DisconnectWatcher":
+        self._thread.start()
+        return self
+    
+    def __exit__(self, *exc) -> None:
+        self._done.set()
+    
+    def _run(self) -> None:
+        while not self._done.is_set():
+            try:
+                readable, _, _ = select.select([self._sock], [], [], self.POLL_INTERVAL)
+                if not readable:
+                    continue
+                if self._sock.recv(1, socket.MSG_PEEK):
+                    # Pipelined data, not a hangup; stop watching
+                    return
+            except (OSError, ValueError):
+                pass
+            if not self._done.is_set():
+                self._token.cancel("client disconnected")
+            return
@@ -0,0 +1,297 @@
+"""cgroup v2 isolation and accounting of child processes for IDA Pro Proxy MCP"""
+
+import logging
+import threading
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Any, Dict, Optional
+
+from .memory import MIB, process_tree
+
+logger = logging.getLogger(__name__)
+
+# Where the unified (v2) hierarchy is mounted
+CGROUP_MOUNT = Path("/sys/fs/cgroup")
+# Controllers delegated to the children, where available
+CONTROLLERS = ("cpu", "memory", "io")
+
+
+@dataclass(frozen=True)
+class SessionClass:
+    """Resource settings for the children serving one kind of session.
+    
+    Attributes:
+        cpu_weight: cpu.weight (1-10000, 100 is the kernel default)
+        io_weight: io.weight (1-10000, 100 is the kernel default)
+        memory_high_ratio: memory.high as a fraction of memory.max; above it
+            the child is throttled and reclaimed from first
+    """
+    cpu_weight: int
+    io_weight: int
+    memory_high_ratio: float
+
+
+# Children serving agents outrank sweeps and batch jobs three to one
+SESSION_CLASSES = {
+    "interactive": SessionClass(cpu_weight=300, io_weight=300, memory_high_ratio=0.9),
+    "background": SessionClass(cpu_weight=100, io_weight=100, memory_high_ratio=0.5),
+}
+# The proxy's own request threads outrank every child
+PROXY_CPU_WEIGHT = 1000
+
+
+@dataclass
+class CgroupUsage:
+    """Resource usage of a child's cgroup.
+    
+    Attributes:
+        cpu_usec: CPU time used (cpu.stat usage_usec)
+        memory_current: Memory charged, including page cache (memory.current)
+        memory_peak: Highest memory charged, where the kernel reports it
+        io_read_bytes: Bytes read from block devices (io.stat)
+        io_write_bytes: Bytes written to block devices (io.stat)
+        memory_high_events: Times the child was throttled at memory.high
+        oom_kills: Processes killed at memory.max
+    """
+    cpu_usec: int = 0
+    memory_current: int = 0
+    memory_peak: Optional[int] = None
+    io_read_bytes: int = 0
+    io_write_bytes: int = 0
+    memory_high_events: int = 0
+    oom_kills: int = 0
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Convert to dictionary format for JSON serialization."""
+        return {
+            "cpu_seconds": round(self.cpu_usec / 1e6, 3),
+            "memory_mb": round(self.memory_current / MIB, 1),
+            "memory_peak_mb": round(self.memory_peak / MIB, 1) if self.memory_peak is not None else None,
+            "io_read_mb": round(self.io_read_bytes / MIB, 1),
+            "io_write_mb": round(self.io_write_bytes / MIB, 1),
+            "memory_high_events": self.memory_high_events,
+            "oom_kills": self.oom_kills,
+        }
+
+
+def _read_keyed(path: Path) -> Dict[str, int]:
+    """Read a flat "key value" cgroup file."""
+    values = {}
+    for line in path.read_text().splitlines():
+        key, _, value = line.partition(" ")
+        if value.strip().isdigit():
+            values[key] = int(value)
+    return values
+
+
+class CgroupManager:
+    """Places each child process in its own cgroup v2 leaf.
+    
+    Children get a cpu.weight, io.weight, memory.high and memory.max from
+    the class of the session they serve, so one runaway auto-analysis
+    can't starve the other children or the proxy. Their usage is read back
+    from the cgroup files.
+    
+    Without a root, the proxy's own cgroup is used: the proxy moves itself
+    into a "proxy" leaf (a cgroup that hands controllers to its children
+    can't hold processes itself) and the children get siblings of it. This
+    needs the cgroup to be delegated to the proxy's user, e.g. by systemd's
+    Delegate=yes. When anything is missing, isolation is off and every
+    method does nothing.
+    
+    Attributes:
+        available: Whether children are being placed in cgroups
+        reason: Why isolation is off, if it is
+    """
+    
+    def __init__(self, root: Optional[str] = None, memory_max: int = 0):
+        """Initialize the manager, setting up the hierarchy if possible.
+        
+        Args:
+            root: Delegated cgroup directory to create the children's cgroups
+                in (default: the proxy's own cgroup)
+            memory_max: memory.max of each child in bytes (0 for no limit)
+        """
+        self.memory_max = memory_max
+        self.available = False
+        self.reason: Optional[str] = None
+        self.controllers: set = set()
+        self._base: Optional[Path] = None
+        self._children: Dict[int, Path] = {}  # port -> cgroup directory
+        self._classes: Dict[int, str] = {}  # port -> session class
+        self._lock = threading.Lock()
+        try:
+            self._setup(Path(root) if root else None)
+        except (OSError, ValueError) as e:
+            self.reason = str(e)
+        if self.available:
+            logger.info(f"Isolating children in cgroups under {self._base} ({', '.join(sorted(self.controllers))})")
+        else:
+            logger.info(f"cgroup isolation unavailable: {self.reason}")
+    
+    @staticmethod
+    def _own_cgroup() -> Path:
+        """The proxy's cgroup in the unified hierarchy.
+        
+        Raises:
+            ValueError: If the host doesn't run cgroup v2 only
+        """
+        if not (CGROUP_MOUNT / "cgroup.controllers").exists():
+            raise ValueError(f"no cgroup v2 hierarchy at {CGROUP_MOUNT}")
+        for line in Path("/proc/self/cgroup").read_text().splitlines():
+            if line.startswith("0::"):
+                return CGROUP_MOUNT / line[3:].lstrip("/")
+        raise ValueError("the proxy is not in a cgroup v2 hierarchy")
+    
+    def _setup(self, root: Optional[Path]) -> None:
+        base = root or self._own_cgroup()
+        controllers = (base / "cgroup.controllers").read_text().split()
+        wanted = [c for c in CONTROLLERS if c in controllers]
+        if not wanted:
+            raise ValueError(f"none of {', '.join(CONTROLLERS)} is delegated to {base}")
+        
+        if root is None:
+            leaf = base / "proxy"
+            leaf.mkdir(exist_ok=True)
+            # Everything in the proxy's cgroup (the proxy and anything it
+            # was started with) moves to the leaf
+            for pid in (base / "cgroup.procs").read_text().split():
+                try:
+                    (leaf / "cgroup.procs").write_text(pid)
+                except ProcessLookupError:
+                    continue
+        (base / "cgroup.subtree_control").write_text(" ".join(f"+{c}" for c in wanted))
+        if root is None and "cpu" in wanted:
+            (base / "proxy" / "cpu.weight").write_text(str(PROXY_CPU_WEIGHT))
+        self._base = base
+        self.controllers = set(wanted)
+        self.available = True
+    
+    def attach(self, port: int, pid: int, session_class: str = "interactive") -> None:
+        """Move a child and its descendants into the child's cgroup.
+        
+        Safe to call again, e.g. once the child is ready, to catch
+        processes it spawned in the meantime.
+        
+        Args:
+            port: Port of the child
+            pid: Process ID of the child
+            session_class: Initial class of the child
+        """
+        if not self.available:
+            return
+        with self._lock:
+            path = self._children.get(port)
+        try:
+            if path is None:
+                path = self._base / f"idalib-{port}"
+                path.mkdir(exist_ok=True)
+                with self._lock:
+                    self._children[port] = path
+                self.set_class(port, session_class)
+            for member in process_tree(pid):
+                try:
+                    (path / "cgroup.procs").write_text(str(member))
+                except ProcessLookupError:
+                    continue
+        except OSError as e:
+            logger.warning(f"Could not place the process on port {port} in a cgroup: {e}")
+    
+    def set_class(self, port: int, session_class: str) -> None:
+        """Apply the resource settings of a session class to a child.
+        
+        Args:
+            port: Port of the child
+            session_class: Key of SESSION_CLASSES
+        """
+        settings = SESSION_CLASSES[session_class]
+        with self._lock:
+            path = self._children.get(port)
+            if path is None or self._classes.get(port) == session_class:
+                return
+            self._classes[port] = session_class
+        writes = []
+        if "cpu" in self.controllers:
+            writes.append(("cpu.weight", str(settings.cpu_weight)))
+        if "io" in self.controllers:
+            writes.append(("io.weight", f"default {settings.io_weight}"))
+        if "memory" in self.controllers:
+            if self.memory_max:
+                writes.append(("memory.max", str(self.memory_max)))
+                writes.append(("memory.high", str(int(self.memory_max * settings.memory_high_ratio))))
+            else:
+                writes.append(("memory.max", "max"))
+                writes.append(("memory.high", "max"))
+        for name, value in writes:
+            try:
+                (path / name).write_text(value)
+            except OSError as e:
+                logger.debug(f"Could not set {name} of {path}: {e}")
+    
+    def session_class(self, port: int) -> Optional[str]:
+        """Current class of a child, if it has a cgroup."""
+        with self._lock:
+            return self._classes.get(port)
+    
+    def usage(self, port: int) -> Optional[CgroupUsage]:
+        """Read a child's resource usage from its cgroup.
+        
+        Returns:
+            CgroupUsage, or None if the child has no cgroup
+        """
+        with self._lock:
+            path = self._children.get(port)
+        if path is None:
+            return None
+        usage = CgroupUsage()
+        try:
+            # cpu.stat is there even without the cpu controller
+            usage.cpu_usec = _read_keyed(path / "cpu.stat").get("usage_usec", 0)
+            if "memory" in self.controllers:
+                usage.memory_current = int((path / "memory.current").read_text())
+                if (path / "memory.peak").exists():
+                    usage.memory_peak = int((path / "memory.peak").read_text())
+                events = _read_keyed(path / "memory.events")
+                usage.memory_high_events = events.get("high", 0)
+                usage.oom_kills = events.get("oom_kill", 0)
+            if "io" in self.controllers:
+                for line in (path / "io.stat").read_text().splitlines():
+                    for field in line.split()[1:]:
+                        key, _, value = field.partition("=")
+                        if key == "rbytes":
+                            usage.io_read_bytes += int(value)
+                        elif key == "wbytes":
+                            usage.io_write_bytes += int(value)
+        except (OSError, ValueError) as e:
+            logger.debug(f"Could not read the usage of {path}: {e}")
+        return usage
+    
+    def remove(self, port: int) -> None:
+        """Remove a child's cgroup once its processes exited."""
+        with self._lock:
+            path = self._children.pop(port, None)
+            self._classes.pop(port, None)
+        if path is None:
+            return
+        try:
+            path.rmdir()
+        except OSError as e:
+            # Still busy if a descendant outlived the child
+            logger.debug(f"Could not remove {path}: {e}")
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize isolation and per-child usage for JSON serialization."""
+        with self._lock:
+            ports = sorted(self._children)
+        children = {}
+        for port in ports:
+            usage = self.usage(port)
+            if usage is not None:
+                children[str(port)] = dict(usage.to_dict(), session_class=self.session_class(port))
+        return {
+            "available": self.available,
+            "reason": self.reason,
+            "root": str(self._base) if self._base is not None else None,
+            "controllers": sorted(self.controllers),
+            "children": children,
+        }
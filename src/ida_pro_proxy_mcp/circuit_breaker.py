@@ -0,0 +1,129 @@
+"""Per-process circuit breaker for IDA Pro Proxy MCP"""
+
+import threading
+import time
+from typing import Optional
+
+
+class CircuitOpenError(RuntimeError):
+    """Raised when a request is rejected because the process breaker is open."""
+
+
+class CircuitBreaker:
+    """Circuit breaker guarding a single idalib-mcp process.
+    
+    States:
+        closed: Requests flow normally; consecutive failures are counted.
+        open: Requests fail fast until reset_timeout has elapsed.
+        half_open: A single probe request is let through. Success closes the
+            breaker, failure re-opens it and marks the process as wedged.
+    
+    Timeouts open the breaker after timeout_threshold in a row, by default
+    the first: a child serves IDA calls on a single thread, so everything
+    queued behind a timed-out call is stuck too.
+    """
+    
+    CLOSED = "closed"
+    OPEN = "open"
+    HALF_OPEN = "half_open"
+    
+    def __init__(self, failure_threshold: int = 3, reset_timeout: float = 30.0, timeout_threshold: int = 1):
+        """Initialize the breaker.
+        
+        Args:
+            failure_threshold: Consecutive errors that open the breaker
+            reset_timeout: Seconds to stay open before allowing a probe
+            timeout_threshold: Consecutive timeouts that open the breaker
+        """
+        self.failure_threshold = failure_threshold
+        self.reset_timeout = reset_timeout
+        self.timeout_threshold = timeout_threshold
+        self._state = self.CLOSED
+        self._failures = 0
+        self._timeouts = 0
+        self._opened_at: Optional[float] = None
+        self._probe_in_flight = False
+        self._lock = threading.Lock()
+    
+    @property
+    def state(self) -> str:
+        """Get the current breaker state."""
+        with self._lock:
+            return self._state
+    
+    def allow_request(self) -> bool:
+        """Check whether a request may be sent to the process.
+        
+        Transitions open -> half_open once reset_timeout has elapsed and
+        admits exactly one probe request.
+        
+        Returns:
+            True if the request may proceed
+        """
+        with self._lock:
+            if self._state == self.CLOSED:
+                return True
+            if self._state == self.OPEN:
+                if time.monotonic() - self._opened_at < self.reset_timeout:
+                    return False
+                self._state = self.HALF_OPEN
+                self._probe_in_flight = False
+            # Half-open: only one probe at a time
+            if self._probe_in_flight:
+                return False
+            self._probe_in_flight = True
+            return True
+    
+    def is_probe(self) -> bool:
+        """Check whether the breaker is currently waiting on a probe."""
+        with self._lock:
+            return self._state == self.HALF_OPEN and self._probe_in_flight
+    
+    def record_success(self) -> None:
+        """Record a successful request, closing the breaker."""
+        with self._lock:
+            self._state = self.CLOSED
+            self._failures = 0
+            self._timeouts = 0
+            self._opened_at = None
+            self._probe_in_flight = False
+    
+    def record_inconclusive(self) -> None:
+        """Record a request whose outcome says nothing about process health.
+        
+        A probe that ended this way frees the slot for another probe.
+        """
+        with self._lock:
+            self._probe_in_flight = False
+    
+    def record_failure(self, timeout: bool = False) -> bool:
+        """Record a failed request.
+        
+        Args:
+            timeout: Whether the failure was a timeout
+        
+        Returns:
+            True if the failure was a failed half-open probe, meaning the
+            process should be considered wedged
+        """
+        with self._lock:
+            self._failures += 1
+            self._timeouts = self._timeouts + 1 if timeout else 0
+            failed_probe = self._state == self.HALF_OPEN
+            if (
+                failed_probe
+                or self._timeouts >= self.timeout_threshold
+                or self._failures >= self.failure_threshold
+            ):
+                self._state = self.OPEN
+                self._opened_at = time.monotonic()
+            self._probe_in_flight = False
+            return failed_probe
+    
+    def to_dict(self) -> dict:
+        """Convert breaker state to dictionary format for JSON serialization."""
+        with self._lock:
+            return {
+                "state": self._state,
+                "consecutive_failures": self._failures,
+            }
@@ -0,0 +1,369 @@
+"""Minimal ELF reader for IDA Pro Proxy MCP"""
+
+import mmap
+import re
+import struct
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Tuple
+
+ELF_MAGIC = b"\x7fELF"
+
+PT_LOAD = 1
+PT_DYNAMIC = 2
+PT_INTERP = 3
+
+SHT_SYMTAB = 2
+SHT_DYNAMIC = 6
+SHT_NOBITS = 8
+SHT_DYNSYM = 11
+
+SHN_UNDEF = 0
+SHN_XINDEX = 0xFFFF
+
+DT_NULL = 0
+DT_NEEDED = 1
+DT_STRTAB = 5
+DT_STRSZ = 10
+DT_SONAME = 14
+DT_RUNPATH = 29
+
+ELF_TYPES = {0: "NONE", 1: "REL", 2: "EXEC", 3: "DYN", 4: "CORE"}
+MACHINES = {
+    3: "x86", 8: "MIPS", 20: "PowerPC", 21: "PowerPC64", 40: "ARM", 42: "SuperH",
+    43: "SPARCV9", 50: "IA-64", 62: "x86-64", 183: "AArch64", 243: "RISC-V",
+}
+SECTION_TYPES = {
+    0: "NULL", 1: "PROGBITS", 2: "SYMTAB", 3: "STRTAB", 4: "RELA", 5: "HASH",
+    6: "DYNAMIC", 7: "NOTE", 8: "NOBITS", 9: "REL", 11: "DYNSYM",
+    14: "INIT_ARRAY", 15: "FINI_ARRAY",
+}
+SYMBOL_TYPES = {
+    0: "NOTYPE", 1: "OBJECT", 2: "FUNC", 3: "SECTION", 4: "FILE", 5: "COMMON",
+    6: "TLS", 10: "IFUNC",
+}
+SYMBOL_BINDS = {0: "LOCAL", 1: "GLOBAL", 2: "WEAK", 10: "UNIQUE"}
+
+
+@dataclass
+class Segment:
+    """A loadable segment: file bytes mapped at a virtual address."""
+    vaddr: int
+    memsz: int
+    offset: int
+    filesz: int
+
+
+@dataclass
+class Section:
+    """A section header."""
+    name: str
+    type: int
+    flags: int
+    addr: int
+    offset: int
+    size: int
+    link: int
+    entsize: int
+    
+    def to_dict(self) -> Dict:
+        """Convert to dictionary for JSON serialization."""
+        return {
+            "name": self.name,
+            "type": SECTION_TYPES.get(self.type, hex(self.type)),
+            "addr": hex(self.addr),
+            "offset": self.offset,
+            "size": self.size,
+            "flags": "".join(c for bit, c in ((1, "W"), (2, "A"), (4, "X")) if self.flags & bit),
+        }
+
+
+@dataclass
+class Symbol:
+    """An entry of the static or dynamic symbol table."""
+    name: str
+    value: int
+    size: int
+    type: int
+    bind: int
+    shndx: int
+    dynamic: bool
+    
+    @property
+    def defined(self) -> bool:
+        return self.shndx != SHN_UNDEF
+    
+    def to_dict(self) -> Dict:
+        """Convert to dictionary for JSON serialization."""
+        return {
+            "name": self.name,
+            "addr": hex(self.value),
+            "size": self.size,
+            "type": SYMBOL_TYPES.get(self.type, str(self.type)),
+            "bind": SYMBOL_BINDS.get(self.bind, str(self.bind)),
+            "defined": self.defined,
+            "dynamic": self.dynamic,
+        }
+
+
+def _cstring(data, offset: int) -> str:
+    """Read a NUL-terminated string."""
+    if offset < 0 or offset >= len(data):
+        return ""
+    end = data.find(b"\0", offset)
+    if end < 0:
+        end = len(data)
+    return bytes(data[offset:end]).decode("utf-8", errors="replace")
+
+
+class ElfFile:
+    """An ELF file, read without IDA.
+    
+    Headers, segments, sections and the dynamic section are read when the
+    file is opened; symbol tables and strings when first asked for, and
+    then kept. The file is memory-mapped only while it is being read.
+    
+    Attributes:
+        path: Path of the file
+        size: File size in bytes
+        bits: 32 or 64
+        little_endian: Byte order of the file
+        type: e_type value
+        machine: e_machine value
+        entry: Entry point address
+        interpreter: Program interpreter, if any
+        segments: Loadable segments, by ascending address
+        sections: Section headers
+        needed: Libraries the file depends on (DT_NEEDED)
+        soname: Shared object name (DT_SONAME), if any
+        runpath: Library search path (DT_RUNPATH), if any
+    """
+    
+    def __init__(self, path: str):
+        """Read an ELF file's headers.
+        
+        Raises:
+            OSError: If the file can't be read
+            ValueError: If the file is not a well-formed ELF file
+        """
+        self.path = path
+        self.interpreter: Optional[str] = None
+        self.needed: List[str] = []
+        self.soname: Optional[str] = None
+        self.runpath: Optional[str] = None
+        self._symbols: Optional[List[Symbol]] = None
+        self._strings: Dict[Tuple[int, Optional[str]], List[Tuple[int, str]]] = {}
+        with open(path, "rb") as f:
+            if f.read(4) != ELF_MAGIC:
+                raise ValueError(f"{path} is not an ELF file")
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                self.size = len(data)
+                try:
+                    self._parse(data)
+                except struct.error as e:
+                    raise ValueError(f"{path} is truncated or malformed: {e}")
+    
+    def _parse(self, data) -> None:
+        if len(data) < 16 or data[4] not in (1, 2) or data[5] not in (1, 2):
+            raise ValueError(f"{self.path} has an invalid ELF class or byte order")
+        self.bits = 32 if data[4] == 1 else 64
+        self.little_endian = data[5] == 1
+        order = "<" if self.little_endian else ">"
+        word = "I" if self.bits == 32 else "Q"
+        
+        (self.type, self.machine, _, self.entry, phoff, shoff, _, _,
+         phentsize, phnum, shentsize, shnum, shstrndx) = struct.unpack_from(
+            order + f"HHI{word}{word}{word}IHHHHHH", data, 16
+        )
+        
+        # Program headers
+        if self.bits == 32:
+            phdr = struct.Struct(order + "IIIIIIII")
+        else:
+            phdr = struct.Struct(order + "IIQQQQQQ")
+        if phnum and phentsize < phdr.size:
+            raise ValueError(f"{self.path} has invalid program headers")
+        self.segments: List[Segment] = []
+        dynamic: Optional[Tuple[int, int]] = None
+        for i in range(phnum):
+            fields = phdr.unpack_from(data, phoff + i * phentsize)
+            if self.bits == 32:
+                p_type, offset, vaddr, _, filesz, memsz, _, _ = fields
+            else:
+                p_type, _, offset, vaddr, _, filesz, memsz, _ = fields
+            if p_type == PT_LOAD and filesz:
+                self.segments.append(Segment(vaddr, memsz, offset, filesz))
+            elif p_type == PT_INTERP:
+                self.interpreter = _cstring(data[offset:offset + filesz], 0)
+            elif p_type == PT_DYNAMIC:
+                dynamic = (offset, filesz)
+        self.segments.sort(key=lambda s: s.vaddr)
+        
+        # Section headers; counts too large for the header live in section 0
+        if self.bits == 32:
+            shdr = struct.Struct(order + "IIIIIIIIII")
+        else:
+            shdr = struct.Struct(order + "IIQQQQIIQQ")
+        self.sections: List[Section] = []
+        if shoff and shentsize >= shdr.size:
+            first = shdr.unpack_from(data, shoff)
+            if shnum == 0:
+                shnum = first[5]
+            if shstrndx == SHN_XINDEX:
+                shstrndx = first[6]
+            headers = [shdr.unpack_from(data, shoff + i * shentsize) for i in range(shnum)]
+            names = b""
+            if shstrndx < len(headers):
+                _, _, _, _, offset, size, _, _, _, _ = headers[shstrndx]
+                names = data[offset:offset + size]
+            for name, sh_type, flags, addr, offset, size, link, _, _, entsize in headers:
+                self.sections.append(
+                    Section(_cstring(names, name), sh_type, flags, addr, offset, size, link, entsize)
+                )
+        
+        self._parse_dynamic(data, order, word, dynamic)
+    
+    def _parse_dynamic(self, data, order: str, word: str, dynamic: Optional[Tuple[int, int]]) -> None:
+        """Read the libraries and names of the dynamic section."""
+        strtab: Optional[Tuple[int, int]] = None
+        for section in self.sections:
+            if section.type == SHT_DYNAMIC:
+                dynamic = (section.offset, section.size)
+                if section.link < len(self.sections):
+                    linked = self.sections[section.link]
+                    strtab = (linked.offset, linked.size)
+                break
+        if dynamic is None:
+            return
+        
+        entry = struct.Struct(order + word + word)
+        entries = []
+        offset, size = dynamic
+        for pos in range(offset, min(offset + size, len(data)) - entry.size + 1, entry.size):
+            tag, value = entry.unpack_from(data, pos)
+            if tag == DT_NULL:
+                break
+            entries.append((tag, value))
+        
+        if strtab is None:
+            # No section headers: find the string table through its address
+            addr = next((v for t, v in entries if t == DT_STRTAB), None)
+            strsz = next((v for t, v in entries if t == DT_STRSZ), 0)
+            start = self.offset_of(addr, strsz) if addr is not None else None
+            if start is None:
+                return
+            strtab = (start, strsz)
+        strings = data[strtab[0]:strtab[0] + strtab[1]]
+        
+        for tag, value in entries:
+            if tag == DT_NEEDED:
+                self.needed.append(_cstring(strings, value))
+            elif tag == DT_SONAME:
+                self.soname = _cstring(strings, value)
+            elif tag == DT_RUNPATH:
+                self.runpath = _cstring(strings, value)
+    
+    @staticmethod
+    def is_elf(path: str) -> bool:
+        """Whether a file starts with the ELF magic."""
+        try:
+            with open(path, "rb") as f:
+                return f.read(4) == ELF_MAGIC
+        except OSError:
+            return False
+    
+    def offset_of(self, vaddr: int, size: int = 1) -> Optional[int]:
+        """File offset of the bytes at a virtual address.
+        
+        Args:
+            vaddr: Virtual address
+            size: Number of bytes that must be backed by the file
+        
+        Returns:
+            The offset, or None if the range is not backed by file bytes
+        """
+        for segment in self.segments:
+            start = vaddr - segment.vaddr
+            if 0 <= start and start + size <= segment.filesz:
+                return segment.offset + start
+        return None
+    
+    def section(self, name: str) -> Optional[Section]:
+        """The first section with a name, if any."""
+        return next((s for s in self.sections if s.name == name), None)
+    
+    def symbols(self) -> List[Symbol]:
+        """Entries of the static and dynamic symbol tables, without the null symbol."""
+        if self._symbols is None:
+            with open(self.path, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                self._symbols = self._read_symbols(data)
+        return self._symbols
+    
+    def _read_symbols(self, data) -> List[Symbol]:
+        order = "<" if self.little_endian else ">"
+        if self.bits == 32:
+            entry = struct.Struct(order + "IIIBBH")
+        else:
+            entry = struct.Struct(order + "IBBHQQ")
+        
+        symbols = []
+        for section in self.sections:
+            if section.type not in (SHT_SYMTAB, SHT_DYNSYM) or section.link >= len(self.sections):
+                continue
+            linked = self.sections[section.link]
+            names = data[linked.offset:linked.offset + linked.size]
+            entsize = section.entsize or entry.size
+            end = min(section.offset + section.size, len(data))
+            for pos in range(section.offset + entsize, end - entry.size + 1, entsize):
+                if self.bits == 32:
+                    name, value, size, info, _, shndx = entry.unpack_from(data, pos)
+                else:
+                    name, info, _, shndx, value, size = entry.unpack_from(data, pos)
+                symbols.append(Symbol(
+                    name=_cstring(names, name),
+                    value=value,
+                    size=size,
+                    type=info & 0xF,
+                    bind=info >> 4,
+                    shndx=shndx,
+                    dynamic=section.type == SHT_DYNSYM,
+                ))
+        return symbols
+    
+    def imports(self) -> List[Symbol]:
+        """Undefined dynamic symbols, resolved from the needed libraries."""
+        return [s for s in self.symbols() if s.dynamic and not s.defined and s.name]
+    
+    def strings(self, min_length: int = 4, section: Optional[str] = None) -> List[Tuple[int, str]]:
+        """Printable ASCII strings, like strings(1).
+        
+        Args:
+            min_length: Shortest run of printable characters reported
+            section: Only search this section (default: the whole file)
+        
+        Returns:
+            (file offset, string) pairs in file order
+        
+        Raises:
+            ValueError: If the section doesn't exist or has no file bytes
+        """
+        key = (min_length, section)
+        if key not in self._strings:
+            start, end = 0, self.size
+            if section is not None:
+                found = self.section(section)
+                if found is None or found.type == SHT_NOBITS:
+                    raise ValueError(f"No section {section} with contents")
+                start, end = found.offset, found.offset + found.size
+            pattern = re.compile(rb"[\t\x20-\x7e]{%d,}" % max(1, min_length))
+            with open(self.path, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                self._strings[key] = [
+                    (m.start(), m.group().decode("ascii")) for m in pattern.finditer(data, start, end)
+                ]
+        return self._strings[key]
+    
+    def vaddr_of(self, offset: int) -> Optional[int]:
+        """Virtual address a file offset is loaded at, if it is loaded."""
+        for segment in self.segments:
+            if segment.offset <= offset < segment.offset + segment.filesz:
+                return segment.vaddr + offset - segment.offset
+        return None
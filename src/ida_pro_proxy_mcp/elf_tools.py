@@ -0,0 +1,179 @@
+"""ELF metadata tools answered by the proxy for IDA Pro Proxy MCP"""
+
+import fnmatch
+import logging
+import threading
+from collections import OrderedDict
+from pathlib import Path
+from typing import Any, Dict, Optional, Tuple
+
+from .elf_reader import ELF_TYPES, MACHINES, ElfFile
+from .hashing import FileHasher
+
+logger = logging.getLogger(__name__)
+
+
+class ElfTools:
+    """Answers ELF metadata queries from the file, without an IDA process.
+    
+    Parsed files are kept per content hash, so repeated queries of a
+    binary cost a stat() call, copies of a binary share one parse, and a
+    binary that changes on disk is parsed again.
+    
+    Attributes:
+        max_files: Number of parsed files kept
+    """
+    
+    def __init__(self, max_files: int = 32):
+        self.max_files = max_files
+        self._files: "OrderedDict[str, ElfFile]" = OrderedDict()
+        self._lock = threading.Lock()
+        self._hasher = FileHasher()
+        self.hits = 0
+        self.misses = 0
+    
+    def load(self, path: str) -> Tuple[str, ElfFile]:
+        """Get a parsed ELF file and its content hash.
+        
+        Raises:
+            FileNotFoundError: If the file doesn't exist
+            ValueError: If the file is not an ELF file
+        """
+        resolved = Path(path).resolve()
+        if not resolved.is_file():
+            raise FileNotFoundError(f"Binary file not found: {path}")
+        content_hash = self._hasher.hash_file(resolved)
+        with self._lock:
+            elf = self._files.get(content_hash)
+            if elf is not None:
+                self._files.move_to_end(content_hash)
+                self.hits += 1
+                return content_hash, elf
+            self.misses += 1
+        
+        elf = ElfFile(str(resolved))
+        with self._lock:
+            self._files[content_hash] = elf
+            while len(self._files) > self.max_files:
+                self._files.popitem(last=False)
+        return content_hash, elf
+    
+    def info(self, path: str) -> Dict[str, Any]:
+        """Headers, segments, sections and dynamic linking information."""
+        content_hash, elf = self.load(path)
+        return {
+            "path": elf.path,
+            "content_hash": content_hash,
+            "size": elf.size,
+            "class": f"ELF{elf.bits}",
+            "endianness": "little" if elf.little_endian else "big",
+            "type": ELF_TYPES.get(elf.type, hex(elf.type)),
+            "machine": MACHINES.get(elf.machine, str(elf.machine)),
+            "entry": hex(elf.entry),
+            "interpreter": elf.interpreter,
+            "needed": elf.needed,
+            "soname": elf.soname,
+            "runpath": elf.runpath,
+            "segments": [
+                {
+                    "vaddr": hex(s.vaddr),
+                    "memsz": s.memsz,
+                    "offset": s.offset,
+                    "filesz": s.filesz,
+                }
+                for s in elf.segments
+            ],
+            "sections": [s.to_dict() for s in elf.sections if s.name],
+        }
+    
+    def symbols(
+        self,
+        path: str,
+        filter: Optional[str] = None,
+        defined_only: bool = False,
+        dynamic_only: bool = False,
+        offset: int = 0,
+        count: int = 1000,
+    ) -> Dict[str, Any]:
+        """Symbols of the static and dynamic symbol tables.
+        
+        Args:
+            path: ELF file
+            filter: Glob pattern symbol names must match
+            defined_only: Leave out undefined (imported) symbols
+            dynamic_only: Only list the dynamic symbol table
+            offset: Matches to skip
+            count: Maximum number of matches
+        
+        Returns:
+            Dictionary with ``symbols``, ``total`` and ``next_offset``
+        """
+        _, elf = self.load(path)
+        matches = [
+            s for s in elf.symbols()
+            if s.name
+            and (not defined_only or s.defined)
+            and (not dynamic_only or s.dynamic)
+            and (filter is None or fnmatch.fnmatchcase(s.name, filter))
+        ]
+        return self._page("symbols", [s.to_dict() for s in matches[offset:offset + count]],
+                          len(matches), offset)
+    
+    def imports(self, path: str) -> Dict[str, Any]:
+        """Needed libraries and the undefined dynamic symbols resolved from them."""
+        _, elf = self.load(path)
+        imports = []
+        for symbol in elf.imports():
+            entry = symbol.to_dict()
+            imports.append({key: entry[key] for key in ("name", "type", "bind")})
+        return {"needed": elf.needed, "imports": imports, "count": len(imports)}
+    
+    def strings(
+        self,
+        path: str,
+        min_length: int = 4,
+        section: Optional[str] = None,
+        contains: Optional[str] = None,
+        offset: int = 0,
+        count: int = 1000,
+    ) -> Dict[str, Any]:
+        """Printable strings of the file or one section.
+        
+        Args:
+            path: ELF file
+            min_length: Shortest string reported
+            section: Only search this section, e.g. ".rodata"
+            contains: Substring strings must contain
+            offset: Matches to skip
+            count: Maximum number of matches
+        
+        Returns:
+            Dictionary with ``strings`` (file offset, load address and
+            text), ``total`` and ``next_offset``
+        
+        Raises:
+            ValueError: If the section doesn't exist
+        """
+        _, elf = self.load(path)
+        matches = elf.strings(min_length, section)
+        if contains:
+            matches = [m for m in matches if contains in m[1]]
+        page = []
+        for file_offset, text in matches[offset:offset + count]:
+            vaddr = elf.vaddr_of(file_offset)
+            page.append({
+                "offset": file_offset,
+                "addr": hex(vaddr) if vaddr is not None else None,
+                "string": text,
+            })
+        return self._page("strings", page, len(matches), offset)
+    
+    @staticmethod
+    def _page(name: str, items: list, total: int, offset: int) -> Dict[str, Any]:
+        end = offset + len(items)
+        return {name: items, "total": total, "next_offset": end if end < total else None}
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize the cache for JSON serialization."""
+        with self._lock:
+            return {"files": len(self._files), "hits": self.hits, "misses": self.misses}
@@ -0,0 +1,201 @@
+"""Fan-out of one tool call across many binaries for IDA Pro Proxy MCP"""
+
+import glob
+import logging
+import os
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional
+
+from .cancellation import CancelToken, Deadline
+from .session_manager import SessionManager
+
+logger = logging.getLogger(__name__)
+
+# Sends a tool call to a session: (session_id, arguments) -> JSON-RPC response
+CallTool = Callable[[str, Dict[str, Any]], Dict[str, Any]]
+
+
+def expand_inputs(inputs: List[str]) -> List[str]:
+    """Expand glob patterns into resolved file paths.
+    
+    Directories are skipped. Paths without wildcards are kept even if they
+    don't exist, so they get a per-binary error rather than vanishing.
+    
+    Args:
+        inputs: Paths and glob patterns (``**`` recurses)
+    
+    Returns:
+        Resolved paths, first occurrence first, without duplicates
+    """
+    paths = []
+    seen = set()
+    for pattern in inputs:
+        pattern = os.path.expanduser(pattern)
+        if glob.has_magic(pattern):
+            matches = sorted(glob.glob(pattern, recursive=True))
+        else:
+            matches = [pattern]
+        for match in matches:
+            if os.path.isdir(match):
+                continue
+            path = str(Path(match).resolve())
+            if path not in seen:
+                seen.add(path)
+                paths.append(path)
+    return paths
+
+
+class MapRun:
+    """One tool call fanned out over a corpus of binaries.
+    
+    Binaries with the same content are grouped so each is opened once, and
+    binaries that are already open are visited first, before opens for the
+    rest can evict them. Each worker holds one pinned session at a time:
+    open, call, close. Sessions opened by the run are closed after their
+    call unless keep_open is set; sessions that were already open are left
+    open.
+    """
+    
+    def __init__(
+        self,
+        session_manager: SessionManager,
+        call_tool: CallTool,
+        arguments: Dict[str, Any],
+        parallelism: int,
+        run_auto_analysis: bool = True,
+        keep_open: bool = False,
+        cancel_token: Optional[CancelToken] = None,
+        deadline: Optional[Deadline] = None,
+    ):
+        """Initialize the run.
+        
+        Args:
+            session_manager: SessionManager to open and close sessions with
+            call_tool: Sends the tool call to one session
+            arguments: Tool arguments, copied for each binary
+            parallelism: Number of binaries worked on at once
+            run_auto_analysis: Whether binaries are opened with auto-analysis
+            keep_open: Whether to keep sessions the run opened
+            cancel_token: Stops scheduling further binaries when cancelled
+            deadline: Stops scheduling further binaries when it passes
+        """
+        self.session_manager = session_manager
+        self.call_tool = call_tool
+        self.arguments = arguments
+        self.parallelism = max(1, parallelism)
+        self.run_auto_analysis = run_auto_analysis
+        self.keep_open = keep_open
+        self.cancel_token = cancel_token
+        self.deadline = deadline
+    
+    def run(
+        self, paths: List[str], on_result: Optional[Callable[[Dict[str, Any]], None]] = None
+    ) -> List[Dict[str, Any]]:
+        """Call the tool on every binary.
+        
+        Args:
+            paths: Resolved binary paths
+            on_result: Called on the calling thread with each binary's
+                result as soon as it is available
+        
+        Returns:
+            Per-binary results in the order of paths. Each has ``binary``
+            and either ``session_id`` and ``result``, or ``error``.
+        """
+        groups: Dict[str, List[str]] = {}  # content hash -> paths with that content
+        results: Dict[str, Dict[str, Any]] = {}
+        
+        def emit(entry: Dict[str, Any]) -> None:
+            results[entry["binary"]] = entry
+            if on_result is not None:
+                on_result(entry)
+        
+        for path in paths:
+            try:
+                groups.setdefault(self.session_manager.content_hash(path), []).append(path)
+            except OSError as e:
+                emit({"binary": path, "error": f"Cannot read binary: {e}"})
+        
+        # Already open binaries first: they cost no open and must not be evicted
+        order = sorted(
+            groups.values(),
+            key=lambda group: self.session_manager.get_session_by_binary(group[0]) is None,
+        )
+        
+        if order:
+            workers = min(self.parallelism, len(order))
+            with ThreadPoolExecutor(max_workers=workers, thread_name_prefix="map") as pool:
+                futures = [pool.submit(self._visit, group) for group in order]
+                for future in as_completed(futures):
+                    for entry in future.result():
+                        emit(entry)
+        
+        return [results[path] for path in paths]
+    
+    def _stopped(self) -> Optional[str]:
+        """Why no further binaries should be started, if they shouldn't."""
+        if self.cancel_token is not None and self.cancel_token.cancelled:
+            return "Cancelled before this binary was started"
+        if self.deadline is not None and self.deadline.expired():
+            return "Deadline exceeded before this binary was started"
+        return None
+    
+    def _visit(self, group: List[str]) -> List[Dict[str, Any]]:
+        """Open one binary, call the tool on it, and close it again."""
+        binary = group[0]
+        entry: Dict[str, Any] = {"binary": binary}
+        
+        stopped = self._stopped()
+        if stopped is not None:
+            entry["error"] = stopped
+            return self._fan_in(group, entry)
+        
+        already_open = self.session_manager.get_session_by_binary(binary) is not None
+        try:
+            session = self.session_manager.open_session(
+                binary, self.run_auto_analysis, make_current=False, pin=True,
+                session_class="background",
+            )
+        except (OSError, RuntimeError) as e:
+            entry["error"] = str(e)
+            return self._fan_in(group, entry)
+        
+        entry["session_id"] = session.session_id
+        try:
+            response = self.call_tool(session.session_id, dict(self.arguments))
+            error = self._response_error(response)
+            if error is not None:
+                entry["error"] = error
+            else:
+                entry["result"] = response["result"]
+        except Exception as e:
+            logger.warning(f"Map call on {binary} failed: {e}")
+            entry["error"] = str(e)
+        finally:
+            self.session_manager.unpin(session.session_id)
+            if not already_open and not self.keep_open:
+                self.session_manager.close_session(session.session_id)
+        return self._fan_in(group, entry)
+    
+    @staticmethod
+    def _fan_in(group: List[str], entry: Dict[str, Any]) -> List[Dict[str, Any]]:
+        """Give every path with the same content the result of its first path."""
+        entries = [entry]
+        for path in group[1:]:
+            entries.append({**entry, "binary": path, "same_content_as": entry["binary"]})
+        return entries
+    
+    @staticmethod
+    def _response_error(response: Dict[str, Any]) -> Optional[str]:
+        """Extract the error message from a failed tool call response."""
+        if "error" in response:
+            return response["error"].get("message", str(response["error"]))
+        result = response.get("result", {})
+        if not result.get("isError"):
+            return None
+        structured = result.get("structuredContent")
+        if isinstance(structured, dict) and "error" in structured:
+            return str(structured["error"])
+        content = result.get("content") or [{}]
+        return content[0].get("text", "Tool call failed")
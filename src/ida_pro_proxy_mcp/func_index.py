@@ -0,0 +1,447 @@
+"""Cross-binary function index for IDA Pro Proxy MCP"""
+
+import bisect
+import fnmatch
+import json
+import logging
+import sys
+import threading
+import time
+from array import array
+from collections import OrderedDict
+from dataclasses import dataclass, field
+from typing import Any, Callable, Dict, Iterable, Iterator, List, Optional, Tuple
+
+from .models import ProxySession
+from .process_manager import ProcessManager
+
+logger = logging.getLogger(__name__)
+
+FUNCTION = "function"
+IMPORT = "import"
+EXPORT = "export"
+KINDS = (FUNCTION, IMPORT, EXPORT)
+
+# (name, address, size, module) as read from a child
+Symbol = Tuple[str, int, int, str]
+
+
+def parse_int(value: Any) -> int:
+    """Parse an address or size sent as an int or a (hex) string."""
+    if isinstance(value, int):
+        return value
+    try:
+        return int(str(value), 0)
+    except ValueError:
+        return 0
+
+
+def tool_result(tool_name: str, response: Dict[str, Any]) -> Any:
+    """Decode the result of a child's tools/call response.
+    
+    Raises:
+        RuntimeError: If the call failed
+    """
+    if "error" in response:
+        raise RuntimeError(f"{tool_name} failed: {response['error']}")
+    result = response.get("result", {})
+    if result.get("isError"):
+        raise RuntimeError(f"{tool_name} failed: {result.get('content')}")
+    if "structuredContent" in result:
+        data = result["structuredContent"]
+        # Lists are wrapped as {"result": [...]} in structured content
+        if isinstance(data, dict) and set(data) == {"result"}:
+            return data["result"]
+        return data
+    content = result.get("content") or [{}]
+    return json.loads(content[0].get("text") or "null")
+
+
+def page_items(data: Any) -> Tuple[List[Dict[str, Any]], Optional[int]]:
+    """Split a (possibly batched) page into its items and next offset."""
+    if isinstance(data, list):
+        if data and isinstance(data[0], dict) and "data" in data[0]:
+            data = data[0]
+        else:
+            return data, None
+    if isinstance(data, dict):
+        items = data.get("data", data.get("functions", []))
+        return items or [], data.get("next_offset")
+    return [], None
+
+
+class SymbolTable:
+    """Symbols of one kind in one binary, sorted by name.
+    
+    Names are kept in a sorted list and addresses and sizes in parallel
+    unsigned 64-bit arrays, so exact and prefix lookups are two bisections
+    and the table costs little beyond the name strings themselves.
+    """
+    
+    __slots__ = ("names", "addrs", "sizes", "modules")
+    
+    def __init__(self, symbols: Iterable[Symbol]):
+        ordered = sorted(symbols)
+        self.names: List[str] = [s[0] for s in ordered]
+        self.addrs = array("Q", (s[1] for s in ordered))
+        self.sizes = array("Q", (s[2] for s in ordered))
+        # Only imports have modules; interned since a few modules repeat
+        modules = [s[3] for s in ordered]
+        self.modules: Optional[List[str]] = (
+            [sys.intern(m) for m in modules] if any(modules) else None
+        )
+    
+    def __len__(self) -> int:
+        return len(self.names)
+    
+    def exact(self, name: str) -> range:
+        """Indices of the symbols named name."""
+        lo = bisect.bisect_left(self.names, name)
+        return range(lo, bisect.bisect_right(self.names, name, lo))
+    
+    def prefix(self, prefix: str) -> range:
+        """Indices of the symbols whose name starts with prefix."""
+        lo = bisect.bisect_left(self.names, prefix)
+        return range(lo, bisect.bisect_left(self.names, prefix + "\U0010ffff", lo))
+    
+    def glob(self, pattern: str) -> Iterator[int]:
+        """Indices of the symbols matching a glob pattern (case-sensitive).
+        
+        Only the range sharing the pattern's literal prefix is scanned.
+        """
+        literal = len(pattern)
+        for i, c in enumerate(pattern):
+            if c in "*?[":
+                literal = i
+                break
+        for i in self.prefix(pattern[:literal]):
+            if fnmatch.fnmatchcase(self.names[i], pattern):
+                yield i
+
+
+@dataclass
+class BinaryIndex:
+    """Index of one binary's content.
+    
+    Attributes:
+        content_hash: Hash of the binary the index was built from (the
+            session ID for journaled sessions without one)
+        binary_path: Path the binary was opened from
+        session_id: Session of the binary, or None once it is closed
+        generation: Session generation the index reflects
+        tables: Symbol tables by kind
+        built_at: Unix time the index was built
+    """
+    content_hash: str
+    binary_path: str
+    session_id: Optional[str]
+    generation: int
+    tables: Dict[str, SymbolTable] = field(default_factory=dict)
+    built_at: float = 0.0
+    
+    @property
+    def symbol_count(self) -> int:
+        return sum(len(table) for table in self.tables.values())
+
+
+class FunctionIndex:
+    """Function, import and export names of every binary, across sessions.
+    
+    Binaries are indexed in the background when their session opens, and
+    re-indexed after their generation changes (a mutating tool call or the
+    file changing on disk), once changes have settled for REFRESH_DELAY.
+    Indexes are kept per content hash, so closed binaries stay searchable
+    (the MAX_CLOSED most recently closed) and a reopened binary is
+    searchable while it is re-indexed.
+    Lookups never touch a child process.
+    """
+    
+    # Symbols requested per paginated call
+    PAGE_SIZE = 10000
+    # Seconds without further changes before a changed binary is re-indexed
+    REFRESH_DELAY = 2.0
+    # Indexes of closed binaries kept
+    MAX_CLOSED = 256
+    # Timeout of one indexing call to a child
+    CALL_TIMEOUT = 300
+    
+    def __init__(self, process_manager: ProcessManager):
+        """Initialize the index and start its background worker.
+        
+        Args:
+            process_manager: Used to query the sessions' processes
+        """
+        self.process_manager = process_manager
+        self._lock = threading.Condition()
+        self._by_hash: "OrderedDict[str, BinaryIndex]" = OrderedDict()
+        self._sessions: Dict[str, ProxySession] = {}  # session_id -> open session
+        self._due: Dict[str, float] = {}  # session_id -> monotonic time to (re)index at
+        self._errors: Dict[str, str] = {}  # session_id -> last indexing error
+        self._listeners: List[Callable[[BinaryIndex], None]] = []
+        self._closed = False
+        self._thread = threading.Thread(target=self._run, name="function-index", daemon=True)
+        self._thread.start()
+    
+    def session_opened(self, session: ProxySession) -> None:
+        """Index a newly opened session, unless its content is indexed already."""
+        with self._lock:
+            self._sessions[session.session_id] = session
+            entry = self._by_hash.get(self._key(session))
+            if entry is not None and entry.session_id is None:
+                # Searchable right away; the refresh picks up unsaved changes lost on close
+                entry.session_id = session.session_id
+                entry.binary_path = session.binary_path
+                self._by_hash.move_to_end(self._key(session))
+            self._schedule(session.session_id, 0)
+    
+    def session_changed(self, session: ProxySession) -> None:
+        """Re-index a session whose database may have changed."""
+        with self._lock:
+            if session.session_id in self._sessions:
+                self._schedule(session.session_id, self.REFRESH_DELAY)
+    
+    def session_closed(self, session: ProxySession) -> None:
+        """Keep a closed session's index under its content hash."""
+        with self._lock:
+            self._sessions.pop(session.session_id, None)
+            self._due.pop(session.session_id, None)
+            self._errors.pop(session.session_id, None)
+            for entry in self._by_hash.values():
+                if entry.session_id == session.session_id:
+                    entry.session_id = None
+            closed = [h for h, e in self._by_hash.items() if e.session_id is None]
+            for content_hash in closed[:max(0, len(closed) - self.MAX_CLOSED)]:
+                del self._by_hash[content_hash]
+    
+    @staticmethod
+    def _key(session: ProxySession) -> str:
+        """Key of a session's index; journaled sessions may lack a hash."""
+        return session.content_hash or session.session_id
+    
+    def add_listener(self, listener: Callable[[BinaryIndex], None]) -> None:
+        """Call listener with every index built, on the index's worker thread."""
+        self._listeners.append(listener)
+    
+    def get(self, key: str) -> Optional[BinaryIndex]:
+        """Index of a binary by content hash, if it is kept."""
+        with self._lock:
+            return self._by_hash.get(key)
+    
+    def entries(self) -> List[BinaryIndex]:
+        """Indexes of all kept binaries, least recently built first."""
+        with self._lock:
+            return list(self._by_hash.values())
+    
+    def _schedule(self, session_id: str, delay: float) -> None:
+        """Queue a session for indexing; called with the lock held."""
+        self._due[session_id] = time.monotonic() + delay
+        self._lock.notify()
+    
+    def lookup(
+        self,
+        name: Optional[str] = None,
+        prefix: Optional[str] = None,
+        pattern: Optional[str] = None,
+        kinds: Optional[Iterable[str]] = None,
+        include_closed: bool = True,
+        limit: int = 1000,
+    ) -> Dict[str, Any]:
+        """Find symbols across all indexed binaries.
+        
+        Exactly one of name, prefix and pattern is used, in that order.
+        
+        Args:
+            name: Exact symbol name
+            prefix: Symbol name prefix
+            pattern: Glob pattern (``*``, ``?``, ``[...]``)
+            kinds: Symbol kinds to search (default: all)
+            include_closed: Whether to search binaries no longer open
+            limit: Maximum number of matches returned
+        
+        Returns:
+            Dictionary with ``matches``, ``count``, ``truncated`` and
+            ``pending`` (sessions not indexed yet)
+        
+        Raises:
+            ValueError: If no query or an unknown kind is given
+        """
+        if name is None and prefix is None and pattern is None:
+            raise ValueError("One of name, prefix or pattern is required")
+        kinds = list(kinds) if kinds else list(KINDS)
+        unknown = [k for k in kinds if k not in KINDS]
+        if unknown:
+            raise ValueError(f"Unknown symbol kinds: {unknown} (expected {list(KINDS)})")
+        
+        with self._lock:
+            entries = list(self._by_hash.values())
+            pending = sorted(
+                s.session_id for s in self._sessions.values()
+                if s.session_id in self._due or self._key(s) not in self._by_hash
+            )
+        
+        matches = []
+        truncated = False
+        for entry in entries:
+            if entry.session_id is None and not include_closed:
+                continue
+            for kind in kinds:
+                table = entry.tables.get(kind)
+                if table is None:
+                    continue
+                if name is not None:
+                    indices: Iterable[int] = table.exact(name)
+                elif prefix is not None:
+                    indices = table.prefix(prefix)
+                else:
+                    indices = table.glob(pattern)
+                for i in indices:
+                    if len(matches) >= limit:
+                        truncated = True
+                        break
+                    match = {
+                        "name": table.names[i],
+                        "kind": kind,
+                        "addr": hex(table.addrs[i]),
+                        "binary": entry.binary_path,
+                        "session_id": entry.session_id,
+                    }
+                    if table.sizes[i]:
+                        match["size"] = table.sizes[i]
+                    if table.modules is not None and table.modules[i]:
+                        match["module"] = table.modules[i]
+                    matches.append(match)
+        return {
+            "matches": matches,
+            "count": len(matches),
+            "truncated": truncated,
+            "pending": pending,
+        }
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize the index for JSON serialization."""
+        with self._lock:
+            entries = list(self._by_hash.values())
+            return {
+                "binaries": len(entries),
+                "open": sum(1 for e in entries if e.session_id is not None),
+                "symbols": sum(e.symbol_count for e in entries),
+                "pending": len(self._due),
+                "errors": dict(self._errors),
+            }
+    
+    def close(self) -> None:
+        """Stop the background worker."""
+        with self._lock:
+            self._closed = True
+            self._lock.notify()
+        self._thread.join(timeout=5)
+    
+    def _run(self) -> None:
+        while True:
+            with self._lock:
+                while True:
+                    if self._closed:
+                        return
+                    now = time.monotonic()
+                    due = min(self._due.items(), key=lambda item: item[1], default=None)
+                    if due is not None and due[1] <= now:
+                        session_id = due[0]
+                        del self._due[session_id]
+                        session = self._sessions.get(session_id)
+                        break
+                    self._lock.wait(None if due is None else due[1] - now)
+            if session is not None:
+                self._index(session)
+    
+    def _index(self, session: ProxySession) -> None:
+        """Build a session's index and publish it."""
+        generation = session.generation
+        started = time.monotonic()
+        try:
+            tables = {
+                FUNCTION: SymbolTable(self._fetch_functions(session)),
+                IMPORT: SymbolTable(self._fetch_imports(session)),
+                EXPORT: SymbolTable(self._fetch_exports(session)),
+            }
+        except (RuntimeError, ValueError, KeyError, TypeError) as e:
+            logger.warning(f"Failed to index session {session.session_id}: {e}")
+            with self._lock:
+                self._errors[session.session_id] = str(e)
+            return
+        
+        key = self._key(session)
+        entry = BinaryIndex(
+            content_hash=key,
+            binary_path=session.binary_path,
+            session_id=session.session_id,
+            generation=generation,
+            tables=tables,
+            built_at=time.time(),
+        )
+        with self._lock:
+            if session.session_id not in self._sessions:
+                return  # Closed while indexing
+            self._errors.pop(session.session_id, None)
+            # The binary may have changed on disk since its last index
+            for stale in [k for k, e in self._by_hash.items() if e.session_id == session.session_id]:
+                del self._by_hash[stale]
+            self._by_hash[key] = entry
+            if session.generation != generation and session.session_id not in self._due:
+                # Changed while indexing
+                self._schedule(session.session_id, self.REFRESH_DELAY)
+        logger.info(
+            f"Indexed {entry.symbol_count} symbols of session {session.session_id} "
+            f"in {time.monotonic() - started:.2f}s"
+        )
+        for listener in self._listeners:
+            try:
+                listener(entry)
+            except Exception as e:
+                logger.warning(f"Function index listener failed: {e}")
+    
+    def _call(self, session: ProxySession, tool_name: str, arguments: Dict[str, Any]) -> Any:
+        """Call a tool on a session's process and decode its result."""
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {"name": tool_name, "arguments": arguments},
+        }
+        response = self.process_manager.forward_request(
+            session.process_port, request, timeout=self.CALL_TIMEOUT, ida_session=session.ida_session_id
+        )
+        return tool_result(tool_name, response)
+    
+    def _paginate(self, session: ProxySession, tool_name: str, make_args) -> Iterator[Dict[str, Any]]:
+        """Yield the items of a paginated tool, following next_offset."""
+        offset: Optional[int] = 0
+        while offset is not None:
+            items, next_offset = page_items(self._call(session, tool_name, make_args(offset)))
+            yield from items
+            if next_offset is None or next_offset <= offset or not items:
+                break
+            offset = next_offset
+    
+    def _fetch_functions(self, session: ProxySession) -> Iterator[Symbol]:
+        pages = self._paginate(
+            session, "list_funcs",
+            lambda offset: {"queries": {"offset": offset, "count": self.PAGE_SIZE, "filter": "*"}},
+        )
+        for func in pages:
+            if func.get("name"):
+                yield (func["name"], parse_int(func.get("addr")), parse_int(func.get("size", 0)), "")
+    
+    def _fetch_imports(self, session: ProxySession) -> Iterator[Symbol]:
+        pages = self._paginate(
+            session, "imports", lambda offset: {"offset": offset, "count": self.PAGE_SIZE}
+        )
+        for imp in pages:
+            name = imp.get("imported_name") or imp.get("name")
+            if name:
+                yield (name, parse_int(imp.get("addr")), 0, imp.get("module") or "")
+    
+    def _fetch_exports(self, session: ProxySession) -> Iterator[Symbol]:
+        items, _ = page_items(self._call(session, "entrypoints", {}))
+        for entry in items:
+            if entry.get("name"):
+                yield (entry["name"], parse_int(entry.get("addr")), parse_int(entry.get("size", 0)), "")
@@ -0,0 +1,201 @@
+"""Listening-socket and child handoff between proxy instances"""
+
+import json
+import logging
+import os
+import socket
+import struct
+import threading
+from typing import Any, Callable, Dict, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+# Sent by the successor to ask for the takeover, and to confirm it is serving
+TAKEOVER_REQUEST = b"takeover\n"
+TAKEOVER_ACK = b"ok\n"
+
+# Length prefix of the JSON session table
+_HEADER = struct.Struct("!Q")
+
+
+class HandoffError(RuntimeError):
+    """Raised when taking over from another proxy instance fails."""
+
+
+def _recv_exactly(conn: socket.socket, size: int) -> bytes:
+    """Read exactly size bytes from a stream socket."""
+    chunks = []
+    while size > 0:
+        chunk = conn.recv(min(size, 65536))
+        if not chunk:
+            raise HandoffError("Connection closed during handoff")
+        chunks.append(chunk)
+        size -= len(chunk)
+    return b"".join(chunks)
+
+
+class HandoffListener:
+    """Waits on a Unix socket for a successor proxy to take over.
+    
+    The successor is sent the listening socket's file descriptor (over
+    SCM_RIGHTS) and the session table. Both instances accept connections
+    on the shared socket until the successor confirms it is serving; then
+    on_complete is called so this instance can stop accepting, let its
+    in-flight calls finish and exit without stopping the children. If the
+    successor fails before confirming, on_abort is called and nothing else
+    changes here.
+    
+    export_state should keep the session table from changing until
+    on_complete or on_abort, or sessions opened in between are lost.
+    """
+    
+    ACK_TIMEOUT = 120
+    
+    def __init__(
+        self,
+        path: str,
+        listen_socket: socket.socket,
+        export_state: Callable[[], Dict[str, Any]],
+        on_complete: Callable[[], None],
+        on_abort: Optional[Callable[[], None]] = None,
+    ):
+        """Initialize the listener.
+        
+        Args:
+            path: Filesystem path of the Unix socket to listen on
+            listen_socket: The HTTP server's listening socket
+            export_state: Returns the session table to hand over
+            on_complete: Called once the successor has taken over
+            on_abort: Called if the handoff fails after export_state
+        """
+        self.path = path
+        self._listen_socket = listen_socket
+        self._export_state = export_state
+        self._on_complete = on_complete
+        self._on_abort = on_abort
+        self._sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._closed = threading.Event()
+    
+    def start(self) -> None:
+        """Bind the Unix socket and wait for a successor in the background."""
+        if os.path.exists(self.path):
+            # Left over by an instance that didn't exit cleanly
+            os.unlink(self.path)
+        self._sock.bind(self.path)
+        os.chmod(self.path, 0o600)
+        self._sock.listen(1)
+        threading.Thread(target=self._run, name="handoff-listener", daemon=True).start()
+        logger.info(f"Accepting takeover requests on {self.path}")
+    
+    def close(self) -> None:
+        """Stop listening and remove the Unix socket."""
+        if self._closed.is_set():
+            return
+        self._closed.set()
+        self._sock.close()
+        try:
+            os.unlink(self.path)
+        except OSError:
+            pass
+    
+    def _run(self) -> None:
+        while not self._closed.is_set():
+            try:
+                conn, _ = self._sock.accept()
+            except OSError:
+                return
+            with conn:
+                try:
+                    if self._hand_over(conn):
+                        return
+                except (OSError, HandoffError) as e:
+                    logger.warning(f"Takeover attempt failed, still serving: {e}")
+    
+    def _hand_over(self, conn: socket.socket) -> bool:
+        """Run the handoff with one successor.
+        
+        Returns:
+            True if the successor took over
+        """
+        conn.settimeout(self.ACK_TIMEOUT)
+        if _recv_exactly(conn, len(TAKEOVER_REQUEST)) != TAKEOVER_REQUEST:
+            raise HandoffError("Unexpected takeover request")
+        
+        try:
+            state = self._export_state()
+        except RuntimeError as e:
+            raise HandoffError(f"Could not export the session table: {e}")
+        try:
+            data = json.dumps(state).encode("utf-8")
+            socket.send_fds(conn, [_HEADER.pack(len(data))], [self._listen_socket.fileno()])
+            conn.sendall(data)
+            logger.info("Sent listening socket and session table to successor")
+            
+            if _recv_exactly(conn, len(TAKEOVER_ACK)) != TAKEOVER_ACK:
+                raise HandoffError("Successor did not confirm takeover")
+        except BaseException:
+            if self._on_abort is not None:
+                self._on_abort()
+            raise
+        
+        # Free the path before the successor binds its own listener
+        self.close()
+        conn.close()
+        logger.info("Successor took over")
+        self._on_complete()
+        return True
+
+
+def request_takeover(path: str, timeout: float = 60) -> Tuple[socket.socket, Dict[str, Any], socket.socket]:
+    """Ask the proxy listening on path to hand over its socket and sessions.
+    
+    Args:
+        path: Unix socket the running proxy accepts takeover requests on
+        timeout: Socket timeout for the exchange
+    
+    Returns:
+        Tuple of the inherited listening socket, the session table, and the
+        control connection to pass to confirm_takeover()
+    
+    Raises:
+        HandoffError: If the running proxy could not be reached or the
+            exchange failed
+    """
+    conn = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    conn.settimeout(timeout)
+    try:
+        conn.connect(path)
+        conn.sendall(TAKEOVER_REQUEST)
+        header, fds, _, _ = socket.recv_fds(conn, _HEADER.size, 1)
+        if not fds:
+            raise HandoffError("No listening socket received")
+        listen_socket = socket.socket(fileno=fds[0])
+        if len(header) < _HEADER.size:
+            header += _recv_exactly(conn, _HEADER.size - len(header))
+        (length,) = _HEADER.unpack(header)
+        state = json.loads(_recv_exactly(conn, length).decode("utf-8"))
+    except (OSError, ValueError) as e:
+        conn.close()
+        raise HandoffError(f"Takeover from {path} failed: {e}")
+    except HandoffError:
+        conn.close()
+        raise
+    return listen_socket, state, conn
+
+
+def confirm_takeover(conn: socket.socket) -> None:
+    """Tell the previous instance we are serving, and wait for it to let go.
+    
+    Returns once the previous instance has released the handoff socket path.
+    
+    Args:
+        conn: Control connection returned by request_takeover()
+    """
+    with conn:
+        try:
+            conn.sendall(TAKEOVER_ACK)
+            # The previous instance closes the connection after unlinking
+            while conn.recv(1):
+                pass
+        except OSError as e:
+            logger.warning(f"Lost contact with previous instance during takeover: {e}")
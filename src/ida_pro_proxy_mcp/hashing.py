@@ -0,0 +1,82 @@
+"""Content hashing of binaries for IDA Pro Proxy MCP"""
+
+import hashlib
+import mmap
+import os
+import threading
+from collections import OrderedDict
+from pathlib import Path
+from typing import Tuple
+
+# (st_dev, st_ino, st_size, st_mtime_ns): changes whenever the content may have
+FileKey = Tuple[int, int, int, int]
+
+
+def file_key(st: os.stat_result) -> FileKey:
+    """Build the cache key identifying one version of a file."""
+    return (st.st_dev, st.st_ino, st.st_size, st.st_mtime_ns)
+
+
+class FileHasher:
+    """SHA-256 of file contents, cached by file identity and version.
+    
+    A file is only read again when its device, inode, size or mtime
+    changes, so repeated opens of the same binary cost a stat() call.
+    Small files are streamed through a reusable buffer; large ones are
+    memory-mapped so the kernel pages them in without extra copies.
+    
+    Attributes:
+        max_entries: Number of file versions kept in the cache
+    """
+    
+    CHUNK_SIZE = 1024 * 1024
+    MMAP_THRESHOLD = 64 * 1024 * 1024
+    
+    def __init__(self, max_entries: int = 1024):
+        self.max_entries = max_entries
+        self._cache: "OrderedDict[FileKey, str]" = OrderedDict()
+        self._lock = threading.Lock()
+    
+    def hash_file(self, path: Path) -> str:
+        """Get the hex SHA-256 of a file's contents.
+        
+        Args:
+            path: File to hash
+        
+        Returns:
+            Hex digest
+        
+        Raises:
+            OSError: If the file can't be read
+        """
+        key = file_key(os.stat(path))
+        with self._lock:
+            digest = self._cache.get(key)
+            if digest is not None:
+                self._cache.move_to_end(key)
+                return digest
+        
+        digest = self._compute(path, key[2])
+        
+        with self._lock:
+            self._cache[key] = digest
+            while len(self._cache) > self.max_entries:
+                self._cache.popitem(last=False)
+        return digest
+    
+    def _compute(self, path: Path, size: int) -> str:
+        """Hash a file's contents, mapping it if it is large."""
+        h = hashlib.sha256()
+        with open(path, "rb") as f:
+            if size >= self.MMAP_THRESHOLD:
+                with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+                    h.update(mapped)
+            else:
+                buffer = bytearray(self.CHUNK_SIZE)
+                view = memoryview(buffer)
+                while True:
+                    n = f.readinto(buffer)
+                    if not n:
+                        break
+                    h.update(view[:n])
+        return h.hexdigest()
@@ -0,0 +1,77 @@
+"""On-disk session journal for IDA Pro Proxy MCP"""
+
+import json
+import logging
+import os
+import tempfile
+import threading
+from pathlib import Path
+from typing import Any, Dict, Optional
+
+logger = logging.getLogger(__name__)
+
+
+class SessionJournal:
+    """Durable copy of the session table, rewritten on every change.
+    
+    Each write replaces the whole file atomically (temp file, fsync,
+    rename), so a crash mid-write leaves the previous state intact. The
+    table is small, so rewriting it is cheaper than replaying an append log.
+    """
+    
+    VERSION = 1
+    
+    def __init__(self, path: str):
+        """Initialize the journal.
+        
+        Args:
+            path: Journal file location; parent directories are created
+        """
+        self.path = Path(path).expanduser().resolve()
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._lock = threading.Lock()
+    
+    def write(self, state: Dict[str, Any]) -> None:
+        """Replace the journaled state.
+        
+        Errors are logged rather than raised: losing the journal only costs
+        a warm restart, which must not fail the request that changed state.
+        
+        Args:
+            state: JSON-serializable session table
+        """
+        data = json.dumps({"version": self.VERSION, **state}, indent=2).encode("utf-8")
+        with self._lock:
+            fd, tmp_path = tempfile.mkstemp(prefix=f".{self.path.name}.", dir=self.path.parent)
+            try:
+                with os.fdopen(fd, "wb") as f:
+                    f.write(data)
+                    f.flush()
+                    os.fsync(f.fileno())
+                os.replace(tmp_path, self.path)
+            except OSError as e:
+                logger.warning(f"Failed to write session journal {self.path}: {e}")
+                try:
+                    os.unlink(tmp_path)
+                except OSError:
+                    pass
+    
+    def read(self) -> Optional[Dict[str, Any]]:
+        """Read the journaled state.
+        
+        Returns:
+            The state, or None if there is no usable journal
+        """
+        try:
+            with open(self.path, "r", encoding="utf-8") as f:
+                state = json.load(f)
+        except FileNotFoundError:
+            return None
+        except (OSError, json.JSONDecodeError) as e:
+            logger.warning(f"Ignoring unreadable session journal {self.path}: {e}")
+            return None
+        
+        if not isinstance(state, dict) or state.get("version") != self.VERSION:
+            logger.warning(f"Ignoring session journal {self.path} with unknown format")
+            return None
+        return state
@@ -0,0 +1,185 @@
+"""Memory sampling and prediction for IDA Pro Proxy MCP"""
+
+import os
+import threading
+import time
+from dataclasses import dataclass
+from typing import Any, Dict, List, Optional
+
+MIB = 1024 * 1024
+
+
+@dataclass
+class MemoryUsage:
+    """Memory used by a child process and its descendants.
+    
+    Attributes:
+        rss: Resident set size in bytes
+        pss: Proportional set size in bytes (shared pages split between the
+            processes sharing them); equal to rss where PSS is unavailable
+        sampled_at: time.monotonic() of the sample
+    """
+    rss: int
+    pss: int
+    sampled_at: float
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Convert to dictionary format for JSON serialization."""
+        return {"rss_mb": round(self.rss / MIB, 1), "pss_mb": round(self.pss / MIB, 1)}
+
+
+def process_tree(pid: int) -> List[int]:
+    """A process and all its descendants, from /proc.
+    
+    Children of ``uv run`` wrappers are where IDA actually runs, so the
+    whole tree is what a child costs.
+    """
+    tree = [pid]
+    i = 0
+    while i < len(tree):
+        tree.extend(_children(tree[i]))
+        i += 1
+    return tree
+
+
+def _children(pid: int) -> List[int]:
+    children = []
+    try:
+        tasks = os.listdir(f"/proc/{pid}/task")
+    except OSError:
+        return children
+    for tid in tasks:
+        try:
+            with open(f"/proc/{pid}/task/{tid}/children") as f:
+                children.extend(int(c) for c in f.read().split())
+        except FileNotFoundError:
+            # Kernels without CONFIG_PROC_CHILDREN
+            return _children_from_stat(pid)
+        except (OSError, ValueError):
+            continue
+    return children
+
+
+def _children_from_stat(pid: int) -> List[int]:
+    children = []
+    for entry in os.listdir("/proc"):
+        if not entry.isdigit():
+            continue
+        try:
+            with open(f"/proc/{entry}/stat") as f:
+                # The command name may contain spaces; fields after it don't
+                stat = f.read().rsplit(")", 1)[1].split()
+            if int(stat[1]) == pid:
+                children.append(int(entry))
+        except (OSError, IndexError, ValueError):
+            continue
+    return children
+
+
+def _read_kb_fields(path: str, names: tuple) -> Dict[str, int]:
+    """Read "Name: <n> kB" fields of a /proc file, in bytes."""
+    values = {}
+    with open(path) as f:
+        for line in f:
+            name, _, rest = line.partition(":")
+            if name in names:
+                values[name] = int(rest.split()[0]) * 1024
+    return values
+
+
+def read_memory(pid: int) -> Optional[MemoryUsage]:
+    """Sample the memory of a process tree from /proc.
+    
+    Returns:
+        MemoryUsage, or None where /proc is unavailable or the process is gone
+    """
+    rss = pss = 0
+    found = False
+    for member in process_tree(pid):
+        try:
+            fields = _read_kb_fields(f"/proc/{member}/smaps_rollup", ("Rss", "Pss"))
+        except OSError:
+            try:
+                fields = _read_kb_fields(f"/proc/{member}/status", ("VmRSS",))
+            except OSError:
+                continue
+            fields = {"Rss": fields.get("VmRSS", 0)}
+        found = True
+        rss += fields.get("Rss", 0)
+        pss += fields.get("Pss", fields.get("Rss", 0))
+    return MemoryUsage(rss, pss, time.monotonic()) if found else None
+
+
+def mem_available() -> Optional[int]:
+    """Host memory available for new allocations (MemAvailable), in bytes.
+    
+    Returns:
+        Bytes available, or None where /proc/meminfo is unavailable
+    """
+    try:
+        return _read_kb_fields("/proc/meminfo", ("MemAvailable",)).get("MemAvailable")
+    except (OSError, ValueError):
+        return None
+
+
+class MemoryPredictor:
+    """Predicts the memory a binary takes once opened in IDA.
+    
+    IDA's memory grows with the size of the binary, so the prediction is
+    the file size times a ratio learned from the sessions opened so far
+    (an exponential moving average, starting from INITIAL_RATIO). A fresh
+    process's own footprint is learned the same way.
+    """
+    
+    # Bytes of memory per byte of binary before anything was observed, and
+    # the range the learned ratio is kept in
+    INITIAL_RATIO = 12.0
+    MIN_RATIO = 2.0
+    MAX_RATIO = 100.0
+    # Binaries below this size are mostly fixed overhead and teach nothing
+    MIN_OBSERVED_SIZE = 1 * MIB
+    # Smallest prediction for a binary; IDA's database overhead dominates small files
+    MIN_BINARY = 64 * MIB
+    # Footprint of an idle process before one was observed
+    INITIAL_PROCESS = 256 * MIB
+    # Weight of a new observation in the moving averages
+    WEIGHT = 0.3
+    
+    def __init__(self):
+        self.ratio = self.INITIAL_RATIO
+        self.process = float(self.INITIAL_PROCESS)
+        self.observations = 0
+        self._lock = threading.Lock()
+    
+    def predict(self, size: int) -> int:
+        """Memory an open of a binary of size bytes is expected to take."""
+        with self._lock:
+            return max(int(size * self.ratio), self.MIN_BINARY)
+    
+    def process_footprint(self) -> int:
+        """Memory a freshly started process is expected to take."""
+        with self._lock:
+            return int(self.process)
+    
+    def observe(self, size: int, used: int) -> None:
+        """Learn from the memory an open of a binary of size bytes took."""
+        if size < self.MIN_OBSERVED_SIZE:
+            return
+        ratio = min(max(used / size, self.MIN_RATIO), self.MAX_RATIO)
+        with self._lock:
+            self.ratio += self.WEIGHT * (ratio - self.ratio)
+            self.observations += 1
+    
+    def observe_process(self, used: int) -> None:
+        """Learn from the footprint of a freshly started process."""
+        with self._lock:
+            self.process += self.WEIGHT * (used - self.process)
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Convert to dictionary format for JSON serialization."""
+        with self._lock:
+            return {
+                "ratio": round(self.ratio, 2),
+                "process_mb": round(self.process / MIB, 1),
+                "observations": self.observations,
+            }
@@ -0,0 +1,113 @@
+"""Runtime metrics for IDA Pro Proxy MCP"""
+
+import threading
+from collections import deque
+from typing import Any, Callable, Deque, Dict, Optional
+
+
+class LatencyTracker:
+    """Keeps a sliding window of call latencies per tool.
+    
+    Attributes:
+        window: Number of most recent samples kept per tool
+    """
+    
+    def __init__(self, window: int = 200):
+        self.window = window
+        self._samples: Dict[str, Deque[float]] = {}
+        self._lock = threading.Lock()
+    
+    def observe(self, tool_name: str, seconds: float) -> None:
+        """Record the latency of a completed call."""
+        with self._lock:
+            samples = self._samples.get(tool_name)
+            if samples is None:
+                samples = deque(maxlen=self.window)
+                self._samples[tool_name] = samples
+            samples.append(seconds)
+    
+    def percentile(self, tool_name: str, pct: float, min_samples: int = 1) -> Optional[float]:
+        """Get a latency percentile for a tool.
+        
+        Args:
+            tool_name: Tool to look up
+            pct: Percentile between 0 and 100
+            min_samples: Minimum number of samples needed for an answer
+        
+        Returns:
+            Latency in seconds, or None if there are too few samples
+        """
+        with self._lock:
+            samples = self._samples.get(tool_name)
+            if samples is None or len(samples) < min_samples:
+                return None
+            ordered = sorted(samples)
+        index = min(int(len(ordered) * pct / 100), len(ordered) - 1)
+        return ordered[index]
+    
+    def to_dict(self) -> Dict[str, Dict[str, float]]:
+        """Summarize the tracked latencies for JSON serialization."""
+        with self._lock:
+            tools = list(self._samples)
+        summary = {}
+        for tool_name in tools:
+            summary[tool_name] = {
+                "p50": self.percentile(tool_name, 50),
+                "p95": self.percentile(tool_name, 95),
+                "p99": self.percentile(tool_name, 99),
+            }
+        return summary
+
+
+class Metrics:
+    """Thread-safe counters, latency percentiles and derived gauges.
+    
+    Components increment named counters; collectors registered with
+    add_collector() contribute values computed at snapshot time.
+    """
+    
+    def __init__(self):
+        self.latency = LatencyTracker()
+        self.recovery = LatencyTracker()  # Time to restore a session after a crash
+        self._counters: Dict[str, int] = {}
+        self._collectors: Dict[str, Callable[[], Any]] = {}
+        self._lock = threading.Lock()
+    
+    def increment(self, name: str, value: int = 1) -> None:
+        """Increment a counter."""
+        with self._lock:
+            self._counters[name] = self._counters.get(name, 0) + value
+    
+    def get(self, name: str) -> int:
+        """Get the current value of a counter."""
+        with self._lock:
+            return self._counters.get(name, 0)
+    
+    def add_collector(self, name: str, collector: Callable[[], Any]) -> None:
+        """Register a callable whose result is included in snapshots under name."""
+        with self._lock:
+            self._collectors[name] = collector
+    
+    def snapshot(self) -> Dict[str, Any]:
+        """Get all metrics as a dictionary for JSON serialization."""
+        with self._lock:
+            counters = dict(self._counters)
+            collectors = dict(self._collectors)
+        
+        hedge_eligible = counters.get("hedge_eligible", 0)
+        hedges_sent = counters.get("hedges_sent", 0)
+        snapshot: Dict[str, Any] = {
+            "counters": counters,
+            "latency": self.latency.to_dict(),
+            "recovery": self.recovery.to_dict(),
+            "hedging": {
+                "hedge_rate": hedges_sent / hedge_eligible if hedge_eligible else 0.0,
+                "win_rate": counters.get("hedge_wins", 0) / hedges_sent if hedges_sent else 0.0,
+            },
+        }
+        for name, collector in collectors.items():
+            try:
+                snapshot[name] = collector()
+            except Exception as e:
+                snapshot[name] = {"error": str(e)}
+        return snapshot
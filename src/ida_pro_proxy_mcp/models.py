@@ -1,12 +1,53 @@
 """Core data models for IDA Pro Proxy MCP"""
 
 import os
+import platform
 import signal
 import subprocess
+import time
 from dataclasses import dataclass, field
 from datetime import datetime
 from pathlib import Path
-from typing import Any, Dict, Optional
+from typing import Any, Dict, List, Optional
+
+from .memory import MIB, MemoryUsage
+from .placement import Placement
+
+
+def pid_alive(pid: int) -> bool:
+    """Check whether a process exists without holding a handle to it.
+    
+    Always True on Windows, where os.kill() would terminate the process.
+    """
+    if pid <= 0:
+        return False
+    if platform.system() == "Windows":
+        return True
+    try:
+        os.kill(pid, 0)
+    except ProcessLookupError:
+        return False
+    except PermissionError:
+        return True
+    return True
+
+
+@dataclass
+class ReplicaInfo:
+    """An extra process serving a read-only copy of a session's binary.
+    
+    Attributes:
+        port: Port of the replica's idalib-mcp process
+        ida_session_id: Session ID returned by the replica's idalib-mcp
+        work_dir: Private directory holding the replica's copy of the binary
+            and database, so it doesn't contend for the primary's database lock
+        generation: Session generation the replica's copy of the database
+            reflects; a replica behind its session may give stale answers
+    """
+    port: int
+    ida_session_id: str
+    work_dir: str
+    generation: int = 0
 
 
 @dataclass
@@ -22,6 +63,27 @@ class ProxySession:
         created_at: Session creation timestamp
         last_accessed: Last access timestamp (for LRU tracking)
         is_current: Whether this is the current active session
+        run_auto_analysis: Whether the binary was opened with auto-analysis
+        restoring: Whether the session is being moved to a replacement process
+        replicas: Extra processes that can serve read-only calls (for hedging)
+        content_hash: SHA-256 of the binary's content when it was opened
+        aliases: Other paths with the same content that map to this session
+        generation: Bumped whenever the session's database may have changed;
+            cached results of older generations are stale
+        summary: Overview of the binary gathered when it was opened, if any
+        memory: Bytes of its process's memory attributed to the session
+            (measured growth at open, or the prediction where unmeasured)
+        session_class: "interactive" for sessions agents work in, or
+            "background" for sweeps and batch jobs, which get lower cgroup
+            weights and are evicted first
+        migrating: Whether the session is being moved to another process
+            while its current one keeps serving
+        work_dir: Private directory holding the copy of the binary and
+            database the session runs on since it was migrated, if it was
+        calls: Times the session was used, for spotting busy sessions
+        tier: "hot" while open in a process, "warm" once evicted with its
+            cached results and summary kept, "cold" once only its content
+            hash is
     """
     session_id: str
     binary_path: str
@@ -31,6 +93,19 @@ class ProxySession:
     created_at: datetime = field(default_factory=datetime.now)
     last_accessed: datetime = field(default_factory=datetime.now)
     is_current: bool = False
+    run_auto_analysis: bool = True
+    restoring: bool = False
+    replicas: List[ReplicaInfo] = field(default_factory=list)
+    content_hash: Optional[str] = None
+    aliases: List[str] = field(default_factory=list)
+    generation: int = 0
+    summary: Optional[Dict[str, Any]] = None
+    memory: int = 0
+    session_class: str = "interactive"
+    migrating: bool = False
+    work_dir: Optional[str] = None
+    calls: int = 0
+    tier: str = "hot"
     
     @classmethod
     def create(cls, binary_path: str, process_port: int, ida_session_id: str) -> "ProxySession":
@@ -40,7 +115,7 @@ class ProxySession:
             binary_path: Path to the binary file
             process_port: Port of the idalib-mcp process
             ida_session_id: Session ID returned by idalib-mcp
-            
+        
         Returns:
             New ProxySession instance
         """
@@ -57,8 +132,9 @@ class ProxySession:
         )
     
     def touch(self) -> None:
-        """Update last_accessed timestamp."""
+        """Update last_accessed timestamp and count the use."""
         self.last_accessed = datetime.now()
+        self.calls += 1
     
     def to_dict(self) -> Dict[str, Any]:
         """Convert session to dictionary format for JSON serialization."""
@@ -69,6 +145,15 @@ class ProxySession:
             "created_at": self.created_at.isoformat(),
             "last_accessed": self.last_accessed.isoformat(),
             "is_current": self.is_current,
+            "restoring": self.restoring,
+            "migrating": self.migrating,
+            "tier": self.tier,
+            "replica_count": len(self.replicas),
+            "content_hash": self.content_hash,
+            "aliases": list(self.aliases),
+            "generation": self.generation,
+            "memory_mb": round(self.memory / MIB, 1),
+            "session_class": self.session_class,
         }
 
 
@@ -79,10 +164,15 @@ class ProcessInfo:
     Attributes:
         port: Port the process is listening on
         pid: Process ID
-        process: Subprocess object for the running process (None for external processes)
+        process: Subprocess object for the running process (None for external
+            and adopted processes)
         binary_path: Path to the binary file loaded in this process
         started_at: Process start timestamp
-        current_ida_session: Current IDA session ID in this process
+        current_ida_session: IDA session whose database is active in this
+            process, or None if unknown (e.g. right after an open)
+        ida_sessions: IDA sessions open in this process
+        memory: Latest memory sample of the process tree, if any
+        placement: CPUs and NUMA node the process is pinned to, if any
     """
     port: int
     pid: int
@@ -90,7 +180,11 @@ class ProcessInfo:
     binary_path: str
     started_at: datetime = field(default_factory=datetime.now)
     current_ida_session: Optional[str] = None
+    ida_sessions: List[str] = field(default_factory=list)
+    memory: Optional[MemoryUsage] = None
+    placement: Optional[Placement] = None
     _external: bool = field(default=False, repr=False)  # True if external process
+    _adopted: bool = field(default=False, repr=False)  # True if reattached after a proxy restart
     
     def is_alive(self) -> bool:
         """Check if the process is still running."""
@@ -98,6 +192,9 @@ class ProcessInfo:
             # For external processes, we can't check directly
             # Assume alive (health check will verify)
             return True
+        if self._adopted:
+            # Started by a previous proxy instance, so only the PID is known
+            return pid_alive(self.pid)
         if self.process is None:
             return False
         return self.process.poll() is None
@@ -110,6 +207,9 @@ class ProcessInfo:
         if self._external:
             # Don't terminate external processes
             return
+        if self._adopted:
+            self._terminate_adopted()
+            return
         if self.process is None or not self.is_alive():
             return
         
@@ -154,7 +254,7 @@ class ProcessInfo:
                         except (ProcessLookupError, OSError):
                             pass
                     self.process.wait()
-                
+        
         except (ProcessLookupError, OSError):
             # Process already terminated
             try:
@@ -162,12 +262,35 @@ class ProcessInfo:
             except Exception:
                 pass
     
+    def _terminate_adopted(self) -> None:
+        """Terminate an adopted process, which can't be waited on."""
+        if not pid_alive(self.pid):
+            return
+        pids = [self.pid] + self._get_child_pids(self.pid)
+        for pid in pids:
+            try:
+                os.kill(pid, signal.SIGTERM)
+            except (ProcessLookupError, OSError):
+                pass
+        
+        deadline = time.monotonic() + 5
+        while time.monotonic() < deadline and pid_alive(self.pid):
+            time.sleep(0.1)
+        
+        if pid_alive(self.pid):
+            # Force kill if not terminated
+            for pid in pids:
+                try:
+                    os.kill(pid, getattr(signal, "SIGKILL", signal.SIGTERM))
+                except (ProcessLookupError, OSError):
+                    pass
+    
     def _get_child_pids(self, parent_pid: int) -> list:
         """Get all child PIDs of a process by reading /proc.
         
         Args:
             parent_pid: Parent process ID
-            
+        
         Returns:
             List of child PIDs
         """
@@ -191,6 +314,26 @@ class ProcessInfo:
         return child_pids
 
 
+@dataclass
+class InFlightCall:
+    """A request currently being processed by a child process.
+    
+    Attributes:
+        child_id: JSON-RPC ID the request was sent to the child with
+        method: JSON-RPC method of the request
+        tool_name: Tool name for tools/call requests
+        process: Process the request was sent to
+        started_at: Monotonic time the request was sent
+        abandoned: Whether the requester went away and the call was cancelled
+    """
+    child_id: int
+    method: str
+    tool_name: Optional[str]
+    process: Optional[ProcessInfo]
+    started_at: float
+    abandoned: bool = False
+
+
 @dataclass
 class ProxyConfig:
     """Configuration for the proxy server.
@@ -201,12 +344,116 @@ class ProxyConfig:
         max_processes: Maximum number of concurrent idalib-mcp processes
         base_port: Starting port for idalib-mcp processes
         request_timeout: Timeout for requests to child processes (seconds)
+        breaker_failure_threshold: Consecutive errors that open a process breaker
+        breaker_timeout_threshold: Consecutive timeouts that open a process breaker
+        breaker_reset_timeout: Seconds a breaker stays open before probing
+        breaker_probe_timeout: Timeout cap for the half-open probe (seconds)
+        cancel_grace: Time a cancelled call may take to drain before its
+            process is restarted (seconds)
+        hedging: Send duplicate read-only calls to session replicas when the
+            primary is slower than the tool's hedge_percentile latency
+        hedge_percentile: Observed latency percentile that triggers a hedge
+        hedge_min_samples: Calls of a tool to observe before hedging it
+        journal_path: File the session table is journaled to. When set, a
+            restarted proxy reattaches to the children listed there, and
+            children are left running when the proxy exits
+        handoff_socket: Unix socket on which a newer proxy instance can take
+            over the listening socket, sessions and children
+        drain_grace: Time in-flight calls get to finish when draining (seconds)
+        admin_endpoints: Serve /admin/drain and /admin/status, to loopback
+            clients only
+        result_cache_size: Read-only tool results to cache (0 disables caching)
+        watch_binaries: Watch open binaries and databases for changes (Linux)
+        reopen_on_change: Reopen a session in the background when its binary
+            or database changes on disk
+        function_index: Index the functions, imports and exports of every
+            opened binary for idalib_lookup
+        similarity_workers: Processes fingerprinting functions for
+            idalib_similar (0 for one per CPU)
+        elf_cache_size: Parsed ELF files kept for the elf_* tools
+        scan_workers: Processes scanning files for idalib_scan (0 for one
+            per CPU)
+        open_summary: Gather a summary of each binary right after opening
+            it, returned by idalib_open and session_summary
+        warm_cache: Decompile functions of the current session into the
+            result cache while its process is idle
+        warm_limit: Functions decompiled per session generation when warming
+        prefetch_depth: Call-graph distance around a decompiled function
+            whose callees and callers are decompiled ahead (0 disables)
+        memory_budget_mb: Memory (PSS) the child processes may use in total;
+            opens evict LRU sessions or are refused beyond it (0 for no budget)
+        memory_reserve_mb: Host memory (MemAvailable) to leave free when
+            admitting opens (0 to ignore the host's memory)
+        cgroups: Place each child in its own cgroup v2 leaf with weights and
+            memory limits from its session class, where delegation allows
+        cgroup_root: Delegated cgroup to create the children's cgroups in
+            (default: the proxy's own cgroup)
+        cgroup_memory_max_mb: memory.max of each child's cgroup (0 for no
+            limit); memory.high is derived from it per session class
+        cpu_affinity: Pin each child to its own core set within one NUMA
+            node, and the proxy's threads to a separate set
+        cores_per_child: CPUs per child (0 to share them out evenly)
+        proxy_cores: CPUs kept for the proxy's threads (0 to share all)
+        numa_membind: Bind each child's memory to its node with numactl
+        pack_binary_mb: Binaries up to this size share processes with other
+            small binaries (0 gives every binary its own process)
+        pack_max_sessions: Most sessions one shared process hosts
+        pack_memory_mb: Predicted memory of the sessions of one shared
+            process (0 for no bound)
+        pack_max_load: Queued calls plus sessions used in the last minute at
+            which a shared process takes no more binaries
+        rebalance_interval: Seconds between checks for a shared process
+            running deeper queues than the rest (0 disables rebalancing)
+        rebalance_queue_depth: Smoothed queue depth above the least loaded
+            process at which a session is moved off a shared one
+        warm_sessions: Evicted sessions kept warm, with their database saved
+            and their cached results and summary still served (0 forgets
+            evicted sessions)
     """
     host: str = "127.0.0.1"
     port: int = 8744
     max_processes: int = 2
     base_port: int = 8745
     request_timeout: int = 300
+    breaker_failure_threshold: int = 3
+    breaker_timeout_threshold: int = 1
+    breaker_reset_timeout: int = 30
+    breaker_probe_timeout: int = 30
+    cancel_grace: int = 30
+    hedging: bool = False
+    hedge_percentile: float = 95.0
+    hedge_min_samples: int = 20
+    journal_path: Optional[str] = None
+    handoff_socket: Optional[str] = None
+    drain_grace: int = 60
+    admin_endpoints: bool = False
+    result_cache_size: int = 4096
+    watch_binaries: bool = True
+    reopen_on_change: bool = False
+    function_index: bool = True
+    similarity_workers: int = 0
+    elf_cache_size: int = 32
+    scan_workers: int = 0
+    open_summary: bool = True
+    warm_cache: bool = False
+    warm_limit: int = 200
+    prefetch_depth: int = 1
+    memory_budget_mb: int = 0
+    memory_reserve_mb: int = 0
+    cgroups: bool = False
+    cgroup_root: Optional[str] = None
+    cgroup_memory_max_mb: int = 0
+    cpu_affinity: bool = False
+    cores_per_child: int = 0
+    proxy_cores: int = 1
+    numa_membind: bool = False
+    pack_binary_mb: int = 0
+    pack_max_sessions: int = 4
+    pack_memory_mb: int = 1024
+    pack_max_load: int = 2
+    rebalance_interval: float = 0
+    rebalance_queue_depth: float = 2.0
+    warm_sessions: int = 0
     
     def validate(self) -> None:
         """Validate configuration values.
@@ -222,3 +469,57 @@ class ProxyConfig:
             raise ValueError("base_port must be between 1 and 65535")
         if self.request_timeout < 1:
             raise ValueError("request_timeout must be at least 1 second")
+        if self.breaker_failure_threshold < 1:
+            raise ValueError("breaker_failure_threshold must be at least 1")
+        if self.breaker_timeout_threshold < 1:
+            raise ValueError("breaker_timeout_threshold must be at least 1")
+        if self.breaker_reset_timeout < 0:
+            raise ValueError("breaker_reset_timeout must not be negative")
+        if self.breaker_probe_timeout < 1:
+            raise ValueError("breaker_probe_timeout must be at least 1 second")
+        if self.cancel_grace < 1:
+            raise ValueError("cancel_grace must be at least 1 second")
+        if not 0 < self.hedge_percentile < 100:
+            raise ValueError("hedge_percentile must be between 0 and 100")
+        if self.hedge_min_samples < 1:
+            raise ValueError("hedge_min_samples must be at least 1")
+        if self.drain_grace < 0:
+            raise ValueError("drain_grace must not be negative")
+        if self.result_cache_size < 0:
+            raise ValueError("result_cache_size must not be negative")
+        if self.similarity_workers < 0:
+            raise ValueError("similarity_workers must not be negative")
+        if self.elf_cache_size < 0:
+            raise ValueError("elf_cache_size must not be negative")
+        if self.scan_workers < 0:
+            raise ValueError("scan_workers must not be negative")
+        if self.warm_limit < 0:
+            raise ValueError("warm_limit must not be negative")
+        if self.prefetch_depth < 0:
+            raise ValueError("prefetch_depth must not be negative")
+        if self.memory_budget_mb < 0:
+            raise ValueError("memory_budget_mb must not be negative")
+        if self.memory_reserve_mb < 0:
+            raise ValueError("memory_reserve_mb must not be negative")
+        if self.cgroup_memory_max_mb < 0:
+            raise ValueError("cgroup_memory_max_mb must not be negative")
+        if self.cores_per_child < 0:
+            raise ValueError("cores_per_child must not be negative")
+        if self.proxy_cores < 0:
+            raise ValueError("proxy_cores must not be negative")
+        if self.pack_binary_mb < 0:
+            raise ValueError("pack_binary_mb must not be negative")
+        if self.pack_max_sessions < 1:
+            raise ValueError("pack_max_sessions must be at least 1")
+        if self.pack_memory_mb < 0:
+            raise ValueError("pack_memory_mb must not be negative")
+        if self.pack_max_load < 1:
+            raise ValueError("pack_max_load must be at least 1")
+        if self.rebalance_interval < 0:
+            raise ValueError("rebalance_interval must not be negative")
+        if self.rebalance_queue_depth <= 0:
+            raise ValueError("rebalance_queue_depth must be positive")
+        if self.warm_sessions < 0:
+            raise ValueError("warm_sessions must not be negative")
+        if self.handoff_socket and os.name == "nt":
+            raise ValueError("handoff_socket requires a Unix platform")
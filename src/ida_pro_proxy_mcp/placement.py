@@ -0,0 +1,257 @@
+"""CPU and NUMA placement of child processes for IDA Pro Proxy MCP"""
+
+import logging
+import os
+import shutil
+import threading
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+from .memory import process_tree
+
+logger = logging.getLogger(__name__)
+
+# Where the kernel describes NUMA nodes
+NODE_ROOT = Path("/sys/devices/system/node")
+
+
+def parse_cpulist(text: str) -> List[int]:
+    """Parse a kernel CPU list like "0-3,8-11"."""
+    cpus = []
+    for part in text.strip().split(","):
+        if not part:
+            continue
+        first, _, last = part.partition("-")
+        cpus.extend(range(int(first), int(last or first) + 1))
+    return cpus
+
+
+def format_cpulist(cpus: List[int]) -> str:
+    """Format CPUs as a kernel CPU list like "0-3,8-11"."""
+    ranges = []
+    for cpu in sorted(cpus):
+        if ranges and cpu == ranges[-1][1] + 1:
+            ranges[-1][1] = cpu
+        else:
+            ranges.append([cpu, cpu])
+    return ",".join(str(a) if a == b else f"{a}-{b}" for a, b in ranges)
+
+
+def read_nodes(allowed: List[int]) -> Dict[int, List[int]]:
+    """The allowed CPUs of each NUMA node; one node without NUMA information."""
+    nodes = {}
+    try:
+        for path in sorted(NODE_ROOT.glob("node[0-9]*")):
+            cpus = [c for c in parse_cpulist((path / "cpulist").read_text()) if c in allowed]
+            if cpus:
+                nodes[int(path.name[4:])] = cpus
+    except (OSError, ValueError):
+        nodes = {}
+    return nodes or {0: sorted(allowed)}
+
+
+@dataclass
+class Placement:
+    """CPUs (and NUMA node) a child process is pinned to.
+    
+    Attributes:
+        cpus: CPUs the child may run on
+        node: NUMA node the CPUs belong to
+        membind: Whether the child's memory is bound to the node
+    """
+    cpus: List[int]
+    node: int
+    membind: bool = False
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Convert to dictionary format for JSON serialization."""
+        return {"cpus": format_cpulist(self.cpus), "numa_node": self.node, "membind": self.membind}
+
+
+@dataclass
+class _Slot:
+    cpus: List[int]
+    node: int
+    ports: List[int] = field(default_factory=list)
+
+
+class PlacementPolicy:
+    """Pins each child process to a core set within one NUMA node.
+    
+    The allowed CPUs, less a few kept for the proxy's own threads, are cut
+    into per-child slots that never cross a node, so a child's threads and
+    (by first touch, or bound with numactl) its memory stay on one node.
+    A new child takes the slot with the fewest children, then the least
+    busy CPUs since the last placement, which spreads children across
+    nodes first. Where CPU affinity isn't supported, placement is off.
+    
+    Attributes:
+        available: Whether children are being pinned
+        reason: Why placement is off, if it is
+        proxy_cpus: CPUs the proxy's threads are kept on
+    """
+    
+    def __init__(
+        self,
+        max_children: int,
+        cores_per_child: int = 0,
+        proxy_cores: int = 1,
+        membind: bool = False,
+    ):
+        """Initialize the policy from the CPUs this process may use.
+        
+        Args:
+            max_children: Children expected at once, to size the slots
+            cores_per_child: CPUs per child (0 to share them out evenly)
+            proxy_cores: CPUs kept for the proxy's threads (0 to share all)
+            membind: Bind each child's memory to its node with numactl
+        """
+        self.available = False
+        self.reason: Optional[str] = None
+        self.proxy_cpus: List[int] = []
+        self.membind = False
+        self._slots: List[_Slot] = []
+        self._placements: Dict[int, Tuple[_Slot, Placement]] = {}  # port -> slot, placement
+        self._busy: Dict[int, Tuple[int, int]] = {}  # cpu -> busy, total jiffies at the last placement
+        self._lock = threading.Lock()
+        if not hasattr(os, "sched_setaffinity"):
+            self.reason = "CPU affinity is not supported on this platform"
+            logger.info(f"Child placement unavailable: {self.reason}")
+            return
+        
+        allowed = sorted(os.sched_getaffinity(0))
+        nodes = read_nodes(allowed)
+        # The proxy keeps the first CPUs of the first node, if enough are left
+        if 0 < proxy_cores < len(allowed):
+            first = nodes[min(nodes)]
+            self.proxy_cpus = first[:min(proxy_cores, len(first) - 1)]
+        spare = {node: [c for c in cpus if c not in self.proxy_cpus] for node, cpus in nodes.items()}
+        total = sum(len(cpus) for cpus in spare.values())
+        size = cores_per_child or max(1, total // max(max_children, 1))
+        for node, cpus in sorted(spare.items()):
+            chunk = min(size, len(cpus))
+            count = max(len(cpus) // chunk, 1)
+            for i in range(count):
+                # The last slot of a node takes its leftover CPUs
+                end = len(cpus) if i == count - 1 else (i + 1) * chunk
+                self._slots.append(_Slot(cpus[i * chunk:end], node))
+        if membind and len(nodes) > 1:
+            self.membind = shutil.which("numactl") is not None
+            if not self.membind:
+                logger.info("numactl not found; child memory follows first touch instead of being bound")
+        self.available = True
+        logger.info(
+            f"Placing children on {len(self._slots)} core sets across {len(nodes)} NUMA node(s)"
+            + (f", proxy on CPUs {format_cpulist(self.proxy_cpus)}" if self.proxy_cpus else "")
+        )
+    
+    def pin_proxy(self) -> None:
+        """Keep the proxy's threads, including those already running, on proxy_cpus."""
+        if not self.available or not self.proxy_cpus:
+            return
+        self._set_affinity(os.getpid(), self.proxy_cpus)
+    
+    def place(self, port: int) -> Optional[Placement]:
+        """Choose the CPUs for a new child.
+        
+        Args:
+            port: Port of the child
+        
+        Returns:
+            Placement, or None if placement is off
+        """
+        if not self.available:
+            return None
+        busy = self._cpu_busy()
+        with self._lock:
+            if port in self._placements:
+                return self._placements[port][1]
+            slot = min(
+                self._slots,
+                key=lambda s: (len(s.ports), sum(busy.get(c, 0.0) for c in s.cpus) / len(s.cpus)),
+            )
+            slot.ports.append(port)
+            placement = Placement(list(slot.cpus), slot.node, self.membind)
+            self._placements[port] = (slot, placement)
+        logger.info(f"Placing the process on port {port} on CPUs {format_cpulist(slot.cpus)} (node {slot.node})")
+        return placement
+    
+    def command_prefix(self, placement: Optional[Placement]) -> List[str]:
+        """Command prefix binding a child's memory to its node, if wanted."""
+        if placement is None or not placement.membind:
+            return []
+        return ["numactl", f"--membind={placement.node}", f"--cpunodebind={placement.node}", "--"]
+    
+    def apply(self, port: int, pid: int) -> None:
+        """Pin every thread of a child and its descendants to its CPUs.
+        
+        Safe to call again, e.g. once the child is ready, to catch
+        processes and threads it started in the meantime.
+        """
+        with self._lock:
+            entry = self._placements.get(port)
+        if entry is None:
+            return
+        for member in process_tree(pid):
+            self._set_affinity(member, entry[1].cpus)
+    
+    @staticmethod
+    def _set_affinity(pid: int, cpus: List[int]) -> None:
+        # sched_setaffinity() on a PID only moves its main thread
+        try:
+            tids = [int(t) for t in os.listdir(f"/proc/{pid}/task")]
+        except OSError:
+            tids = [pid]
+        for tid in tids:
+            try:
+                os.sched_setaffinity(tid, cpus)
+            except OSError as e:
+                logger.debug(f"Could not set the affinity of thread {tid}: {e}")
+    
+    def release(self, port: int) -> None:
+        """Free a child's slot."""
+        with self._lock:
+            entry = self._placements.pop(port, None)
+            if entry is not None:
+                entry[0].ports.remove(port)
+    
+    def placement(self, port: int) -> Optional[Placement]:
+        """Where a child is pinned, if it is."""
+        with self._lock:
+            entry = self._placements.get(port)
+            return entry[1] if entry is not None else None
+    
+    def _cpu_busy(self) -> Dict[int, float]:
+        """Busy fraction of each CPU since the previous call, from /proc/stat."""
+        busy = {}
+        try:
+            with open("/proc/stat") as f:
+                lines = [line.split() for line in f if line.startswith("cpu") and line[3].isdigit()]
+        except OSError:
+            return busy
+        with self._lock:
+            for fields in lines:
+                cpu = int(fields[0][3:])
+                times = [int(v) for v in fields[1:]]
+                # idle and iowait
+                idle = times[3] + (times[4] if len(times) > 4 else 0)
+                total = sum(times)
+                last_busy, last_total = self._busy.get(cpu, (0, 0))
+                if total > last_total:
+                    busy[cpu] = ((total - idle) - last_busy) / (total - last_total)
+                self._busy[cpu] = (total - idle, total)
+        return busy
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize the placement for JSON serialization."""
+        with self._lock:
+            return {
+                "available": self.available,
+                "reason": self.reason,
+                "proxy_cpus": format_cpulist(self.proxy_cpus),
+                "slots": [
+                    {"cpus": format_cpulist(s.cpus), "numa_node": s.node, "ports": list(s.ports)}
+                    for s in self._slots
+                ],
+            }
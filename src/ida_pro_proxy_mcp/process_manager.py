@@ -1,15 +1,23 @@
 """Process Manager for idalib-mcp child processes"""
 
+import itertools
 import json
 import http.client
 import logging
+import socket
 import subprocess
 import threading
 import time
 from datetime import datetime
-from typing import Dict, Optional, Set
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional, Set
 
-from .models import ProcessInfo
+from .cancellation import CancelToken, Deadline, DeadlineExceededError
+from .cgroups import CgroupManager, CgroupUsage
+from .circuit_breaker import CircuitBreaker, CircuitOpenError
+from .memory import MemoryUsage, read_memory
+from .models import InFlightCall, ProcessInfo, pid_alive
+from .placement import PlacementPolicy
 
 logger = logging.getLogger(__name__)
 
@@ -22,17 +30,65 @@ class ProcessManager:
     """
     
     BASE_PORT = 8745
+    # Age (seconds) up to which a memory sample is reused
+    MEMORY_MAX_AGE = 1.0
+    # Tools after which the child's active database is no longer known
+    SESSION_CHANGING_TOOLS = ("idalib_open", "idalib_close")
+    # Interval (seconds) at which a queued call checks whether the breaker opened
+    QUEUE_BREAKER_POLL = 0.2
     
-    def __init__(self, host: str = "127.0.0.1", request_timeout: int = 30):
+    def __init__(
+        self,
+        host: str = "127.0.0.1",
+        request_timeout: int = 30,
+        breaker_failure_threshold: int = 3,
+        breaker_timeout_threshold: int = 1,
+        breaker_reset_timeout: int = 30,
+        breaker_probe_timeout: int = 30,
+        cancel_grace: int = 30,
+        child_log_dir: Optional[str] = None,
+        cgroups: Optional[CgroupManager] = None,
+        placement: Optional[PlacementPolicy] = None,
+    ):
         """Initialize the process manager.
         
         Args:
             host: Host address for child processes
             request_timeout: Timeout for HTTP requests to child processes
+            breaker_failure_threshold: Consecutive errors that open a process breaker
+            breaker_timeout_threshold: Consecutive timeouts that open a process breaker
+            breaker_reset_timeout: Seconds a breaker stays open before probing
+            breaker_probe_timeout: Timeout cap for the half-open probe request
+            cancel_grace: Time a cancelled call may take to drain before the
+                process is reported as wedged
+            child_log_dir: If set, children write their output to log files
+                here and run in their own session, so they outlive the proxy
+            cgroups: Places each child in its own cgroup, if given
+            placement: Pins each child to a core set, if given
         """
         self.host = host
         self.request_timeout = request_timeout
+        self.breaker_failure_threshold = breaker_failure_threshold
+        self.breaker_timeout_threshold = breaker_timeout_threshold
+        self.breaker_reset_timeout = breaker_reset_timeout
+        self.breaker_probe_timeout = breaker_probe_timeout
+        self.cancel_grace = cancel_grace
+        self.child_log_dir = child_log_dir
+        self.cgroups = cgroups
+        self.placement = placement
+        # idalib_switch calls sent to change a child's active database
+        self.session_switches = 0
+        # Called with the port of a process whose half-open probe failed
+        self.on_wedged: Optional[Callable[[int], None]] = None
         self._processes: Dict[int, ProcessInfo] = {}  # port -> ProcessInfo
+        self._breakers: Dict[int, CircuitBreaker] = {}  # port -> CircuitBreaker
+        self._in_flight: Dict[int, Dict[int, InFlightCall]] = {}  # port -> child_id -> call
+        self._child_ids = itertools.count(1)
+        # Children run IDA calls one at a time, so calls queue here, where
+        # deadlines can still be enforced, rather than inside the child
+        self._dispatch_locks: Dict[int, threading.Lock] = {}  # port -> Lock
+        self._waiting: Dict[int, int] = {}  # port -> number of queued calls
+        self._no_batch: Set[int] = set()  # ports whose child rejected a JSON-RPC batch
         self._available_ports: Set[int] = set()
         self._next_port = self.BASE_PORT
         self._lock = threading.RLock()
@@ -43,7 +99,7 @@ class ProcessManager:
         
         Args:
             port: Port to check
-            
+        
         Returns:
             True if server is responding, False otherwise
         """
@@ -78,7 +134,7 @@ class ProcessManager:
         
         Args:
             startup_timeout: Maximum time to wait for process to be ready
-            
+        
         Returns:
             ProcessInfo for the default process
         """
@@ -124,7 +180,7 @@ class ProcessManager:
         
         Returns:
             Available port number
-            
+        
         Raises:
             RuntimeError: If no ports are available
         """
@@ -139,11 +195,15 @@ class ProcessManager:
             return port
     
     def release_port(self, port: int) -> None:
-        """Release a port for reuse.
+        """Release a port for reuse, removing the cgroup of its process.
         
         Args:
             port: Port number to release
         """
+        if self.cgroups is not None:
+            self.cgroups.remove(port)
+        if self.placement is not None:
+            self.placement.release(port)
         with self._lock:
             self._available_ports.add(port)
     
@@ -153,10 +213,10 @@ class ProcessManager:
         Args:
             binary_path: Optional path to binary file to load initially
             startup_timeout: Maximum time to wait for process to be ready (seconds)
-            
+        
         Returns:
             ProcessInfo for the started process
-            
+        
         Raises:
             RuntimeError: If process fails to start
         """
@@ -171,16 +231,42 @@ class ProcessManager:
         if binary_path:
             cmd.append(binary_path)
         
+        placement = self.placement.place(port) if self.placement is not None else None
+        if placement is not None:
+            cmd = self.placement.command_prefix(placement) + cmd
+        
         logger.info(f"Starting idalib-mcp on port {port}: {' '.join(cmd)}")
         
         # Platform-specific settings
         import platform
         is_windows = platform.system() == "Windows"
         
+        # Children that must outlive the proxy can't write to pipes it owns
+        log_path = None
+        if self.child_log_dir:
+            log_path = Path(self.child_log_dir) / f"idalib-mcp-{port}.log"
+        
         try:
             # On Windows, use CREATE_NEW_PROCESS_GROUP to allow proper termination
             # On Unix, don't use start_new_session to inherit process group
-            if is_windows:
+            if log_path is not None:
+                with open(log_path, "ab") as log_file:
+                    if is_windows:
+                        process = subprocess.Popen(
+                            cmd,
+                            stdout=log_file,
+                            stderr=subprocess.STDOUT,
+                            creationflags=0x00000200,  # CREATE_NEW_PROCESS_GROUP
+                        )
+                    else:
+                        # Own session, so a Ctrl+C aimed at the proxy spares it
+                        process = subprocess.Popen(
+                            cmd,
+                            stdout=log_file,
+                            stderr=subprocess.STDOUT,
+                            start_new_session=True,
+                        )
+            elif is_windows:
                 # Windows-specific: CREATE_NEW_PROCESS_GROUP = 0x00000200
                 process = subprocess.Popen(
                     cmd,
@@ -194,6 +280,10 @@ class ProcessManager:
                     stdout=subprocess.PIPE,
                     stderr=subprocess.PIPE,
                 )
+            if self.cgroups is not None:
+                self.cgroups.attach(port, process.pid)
+            if placement is not None:
+                self.placement.apply(port, process.pid)
             
             # Wait for process to be ready by polling the HTTP endpoint
             start_time = time.time()
@@ -210,8 +300,10 @@ class ProcessManager:
                 if process.poll() is not None:
                     stdout, stderr = process.communicate()
                     self.release_port(port)
+                    if stderr is None and log_path is not None:
+                        stderr = log_path.read_bytes()[-4096:]
                     raise RuntimeError(
-                        f"idalib-mcp process exited immediately: {stderr.decode()}"
+                        f"idalib-mcp process exited immediately: {stderr.decode(errors='replace')}"
                     )
                 
                 # Try to connect to the HTTP endpoint
@@ -254,19 +346,27 @@ class ProcessManager:
                     f"Last error: {last_error}"
                 )
             
+            # uv may have spawned idalib-mcp before the wrapper was moved or pinned
+            if self.cgroups is not None:
+                self.cgroups.attach(port, process.pid)
+            if placement is not None:
+                self.placement.apply(port, process.pid)
+            
             info = ProcessInfo(
                 port=port,
                 pid=process.pid,
                 process=process,
                 binary_path=binary_path or "",
+                placement=placement,
             )
             
             with self._lock:
                 self._processes[port] = info
+                self._breakers[port] = self._new_breaker()
             
             logger.info(f"Started idalib-mcp process (pid={process.pid}, port={port})")
             return info
-            
+        
         except FileNotFoundError as e:
             self.release_port(port)
             raise RuntimeError(f"Failed to start idalib-mcp: {e}")
@@ -281,13 +381,17 @@ class ProcessManager:
         
         Args:
             port: Port of the process to stop
-            
+        
         Returns:
             True if process was stopped, False if not found
         """
         with self._lock:
             info = self._processes.pop(port, None)
-            
+            self._breakers.pop(port, None)
+            self._in_flight.pop(port, None)
+            self._dispatch_locks.pop(port, None)
+            self._no_batch.discard(port)
+        
         if info is None:
             logger.warning(f"No process found on port {port}")
             return False
@@ -315,24 +419,177 @@ class ProcessManager:
         
         logger.info("All processes stopped")
     
+    def export_processes(self) -> List[Dict[str, Any]]:
+        """Describe the processes this proxy owns, for the session journal.
+        
+        External processes are left out; they are rediscovered on startup.
+        
+        Returns:
+            List of process dictionaries
+        """
+        with self._lock:
+            infos = [info for info in self._processes.values() if not info._external]
+            default_port = self._default_port
+        return [
+            {
+                "port": info.port,
+                "pid": info.pid,
+                "binary_path": info.binary_path,
+                "started_at": info.started_at.isoformat(),
+                "current_ida_session": info.current_ida_session,
+                "ida_sessions": list(info.ida_sessions),
+                "is_default": info.port == default_port,
+            }
+            for info in infos
+        ]
+    
+    def adopt_process(self, record: Dict[str, Any], probe: bool = True) -> Optional[ProcessInfo]:
+        """Take ownership of a child left running by a previous proxy instance.
+        
+        The process must still exist and, if probe is set, answer on its port.
+        
+        Args:
+            record: Process dictionary from export_processes()
+            probe: Whether to health check the process before adopting it
+        
+        Returns:
+            ProcessInfo for the adopted process, or None if it is gone
+        """
+        port = int(record["port"])
+        pid = int(record["pid"])
+        with self._lock:
+            # Never hand out a journaled port again, even if its process is gone
+            self._next_port = max(self._next_port, port + 1)
+            if port in self._processes:
+                return self._processes[port]
+        
+        if not pid_alive(pid) or (probe and not self.check_existing_server(port)):
+            logger.info(f"Journaled idalib-mcp process (pid={pid}, port={port}) is gone")
+            return None
+        
+        info = ProcessInfo(
+            port=port,
+            pid=pid,
+            process=None,
+            binary_path=record.get("binary_path", ""),
+            started_at=datetime.fromisoformat(record["started_at"]),
+            current_ida_session=record.get("current_ida_session"),
+            ida_sessions=list(record.get("ida_sessions", [])),
+        )
+        info._adopted = True
+        with self._lock:
+            self._processes[port] = info
+            self._breakers[port] = self._new_breaker()
+            if record.get("is_default"):
+                self._default_port = port
+        
+        if self.cgroups is not None:
+            self.cgroups.attach(port, pid)
+        if self.placement is not None:
+            info.placement = self.placement.place(port)
+            self.placement.apply(port, pid)
+        logger.info(f"Adopted running idalib-mcp process (pid={pid}, port={port})")
+        return info
+    
+    def detach_all(self) -> None:
+        """Forget all processes without terminating them.
+        
+        Used when the proxy exits but a successor will adopt the children.
+        """
+        with self._lock:
+            count = len(self._processes)
+            self._processes.clear()
+            self._breakers.clear()
+            self._default_port = None
+        logger.info(f"Detached from {count} idalib-mcp processes, leaving them running")
+    
     def get_process(self, port: int) -> Optional[ProcessInfo]:
         """Get process info by port.
         
         Args:
             port: Port number
-            
+        
         Returns:
             ProcessInfo or None if not found
         """
         with self._lock:
             return self._processes.get(port)
     
+    def sample_memory(self, port: int, max_age: Optional[float] = None) -> Optional[MemoryUsage]:
+        """Sample the RSS and PSS of a process and its descendants from /proc.
+        
+        Args:
+            port: Port of the process
+            max_age: Reuse a sample at most this old (default MEMORY_MAX_AGE;
+                0 always samples)
+        
+        Returns:
+            MemoryUsage, or None for unknown and external processes and
+            where /proc is unavailable
+        """
+        with self._lock:
+            info = self._processes.get(port)
+        if info is None or info._external:
+            return None
+        if max_age is None:
+            max_age = self.MEMORY_MAX_AGE
+        cached = info.memory
+        if cached is not None and time.monotonic() - cached.sampled_at <= max_age:
+            return cached
+        info.memory = read_memory(info.pid)
+        return info.memory
+    
+    def set_session_class(self, port: int, session_class: str) -> None:
+        """Apply the cgroup settings of a session class to a process, if it has a cgroup.
+        
+        Args:
+            port: Port of the process
+            session_class: "interactive" or "background"
+        """
+        if self.cgroups is not None:
+            self.cgroups.set_class(port, session_class)
+    
+    def record_session(self, port: int, ida_session_id: str, binary_path: str) -> None:
+        """Record that an IDA session was opened in a process.
+        
+        Args:
+            port: Port of the process
+            ida_session_id: Session ID returned by idalib_open
+            binary_path: Path of the binary opened
+        """
+        with self._lock:
+            info = self._processes.get(port)
+            if info is None:
+                return
+            if ida_session_id not in info.ida_sessions:
+                info.ida_sessions.append(ida_session_id)
+            info.binary_path = binary_path
+    
+    def forget_session(self, port: int, ida_session_id: str) -> None:
+        """Record that an IDA session was closed in a process."""
+        with self._lock:
+            info = self._processes.get(port)
+            if info is not None and ida_session_id in info.ida_sessions:
+                info.ida_sessions.remove(ida_session_id)
+    
+    def placement_of(self, port: int) -> Optional[Dict[str, Any]]:
+        """Where a process is pinned, if it is."""
+        with self._lock:
+            info = self._processes.get(port)
+        if info is None or info.placement is None:
+            return None
+        return info.placement.to_dict()
+    
+    def cgroup_usage(self, port: int) -> Optional[CgroupUsage]:
+        """Read a process's usage from its cgroup, if it has one."""
+        return self.cgroups.usage(port) if self.cgroups is not None else None
+    
     def check_process_health(self, port: int) -> bool:
         """Check if a process is healthy.
         
         Args:
             port: Port of the process to check
-            
+        
         Returns:
             True if process is alive and responding
         """
@@ -344,41 +601,558 @@ class ProcessManager:
         
         return info.is_alive()
     
-    def forward_request(self, port: int, request: dict, timeout: Optional[int] = None) -> dict:
+    def _new_breaker(self) -> CircuitBreaker:
+        """Create a circuit breaker with the configured thresholds."""
+        return CircuitBreaker(
+            failure_threshold=self.breaker_failure_threshold,
+            timeout_threshold=self.breaker_timeout_threshold,
+            reset_timeout=self.breaker_reset_timeout,
+        )
+    
+    def get_breaker(self, port: int) -> CircuitBreaker:
+        """Get the circuit breaker for a process, creating it if needed.
+        
+        Args:
+            port: Port of the process
+        
+        Returns:
+            CircuitBreaker for the process
+        """
+        with self._lock:
+            breaker = self._breakers.get(port)
+            if breaker is None:
+                breaker = self._new_breaker()
+                self._breakers[port] = breaker
+            return breaker
+    
+    def _report_wedged(self, port: int, info: Optional[ProcessInfo]) -> None:
+        """Notify the wedged-process handler, if any.
+        
+        Args:
+            port: Port of the wedged process
+            info: Process the failure was observed on; ignored if the port
+                has since been given to a different process
+        """
+        with self._lock:
+            if info is None or self._processes.get(port) is not info:
+                return
+        logger.error(f"Process on port {port} failed its recovery probe, treating as wedged")
+        if self.on_wedged is None:
+            return
+        try:
+            self.on_wedged(port)
+        except Exception as e:
+            logger.warning(f"Wedged-process handler failed for port {port}: {e}")
+    
+    def _begin_call(self, port: int, request: dict, info: Optional[ProcessInfo]) -> InFlightCall:
+        """Register a request as in flight on a process."""
+        params = request.get("params") or {}
+        call = InFlightCall(
+            child_id=next(self._child_ids),
+            method=request.get("method", "unknown"),
+            tool_name=params.get("name") if isinstance(params, dict) else None,
+            process=info,
+            started_at=time.monotonic(),
+        )
+        with self._lock:
+            self._in_flight.setdefault(port, {})[call.child_id] = call
+        return call
+    
+    def _end_call(self, port: int, call: InFlightCall) -> None:
+        """Remove a finished (or drained) request from the in-flight table."""
+        with self._lock:
+            calls = self._in_flight.get(port)
+            if calls is not None:
+                calls.pop(call.child_id, None)
+    
+    def get_in_flight(self, port: int) -> list[InFlightCall]:
+        """Get the requests currently in flight on a process.
+        
+        Args:
+            port: Port of the process
+        
+        Returns:
+            List of in-flight calls, including abandoned ones still draining
+        """
+        with self._lock:
+            return list(self._in_flight.get(port, {}).values())
+    
+    def is_draining(self, port: int) -> bool:
+        """Check whether a process is still working on abandoned calls.
+        
+        Args:
+            port: Port of the process
+        
+        Returns:
+            True if a cancelled call has not finished yet
+        """
+        return any(call.abandoned for call in self.get_in_flight(port))
+    
+    def _send_notification(self, port: int, notification: dict) -> None:
+        """Send a JSON-RPC notification to a child, ignoring failures."""
+        try:
+            conn = http.client.HTTPConnection(self.host, port, timeout=2)
+            try:
+                conn.request("POST", "/mcp", json.dumps(notification), {"Content-Type": "application/json"})
+                conn.getresponse().read()
+            finally:
+                conn.close()
+        except Exception as e:
+            logger.debug(f"Failed to send notification to port {port}: {e}")
+    
+    def cancel_request(
+        self, port: int, child_id: int, reason: str = "cancelled", escalate: bool = True
+    ) -> bool:
+        """Cancel an in-flight request on a child process.
+        
+        Sends MCP notifications/cancelled to the child. If the call has not
+        drained after cancel_grace seconds, the process is reported as wedged
+        so it can be restarted.
+        
+        Args:
+            port: Port of the process
+            child_id: Child-side JSON-RPC ID of the request
+            reason: Cancellation reason sent to the child
+            escalate: Whether to restart the process if the call never drains
+        
+        Returns:
+            True if the call was found and cancelled
+        """
+        with self._lock:
+            call = self._in_flight.get(port, {}).get(child_id)
+            if call is None or call.abandoned:
+                return False
+            call.abandoned = True
+        
+        logger.info(f"Cancelling '{call.tool_name or call.method}' (id={child_id}) on port {port}: {reason}")
+        self._send_notification(port, {
+            "jsonrpc": "2.0",
+            "method": "notifications/cancelled",
+            "params": {"requestId": child_id, "reason": reason},
+        })
+        
+        if not escalate:
+            return True
+        timer = threading.Timer(self.cancel_grace, self._escalate_cancel, args=(port, call))
+        timer.daemon = True
+        timer.start()
+        return True
+    
+    def _escalate_cancel(self, port: int, call: InFlightCall) -> None:
+        """Report a process as wedged if a cancelled call never drained."""
+        with self._lock:
+            still_running = call.child_id in self._in_flight.get(port, {})
+        if still_running:
+            logger.warning(
+                f"Cancelled call id={call.child_id} on port {port} did not drain "
+                f"within {self.cancel_grace}s, escalating to restart"
+            )
+            self._report_wedged(port, call.process)
+    
+    def _drain_in_background(
+        self, port: int, call: InFlightCall, conn: http.client.HTTPConnection, dispatch_lock: threading.Lock
+    ) -> None:
+        """Keep reading an abandoned call's response so the process is known busy until it drains.
+        
+        The dispatch lock stays held until then, so queued calls wait in the
+        proxy instead of piling up behind the abandoned call in the child.
+        """
+        def drain():
+            try:
+                conn.sock.settimeout(self.cancel_grace)
+                conn.getresponse().read()
+                logger.info(f"Abandoned call id={call.child_id} on port {port} drained")
+            except Exception:
+                pass
+            finally:
+                conn.close()
+                self._end_call(port, call)
+                dispatch_lock.release()
+        
+        threading.Thread(target=drain, name=f"drain-{port}", daemon=True).start()
+    
+    def _get_dispatch_lock(self, port: int) -> threading.Lock:
+        """Get the lock serializing calls to a process."""
+        with self._lock:
+            lock = self._dispatch_locks.get(port)
+            if lock is None:
+                lock = threading.Lock()
+                self._dispatch_locks[port] = lock
+            return lock
+    
+    def _wait_for_dispatch(
+        self, port: int, dispatch_lock: threading.Lock, breaker: CircuitBreaker, budget_end: float
+    ) -> bool:
+        """Wait for a process's dispatch slot, counting the wait in its queue depth.
+        
+        A call that doesn't get the slot gives up its breaker admission, which
+        may have been the half-open probe.
+        
+        Args:
+            port: Port of the process
+            dispatch_lock: The process's dispatch lock
+            breaker: The process's circuit breaker, already admitting the call
+            budget_end: Monotonic time after which to stop waiting
+        
+        Returns:
+            True if the slot was acquired, False if budget_end passed first
+        
+        Raises:
+            CircuitOpenError: If the breaker opened while the call was queued
+        """
+        with self._lock:
+            self._waiting[port] = self._waiting.get(port, 0) + 1
+        try:
+            while True:
+                remaining = max(budget_end - time.monotonic(), 0)
+                if dispatch_lock.acquire(timeout=min(remaining, self.QUEUE_BREAKER_POLL)):
+                    return True
+                if breaker.state == CircuitBreaker.OPEN:
+                    breaker.record_inconclusive()
+                    raise CircuitOpenError(
+                        f"Process on port {port} is unresponsive (circuit open), failing fast"
+                    )
+                if remaining <= self.QUEUE_BREAKER_POLL:
+                    breaker.record_inconclusive()
+                    return False
+        finally:
+            with self._lock:
+                self._waiting[port] -= 1
+    
+    def queue_depth(self, port: int) -> int:
+        """Get the number of calls queued for or running on a process.
+        
+        Args:
+            port: Port of the process
+        
+        Returns:
+            Queued plus in-flight calls
+        """
+        with self._lock:
+            return self._waiting.get(port, 0) + len(self._in_flight.get(port, {}))
+    
+    def _select_session(
+        self, port: int, info: Optional[ProcessInfo], ida_session: Optional[str], budget_end: float
+    ) -> None:
+        """Make an IDA session the child's active database before a call.
+        
+        A process hosting several binaries serves whichever database it
+        switched to last, so a call for another one is preceded by an
+        idalib_switch. A process hosting one binary is never switched.
+        Called holding the process's dispatch slot.
+        
+        Raises:
+            RuntimeError: If the switch failed
+        """
+        if ida_session is None or info is None or info.current_ida_session == ida_session:
+            return
+        with self._lock:
+            shared = len(info.ida_sessions) > 1
+        if not shared:
+            return
+        request = {
+            "jsonrpc": "2.0",
+            "id": next(self._child_ids),
+            "method": "tools/call",
+            "params": {"name": "idalib_switch", "arguments": {"session_id": ida_session}},
+        }
+        conn = http.client.HTTPConnection(
+            self.host, port, timeout=max(budget_end - time.monotonic(), 0.001)
+        )
+        error = None
+        try:
+            conn.request("POST", "/mcp", json.dumps(request), {"Content-Type": "application/json"})
+            response = json.loads(conn.getresponse().read().decode())
+            result = response.get("result") if isinstance(response, dict) else None
+            if not isinstance(result, dict) or result.get("isError"):
+                error = response.get("error") if isinstance(response, dict) else None
+                error = error or (result.get("content") if isinstance(result, dict) else response)
+        except Exception as e:
+            error = e
+        finally:
+            conn.close()
+        if error is not None:
+            # The child may or may not have switched
+            info.current_ida_session = None
+            raise RuntimeError(f"Could not switch process on port {port} to session {ida_session}: {error}")
+        info.current_ida_session = ida_session
+        with self._lock:
+            self.session_switches += 1
+    
+    def forward_request(
+        self,
+        port: int,
+        request: dict,
+        timeout: Optional[int] = None,
+        cancel_token: Optional[CancelToken] = None,
+        deadline: Optional[Deadline] = None,
+        ida_session: Optional[str] = None,
+    ) -> dict:
         """Forward a JSON-RPC request to a child process.
         
+        Requests are sent with a proxy-assigned ID so they can be cancelled;
+        the response carries the caller's original ID. When the request times
+        out or cancel_token fires, the child is sent notifications/cancelled
+        and the call stays tracked as in flight until the child drains it.
+        
+        Calls to the same process are dispatched one at a time. The timeout
+        covers both queueing and execution, and is shortened to the client's
+        deadline if one is given.
+        
         Args:
             port: Port of the target process
             request: JSON-RPC request dictionary
             timeout: Optional timeout override (seconds)
-            
+            cancel_token: Optional token signalling the requester went away
+            deadline: Optional client deadline for the request
+            ida_session: IDA session the call is for; the child is switched
+                to it first if another database is active
+        
         Returns:
             JSON-RPC response dictionary
-            
+        
         Raises:
+            CircuitOpenError: If the process breaker is open
+            DeadlineExceededError: If the deadline passed before a response arrived
             RuntimeError: If request fails
         """
+        if deadline is not None and deadline.expired():
+            raise DeadlineExceededError("Deadline exceeded before the request was dispatched")
+        
         # Check process health first
         if not self.check_process_health(port):
             raise RuntimeError(f"Process on port {port} is not healthy")
         
         request_timeout = timeout if timeout is not None else self.request_timeout
+        budget_end = time.monotonic() + request_timeout
+        deadline_bound = deadline is not None and deadline.remaining() < request_timeout
+        if deadline_bound:
+            budget_end = time.monotonic() + deadline.remaining()
+        
+        # Fail fast rather than queue behind a call to an unresponsive child
+        breaker = self.get_breaker(port)
+        if not breaker.allow_request():
+            raise CircuitOpenError(
+                f"Process on port {port} is unresponsive (circuit open), failing fast"
+            )
+        
+        # Notifications aren't queued or tracked
+        dispatch_lock = None
+        if "id" in request:
+            dispatch_lock = self._get_dispatch_lock(port)
+            acquired = self._wait_for_dispatch(port, dispatch_lock, breaker, budget_end)
+            if not acquired:
+                if deadline_bound:
+                    raise DeadlineExceededError(
+                        f"Deadline exceeded while queued for process on port {port}"
+                    )
+                raise RuntimeError(f"Request to port {port} timed out waiting in queue")
+        
+        info = self.get_process(port)
+        try:
+            if breaker.state == CircuitBreaker.OPEN:
+                # The call ahead of this one opened it
+                raise CircuitOpenError(
+                    f"Process on port {port} is unresponsive (circuit open), failing fast"
+                )
+            if dispatch_lock is not None:
+                try:
+                    self._select_session(port, info, ida_session, budget_end)
+                except RuntimeError:
+                    # A refused switch doesn't mean the child is wedged, but it
+                    # may have been the half-open probe; free its slot
+                    breaker.record_inconclusive()
+                    raise
+        except RuntimeError:
+            if dispatch_lock is not None:
+                dispatch_lock.release()
+            raise
+        
+        request_timeout = budget_end - time.monotonic()
+        if breaker.is_probe():
+            # Don't let a probe of a possibly wedged child burn the full timeout
+            request_timeout = min(request_timeout, self.breaker_probe_timeout)
+        
+        call = None
+        child_request = request
+        if dispatch_lock is not None:
+            call = self._begin_call(port, request, info)
+            child_request = dict(request, id=call.child_id)
+        
+        on_cancel = None
+        if cancel_token is not None and call is not None:
+            def on_cancel():
+                self.cancel_request(
+                    port, call.child_id, cancel_token.reason or "cancelled", escalate=cancel_token.escalate
+                )
+            cancel_token.add_callback(on_cancel)
+        
         conn = http.client.HTTPConnection(
-            self.host, port, timeout=request_timeout
+            self.host, port, timeout=max(request_timeout, 0.001)
         )
+        draining = False
         
         try:
-            body = json.dumps(request)
+            body = json.dumps(child_request)
             conn.request("POST", "/mcp", body, {"Content-Type": "application/json"})
             response = conn.getresponse()
             data = response.read().decode()
-            return json.loads(data)
+            result = json.loads(data)
         except Exception as e:
             method = request.get("method", "unknown")
             logger.error(f"Request '{method}' to port {port} failed: {e}")
+            timed_out = isinstance(e, (socket.timeout, TimeoutError))
+            if timed_out and call is not None:
+                # The child keeps working on it; ask it to stop and wait for it to drain
+                self.cancel_request(port, call.child_id, "deadline exceeded" if deadline_bound else "timeout")
+                self._drain_in_background(port, call, conn, dispatch_lock)
+                draining = True
+            if timed_out and deadline_bound:
+                # The client asked for less time than the child needed; not the child's fault
+                breaker.record_inconclusive()
+                raise DeadlineExceededError(f"Deadline exceeded waiting for process on port {port}")
+            if breaker.record_failure(timeout=timed_out):
+                self._report_wedged(port, info)
             raise RuntimeError(f"Request to port {port} failed: {e}")
         finally:
-            conn.close()
+            if info is not None and call is not None and call.tool_name in self.SESSION_CHANGING_TOOLS:
+                # The active database changed to one only the caller can name
+                info.current_ida_session = None
+            if on_cancel is not None:
+                cancel_token.remove_callback(on_cancel)
+            if not draining:
+                conn.close()
+                if call is not None:
+                    self._end_call(port, call)
+                if dispatch_lock is not None:
+                    dispatch_lock.release()
+        
+        breaker.record_success()
+        if call is not None and isinstance(result, dict):
+            result["id"] = request["id"]
+        return result
+    
+    def forward_batch(
+        self,
+        port: int,
+        requests: List[dict],
+        timeout: Optional[int] = None,
+        cancel_token: Optional[CancelToken] = None,
+        ida_session: Optional[str] = None,
+    ) -> List[dict]:
+        """Forward several JSON-RPC requests to a child in one round trip.
+        
+        The requests are sent as one JSON-RPC batch that takes the process's
+        dispatch slot once, instead of queueing behind other calls once per
+        request. A child that answers the batch with a single error is sent
+        the requests one at a time through forward_request, now and for
+        later batches.
+        
+        Args:
+            port: Port of the target process
+            requests: JSON-RPC requests, each with an ID
+            timeout: Optional timeout override for the whole batch (seconds)
+            cancel_token: Optional token cancelling every request of the batch
+            ida_session: IDA session the requests are for, as in forward_request
+        
+        Returns:
+            JSON-RPC responses in the order of requests, with the callers' IDs
+        
+        Raises:
+            CircuitOpenError: If the process breaker is open
+            RuntimeError: If the batch fails
+        """
+        if port in self._no_batch:
+            return [
+                self.forward_request(port, request, timeout=timeout, cancel_token=cancel_token, ida_session=ida_session)
+                for request in requests
+            ]
+        if not self.check_process_health(port):
+            raise RuntimeError(f"Process on port {port} is not healthy")
+        
+        budget_end = time.monotonic() + (timeout if timeout is not None else self.request_timeout)
+        breaker = self.get_breaker(port)
+        if not breaker.allow_request():
+            raise CircuitOpenError(
+                f"Process on port {port} is unresponsive (circuit open), failing fast"
+            )
+        dispatch_lock = self._get_dispatch_lock(port)
+        if not self._wait_for_dispatch(port, dispatch_lock, breaker, budget_end):
+            raise RuntimeError(f"Batch to port {port} timed out waiting in queue")
+        
+        calls: List[InFlightCall] = []
+        on_cancel = None
+        draining = False
+        try:
+            if breaker.state == CircuitBreaker.OPEN:
+                raise CircuitOpenError(
+                    f"Process on port {port} is unresponsive (circuit open), failing fast"
+                )
+            info = self.get_process(port)
+            try:
+                self._select_session(port, info, ida_session, budget_end)
+            except RuntimeError:
+                # A refused switch doesn't mean the child is wedged, but it
+                # may have been the half-open probe; free its slot
+                breaker.record_inconclusive()
+                raise
+            calls = [self._begin_call(port, request, info) for request in requests]
+            if cancel_token is not None:
+                def on_cancel():
+                    for call in calls:
+                        self.cancel_request(
+                            port, call.child_id, cancel_token.reason or "cancelled",
+                            escalate=cancel_token.escalate and call is calls[0],
+                        )
+                cancel_token.add_callback(on_cancel)
+            body = [dict(request, id=call.child_id) for request, call in zip(requests, calls)]
+            conn = http.client.HTTPConnection(
+                self.host, port, timeout=max(budget_end - time.monotonic(), 0.001)
+            )
+            try:
+                conn.request("POST", "/mcp", json.dumps(body), {"Content-Type": "application/json"})
+                result = json.loads(conn.getresponse().read().decode() or "null")
+            except Exception as e:
+                logger.error(f"Batch of {len(requests)} requests to port {port} failed: {e}")
+                timed_out = isinstance(e, (socket.timeout, TimeoutError))
+                if timed_out:
+                    for call in calls:
+                        self.cancel_request(port, call.child_id, "timeout", escalate=call is calls[0])
+                    # The first call stands for the batch until the child drains it
+                    self._drain_in_background(port, calls[0], conn, dispatch_lock)
+                    draining = True
+                if breaker.record_failure(timeout=timed_out):
+                    self._report_wedged(port, info)
+                raise RuntimeError(f"Batch to port {port} failed: {e}")
+            finally:
+                if not draining:
+                    conn.close()
+            breaker.record_success()
+        finally:
+            if on_cancel is not None:
+                cancel_token.remove_callback(on_cancel)
+            for call in calls[1:] if draining else calls:
+                self._end_call(port, call)
+            if not draining:
+                dispatch_lock.release()
+        
+        if not isinstance(result, list):
+            logger.info(f"Process on port {port} does not accept JSON-RPC batches, sending requests one at a time")
+            self._no_batch.add(port)
+            return [
+                self.forward_request(port, request, timeout=timeout, cancel_token=cancel_token, ida_session=ida_session)
+                for request in requests
+            ]
+        
+        by_child_id = {item.get("id"): item for item in result if isinstance(item, dict)}
+        responses = []
+        for request, call in zip(requests, calls):
+            response = by_child_id.get(call.child_id)
+            if response is None:
+                response = {"jsonrpc": "2.0", "error": {"code": -32603, "message": "No response in batch"}}
+            response["id"] = request.get("id")
+            responses.append(response)
+        return responses
     
     @property
     def process_count(self) -> int:
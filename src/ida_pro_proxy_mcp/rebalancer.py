@@ -0,0 +1,143 @@
+"""Queue-depth rebalancing of sessions across processes for IDA Pro Proxy MCP"""
+
+import logging
+import threading
+import time
+from typing import Any, Dict, List, Optional
+
+from .models import ProxySession
+from .session_manager import SessionManager
+
+logger = logging.getLogger(__name__)
+
+
+class Rebalancer:
+    """Moves busy sessions off processes they share with others.
+    
+    Every interval, the queue depth of each process is sampled into a
+    moving average. When a process serving several sessions runs at least
+    threshold calls deeper than the least loaded one, the session that
+    made the most calls since the last check is migrated to an idle or new
+    process, one move per check. Processes serving a single session are
+    left alone: moving their only session gains nothing.
+    
+    Attributes:
+        interval: Seconds between checks
+        threshold: Smoothed queue depth above the least loaded process at
+            which a session is moved
+    """
+    
+    # Weight of a new sample in the moving average of queue depths
+    WEIGHT = 0.5
+    
+    def __init__(self, session_manager: SessionManager, interval: float = 10.0, threshold: float = 2.0):
+        """Initialize the rebalancer and start its background thread.
+        
+        Args:
+            session_manager: Provides the sessions, their processes and migration
+            interval: Seconds between checks
+            threshold: Smoothed queue depth above the least loaded process
+                at which a session is moved
+        """
+        self.session_manager = session_manager
+        self.process_manager = session_manager.process_manager
+        self.interval = interval
+        self.threshold = threshold
+        self.migrations = 0
+        self.failures = 0
+        self.last_move: Optional[Dict[str, Any]] = None
+        self._depths: Dict[int, float] = {}  # port -> smoothed queue depth
+        self._calls: Dict[str, int] = {}  # session_id -> calls at the last check
+        self._lock = threading.Lock()
+        self._stop = threading.Event()
+        self._thread = threading.Thread(target=self._run, name="rebalancer", daemon=True)
+        self._thread.start()
+    
+    def _run(self) -> None:
+        while not self._stop.wait(self.interval):
+            try:
+                self.tick()
+            except Exception as e:
+                logger.warning(f"Rebalancing check failed: {e}")
+    
+    def tick(self) -> Optional[ProxySession]:
+        """Sample the queue depths and move one session if they are uneven.
+        
+        Returns:
+            The session moved, if one was
+        """
+        ports = self.process_manager.active_ports
+        with self._lock:
+            depths = {}
+            for port in ports:
+                depth = self.process_manager.queue_depth(port)
+                last = self._depths.get(port, float(depth))
+                depths[port] = last + self.WEIGHT * (depth - last)
+            self._depths = depths
+        
+        # Only primaries count; a replica's port also serves its session
+        hosted: Dict[int, List[ProxySession]] = {}
+        for port, session_ids in self.session_manager.port_sessions().items():
+            for session_id in session_ids:
+                session = self.session_manager.get_session(session_id)
+                if session is not None and session.process_port == port:
+                    hosted.setdefault(port, []).append(session)
+        recent = {}
+        for sessions in hosted.values():
+            for session in sessions:
+                recent[session.session_id] = session.calls - self._calls.get(session.session_id, session.calls)
+                self._calls[session.session_id] = session.calls
+        self._calls = {sid: calls for sid, calls in self._calls.items() if sid in recent}
+        
+        if not depths:
+            return None
+        lowest = min(depths.values())
+        shared = [port for port, sessions in hosted.items() if len(sessions) > 1 and port in depths]
+        if not shared:
+            return None
+        source = max(shared, key=lambda port: depths[port])
+        if depths[source] - lowest < self.threshold:
+            return None
+        candidates = [s for s in hosted[source] if not s.restoring and not s.migrating]
+        if not candidates:
+            return None
+        session = max(candidates, key=lambda s: recent.get(s.session_id, 0))
+        
+        logger.info(
+            f"Port {source} has a queue depth of {depths[source]:.1f} against {lowest:.1f}; "
+            f"moving session {session.session_id}"
+        )
+        try:
+            self.session_manager.migrate_session(session.session_id)
+        except (ValueError, RuntimeError) as e:
+            logger.warning(f"Rebalancing could not move {session.session_id}: {e}")
+            with self._lock:
+                self.failures += 1
+            return None
+        with self._lock:
+            self.migrations += 1
+            self.last_move = {
+                "session_id": session.session_id,
+                "from_port": source,
+                "to_port": session.process_port,
+                "at": time.time(),
+            }
+        return session
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize the rebalancer for JSON serialization."""
+        with self._lock:
+            return {
+                "interval": self.interval,
+                "threshold": self.threshold,
+                "queue_depth": {str(port): round(depth, 2) for port, depth in sorted(self._depths.items())},
+                "migrations": self.migrations,
+                "failures": self.failures,
+                "last_move": self.last_move,
+            }
+    
+    def close(self) -> None:
+        """Stop checking; a migration in progress finishes first."""
+        self._stop.set()
+        if self._thread is not threading.current_thread():
+            self._thread.join(timeout=5)
@@ -0,0 +1,78 @@
+"""Cache of read-only tool results for IDA Pro Proxy MCP"""
+
+import json
+import threading
+from collections import OrderedDict
+from typing import Any, Dict, Optional, Tuple
+
+CacheKey = Tuple[str, int, str, str]  # session_id, generation, tool, arguments
+
+
+class ResultCache:
+    """LRU cache of read-only tool results.
+    
+    Entries are keyed by the session's generation, which is bumped whenever
+    the session's database may have changed (a mutating tool call, or the
+    binary or database changing on disk). Entries of older generations are
+    never returned and are dropped eagerly by invalidate().
+    
+    Attributes:
+        max_entries: Number of results kept
+    """
+    
+    def __init__(self, max_entries: int = 4096):
+        self.max_entries = max_entries
+        self._entries: "OrderedDict[CacheKey, Dict[str, Any]]" = OrderedDict()
+        self._lock = threading.Lock()
+    
+    @staticmethod
+    def _key(session_id: str, generation: int, tool_name: str, arguments: Dict[str, Any]) -> CacheKey:
+        return (session_id, generation, tool_name, json.dumps(arguments, sort_keys=True, default=str))
+    
+    def get(
+        self, session_id: str, generation: int, tool_name: str, arguments: Dict[str, Any]
+    ) -> Optional[Dict[str, Any]]:
+        """Look up a cached result.
+        
+        Returns:
+            The tool's JSON-RPC result, or None on a miss
+        """
+        key = self._key(session_id, generation, tool_name, arguments)
+        with self._lock:
+            result = self._entries.get(key)
+            if result is not None:
+                self._entries.move_to_end(key)
+            return result
+    
+    def put(
+        self,
+        session_id: str,
+        generation: int,
+        tool_name: str,
+        arguments: Dict[str, Any],
+        result: Dict[str, Any],
+    ) -> None:
+        """Store a tool's JSON-RPC result."""
+        key = self._key(session_id, generation, tool_name, arguments)
+        with self._lock:
+            self._entries[key] = result
+            self._entries.move_to_end(key)
+            while len(self._entries) > self.max_entries:
+                self._entries.popitem(last=False)
+    
+    def invalidate(self, session_id: str) -> int:
+        """Drop all results of a session.
+        
+        Returns:
+            Number of entries dropped
+        """
+        with self._lock:
+            stale = [key for key in self._entries if key[0] == session_id]
+            for key in stale:
+                del self._entries[key]
+        return len(stale)
+    
+    def to_dict(self) -> Dict[str, int]:
+        """Summarize the cache for JSON serialization."""
+        with self._lock:
+            return {"entries": len(self._entries), "max_entries": self.max_entries}
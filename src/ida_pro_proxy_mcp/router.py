@@ -2,12 +2,48 @@
 
 import json
 import logging
-from typing import Any, Dict, Optional
+import time
+from concurrent.futures import FIRST_COMPLETED, ThreadPoolExecutor, wait
+from typing import Any, Callable, Dict, List, Optional
 
+from .cancellation import CancelToken, Deadline, DeadlineExceededError
+from .circuit_breaker import CircuitOpenError
+from .elf_tools import ElfTools
+from .fanout import MapRun, expand_inputs
+from .metrics import Metrics
+from .models import ProxySession, ReplicaInfo
+from .result_cache import ResultCache
+from .scan import Scanner, compile_patterns
 from .session_manager import SessionManager
+from .similarity import SimilarityIndex
+from .warmer import CacheWarmer
 
 logger = logging.getLogger(__name__)
 
+# Arguments naming the file an elf_* tool reads
+_ELF_TARGET = {
+    'path': {
+        'type': 'string',
+        'description': 'ELF file to read (default: the binary of session)',
+    },
+    'session': {
+        'type': 'string',
+        'description': 'Session whose binary to read, if path is not given (default: current session)',
+    },
+}
+_ELF_PAGE = {
+    'offset': {
+        'type': 'integer',
+        'description': 'Matches to skip (default: 0)',
+        'default': 0,
+    },
+    'count': {
+        'type': 'integer',
+        'description': 'Maximum number of matches (default: 1000)',
+        'default': 1000,
+    },
+}
+
 
 class RequestRouter:
     """Routes MCP requests to appropriate handlers or child processes.
@@ -17,13 +53,58 @@ class RequestRouter:
     idalib-mcp process based on the session parameter.
     """
     
+    # JSON-RPC error code for calls whose client deadline has passed
+    DEADLINE_EXCEEDED = -32003
+    # JSON-RPC error code for calls refused because the server is draining
+    SERVER_DRAINING = -32004
+    
+    # Tools that read ELF files directly, without an IDA process
+    ELF_TOOLS = {
+        'elf_info',
+        'elf_symbols',
+        'elf_imports',
+        'elf_strings',
+    }
+    
     # Tools that are handled by the proxy itself
-    SESSION_TOOLS = {
+    SESSION_TOOLS = ELF_TOOLS | {
         'idalib_open',
         'idalib_close', 
         'idalib_switch',
+        'idalib_migrate',
         'idalib_list',
         'idalib_current',
+        'idalib_map',
+        'idalib_lookup',
+        'idalib_similar',
+        'idalib_scan',
+        'session_summary',
+    }
+    
+    # Analysis tools that don't modify the database. Only these may be
+    # hedged to a replica or retried.
+    READ_ONLY_TOOLS = {
+        'decompile',
+        'disasm',
+        'list_funcs',
+        'lookup_funcs',
+        'list_globals',
+        'imports',
+        'strings',
+        'entrypoints',
+        'xrefs_to',
+        'xrefs_to_field',
+        'callees',
+        'callers',
+        'callgraph',
+        'basic_blocks',
+        'find_bytes',
+        'find_insns',
+        'get_bytes',
+        'get_string',
+        'get_global_value',
+        'stack_frame',
+        'int_convert',
     }
     
     # Schema definitions for session tools
@@ -43,6 +124,11 @@ class RequestRouter:
                         'description': 'Run IDA auto-analysis (default: true)',
                         'default': True,
                     },
+                    'replicas': {
+                        'type': 'integer',
+                        'description': 'Extra processes to open the binary on for hedging read-only calls (default: 0)',
+                        'default': 0,
+                    },
                 },
                 'required': ['input_path'],
             },
@@ -107,6 +193,33 @@ class RequestRouter:
                 },
             },
         },
+        'idalib_migrate': {
+            'name': 'idalib_migrate',
+            'description': 'Move a session to another IDA process, e.g. off a busy one. '
+                           'The old process keeps serving until the move completes.',
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    'session_id': {
+                        'type': 'string',
+                        'description': 'Session ID to move',
+                    },
+                    'port': {
+                        'type': 'integer',
+                        'description': 'Port of the process to move to (default: an idle or new process)',
+                    },
+                },
+                'required': ['session_id'],
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'success': {'type': 'boolean'},
+                    'session': {'type': 'object'},
+                    'message': {'type': 'string'},
+                },
+            },
+        },
         'idalib_list': {
             'name': 'idalib_list',
             'description': 'List all open sessions.',
@@ -143,16 +256,416 @@ class RequestRouter:
                 },
             },
         },
+        'idalib_map': {
+            'name': 'idalib_map',
+            'description': (
+                'Call one analysis tool on many binaries, opening up to max_processes '
+                'at a time. Each binary is opened once and closed after its call unless '
+                'it was already open. With a progressToken, per-binary results are '
+                'streamed as progress notifications as they complete.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    'inputs': {
+                        'type': 'array',
+                        'items': {'type': 'string'},
+                        'description': 'Binary paths or glob patterns (** recurses)',
+                    },
+                    'tool': {
+                        'type': 'string',
+                        'description': 'Analysis tool to call on each binary',
+                    },
+                    'arguments': {
+                        'type': 'object',
+                        'description': 'Arguments for the tool (default: none)',
+                        'default': {},
+                    },
+                    'parallelism': {
+                        'type': 'integer',
+                        'description': 'Binaries worked on at once (default and maximum: max_processes)',
+                    },
+                    'run_auto_analysis': {
+                        'type': 'boolean',
+                        'description': 'Run IDA auto-analysis on binaries opened for the map (default: true)',
+                        'default': True,
+                    },
+                    'keep_open': {
+                        'type': 'boolean',
+                        'description': 'Keep binaries opened for the map open afterwards (default: false)',
+                        'default': False,
+                    },
+                },
+                'required': ['inputs', 'tool'],
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'results': {
+                        'type': 'array',
+                        'items': {'type': 'object'},
+                    },
+                    'count': {'type': 'integer'},
+                    'failed': {'type': 'integer'},
+                },
+            },
+        },
+        'idalib_lookup': {
+            'name': 'idalib_lookup',
+            'description': (
+                'Find functions, imports and exports by name across every binary opened '
+                'so far, including closed ones, without querying IDA. Binaries are '
+                'indexed in the background when opened and after changes; those still '
+                'being indexed are listed in pending.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    'name': {
+                        'type': 'string',
+                        'description': 'Exact symbol name',
+                    },
+                    'prefix': {
+                        'type': 'string',
+                        'description': 'Symbol name prefix',
+                    },
+                    'pattern': {
+                        'type': 'string',
+                        'description': 'Case-sensitive glob pattern, e.g. "*crypt*"',
+                    },
+                    'kinds': {
+                        'type': 'array',
+                        'items': {'type': 'string', 'enum': ['function', 'import', 'export']},
+                        'description': 'Symbol kinds to search (default: all)',
+                    },
+                    'include_closed': {
+                        'type': 'boolean',
+                        'description': 'Also search binaries that are no longer open (default: true)',
+                        'default': True,
+                    },
+                    'limit': {
+                        'type': 'integer',
+                        'description': 'Maximum number of matches (default: 1000)',
+                        'default': 1000,
+                    },
+                },
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'matches': {
+                        'type': 'array',
+                        'items': {'type': 'object'},
+                    },
+                    'count': {'type': 'integer'},
+                    'truncated': {'type': 'boolean'},
+                    'pending': {
+                        'type': 'array',
+                        'items': {'type': 'string'},
+                    },
+                },
+            },
+        },
+        'elf_info': {
+            'name': 'elf_info',
+            'description': (
+                'Read the ELF header, segments, sections, interpreter and needed libraries '
+                'of a file directly, without opening it in IDA.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': dict(_ELF_TARGET),
+            },
+            'outputSchema': {'type': 'object'},
+        },
+        'elf_symbols': {
+            'name': 'elf_symbols',
+            'description': (
+                'List the static and dynamic symbols of an ELF file directly, without '
+                'opening it in IDA.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    **_ELF_TARGET,
+                    'filter': {
+                        'type': 'string',
+                        'description': 'Glob pattern names must match, e.g. "*crypt*"',
+                    },
+                    'defined_only': {
+                        'type': 'boolean',
+                        'description': 'Leave out undefined (imported) symbols (default: false)',
+                        'default': False,
+                    },
+                    'dynamic_only': {
+                        'type': 'boolean',
+                        'description': 'Only list the dynamic symbol table (default: false)',
+                        'default': False,
+                    },
+                    **_ELF_PAGE,
+                },
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'symbols': {
+                        'type': 'array',
+                        'items': {'type': 'object'},
+                    },
+                    'total': {'type': 'integer'},
+                    'next_offset': {'type': ['integer', 'null']},
+                },
+            },
+        },
+        'elf_imports': {
+            'name': 'elf_imports',
+            'description': (
+                'List the needed libraries and imported symbols of an ELF file directly, '
+                'without opening it in IDA.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': dict(_ELF_TARGET),
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'needed': {
+                        'type': 'array',
+                        'items': {'type': 'string'},
+                    },
+                    'imports': {
+                        'type': 'array',
+                        'items': {'type': 'object'},
+                    },
+                    'count': {'type': 'integer'},
+                },
+            },
+        },
+        'elf_strings': {
+            'name': 'elf_strings',
+            'description': (
+                'List the printable strings of an ELF file or one of its sections directly, '
+                'without opening it in IDA.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    **_ELF_TARGET,
+                    'min_length': {
+                        'type': 'integer',
+                        'description': 'Shortest string reported (default: 4)',
+                        'default': 4,
+                    },
+                    'section': {
+                        'type': 'string',
+                        'description': 'Only search this section, e.g. ".rodata" (default: whole file)',
+                    },
+                    'contains': {
+                        'type': 'string',
+                        'description': 'Substring strings must contain',
+                    },
+                    **_ELF_PAGE,
+                },
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'strings': {
+                        'type': 'array',
+                        'items': {'type': 'object'},
+                    },
+                    'total': {'type': 'integer'},
+                    'next_offset': {'type': ['integer', 'null']},
+                },
+            },
+        },
+        'idalib_scan': {
+            'name': 'idalib_scan',
+            'description': (
+                'Search binaries for byte signatures with wildcards, strings and regular '
+                'expressions, reading the files directly without IDA. Scans the binaries of '
+                'the open sessions unless inputs are given. Matches are reported with file '
+                'offsets and, for ELF files, virtual addresses.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    'patterns': {
+                        'type': 'array',
+                        'items': {
+                            'type': 'object',
+                            'properties': {
+                                'hex': {
+                                    'type': 'string',
+                                    'description': 'Byte signature, ?? for any byte, e.g. "48 8B ?? E8"',
+                                },
+                                'string': {'type': 'string', 'description': 'Literal string'},
+                                'wide': {
+                                    'type': 'boolean',
+                                    'description': 'Also match the string as UTF-16LE',
+                                },
+                                'regex': {'type': 'string', 'description': 'Regular expression over bytes'},
+                                'name': {'type': 'string', 'description': 'Name reported with matches'},
+                            },
+                        },
+                        'description': 'Patterns, each with one of hex, string or regex',
+                    },
+                    'inputs': {
+                        'type': 'array',
+                        'items': {'type': 'string'},
+                        'description': 'Binary paths or glob patterns (default: binaries of open sessions)',
+                    },
+                    'max_matches': {
+                        'type': 'integer',
+                        'description': 'Matches reported per pattern and binary (default: 100)',
+                        'default': 100,
+                    },
+                },
+                'required': ['patterns'],
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'results': {
+                        'type': 'array',
+                        'items': {'type': 'object'},
+                    },
+                    'scanned': {'type': 'integer'},
+                    'matched': {'type': 'integer'},
+                    'failed': {'type': 'integer'},
+                },
+            },
+        },
+        'session_summary': {
+            'name': 'session_summary',
+            'description': (
+                'Get the overview of a session\'s binary gathered when it was opened: '
+                'function count and largest functions, entry points, imports by module, '
+                'interesting strings, and for ELF files headers and sections.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    'session': {
+                        'type': 'string',
+                        'description': 'Session to summarize (default: current session)',
+                    },
+                    'refresh': {
+                        'type': 'boolean',
+                        'description': 'Gather the summary again from the process (default: false)',
+                        'default': False,
+                    },
+                },
+            },
+            'outputSchema': {'type': 'object'},
+        },
+        'idalib_similar': {
+            'name': 'idalib_similar',
+            'description': (
+                'Find functions similar to a function of a session, across every binary '
+                'opened so far, ranked by estimated similarity of their byte n-grams '
+                '(MinHash). ELF binaries only; functions are fingerprinted in the '
+                'background after they are indexed.'
+            ),
+            'inputSchema': {
+                'type': 'object',
+                'properties': {
+                    'addr': {
+                        'type': 'string',
+                        'description': 'Start address of the function',
+                    },
+                    'name': {
+                        'type': 'string',
+                        'description': 'Name of the function, if addr is not given',
+                    },
+                    'session': {
+                        'type': 'string',
+                        'description': 'Session of the function (default: current session)',
+                    },
+                    'top_k': {
+                        'type': 'integer',
+                        'description': 'Maximum number of matches (default: 10)',
+                        'default': 10,
+                    },
+                    'min_similarity': {
+                        'type': 'number',
+                        'description': 'Smallest similarity reported, 0-1 (default: 0.5)',
+                        'default': 0.5,
+                    },
+                    'include_closed': {
+                        'type': 'boolean',
+                        'description': 'Also search binaries that are no longer open (default: true)',
+                        'default': True,
+                    },
+                },
+            },
+            'outputSchema': {
+                'type': 'object',
+                'properties': {
+                    'function': {'type': 'object'},
+                    'matches': {
+                        'type': 'array',
+                        'items': {'type': 'object'},
+                    },
+                    'count': {'type': 'integer'},
+                    'pending': {
+                        'type': 'array',
+                        'items': {'type': 'string'},
+                    },
+                },
+            },
+        },
     }
     
-    def __init__(self, session_manager: SessionManager):
+    def __init__(
+        self,
+        session_manager: SessionManager,
+        metrics: Optional[Metrics] = None,
+        hedging: bool = False,
+        hedge_percentile: float = 95.0,
+        hedge_min_samples: int = 20,
+        result_cache: Optional[ResultCache] = None,
+        similarity: Optional[SimilarityIndex] = None,
+        elf_tools: Optional[ElfTools] = None,
+        scanner: Optional[Scanner] = None,
+        warmer: Optional[CacheWarmer] = None,
+    ):
         """Initialize the router.
         
         Args:
             session_manager: SessionManager instance
+            metrics: Metrics registry (a private one is created if omitted)
+            hedging: Whether to hedge slow read-only calls to session replicas
+            hedge_percentile: Observed latency percentile that triggers a hedge
+            hedge_min_samples: Calls of a tool to observe before hedging it
+            result_cache: Cache for results of read-only tools, if any
+            similarity: Function similarity index for idalib_similar, if any
+            elf_tools: Reader answering the elf_* tools (a private one is
+                created if omitted)
+            scanner: Scans files for idalib_scan (a private one is created
+                if omitted)
+            warmer: Cache warmer told about served decompiles, if any
         """
         self.session_manager = session_manager
+        self.metrics = metrics or Metrics()
+        self.hedging = hedging
+        self.hedge_percentile = hedge_percentile
+        self.hedge_min_samples = hedge_min_samples
+        self.result_cache = result_cache
+        self.similarity = similarity
+        self.elf_tools = elf_tools or ElfTools()
+        self.scanner = scanner or Scanner()
+        self.warmer = warmer
         self._cached_tools = []  # Cached tools from child process
+        self.admitting = True  # Cleared when the server starts draining
+        self._hedge_executor = (
+            ThreadPoolExecutor(max_workers=32, thread_name_prefix="hedge") if hedging else None
+        )
+    
+    def stop_admission(self) -> None:
+        """Refuse new tool calls; calls already admitted run to completion."""
+        self.admitting = False
     
     def refresh_tools(self) -> None:
         """Refresh the cached tools list from the default process.
@@ -180,12 +693,20 @@ class RequestRouter:
         except Exception as e:
             logger.warning(f"Failed to refresh tools: {e}")
     
-    def route(self, request: Dict[str, Any]) -> Dict[str, Any]:
+    def route(
+        self,
+        request: Dict[str, Any],
+        cancel_token: Optional[CancelToken] = None,
+        notify: Optional[Callable[[Dict[str, Any]], None]] = None,
+    ) -> Dict[str, Any]:
         """Route a JSON-RPC request to the appropriate handler.
         
         Args:
             request: JSON-RPC request dictionary
-            
+            cancel_token: Optional token cancelled when the client goes away
+            notify: Sends a JSON-RPC notification to the client before the
+                response, if the transport can stream
+        
         Returns:
             JSON-RPC response dictionary
         """
@@ -198,13 +719,13 @@ class RequestRouter:
             elif method == "tools/list":
                 return self._handle_tools_list(request)
             elif method == "tools/call":
-                return self._handle_tools_call(request)
+                return self._handle_tools_call(request, cancel_token, notify)
             elif method.startswith("notifications/"):
                 # Notifications don't need responses
                 return None
             else:
                 # Forward other methods to current session's process
-                return self._forward_to_current(request)
+                return self._forward_to_current(request, cancel_token)
         except Exception as e:
             logger.exception(f"Error routing request: {e}")
             return self._error_response(request_id, -32603, f"Internal error: {e}")
@@ -299,17 +820,42 @@ class RequestRouter:
             "result": {"tools": all_tools},
         }
     
-    def _handle_tools_call(self, request: Dict[str, Any]) -> Dict[str, Any]:
-        """Handle tools/call request."""
+    def _handle_tools_call(
+        self,
+        request: Dict[str, Any],
+        cancel_token: Optional[CancelToken] = None,
+        notify: Optional[Callable[[Dict[str, Any]], None]] = None,
+    ) -> Dict[str, Any]:
+        """Handle tools/call request.
+        
+        A client deadline in ``params._meta`` is checked on admission and
+        carried through to the child process.
+        """
         params = request.get("params", {})
         tool_name = params.get("name", "")
         arguments = params.get("arguments", {})
         request_id = request.get("id")
         
-        if tool_name in self.SESSION_TOOLS:
+        if not self.admitting:
+            return self._error_response(
+                request_id, self.SERVER_DRAINING, "Server is draining and not accepting new calls"
+            )
+        
+        deadline = Deadline.from_meta(params.get("_meta"))
+        if deadline is not None and deadline.expired():
+            return self._deadline_error_response(request_id, "Deadline exceeded before the call was admitted")
+        
+        if tool_name in ("idalib_map", "idalib_scan"):
+            progress_token = (params.get("_meta") or {}).get("progressToken")
+            handler = self._handle_idalib_map if tool_name == "idalib_map" else self._handle_idalib_scan
+            return handler(
+                request_id, arguments, cancel_token, deadline,
+                notify if progress_token is not None else None, progress_token,
+            )
+        elif tool_name in self.SESSION_TOOLS:
             return self._handle_session_tool(request_id, tool_name, arguments)
         else:
-            return self._handle_analysis_tool(request_id, tool_name, arguments)
+            return self._handle_analysis_tool(request_id, tool_name, arguments, cancel_token, deadline)
     
     def _handle_session_tool(
         self, request_id: Any, tool_name: str, arguments: Dict[str, Any]
@@ -322,10 +868,20 @@ class RequestRouter:
                 return self._handle_idalib_close(request_id, arguments)
             elif tool_name == "idalib_switch":
                 return self._handle_idalib_switch(request_id, arguments)
+            elif tool_name == "idalib_migrate":
+                return self._handle_idalib_migrate(request_id, arguments)
             elif tool_name == "idalib_list":
                 return self._handle_idalib_list(request_id)
             elif tool_name == "idalib_current":
                 return self._handle_idalib_current(request_id)
+            elif tool_name == "idalib_lookup":
+                return self._handle_idalib_lookup(request_id, arguments)
+            elif tool_name == "idalib_similar":
+                return self._handle_idalib_similar(request_id, arguments)
+            elif tool_name == "session_summary":
+                return self._handle_session_summary(request_id, arguments)
+            elif tool_name in self.ELF_TOOLS:
+                return self._handle_elf_tool(request_id, tool_name, arguments)
             else:
                 return self._error_response(request_id, -32601, f"Unknown tool: {tool_name}")
         except Exception as e:
@@ -339,14 +895,24 @@ class RequestRouter:
             return self._tool_error_response(request_id, "input_path is required")
         
         run_auto_analysis = arguments.get("run_auto_analysis", True)
+        replicas = arguments.get("replicas", 0)
         
         try:
             session = self.session_manager.open_session(input_path, run_auto_analysis)
+            while replicas > 0 and len(session.replicas) < replicas:
+                try:
+                    if self.session_manager.add_replica(session.session_id) is None:
+                        break
+                except RuntimeError as e:
+                    logger.warning(f"Failed to add replica: {e}")
+                    break
             result = {
                 "success": True,
                 "session": session.to_dict(),
                 "message": f"Binary opened successfully: {session.binary_name}",
             }
+            if session.summary is not None:
+                result["summary"] = session.summary
             return self._tool_response(request_id, result)
         except FileNotFoundError as e:
             return self._tool_error_response(request_id, str(e))
@@ -383,6 +949,24 @@ class RequestRouter:
         except ValueError as e:
             return self._tool_error_response(request_id, str(e))
     
+    def _handle_idalib_migrate(self, request_id: Any, arguments: Dict[str, Any]) -> Dict[str, Any]:
+        """Handle idalib_migrate tool call."""
+        session_id = arguments.get("session_id")
+        if not session_id:
+            return self._tool_error_response(request_id, "session_id is required")
+        
+        self.metrics.increment("migrations")
+        try:
+            session = self.session_manager.migrate_session(session_id, arguments.get("port"))
+        except (ValueError, RuntimeError) as e:
+            return self._tool_error_response(request_id, str(e))
+        result = {
+            "success": True,
+            "session": dict(session.to_dict(), process_port=session.process_port),
+            "message": f"Moved session {session_id} to the process on port {session.process_port}",
+        }
+        return self._tool_response(request_id, result)
+    
     def _handle_idalib_list(self, request_id: Any) -> Dict[str, Any]:
         """Handle idalib_list tool call."""
         sessions = self.session_manager.list_sessions()
@@ -407,8 +991,242 @@ class RequestRouter:
         
         return self._tool_response(request_id, session.to_dict())
     
-    def _handle_analysis_tool(
+    def _handle_idalib_lookup(self, request_id: Any, arguments: Dict[str, Any]) -> Dict[str, Any]:
+        """Handle idalib_lookup tool call."""
+        index = self.session_manager.index
+        if index is None:
+            return self._tool_error_response(request_id, "The function index is disabled")
+        
+        try:
+            result = index.lookup(
+                name=arguments.get("name"),
+                prefix=arguments.get("prefix"),
+                pattern=arguments.get("pattern"),
+                kinds=arguments.get("kinds"),
+                include_closed=arguments.get("include_closed", True),
+                limit=arguments.get("limit", 1000),
+            )
+        except ValueError as e:
+            return self._tool_error_response(request_id, str(e))
+        self.metrics.increment("lookup_calls")
+        return self._tool_response(request_id, result)
+    
+    def _handle_elf_tool(
         self, request_id: Any, tool_name: str, arguments: Dict[str, Any]
+    ) -> Dict[str, Any]:
+        """Handle the elf_* tools, reading the file in the proxy."""
+        arguments = dict(arguments)
+        path = arguments.pop("path", None)
+        session_id = arguments.pop("session", None)
+        if not path:
+            if session_id:
+                session = self.session_manager.get_session(session_id)
+                if session is None:
+                    return self._tool_error_response(request_id, f"Session not found: {session_id}")
+            else:
+                session = self.session_manager.get_current_session()
+                if session is None:
+                    return self._tool_error_response(
+                        request_id, "path is required when there is no active session"
+                    )
+            path = session.binary_path
+        
+        handlers = {
+            "elf_info": self.elf_tools.info,
+            "elf_symbols": self.elf_tools.symbols,
+            "elf_imports": self.elf_tools.imports,
+            "elf_strings": self.elf_tools.strings,
+        }
+        try:
+            result = handlers[tool_name](path, **arguments)
+        except TypeError as e:
+            return self._tool_error_response(request_id, f"Invalid arguments: {e}")
+        except (OSError, ValueError) as e:
+            return self._tool_error_response(request_id, str(e))
+        self.metrics.increment("elf_tool_calls")
+        return self._tool_response(request_id, result)
+    
+    def _handle_idalib_similar(self, request_id: Any, arguments: Dict[str, Any]) -> Dict[str, Any]:
+        """Handle idalib_similar tool call."""
+        if self.similarity is None:
+            return self._tool_error_response(request_id, "The function index is disabled")
+        
+        session_id = arguments.get("session")
+        if session_id:
+            session = self.session_manager.get_session(session_id)
+            if session is None:
+                return self._tool_error_response(request_id, f"Session not found: {session_id}")
+        else:
+            session = self.session_manager.get_current_session()
+            if session is None:
+                return self._tool_error_response(
+                    request_id, "No active session. Use idalib_open() to open a binary first."
+                )
+        
+        addr = arguments.get("addr")
+        try:
+            result = self.similarity.similar(
+                session.content_hash or session.session_id,
+                addr=int(str(addr), 0) if addr is not None else None,
+                name=arguments.get("name"),
+                top_k=arguments.get("top_k", 10),
+                min_similarity=arguments.get("min_similarity", 0.5),
+                include_closed=arguments.get("include_closed", True),
+            )
+        except ValueError as e:
+            return self._tool_error_response(request_id, str(e))
+        self.metrics.increment("similar_calls")
+        return self._tool_response(request_id, result)
+    
+    def _handle_session_summary(self, request_id: Any, arguments: Dict[str, Any]) -> Dict[str, Any]:
+        """Handle session_summary tool call."""
+        session_id = arguments.get("session")
+        if not session_id:
+            session = self.session_manager.get_current_session()
+            if session is None:
+                return self._tool_error_response(
+                    request_id, "No active session. Use idalib_open() to open a binary first."
+                )
+            session_id = session.session_id
+        
+        try:
+            summary = self.session_manager.summarize(session_id, refresh=arguments.get("refresh", False))
+        except (ValueError, RuntimeError) as e:
+            return self._tool_error_response(request_id, str(e))
+        self.metrics.increment("summary_calls")
+        return self._tool_response(request_id, summary)
+    
+    def _handle_idalib_map(
+        self,
+        request_id: Any,
+        arguments: Dict[str, Any],
+        cancel_token: Optional[CancelToken],
+        deadline: Optional[Deadline],
+        notify: Optional[Callable[[Dict[str, Any]], None]],
+        progress_token: Any,
+    ) -> Dict[str, Any]:
+        """Handle idalib_map tool call.
+        
+        Each binary's call goes through the same path as a direct call on its
+        session (result cache, crash recovery, hedging, metrics).
+        """
+        inputs = arguments.get("inputs")
+        tool_name = arguments.get("tool")
+        if isinstance(inputs, str):
+            inputs = [inputs]
+        if not inputs or not tool_name:
+            return self._tool_error_response(request_id, "inputs and tool are required")
+        if tool_name in self.SESSION_TOOLS:
+            return self._tool_error_response(request_id, f"{tool_name} cannot be mapped")
+        
+        paths = expand_inputs(inputs)
+        if not paths:
+            return self._tool_error_response(request_id, f"No binaries match {inputs}")
+        
+        max_processes = self.session_manager.max_processes
+        parallelism = min(arguments.get("parallelism") or max_processes, max_processes)
+        tool_arguments = arguments.get("arguments") or {}
+        
+        def call_tool(session_id: str, tool_args: Dict[str, Any]) -> Dict[str, Any]:
+            tool_args["session"] = session_id
+            return self._handle_analysis_tool(request_id, tool_name, tool_args, cancel_token, deadline)
+        
+        on_result = self._progress_notifier(notify, progress_token, len(paths))
+        self.metrics.increment("map_calls")
+        run = MapRun(
+            self.session_manager,
+            call_tool,
+            tool_arguments,
+            parallelism,
+            run_auto_analysis=arguments.get("run_auto_analysis", True),
+            keep_open=arguments.get("keep_open", False),
+            cancel_token=cancel_token,
+            deadline=deadline,
+        )
+        results = run.run(paths, on_result)
+        failed = sum(1 for entry in results if "error" in entry)
+        self.metrics.increment("map_binaries", len(results))
+        return self._tool_response(
+            request_id, {"results": results, "count": len(results), "failed": failed}
+        )
+    
+    def _handle_idalib_scan(
+        self,
+        request_id: Any,
+        arguments: Dict[str, Any],
+        cancel_token: Optional[CancelToken],
+        deadline: Optional[Deadline],
+        notify: Optional[Callable[[Dict[str, Any]], None]],
+        progress_token: Any,
+    ) -> Dict[str, Any]:
+        """Handle idalib_scan tool call, scanning the files in the proxy."""
+        try:
+            patterns = compile_patterns(arguments.get("patterns") or [])
+        except ValueError as e:
+            return self._tool_error_response(request_id, str(e))
+        if not patterns:
+            return self._tool_error_response(request_id, "patterns is required")
+        
+        inputs = arguments.get("inputs")
+        if isinstance(inputs, str):
+            inputs = [inputs]
+        if inputs:
+            paths = expand_inputs(inputs)
+        else:
+            paths = sorted({s["binary_path"] for s in self.session_manager.list_sessions()})
+        if not paths:
+            return self._tool_error_response(request_id, f"No binaries match {inputs or 'the open sessions'}")
+        
+        on_result = self._progress_notifier(notify, progress_token, len(paths))
+        self.metrics.increment("scan_calls")
+        results = self.scanner.scan(
+            paths,
+            patterns,
+            max_matches=arguments.get("max_matches", 100),
+            cancel_token=cancel_token,
+            deadline=deadline,
+            on_result=on_result,
+        )
+        self.metrics.increment("scan_binaries", len(results))
+        return self._tool_response(request_id, {
+            "results": [r for r in results if r.get("matches") or "error" in r],
+            "scanned": len(results),
+            "matched": sum(1 for r in results if r.get("matches")),
+            "failed": sum(1 for r in results if "error" in r),
+        })
+    
+    @staticmethod
+    def _progress_notifier(
+        notify: Optional[Callable[[Dict[str, Any]], None]], progress_token: Any, total: int
+    ) -> Callable[[Dict[str, Any]], None]:
+        """Build a callback sending each per-binary result as a progress notification."""
+        done = 0
+        
+        def on_result(entry: Dict[str, Any]) -> None:
+            nonlocal done
+            done += 1
+            if notify is None:
+                return
+            notify({
+                "jsonrpc": "2.0",
+                "method": "notifications/progress",
+                "params": {
+                    "progressToken": progress_token,
+                    "progress": done,
+                    "total": total,
+                    "message": json.dumps(entry),
+                },
+            })
+        
+        return on_result
+    
+    def _handle_analysis_tool(
+        self,
+        request_id: Any,
+        tool_name: str,
+        arguments: Dict[str, Any],
+        cancel_token: Optional[CancelToken] = None,
+        deadline: Optional[Deadline] = None,
     ) -> Dict[str, Any]:
         """Handle analysis tools by forwarding to child process."""
         # Extract session parameter
@@ -418,6 +1236,9 @@ class RequestRouter:
         if session_id:
             session = self.session_manager.get_session(session_id)
             if session is None:
+                hibernated = self.session_manager.get_hibernated(session_id)
+                if hibernated is not None:
+                    return self._serve_hibernated(request_id, hibernated, tool_name, arguments)
                 return self._tool_error_response(
                     request_id,
                     f"Session not found: {session_id}. Use idalib_open() to create a session first."
@@ -433,14 +1254,26 @@ class RequestRouter:
         # Update LRU
         session.touch()
         
-        # Check if process is healthy
-        if not self.session_manager.process_manager.check_process_health(session.process_port):
-            # Process crashed, clean up
-            self.session_manager.close_session(session.session_id)
-            return self._tool_error_response(
-                request_id,
-                f"Session {session.session_id} is no longer available (process crashed)"
-            )
+        process_manager = self.session_manager.process_manager
+        
+        # A crashed process, or one already being replaced, gets the session
+        # restored in place before the call goes out
+        if session.restoring or not process_manager.check_process_health(session.process_port):
+            error = self._recover_session(session)
+            if error is not None:
+                return self._tool_error_response(request_id, error)
+        
+        # Serve repeated read-only calls from the cache while the database is unchanged
+        read_only = tool_name in self.READ_ONLY_TOOLS
+        generation = session.generation
+        if read_only and self.result_cache is not None:
+            cached = self.result_cache.get(session.session_id, generation, tool_name, arguments)
+            if cached is not None:
+                self.metrics.increment("result_cache_hits")
+                if self.warmer is not None:
+                    self.warmer.served(session, tool_name, arguments, cached=True)
+                return {"jsonrpc": "2.0", "id": request_id, "result": cached}
+            self.metrics.increment("result_cache_misses")
         
         # Forward request to child process
         child_request = {
@@ -453,17 +1286,206 @@ class RequestRouter:
             },
         }
         
+        if not read_only:
+            # A migration can't carry over changes made while it copies the database
+            self.session_manager.begin_write(session.session_id)
         try:
-            response = self.session_manager.process_manager.forward_request(
-                session.process_port, child_request
-            )
+            try:
+                response = self._forward_analysis_call(
+                    session, tool_name, child_request, cancel_token, deadline
+                )
+            except (CircuitOpenError, DeadlineExceededError):
+                raise
+            except RuntimeError:
+                if process_manager.check_process_health(session.process_port):
+                    raise
+                # The process died under the call
+                error = self._recover_session(session)
+                if error is not None:
+                    return self._tool_error_response(request_id, error)
+                if tool_name not in self.READ_ONLY_TOOLS:
+                    return self._tool_error_response(
+                        request_id,
+                        f"Session {session.session_id} was restored after its process crashed, "
+                        f"but {tool_name} was not retried because it may modify the database. "
+                        f"Changes not yet saved were lost."
+                    )
+                logger.info(f"Retrying {tool_name} on restored session {session.session_id}")
+                response = self._forward_analysis_call(
+                    session, tool_name, child_request, cancel_token, deadline
+                )
+            if read_only and self.result_cache is not None and self._is_success(response):
+                self.result_cache.put(
+                    session.session_id, generation, tool_name, arguments, response["result"]
+                )
+                if self.warmer is not None:
+                    self.warmer.served(session, tool_name, arguments, cached=False)
             # Return the child's response with our request ID
             response["id"] = request_id
             return response
+        except DeadlineExceededError as e:
+            return self._deadline_error_response(request_id, str(e))
         except RuntimeError as e:
             return self._tool_error_response(request_id, str(e))
+        finally:
+            if not read_only:
+                # The call may have modified the database, even if it failed
+                self.session_manager.bump_generation(session.session_id)
+                self.session_manager.end_write(session.session_id)
     
-    def _forward_to_current(self, request: Dict[str, Any]) -> Dict[str, Any]:
+    def _serve_hibernated(
+        self, request_id: Any, session: ProxySession, tool_name: str, arguments: Dict[str, Any]
+    ) -> Dict[str, Any]:
+        """Answer a call on a hibernated session from what was kept of it.
+        
+        The session is reopened in the background either way, so the agent
+        gets a cached result, or an error telling it to retry, right away
+        instead of waiting for the open.
+        """
+        self.session_manager.wake_in_background(session.session_id)
+        if tool_name in self.READ_ONLY_TOOLS and self.result_cache is not None:
+            cached = self.result_cache.get(session.session_id, session.generation, tool_name, arguments)
+            if cached is not None:
+                self.metrics.increment("warm_hits")
+                return {"jsonrpc": "2.0", "id": request_id, "result": cached}
+        self.metrics.increment("warm_misses")
+        message = (
+            f"Session {session.session_id} is {session.tier}: its process was reclaimed and it is "
+            f"being reopened in the background. Retry shortly."
+        )
+        if session.summary is not None:
+            message += " Its summary is available from session_summary meanwhile."
+        return self._tool_error_response(request_id, message)
+    
+    @staticmethod
+    def _is_success(response: Dict[str, Any]) -> bool:
+        """Whether a child response carries a successful tool result."""
+        result = response.get("result")
+        return isinstance(result, dict) and not result.get("isError") and "error" not in response
+    
+    def _recover_session(self, session: ProxySession) -> Optional[str]:
+        """Restore a session whose process crashed, keeping its session ID.
+        
+        Returns:
+            None on success, otherwise an error message for the client
+        """
+        started = time.monotonic()
+        try:
+            self.session_manager.restore_session(session.session_id)
+        except (ValueError, RuntimeError) as e:
+            logger.error(f"Could not recover session {session.session_id}: {e}")
+            self.metrics.increment("crash_recovery_failures")
+            return (
+                f"Session {session.session_id} is no longer available "
+                f"(process crashed and could not be restored: {e})"
+            )
+        self.metrics.increment("crash_recoveries")
+        self.metrics.recovery.observe("restore", time.monotonic() - started)
+        return None
+    
+    def _forward_analysis_call(
+        self,
+        session: ProxySession,
+        tool_name: str,
+        child_request: Dict[str, Any],
+        cancel_token: Optional[CancelToken],
+        deadline: Optional[Deadline],
+    ) -> Dict[str, Any]:
+        """Send an analysis call to a session's process, hedging it if enabled.
+        
+        Records the call's latency for the tool's percentile statistics.
+        """
+        process_manager = self.session_manager.process_manager
+        started = time.monotonic()
+        
+        hedge_after = None
+        if self.hedging and tool_name in self.READ_ONLY_TOOLS and self._current_replicas(session):
+            self.metrics.increment("hedge_eligible")
+            hedge_after = self.metrics.latency.percentile(
+                tool_name, self.hedge_percentile, self.hedge_min_samples
+            )
+        
+        if hedge_after is None:
+            response = self._forward_routed(session, child_request, cancel_token=cancel_token, deadline=deadline)
+        else:
+            response = self._forward_hedged(session, child_request, hedge_after, cancel_token, deadline)
+        
+        self.metrics.latency.observe(tool_name, time.monotonic() - started)
+        return response
+    
+    def _forward_hedged(
+        self,
+        session: ProxySession,
+        child_request: Dict[str, Any],
+        hedge_after: float,
+        cancel_token: Optional[CancelToken],
+        deadline: Optional[Deadline],
+    ) -> Dict[str, Any]:
+        """Send a call to the primary and, if it is slow, also to a replica.
+        
+        The first successful answer wins and the other call is cancelled.
+        Cancelling the loser doesn't escalate to a restart: its work is only
+        redundant, not a sign of a wedged process.
+        """
+        process_manager = self.session_manager.process_manager
+        primary_token = CancelToken(escalate=False)
+        hedge_token = CancelToken(escalate=False)
+        if cancel_token is not None:
+            def cancel_both():
+                primary_token.cancel(cancel_token.reason or "cancelled")
+                hedge_token.cancel(cancel_token.reason or "cancelled")
+            cancel_token.add_callback(cancel_both)
+        
+        try:
+            primary = self._hedge_executor.submit(
+                self._forward_routed, session, child_request, cancel_token=primary_token, deadline=deadline,
+            )
+            done, _ = wait([primary], timeout=hedge_after)
+            if done:
+                return primary.result()
+            
+            # A write since the call started may have left every replica behind
+            replicas = self._current_replicas(session)
+            if not replicas:
+                return primary.result()
+            replica = min(replicas, key=lambda r: process_manager.queue_depth(r.port))
+            logger.debug(f"Hedging call to {session.session_id} on replica port {replica.port}")
+            self.metrics.increment("hedges_sent")
+            hedge = self._hedge_executor.submit(
+                process_manager.forward_request, replica.port, dict(child_request),
+                cancel_token=hedge_token, deadline=deadline, ida_session=replica.ida_session_id,
+            )
+            
+            pending = {primary, hedge}
+            error = None
+            while pending:
+                done, pending = wait(pending, return_when=FIRST_COMPLETED)
+                for future in done:
+                    try:
+                        response = future.result()
+                    except RuntimeError as e:
+                        error = e
+                        continue
+                    if future is hedge:
+                        self.metrics.increment("hedge_wins")
+                        primary_token.cancel("hedge won")
+                    else:
+                        hedge_token.cancel("hedge lost")
+                    return response
+            raise error
+        finally:
+            # The caller's token outlives this call; don't keep cancelling finished ones
+            if cancel_token is not None:
+                cancel_token.remove_callback(cancel_both)
+    
+    @staticmethod
+    def _current_replicas(session: ProxySession) -> List[ReplicaInfo]:
+        """Replicas of a session whose database copy is as new as the session's."""
+        return [replica for replica in list(session.replicas) if replica.generation == session.generation]
+    
+    def _forward_to_current(
+        self, request: Dict[str, Any], cancel_token: Optional[CancelToken] = None
+    ) -> Dict[str, Any]:
         """Forward a request to the current session's process."""
         session = self.session_manager.get_current_session()
         
@@ -475,12 +1497,17 @@ class RequestRouter:
             )
         
         try:
-            return self.session_manager.process_manager.forward_request(
-                session.process_port, request
-            )
+            return self._forward_routed(session, request, cancel_token=cancel_token)
         except RuntimeError as e:
             return self._error_response(request.get("id"), -32000, str(e))
     
+    def _forward_routed(self, session: ProxySession, request: Dict[str, Any], **kwargs) -> Dict[str, Any]:
+        """Forward a request to a session's process, holding its route until the answer."""
+        with self.session_manager.route(session) as (port, ida_session_id):
+            return self.session_manager.process_manager.forward_request(
+                port, request, ida_session=ida_session_id, **kwargs
+            )
+    
     def _tool_response(self, request_id: Any, result: Dict[str, Any]) -> Dict[str, Any]:
         """Create a successful tool response.
         
@@ -516,6 +1543,18 @@ class RequestRouter:
             },
         }
     
+    def _deadline_error_response(self, request_id: Any, message: str) -> Dict[str, Any]:
+        """Create the JSON-RPC error returned when a client deadline passes."""
+        return {
+            "jsonrpc": "2.0",
+            "id": request_id,
+            "error": {
+                "code": self.DEADLINE_EXCEEDED,
+                "message": message,
+                "data": {"reason": "deadline_exceeded"},
+            },
+        }
+    
     def _error_response(self, request_id: Any, code: int, message: str) -> Dict[str, Any]:
         """Create a JSON-RPC error response."""
         return {
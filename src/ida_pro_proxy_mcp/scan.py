@@ -0,0 +1,260 @@
+"""Byte-pattern and string scanning of binaries for IDA Pro Proxy MCP"""
+
+import logging
+import mmap
+import multiprocessing
+import os
+import re
+import threading
+from concurrent.futures import FIRST_COMPLETED, ProcessPoolExecutor, wait
+from dataclasses import dataclass
+from typing import Any, Callable, Dict, List, Optional
+
+from .cancellation import CancelToken, Deadline
+from .elf_reader import ElfFile
+
+logger = logging.getLogger(__name__)
+
+
+@dataclass
+class ScanPattern:
+    """A compiled search pattern.
+    
+    Attributes:
+        name: Reported with each match
+        regex: Compiled bytes regex matching the pattern
+    """
+    name: str
+    regex: "re.Pattern[bytes]"
+
+
+def parse_hex(signature: str) -> bytes:
+    """Translate a hex signature with wildcards into a bytes regex.
+    
+    Bytes are two hex digits, optionally separated by spaces. ``??`` (or
+    ``?``) matches any byte and a ``?`` in place of one digit matches any
+    value of that nibble, e.g. ``48 8B ?? E8 ?? ?? ?? ?? 4?``.
+    
+    Raises:
+        ValueError: If the signature is malformed
+    """
+    tokens = signature.split()
+    if len(tokens) == 1 and len(tokens[0]) > 2:
+        text = tokens[0]
+        tokens = [text[i:i + 2] for i in range(0, len(text), 2)]
+    if not tokens:
+        raise ValueError("Empty hex pattern")
+    
+    parts = []
+    for token in tokens:
+        if token in ("?", "??"):
+            parts.append(b".")
+            continue
+        if len(token) != 2 or any(c not in "0123456789abcdefABCDEF?" for c in token):
+            raise ValueError(f"Invalid byte {token!r} in hex pattern {signature!r}")
+        high, low = token
+        if high == "?":
+            value = int(low, 16)
+            parts.append(b"[" + b"".join(re.escape(bytes([h << 4 | value])) for h in range(16)) + b"]")
+        elif low == "?":
+            base = int(high, 16) << 4
+            parts.append(b"[" + re.escape(bytes([base])) + b"-" + re.escape(bytes([base | 0xF])) + b"]")
+        else:
+            parts.append(re.escape(bytes([int(token, 16)])))
+    return b"".join(parts)
+
+
+def compile_patterns(specs: List[Dict[str, Any]]) -> List[ScanPattern]:
+    """Compile pattern specifications.
+    
+    Each specification has exactly one of ``hex`` (a signature for
+    parse_hex), ``string`` (a literal, searched as UTF-8 and, with
+    ``wide``, also as UTF-16LE) or ``regex`` (a Python regular expression
+    over bytes), and optionally a ``name``.
+    
+    Raises:
+        ValueError: If a specification is invalid
+    """
+    patterns = []
+    for i, spec in enumerate(specs):
+        if not isinstance(spec, dict):
+            raise ValueError(f"Pattern {i} must be an object")
+        kinds = [k for k in ("hex", "string", "regex") if k in spec]
+        if len(kinds) != 1:
+            raise ValueError(f"Pattern {i} needs exactly one of hex, string or regex")
+        kind = kinds[0]
+        value = spec[kind]
+        if not isinstance(value, str) or not value:
+            raise ValueError(f"Pattern {i}: {kind} must be a non-empty string")
+        name = spec.get("name") or f"{kind}:{value}"
+        
+        if kind == "hex":
+            source, flags = parse_hex(value), re.DOTALL
+        elif kind == "string":
+            forms = [value.encode("utf-8")]
+            if spec.get("wide"):
+                forms.append(value.encode("utf-16-le"))
+            source, flags = b"|".join(re.escape(form) for form in forms), 0
+        else:
+            source, flags = value.encode("utf-8"), 0
+        try:
+            regex = re.compile(source, flags)
+        except re.error as e:
+            raise ValueError(f"Pattern {i}: invalid {kind}: {e}")
+        patterns.append(ScanPattern(name, regex))
+    return patterns
+
+
+def scan_file(path: str, patterns: List[ScanPattern], max_matches: int) -> Dict[str, Any]:
+    """Scan one file for every pattern.
+    
+    The file is memory-mapped and each pattern runs over it once in the
+    regex engine, which finds candidates for patterns with a literal prefix
+    with a fast substring search. Offsets in ELF files are also given as
+    virtual addresses.
+    
+    Args:
+        path: File to scan
+        patterns: Compiled patterns
+        max_matches: Matches reported per pattern
+    
+    Returns:
+        Dictionary with ``binary``, ``matches`` and ``truncated``, or
+        ``binary`` and ``error``
+    """
+    result: Dict[str, Any] = {"binary": path}
+    try:
+        elf = ElfFile(path) if ElfFile.is_elf(path) else None
+    except (OSError, ValueError):
+        elf = None
+    
+    matches = []
+    truncated = False
+    try:
+        with open(path, "rb") as f:
+            if os.fstat(f.fileno()).st_size == 0:
+                result.update(matches=[], truncated=False)
+                return result
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                for pattern in patterns:
+                    found = 0
+                    for m in pattern.regex.finditer(data):
+                        if found == max_matches:
+                            truncated = True
+                            break
+                        found += 1
+                        vaddr = elf.vaddr_of(m.start()) if elf is not None else None
+                        matches.append({
+                            "pattern": pattern.name,
+                            "offset": m.start(),
+                            "addr": hex(vaddr) if vaddr is not None else None,
+                            "length": m.end() - m.start(),
+                        })
+    except OSError as e:
+        return {"binary": path, "error": str(e)}
+    matches.sort(key=lambda m: m["offset"])
+    result.update(matches=matches, truncated=truncated)
+    return result
+
+
+class Scanner:
+    """Scans many files for patterns, in parallel worker processes.
+    
+    The regex engine holds the GIL, so files are spread over spawned
+    worker processes rather than threads. Small scans run in-process.
+    """
+    
+    # Total bytes below which files are scanned in-process
+    PARALLEL_THRESHOLD = 64 * 1024 * 1024
+    
+    def __init__(self, workers: int = 0):
+        """Initialize the scanner.
+        
+        Args:
+            workers: Worker processes (0 for one per CPU)
+        """
+        self.workers = workers or os.cpu_count() or 1
+        self._pool: Optional[ProcessPoolExecutor] = None
+        self._lock = threading.Lock()
+    
+    def scan(
+        self,
+        paths: List[str],
+        patterns: List[ScanPattern],
+        max_matches: int = 100,
+        cancel_token: Optional[CancelToken] = None,
+        deadline: Optional[Deadline] = None,
+        on_result: Optional[Callable[[Dict[str, Any]], None]] = None,
+    ) -> List[Dict[str, Any]]:
+        """Scan files for patterns.
+        
+        Args:
+            paths: Files to scan
+            patterns: Compiled patterns
+            max_matches: Matches reported per pattern and file
+            cancel_token: Stops starting further files when cancelled
+            deadline: Stops starting further files when it passes
+            on_result: Called with each file's result as it completes
+        
+        Returns:
+            Per-file results in the order of paths
+        """
+        results: Dict[str, Dict[str, Any]] = {}
+        
+        def stopped() -> Optional[str]:
+            if cancel_token is not None and cancel_token.cancelled:
+                return "Cancelled before this binary was scanned"
+            if deadline is not None and deadline.expired():
+                return "Deadline exceeded before this binary was scanned"
+            return None
+        
+        def emit(result: Dict[str, Any]) -> None:
+            results[result["binary"]] = result
+            if on_result is not None:
+                on_result(result)
+        
+        total = 0
+        for path in paths:
+            try:
+                total += os.path.getsize(path)
+            except OSError:
+                pass
+        
+        if len(paths) < 2 or self.workers == 1 or total < self.PARALLEL_THRESHOLD:
+            for path in paths:
+                reason = stopped()
+                emit({"binary": path, "error": reason} if reason else scan_file(path, patterns, max_matches))
+        else:
+            pool = self._get_pool()
+            pending = {pool.submit(scan_file, path, patterns, max_matches): path for path in paths}
+            while pending:
+                done, _ = wait(pending, timeout=1, return_when=FIRST_COMPLETED)
+                for future in done:
+                    path = pending.pop(future)
+                    try:
+                        emit(future.result())
+                    except Exception as e:
+                        emit({"binary": path, "error": str(e)})
+                reason = stopped()
+                if reason:
+                    for future, path in list(pending.items()):
+                        if future.cancel():
+                            del pending[future]
+                            emit({"binary": path, "error": reason})
+        return [results[path] for path in paths]
+    
+    def _get_pool(self) -> ProcessPoolExecutor:
+        with self._lock:
+            if self._pool is None:
+                # Spawned rather than forked: the proxy is multithreaded
+                self._pool = ProcessPoolExecutor(
+                    max_workers=self.workers, mp_context=multiprocessing.get_context("spawn")
+                )
+            return self._pool
+    
+    def close(self) -> None:
+        """Stop the worker processes."""
+        with self._lock:
+            if self._pool is not None:
+                self._pool.shutdown(wait=False, cancel_futures=True)
+                self._pool = None
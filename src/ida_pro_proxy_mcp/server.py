@@ -1,27 +1,99 @@
 """HTTP Server for IDA Pro Proxy MCP"""
 
 import argparse
+import ipaddress
 import json
 import logging
+import os
 import signal
 import sys
 import threading
+import time
 from http.server import ThreadingHTTPServer, BaseHTTPRequestHandler
-from typing import Optional
+from typing import Any, Dict, List, Optional
 
+from .api import LocalProxy
+from .cancellation import CancelToken, Deadline, DisconnectWatcher
+from .handoff import HandoffListener, confirm_takeover, request_takeover
+from .journal import SessionJournal
 from .models import ProxyConfig
-from .process_manager import ProcessManager
-from .session_manager import SessionManager
 from .router import RequestRouter
 from . import __version__
 
 logger = logging.getLogger(__name__)
 
 
+class ActiveRequests:
+    """Counts MCP requests being handled, so shutdown can wait for them."""
+    
+    def __init__(self):
+        self._count = 0
+        self._cond = threading.Condition()
+    
+    def __enter__(self) -> "ActiveRequests":
+        with self._cond:
+            self._count += 1
+        return self
+    
+    def __exit__(self, *exc) -> None:
+        with self._cond:
+            self._count -= 1
+            if self._count == 0:
+                self._cond.notify_all()
+    
+    @property
+    def count(self) -> int:
+        """Number of requests currently being handled."""
+        with self._cond:
+            return self._count
+    
+    def wait_idle(self, timeout: float) -> bool:
+        """Wait until no requests are being handled.
+        
+        Returns:
+            True if idle, False if the timeout expired first
+        """
+        with self._cond:
+            return self._cond.wait_for(lambda: self._count == 0, timeout=timeout)
+
+
+class EventStream:
+    """Sends the JSON-RPC messages of one request as server-sent events.
+    
+    Headers go out with the first message, so a request that ends up
+    sending no notifications is still answered with a plain JSON body.
+    """
+    
+    def __init__(self, handler: BaseHTTPRequestHandler):
+        self._handler = handler
+        self._lock = threading.Lock()
+        self.started = False
+    
+    def send(self, message: Dict[str, Any]) -> None:
+        """Write one message to the stream."""
+        data = f"event: message\ndata: {json.dumps(message)}\n\n".encode("utf-8")
+        with self._lock:
+            try:
+                if not self.started:
+                    self.started = True
+                    self._handler.send_response(200)
+                    self._handler.send_header("Content-Type", "text/event-stream")
+                    self._handler.send_header("Cache-Control", "no-cache")
+                    self._handler.end_headers()
+                    # The stream has no length; its end is the end of the connection
+                    self._handler.close_connection = True
+                self._handler.wfile.write(data)
+                self._handler.wfile.flush()
+            except (ConnectionAbortedError, ConnectionResetError, BrokenPipeError) as e:
+                logger.debug(f"Client closed event stream: {e}")
+
+
 class ProxyHttpHandler(BaseHTTPRequestHandler):
     """HTTP request handler for the proxy MCP server."""
     
     router: RequestRouter = None  # Set by server
+    active_requests: ActiveRequests = None  # Set by server
+    proxy_server: "ProxyMcpServer" = None  # Set by server, for admin endpoints
     
     def log_message(self, format, *args):
         """Override to use logging module."""
@@ -30,17 +102,47 @@ class ProxyHttpHandler(BaseHTTPRequestHandler):
     def do_POST(self):
         """Handle POST requests."""
         if self.path == "/mcp":
-            self._handle_mcp()
+            with self.active_requests:
+                self._handle_mcp()
+        elif self.path == "/admin/drain":
+            if self._admin_allowed():
+                self.proxy_server.drain()
+                self._send_json(self.proxy_server.drain_status())
         else:
             self.send_error(404, "Not Found")
     
     def do_GET(self):
-        """Handle GET requests (for SSE)."""
+        """Handle GET requests (for SSE and metrics)."""
         if self.path == "/sse":
             self._handle_sse()
+        elif self.path == "/metrics":
+            self._send_json(self.router.metrics.snapshot())
+        elif self.path == "/admin/status":
+            if self._admin_allowed():
+                self._send_json(self.proxy_server.drain_status())
         else:
             self.send_error(404, "Not Found")
     
+    def _admin_allowed(self) -> bool:
+        """Check the admin endpoints are enabled and the client is local.
+        
+        Sends the error response if not.
+        
+        Returns:
+            True if the admin request may be served
+        """
+        if not self.proxy_server.config.admin_endpoints:
+            self.send_error(404, "Not Found")
+            return False
+        address = ipaddress.ip_address(self.client_address[0].split("%", 1)[0])
+        if getattr(address, "ipv4_mapped", None) is not None:
+            address = address.ipv4_mapped
+        if not address.is_loopback:
+            logger.warning(f"Refused admin request {self.path} from {self.client_address[0]}")
+            self.send_error(403, "Forbidden")
+            return False
+        return True
+    
     def _handle_mcp(self):
         """Handle MCP JSON-RPC requests."""
         try:
@@ -48,7 +150,19 @@ class ProxyHttpHandler(BaseHTTPRequestHandler):
             body = self.rfile.read(content_length)
             request = json.loads(body.decode("utf-8"))
             
-            response = self.router.route(request)
+            stream = None
+            if isinstance(request, dict) and request.get("method") == "tools/call":
+                if "text/event-stream" in self.headers.get("Accept", ""):
+                    # Let long calls stream notifications ahead of their response
+                    stream = EventStream(self)
+                # Cancel the child's work if the client hangs up while waiting
+                cancel_token = CancelToken()
+                with DisconnectWatcher(self.connection, cancel_token):
+                    response = self.router.route(
+                        request, cancel_token=cancel_token, notify=stream.send if stream else None
+                    )
+            else:
+                response = self.router.route(request)
             
             if response is None:
                 # Notification, no response needed
@@ -56,6 +170,10 @@ class ProxyHttpHandler(BaseHTTPRequestHandler):
                 self.end_headers()
                 return
             
+            if stream is not None and stream.started:
+                stream.send(response)
+                return
+            
             response_body = json.dumps(response).encode("utf-8")
             
             self.send_response(200)
@@ -71,7 +189,7 @@ class ProxyHttpHandler(BaseHTTPRequestHandler):
                 # This is common on Windows when client times out
                 logger.debug(f"Client closed connection before response could be sent: {e}")
                 return
-            
+        
         except json.JSONDecodeError as e:
             self._send_json_error(-32700, f"Parse error: {e}")
         except (ConnectionAbortedError, ConnectionResetError, BrokenPipeError) as e:
@@ -108,6 +226,19 @@ class ProxyHttpHandler(BaseHTTPRequestHandler):
         except (BrokenPipeError, ConnectionResetError):
             pass
     
+    def _send_json(self, data: dict):
+        """Send a plain JSON response."""
+        response_body = json.dumps(data).encode("utf-8")
+        
+        try:
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", len(response_body))
+            self.end_headers()
+            self.wfile.write(response_body)
+        except (ConnectionAbortedError, ConnectionResetError, BrokenPipeError) as e:
+            logger.debug(f"Connection closed, unable to send response: {e}")
+    
     def _send_json_error(self, code: int, message: str):
         """Send a JSON-RPC error response."""
         response = {
@@ -140,19 +271,63 @@ class ProxyMcpServer:
         self.config = config
         config.validate()
         
-        self.process_manager = ProcessManager(
-            host=config.host,
-            request_timeout=config.request_timeout,
-        )
-        self.session_manager = SessionManager(
-            max_processes=config.max_processes,
-            process_manager=self.process_manager,
-        )
-        self.router = RequestRouter(self.session_manager)
+        self.journal = SessionJournal(config.journal_path) if config.journal_path else None
+        # With a journal, children keep running across proxy restarts
+        self.stop_children_on_exit = self.journal is None
+        
+        # Children must outlive this instance if a successor may take them over
+        child_log_dir = None
+        if self.journal:
+            child_log_dir = str(self.journal.path.parent)
+        elif config.handoff_socket:
+            child_log_dir = os.path.dirname(os.path.abspath(config.handoff_socket))
+        
+        stack = LocalProxy(config, journal=self.journal, child_log_dir=child_log_dir)
+        self.process_manager = stack.process_manager
+        self.watcher = stack.watcher
+        self.index = stack.index
+        self.similarity = stack.similarity
+        self.scanner = stack.scanner
+        self.warmer = stack.warmer
+        self.rebalancer = stack.rebalancer
+        self.session_manager = stack.session_manager
+        self.metrics = stack.metrics
+        self.router = stack.router
+        self.active_requests = ActiveRequests()
         self._server: Optional[ThreadingHTTPServer] = None
+        self._handoff: Optional[HandoffListener] = None
+        self._handed_off = False
+        self._drain_lock = threading.Lock()
+        self._drain_started: Optional[float] = None  # Monotonic time drain began
+        self._drain_deadline: Optional[Deadline] = None
+        self._checkpoints: Dict[str, str] = {}  # session_id -> checkpoint status
+        self._shutdown_called = False
+        self._shutdown_done = threading.Event()
     
-    def serve(self):
-        """Start the HTTP server."""
+    def serve(self, takeover: bool = False):
+        """Start the HTTP server.
+        
+        Args:
+            takeover: Take over the listening socket, sessions and children
+                of the instance accepting takeovers on config.handoff_socket,
+                instead of binding the port
+        
+        Raises:
+            HandoffError: If the takeover failed
+        """
+        # Reattach to children left running by a previous instance first, so
+        # the default process is adopted rather than started again
+        listen_socket = None
+        if takeover:
+            listen_socket, state, control = request_takeover(self.config.handoff_socket)
+            resumed = self.session_manager.resume_from_state(state, probe=False)
+            logger.info(f"Took over {resumed} sessions from the previous instance")
+        else:
+            try:
+                self.session_manager.resume_from_journal()
+            except Exception as e:
+                logger.error(f"Failed to resume sessions from journal: {e}")
+        
         # Ensure default idalib-mcp process is running
         try:
             logger.info("Ensuring default idalib-mcp process is available...")
@@ -167,11 +342,35 @@ class ProxyMcpServer:
         
         # Set router on handler class
         ProxyHttpHandler.router = self.router
+        ProxyHttpHandler.active_requests = self.active_requests
+        ProxyHttpHandler.proxy_server = self
         
-        self._server = ThreadingHTTPServer(
-            (self.config.host, self.config.port),
-            ProxyHttpHandler,
-        )
+        if listen_socket is None:
+            self._server = ThreadingHTTPServer(
+                (self.config.host, self.config.port),
+                ProxyHttpHandler,
+            )
+        else:
+            # Accept on the inherited socket; it is already bound and listening
+            self._server = ThreadingHTTPServer(
+                listen_socket.getsockname()[:2],
+                ProxyHttpHandler,
+                bind_and_activate=False,
+            )
+            self._server.socket.close()
+            self._server.socket = listen_socket
+            self._server.server_address = listen_socket.getsockname()
+            confirm_takeover(control)
+        
+        if self.config.handoff_socket:
+            self._handoff = HandoffListener(
+                self.config.handoff_socket,
+                self._server.socket,
+                self.session_manager.freeze,
+                self._complete_handoff,
+                self.session_manager.thaw,
+            )
+            self._handoff.start()
         
         logger.info(
             f"IDA Pro Proxy MCP server v{__version__} starting on "
@@ -186,24 +385,150 @@ class ProxyMcpServer:
         finally:
             self.shutdown()
     
+    def _complete_handoff(self):
+        """Stop accepting once a successor has taken over.
+        
+        serve() then returns and shutdown() leaves the children to the successor.
+        """
+        self._handed_off = True
+        # The successor writes the journal from now on; opens and closes
+        # still waiting here must go to it
+        self.session_manager.journal = None
+        self.session_manager.thaw(handed_over=True)
+        self._server.shutdown()
+    
+    def drain(self) -> None:
+        """Start draining: refuse new calls, finish in-flight ones, then shut down.
+        
+        In-flight calls get up to drain_grace seconds. Meanwhile every
+        session's database is checkpointed, each save queued behind the calls
+        already running on its process. Returns immediately; progress is
+        reported by drain_status().
+        """
+        with self._drain_lock:
+            if self._drain_started is not None or self._shutdown_called:
+                return
+            self._drain_started = time.monotonic()
+            self._drain_deadline = Deadline(self.config.drain_grace)
+        
+        logger.info(
+            f"Draining: {self.active_requests.count} requests in flight, "
+            f"grace {self.config.drain_grace}s"
+        )
+        self.router.stop_admission()
+        if self.warmer:
+            self.warmer.close()
+        if self.rebalancer:
+            self.rebalancer.close()
+        threading.Thread(target=self._run_drain, name="drain", daemon=True).start()
+    
+    def _run_drain(self) -> None:
+        deadline = self._drain_deadline
+        checkpoint_threads: List[threading.Thread] = []
+        for session in self.session_manager.list_sessions():
+            session_id = session["session_id"]
+            with self._drain_lock:
+                self._checkpoints[session_id] = "pending"
+            thread = threading.Thread(
+                target=self._checkpoint, args=(session_id, deadline),
+                name=f"checkpoint-{session_id}", daemon=True,
+            )
+            thread.start()
+            checkpoint_threads.append(thread)
+        
+        if not self.active_requests.wait_idle(timeout=max(deadline.remaining(), 0)):
+            logger.warning(
+                f"Drain grace expired with {self.active_requests.count} requests still running"
+            )
+        for thread in checkpoint_threads:
+            thread.join(timeout=max(deadline.remaining(), 0))
+        
+        logger.info(f"Drain finished after {time.monotonic() - self._drain_started:.1f}s")
+        self.shutdown()
+    
+    def _checkpoint(self, session_id: str, deadline: Deadline) -> None:
+        """Save one session's database during a drain, recording the outcome."""
+        try:
+            self.session_manager.checkpoint_session(session_id, deadline=deadline)
+            status = "saved"
+        except (ValueError, RuntimeError) as e:
+            logger.warning(f"Checkpoint of {session_id} failed: {e}")
+            status = f"failed: {e}"
+        with self._drain_lock:
+            self._checkpoints[session_id] = status
+    
+    def drain_status(self) -> Dict[str, Any]:
+        """Report the server's lifecycle state and drain progress.
+        
+        Returns:
+            Status dictionary for JSON serialization
+        """
+        with self._drain_lock:
+            started = self._drain_started
+            deadline = self._drain_deadline
+            checkpoints = dict(self._checkpoints)
+        
+        if self._shutdown_done.is_set():
+            state = "stopped"
+        elif started is not None or self._shutdown_called:
+            state = "draining"
+        else:
+            state = "serving"
+        
+        status: Dict[str, Any] = {
+            "state": state,
+            "in_flight": self.active_requests.count,
+            "sessions": self.session_manager.session_count,
+        }
+        if started is not None:
+            status["drain_elapsed"] = round(time.monotonic() - started, 3)
+            status["grace_remaining"] = round(max(deadline.remaining(), 0), 3)
+            status["checkpoints"] = checkpoints
+        return status
+    
     def shutdown(self):
-        """Shutdown the server and all child processes."""
-        if hasattr(self, '_shutdown_called') and self._shutdown_called:
-            return  # Already shutting down
+        """Shutdown the server and all child processes.
+        
+        Later calls wait for the first one to finish.
+        """
+        if self._shutdown_called:
+            # Already shutting down
+            self._shutdown_done.wait()
+            return
         self._shutdown_called = True
         
         logger.info("Shutting down...")
         
-        # First stop all child processes
-        try:
-            self.session_manager.close_all()
-        except Exception as e:
-            logger.warning(f"Error closing sessions: {e}")
+        if self._handoff:
+            self._handoff.close()
+        if self.warmer:
+            self.warmer.close()
+        if self.rebalancer:
+            self.rebalancer.close()
         
-        try:
-            self.process_manager.stop_all()
-        except Exception as e:
-            logger.warning(f"Error stopping processes: {e}")
+        if self._handed_off or not self.stop_children_on_exit:
+            # Stop accepting and let in-flight calls finish, then leave the
+            # children (and the journal) to the next instance
+            if self._server:
+                self._server.shutdown()
+            if not self.active_requests.wait_idle(timeout=self.config.request_timeout):
+                logger.warning(f"{self.active_requests.count} requests still running at exit")
+            try:
+                self.session_manager.detach()
+                self.process_manager.detach_all()
+            except Exception as e:
+                logger.warning(f"Error detaching from processes: {e}")
+        else:
+            # First stop all child processes
+            try:
+                self.session_manager.close_all()
+            except Exception as e:
+                logger.warning(f"Error closing sessions: {e}")
+            
+            try:
+                self.process_manager.stop_all()
+            except Exception as e:
+                logger.warning(f"Error stopping processes: {e}")
         
         # Then shutdown HTTP server
         if self._server:
@@ -212,6 +537,15 @@ class ProxyMcpServer:
             except Exception as e:
                 logger.warning(f"Error shutting down HTTP server: {e}")
         
+        if self.watcher:
+            self.watcher.close()
+        if self.index:
+            self.index.close()
+        if self.similarity:
+            self.similarity.close()
+        self.scanner.close()
+        
+        self._shutdown_done.set()
         logger.info("Shutdown complete")
 
 
@@ -220,7 +554,7 @@ def load_config(config_path: Optional[str] = None) -> ProxyConfig:
     
     Args:
         config_path: Path to config file (optional)
-        
+    
     Returns:
         ProxyConfig instance
     """
@@ -240,6 +574,84 @@ def load_config(config_path: Optional[str] = None) -> ProxyConfig:
                     config.base_port = data["base_port"]
                 if "request_timeout" in data:
                     config.request_timeout = data["request_timeout"]
+                if "breaker_failure_threshold" in data:
+                    config.breaker_failure_threshold = data["breaker_failure_threshold"]
+                if "breaker_timeout_threshold" in data:
+                    config.breaker_timeout_threshold = data["breaker_timeout_threshold"]
+                if "breaker_reset_timeout" in data:
+                    config.breaker_reset_timeout = data["breaker_reset_timeout"]
+                if "breaker_probe_timeout" in data:
+                    config.breaker_probe_timeout = data["breaker_probe_timeout"]
+                if "cancel_grace" in data:
+                    config.cancel_grace = data["cancel_grace"]
+                if "hedging" in data:
+                    config.hedging = data["hedging"]
+                if "hedge_percentile" in data:
+                    config.hedge_percentile = data["hedge_percentile"]
+                if "hedge_min_samples" in data:
+                    config.hedge_min_samples = data["hedge_min_samples"]
+                if "journal_path" in data:
+                    config.journal_path = data["journal_path"]
+                if "handoff_socket" in data:
+                    config.handoff_socket = data["handoff_socket"]
+                if "drain_grace" in data:
+                    config.drain_grace = data["drain_grace"]
+                if "admin_endpoints" in data:
+                    config.admin_endpoints = data["admin_endpoints"]
+                if "result_cache_size" in data:
+                    config.result_cache_size = data["result_cache_size"]
+                if "watch_binaries" in data:
+                    config.watch_binaries = data["watch_binaries"]
+                if "reopen_on_change" in data:
+                    config.reopen_on_change = data["reopen_on_change"]
+                if "function_index" in data:
+                    config.function_index = data["function_index"]
+                if "similarity_workers" in data:
+                    config.similarity_workers = data["similarity_workers"]
+                if "elf_cache_size" in data:
+                    config.elf_cache_size = data["elf_cache_size"]
+                if "scan_workers" in data:
+                    config.scan_workers = data["scan_workers"]
+                if "open_summary" in data:
+                    config.open_summary = data["open_summary"]
+                if "warm_cache" in data:
+                    config.warm_cache = data["warm_cache"]
+                if "warm_limit" in data:
+                    config.warm_limit = data["warm_limit"]
+                if "prefetch_depth" in data:
+                    config.prefetch_depth = data["prefetch_depth"]
+                if "memory_budget_mb" in data:
+                    config.memory_budget_mb = data["memory_budget_mb"]
+                if "memory_reserve_mb" in data:
+                    config.memory_reserve_mb = data["memory_reserve_mb"]
+                if "cgroups" in data:
+                    config.cgroups = data["cgroups"]
+                if "cgroup_root" in data:
+                    config.cgroup_root = data["cgroup_root"]
+                if "cgroup_memory_max_mb" in data:
+                    config.cgroup_memory_max_mb = data["cgroup_memory_max_mb"]
+                if "cpu_affinity" in data:
+                    config.cpu_affinity = data["cpu_affinity"]
+                if "cores_per_child" in data:
+                    config.cores_per_child = data["cores_per_child"]
+                if "proxy_cores" in data:
+                    config.proxy_cores = data["proxy_cores"]
+                if "numa_membind" in data:
+                    config.numa_membind = data["numa_membind"]
+                if "pack_binary_mb" in data:
+                    config.pack_binary_mb = data["pack_binary_mb"]
+                if "pack_max_sessions" in data:
+                    config.pack_max_sessions = data["pack_max_sessions"]
+                if "pack_memory_mb" in data:
+                    config.pack_memory_mb = data["pack_memory_mb"]
+                if "pack_max_load" in data:
+                    config.pack_max_load = data["pack_max_load"]
+                if "rebalance_interval" in data:
+                    config.rebalance_interval = data["rebalance_interval"]
+                if "rebalance_queue_depth" in data:
+                    config.rebalance_queue_depth = data["rebalance_queue_depth"]
+                if "warm_sessions" in data:
+                    config.warm_sessions = data["warm_sessions"]
         except FileNotFoundError:
             logger.warning(f"Config file not found: {config_path}")
         except json.JSONDecodeError as e:
@@ -250,6 +662,10 @@ def load_config(config_path: Optional[str] = None) -> ProxyConfig:
 
 def main():
     """Main entry point."""
+    if sys.argv[1:2] == ["batch"]:
+        from .batch import main as batch_main
+        sys.exit(batch_main(sys.argv[2:]))
+    
     parser = argparse.ArgumentParser(
         description="IDA Pro Proxy MCP - Multi-binary analysis proxy"
     )
@@ -277,6 +693,28 @@ def main():
         default=None,
         help="Path to configuration file",
     )
+    parser.add_argument(
+        "--journal",
+        type=str,
+        default=None,
+        help="Journal sessions to this file and reattach to running children on restart",
+    )
+    parser.add_argument(
+        "--stop-children",
+        action="store_true",
+        help="Stop child processes on exit even when journaling sessions",
+    )
+    parser.add_argument(
+        "--handoff-socket",
+        type=str,
+        default=None,
+        help="Unix socket on which a newer proxy can take over this one",
+    )
+    parser.add_argument(
+        "--takeover",
+        action="store_true",
+        help="Take over from the proxy running on --handoff-socket instead of binding the port",
+    )
     parser.add_argument(
         "--verbose", "-v",
         action="store_true",
@@ -300,9 +738,17 @@ def main():
     config.port = args.port
     if args.max_processes is not None:
         config.max_processes = args.max_processes
+    if args.journal is not None:
+        config.journal_path = args.journal
+    if args.handoff_socket is not None:
+        config.handoff_socket = args.handoff_socket
+    if args.takeover and not config.handoff_socket:
+        parser.error("--takeover requires --handoff-socket")
     
     # Create and run server
     server = ProxyMcpServer(config)
+    if args.stop_children:
+        server.stop_children_on_exit = True
     
     # Flag to track shutdown state
     shutdown_event = threading.Event()
@@ -314,9 +760,16 @@ def main():
             logger.warning("Forced exit on second signal")
             sys.exit(1)
         
-        logger.info("Received signal, shutting down...")
         shutdown_event.set()
         
+        if signum == signal.SIGTERM:
+            # Let in-flight calls finish; drain() shuts down when done
+            logger.info("Received SIGTERM, draining...")
+            server.drain()
+            return
+        
+        logger.info("Received signal, shutting down...")
+        
         # Shutdown HTTP server from a separate thread to avoid blocking
         # HTTPServer.shutdown() must be called from a different thread than serve_forever()
         def do_shutdown():
@@ -329,7 +782,7 @@ def main():
     signal.signal(signal.SIGTERM, signal_handler)
     
     try:
-        server.serve()
+        server.serve(takeover=args.takeover)
     except Exception as e:
         logger.error(f"Server error: {e}")
     finally:
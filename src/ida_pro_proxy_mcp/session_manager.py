@@ -1,18 +1,42 @@
 """Session Manager with LRU eviction for IDA Pro Proxy MCP"""
 
+import functools
 import json
 import logging
+import os
+import shutil
+import tempfile
 import threading
+import time
+from collections import OrderedDict
+from contextlib import contextmanager
 from datetime import datetime
 from pathlib import Path
-from typing import Dict, List, Optional, Set
+from typing import Any, Callable, Dict, Iterator, List, Optional, Set, Tuple
 
-from .models import ProxySession
+from .cancellation import Deadline
+from .func_index import FunctionIndex
+from .hashing import FileHasher
+from .journal import SessionJournal
+from .memory import MIB, MemoryPredictor, mem_available
+from .models import ProxySession, ReplicaInfo
 from .process_manager import ProcessManager
+from .result_cache import ResultCache
+from .summary import BinarySummarizer
+from .watcher import FileWatcher
 
 logger = logging.getLogger(__name__)
 
 
+def _changes_sessions(method: Callable[..., Any]) -> Callable[..., Any]:
+    """Run a SessionManager method as a change a handoff's export waits for."""
+    @functools.wraps(method)
+    def wrapper(self, *args, **kwargs):
+        with self._changing():
+            return method(self, *args, **kwargs)
+    return wrapper
+
+
 class SessionManager:
     """Manages proxy sessions with LRU eviction.
     
@@ -20,23 +44,136 @@ class SessionManager:
     when sessions are closed or evicted. When the maximum number of processes
     is reached, the least recently used session is evicted and its process
     is reused for the new session.
+    
+    With a memory budget or reserve, opens are also admitted by memory:
+    the children's PSS, the host's MemAvailable and the predicted memory of
+    the opens still in progress decide whether the new binary fits, and
+    least recently used sessions are evicted until it does.
+    
+    With warm_sessions set, an evicted session is hibernated instead of
+    forgotten. Its database is saved first, and it stays warm: its cached
+    results and summary are kept and still served. Past warm_sessions, the
+    oldest warm sessions turn cold and keep only their content hash (and
+    the function index kept under it). Opening the same content again, or
+    calling a tool on the session, reopens it under the same session ID.
     """
     
-    def __init__(self, max_processes: int, process_manager: ProcessManager):
+    # Upper bound for waiting on another thread's restore (covers a first-time open)
+    RESTORE_WAIT_TIMEOUT = 660
+    # How long after our own save database change events are attributed to it
+    OWN_WRITE_GRACE = 2.0
+    # A session used this recently counts towards its process's expected load
+    PACK_ACTIVE_WINDOW = 60.0
+    # How long a migration lets calls queued on the old process finish there
+    MIGRATE_DRAIN_TIMEOUT = 30.0
+    # Most cold sessions remembered
+    MAX_COLD_SESSIONS = 256
+    # How long a handoff's export waits for changes in progress to finish
+    FREEZE_TIMEOUT = 30.0
+    # How long a change waits for a handoff to finish; longer than a handoff
+    # waits for the successor's confirmation
+    HANDOFF_WAIT_TIMEOUT = 150.0
+    
+    def __init__(
+        self,
+        max_processes: int,
+        process_manager: ProcessManager,
+        journal: Optional[SessionJournal] = None,
+        result_cache: Optional[ResultCache] = None,
+        watcher: Optional[FileWatcher] = None,
+        reopen_on_change: bool = False,
+        index: Optional[FunctionIndex] = None,
+        summarizer: Optional[BinarySummarizer] = None,
+        memory_budget: int = 0,
+        memory_reserve: int = 0,
+        pack_binary_size: int = 0,
+        pack_max_sessions: int = 4,
+        pack_memory: int = 0,
+        pack_max_load: int = 2,
+        warm_sessions: int = 0,
+    ):
         """Initialize the session manager.
         
         Args:
             max_processes: Maximum number of concurrent sessions/processes
             process_manager: ProcessManager instance for managing child processes
+            journal: Where to persist the session table, if anywhere
+            result_cache: Cache of read-only results to invalidate on changes
+            watcher: Watches open binaries and their databases for changes
+            reopen_on_change: Whether to reopen a session in the background
+                when its binary or database changes on disk
+            index: Cross-binary symbol index to keep up to date
+            summarizer: Gathers a summary of each binary once it is opened
+            memory_budget: Bytes the children may use in total (PSS), 0 for
+                no budget
+            memory_reserve: Bytes of host MemAvailable to leave free, 0 to
+                ignore the host's memory
+            pack_binary_size: Binaries up to this many bytes may share a
+                process with other small binaries, 0 to give every binary
+                its own process
+            pack_max_sessions: Most sessions one shared process hosts
+            pack_memory: Predicted bytes the sessions of one shared process
+                may take together, 0 for no bound
+            pack_max_load: Queued calls plus recently used sessions at which
+                a shared process takes no more binaries
+            warm_sessions: Evicted sessions whose cached results and summary
+                are kept, 0 to forget evicted sessions
         """
         self.max_processes = max_processes
         self.process_manager = process_manager
+        self.journal = journal
+        self.result_cache = result_cache
+        self.watcher = watcher
+        self.reopen_on_change = reopen_on_change
+        self.index = index
+        self.summarizer = summarizer
+        self.memory_budget = memory_budget
+        self.memory_reserve = memory_reserve
+        self.pack_binary_size = pack_binary_size
+        self.pack_max_sessions = pack_max_sessions
+        self.pack_memory = pack_memory
+        self.pack_max_load = pack_max_load
+        self.warm_sessions = warm_sessions
+        self.hibernations = 0
+        self.wakes = 0
+        self.packed_opens = 0
+        self.migrations = 0
+        self.migration_failures = 0
+        self.predictor = MemoryPredictor()
+        self.memory_evictions = 0
+        self.memory_refusals = 0
+        self._pending_memory: Dict[str, int] = {}  # content hash -> predicted bytes of its open
         self._sessions: Dict[str, ProxySession] = {}  # session_id -> ProxySession
-        self._binary_to_session: Dict[str, str] = {}  # binary_path -> session_id
-        self._port_to_session: Dict[int, str] = {}  # port -> session_id (for tracking which ports have sessions)
+        self._binary_to_session: Dict[str, str] = {}  # binary_path or alias -> session_id
+        self._hash_to_session: Dict[str, str] = {}  # content hash -> session_id
+        self._watched: Dict[str, str] = {}  # watched binary/database path -> session_id
+        self._own_writes: Dict[str, float] = {}  # session_id -> expect own database writes until
+        self._hasher = FileHasher()
+        self._port_sessions: Dict[int, List[str]] = {}  # port -> session_ids (primaries and replicas) it serves
+        self._pack_ports: Set[int] = set()  # ports whose sessions are small binaries that may share them
         self._current_session_id: Optional[str] = None
         self._lru_order: List[str] = []  # session_ids in LRU order (oldest first)
         self._lock = threading.RLock()
+        self._restore_done: Dict[str, threading.Event] = {}  # session_id -> set when restore ends
+        self._opening: Dict[str, threading.Event] = {}  # content hash -> set when its open ends
+        self._reserved_ports: Set[int] = set()  # ports a binary is being opened on
+        self._closing: Dict[int, int] = {}  # port -> evicted sessions still being closed on it
+        self._starting = 0  # processes being started outside the lock
+        self._pins: Dict[str, int] = {}  # session_id -> callers holding it open
+        self._writes: Dict[str, int] = {}  # session_id -> calls in progress that may modify its database
+        self._routes: Dict[Tuple[int, str], int] = {}  # (port, IDA session) -> calls holding it
+        self._routes_released = threading.Condition(self._lock)
+        # session_id -> warm or cold session, oldest hibernation first
+        self._hibernated: "OrderedDict[str, ProxySession]" = OrderedDict()
+        self._waking: Set[str] = set()  # hibernated session_ids being reopened in the background
+        self._changes = 0  # opens, closes, migrations and restores in progress
+        self._changer = threading.local()  # .depth: changes the current thread is inside
+        self._frozen = False  # set while a handoff's export is being taken over
+        self._handed_over = False
+        self._changes_settled = threading.Condition(self._lock)
+        
+        # Replace children whose circuit breaker reports them as wedged
+        self.process_manager.on_wedged = self._on_process_wedged
     
     def _update_lru(self, session_id: str) -> None:
         """Move session to end of LRU list (most recently used).
@@ -48,42 +185,120 @@ class SessionManager:
             self._lru_order.remove(session_id)
         self._lru_order.append(session_id)
     
+    def _bind(self, port: int, session_id: str) -> None:
+        """Record that a process serves a session. Called with the lock held."""
+        session_ids = self._port_sessions.setdefault(port, [])
+        if session_id not in session_ids:
+            session_ids.append(session_id)
+    
+    def _unbind(self, port: int, session_id: str) -> None:
+        """Record that a process no longer serves a session. Called with the lock held."""
+        session_ids = self._port_sessions.get(port)
+        if session_ids is None or session_id not in session_ids:
+            return
+        session_ids.remove(session_id)
+        if not session_ids:
+            del self._port_sessions[port]
+            self._pack_ports.discard(port)
+    
     def _get_idle_port(self) -> Optional[int]:
         """Get a port of an idle process (process without active session).
         
+        Processes still draining cancelled calls are not considered idle.
+        
         Returns:
             Port number of idle process, or None if no idle processes
         """
         active_ports = self.process_manager.active_ports
         for port in active_ports:
-            if port not in self._port_to_session:
+            if port in self._port_sessions or port in self._reserved_ports or port in self._closing:
+                continue
+            if not self.process_manager.is_draining(port):
                 return port
         return None
     
-    def _evict_lru_for_reuse(self) -> Optional[int]:
-        """Evict the least recently used session and return its process port.
+    def _detach_for_reuse(self) -> Tuple[List[ProxySession], Optional[int]]:
+        """Detach LRU sessions until a process serves none, and reserve its port.
         
-        This closes the IDA session but keeps the process running for reuse.
+        Called with the lock held. A shared process is only free once all
+        its sessions are gone, so this may take several evictions. The
+        detached sessions must be closed with _close_evicted() before the
+        port is used.
         
         Returns:
-            Port of the evicted session's process, or None if no sessions
+            Tuple of the detached sessions and the freed port, or None if
+            no session is left to evict
         """
-        if not self._lru_order:
+        victims = []
+        while True:
+            session = self._detach_lru()
+            if session is None:
+                return victims, None
+            victims.append(session)
+            port = session.process_port
+            # A port still being packed into isn't free either
+            if port not in self._port_sessions and port not in self._reserved_ports:
+                self._reserved_ports.add(port)
+                return victims, port
+    
+    def _detach_lru(self) -> Optional[ProxySession]:
+        """Take the least recently used session out of use so it can be evicted.
+        
+        Called with the lock held. Pinned sessions are skipped and background
+        sessions go first. The session is no longer found, routed to or
+        picked again, and its processes count as busy until
+        _close_evicted() has closed it.
+        
+        Returns:
+            The detached session, or None if no sessions
+        """
+        unpinned = self._evictable()
+        if not unpinned:
             return None
         
-        # Get oldest session (front of list)
-        oldest_session_id = self._lru_order[0]
+        # Get oldest session
+        oldest_session_id = unpinned[0]
         session = self._sessions.get(oldest_session_id)
         
         if session is None:
-            self._lru_order.pop(0)
+            self._lru_order.remove(oldest_session_id)
             return None
         
         logger.info(f"Evicting LRU session: {oldest_session_id}")
         
-        # Get the port before closing
+        # Remove session from our tracking; a warm session keeps its cached results
+        self._sessions.pop(oldest_session_id, None)
+        self._forget_binary(session, keep_results=self.warm_sessions > 0)
+        for port in [session.process_port] + [replica.port for replica in session.replicas]:
+            self._unbind(port, oldest_session_id)
+            self._closing[port] = self._closing.get(port, 0) + 1
+        self._lru_order.remove(oldest_session_id)
+        
+        # Update current session if needed
+        if self._current_session_id == oldest_session_id:
+            self._current_session_id = self._lru_order[-1] if self._lru_order else None
+            if self._current_session_id and self._current_session_id in self._sessions:
+                self._sessions[self._current_session_id].is_current = True
+        return session
+    
+    def _close_evicted(self, session: ProxySession) -> None:
+        """Close a session detached by _detach_lru(). Called without the lock.
+        
+        This closes the IDA session but keeps the process running for reuse.
+        With hibernation on, the database is saved first and the session
+        kept warm; if the save fails it is forgotten instead.
+        """
         port = session.process_port
         
+        # A saved database keeps the analysis the cached results came from
+        hibernate = self.warm_sessions > 0
+        if hibernate:
+            try:
+                self._save_database(session)
+            except RuntimeError as e:
+                logger.warning(f"Could not save {session.session_id}, closing it instead of hibernating it: {e}")
+                hibernate = False
+        
         # Close the IDA session on the process (but don't terminate the process)
         try:
             request = {
@@ -100,38 +315,265 @@ class SessionManager:
             self.process_manager.forward_request(port, request)
         except Exception as e:
             logger.warning(f"Failed to close IDA session during eviction: {e}")
+        self.process_manager.forget_session(port, session.ida_session_id)
+        self._retire_work_dir(session)
         
-        # Remove session from our tracking
-        self._sessions.pop(oldest_session_id, None)
-        self._binary_to_session.pop(session.binary_path, None)
-        self._port_to_session.pop(port, None)
-        self._lru_order.pop(0)
+        ports = [port] + [replica.port for replica in session.replicas]
+        for replica in session.replicas:
+            self._close_replica(replica)
+        session.replicas = []
         
-        # Update current session if needed
-        if self._current_session_id == oldest_session_id:
-            self._current_session_id = self._lru_order[-1] if self._lru_order else None
-            if self._current_session_id and self._current_session_id in self._sessions:
-                self._sessions[self._current_session_id].is_current = True
+        with self._lock:
+            for closed in ports:
+                self._closed(closed)
+            # Content opened again meanwhile already has a new session
+            if hibernate and session.content_hash not in self._hash_to_session:
+                self._hibernate(session)
+            elif self.result_cache is not None:
+                self.result_cache.invalidate(session.session_id)
         
-        logger.info(f"Evicted session: {oldest_session_id}, process on port {port} available for reuse")
-        return port
+        logger.info(f"Evicted session: {session.session_id} from the process on port {port}")
+    
+    def _closed(self, port: int) -> None:
+        """Note that a session or replica being closed on a process is gone. Called with the lock held."""
+        remaining = self._closing.get(port, 0) - 1
+        if remaining > 0:
+            self._closing[port] = remaining
+        else:
+            self._closing.pop(port, None)
+    
+    def _hibernate(self, session: ProxySession) -> None:
+        """Keep an evicted session warm, turning the oldest warm ones cold.
+        
+        Called with the lock held.
+        """
+        session.tier = "warm"
+        session.is_current = False
+        self._hibernated[session.session_id] = session
+        self._hibernated.move_to_end(session.session_id)
+        self.hibernations += 1
+        warm = [s for s in self._hibernated.values() if s.tier == "warm"]
+        for cold in warm[:max(0, len(warm) - self.warm_sessions)]:
+            cold.tier = "cold"
+            cold.summary = None
+            if self.result_cache is not None:
+                self.result_cache.invalidate(cold.session_id)
+        while len(self._hibernated) > self.warm_sessions + self.MAX_COLD_SESSIONS:
+            self._hibernated.popitem(last=False)
+    
+    def _take_hibernated(self, content_hash: str) -> Optional[ProxySession]:
+        """Remove and return the hibernated session of some content. Called with the lock held."""
+        for session_id, session in self._hibernated.items():
+            if session.content_hash == content_hash:
+                del self._hibernated[session_id]
+                session.tier = "hot"
+                return session
+        return None
+    
+    def get_hibernated(self, session_id: str) -> Optional[ProxySession]:
+        """Get a warm or cold session by ID."""
+        with self._lock:
+            return self._hibernated.get(session_id)
+    
+    @_changes_sessions
+    def wake_session(self, session_id: str) -> ProxySession:
+        """Reopen a hibernated session, keeping its session ID.
+        
+        Args:
+            session_id: Session to reopen
+        
+        Returns:
+            The reopened session
+        
+        Raises:
+            ValueError: If the session is neither open nor hibernated
+            RuntimeError: If the binary is gone, changed, or failed to open
+        """
+        with self._lock:
+            session = self._sessions.get(session_id) or self._hibernated.get(session_id)
+        if session is None:
+            raise ValueError(f"Session not found: {session_id}")
+        if session.tier == "hot":
+            return session
+        
+        logger.info(f"Reopening {session.tier} session {session_id}")
+        try:
+            opened = self.open_session(
+                session.binary_path,
+                session.run_auto_analysis,
+                make_current=False,
+                session_class=session.session_class,
+            )
+        except FileNotFoundError as e:
+            opened, error = None, str(e)
+        else:
+            error = f"it is open as {opened.session_id}"
+        if opened is None or opened is not session:
+            # The binary changed; what was kept describes content that is gone
+            with self._lock:
+                self._hibernated.pop(session_id, None)
+            if self.result_cache is not None:
+                self.result_cache.invalidate(session_id)
+            raise RuntimeError(f"Could not reopen session {session_id} as {session.binary_path} changed: {error}")
+        return opened
+    
+    def wake_in_background(self, session_id: str) -> bool:
+        """Start reopening a hibernated session, unless that is under way.
+        
+        Returns:
+            Whether the session is hibernated
+        """
+        with self._lock:
+            if session_id not in self._hibernated:
+                return False
+            if session_id in self._waking:
+                return True
+            self._waking.add(session_id)
+        
+        def wake():
+            try:
+                self.wake_session(session_id)
+            except (ValueError, RuntimeError) as e:
+                logger.warning(f"Failed to reopen session {session_id}: {e}")
+            finally:
+                with self._lock:
+                    self._waking.discard(session_id)
+        
+        threading.Thread(target=wake, name=f"wake-{session_id}", daemon=True).start()
+        return True
     
-    def open_session(self, binary_path: str, run_auto_analysis: bool = True) -> ProxySession:
+    def hibernation_to_dict(self) -> Dict:
+        """Summarize the hibernated sessions for JSON serialization."""
+        with self._lock:
+            tiers = [s.tier for s in self._hibernated.values()]
+            return {
+                "warm": tiers.count("warm"),
+                "cold": tiers.count("cold"),
+                "reopening": len(self._waking),
+                "hibernations": self.hibernations,
+                "wakes": self.wakes,
+            }
+    
+    def _open_binary_on_port(self, port: int, path: Path, run_auto_analysis: bool) -> str:
+        """Call idalib_open for a binary on the given process.
+        
+        Args:
+            port: Port of the idalib-mcp process
+            path: Resolved path to the binary file
+            run_auto_analysis: Whether to run IDA auto-analysis
+        
+        Returns:
+            Session ID returned by idalib-mcp
+        
+        Raises:
+            RuntimeError: If the process failed to open the binary
+        """
+        binary_path_str = str(path)
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {
+                "name": "idalib_open",
+                "arguments": {
+                    "input_path": binary_path_str,
+                    "run_auto_analysis": run_auto_analysis,
+                }
+            }
+        }
+        
+        try:
+            # Use longer timeout for opening files (especially on first open)
+            # Check if .i64/.idb file exists to estimate timeout needed
+            import platform
+            is_windows = platform.system() == "Windows"
+            
+            # Check for existing IDA database files
+            has_database = any(p.exists() for p in self._database_paths(path))
+            
+            if has_database:
+                # Database exists, should be fast (10-60 seconds)
+                open_timeout = 120
+            else:
+                # First time opening, may need to create database
+                # Even without auto-analysis, this can take time on Windows
+                open_timeout = 600
+            
+            logger.info(f"Opening binary with timeout={open_timeout}s (has_database={has_database}, windows={is_windows})")
+            response = self.process_manager.forward_request(port, request, timeout=open_timeout)
+        except Exception as e:
+            raise RuntimeError(f"Failed to open binary: {e}")
+        
+        # Extract session ID from response
+        if "error" in response:
+            raise RuntimeError(f"idalib_open failed: {response['error']}")
+        
+        result = response.get("result", {})
+        if isinstance(result, dict) and "content" in result:
+            # MCP tools/call response format
+            content = result["content"]
+            if isinstance(content, list) and len(content) > 0 and isinstance(content[0], dict):
+                text_content = content[0].get("text", "{}")
+                try:
+                    result_data = json.loads(text_content)
+                except ValueError:
+                    # A child reporting its error as plain text
+                    raise RuntimeError(f"idalib_open failed: {text_content}")
+            else:
+                result_data = {}
+        else:
+            result_data = result
+        
+        if not isinstance(result_data, dict) or not result_data.get("success"):
+            error = result_data.get("error", "Unknown error") if isinstance(result_data, dict) else result_data
+            raise RuntimeError(f"idalib_open failed: {error}")
+        
+        session_data = result_data.get("session", {})
+        return session_data.get("session_id", "unknown")
+    
+    def _update_process_info(self, port: int, ida_session_id: str, binary_path: str) -> None:
+        """Record which IDA session a process now serves."""
+        self.process_manager.record_session(port, ida_session_id, binary_path)
+    
+    @_changes_sessions
+    def open_session(
+        self,
+        binary_path: str,
+        run_auto_analysis: bool = True,
+        make_current: bool = True,
+        pin: bool = False,
+        session_class: str = "interactive",
+    ) -> ProxySession:
         """Open a new session for a binary file.
         
-        If the binary is already open, returns the existing session.
+        Sessions are identified by the binary's content hash: if the same
+        content is already open, possibly under another path, the existing
+        session is returned and the path recorded as an alias. A path whose
+        content changed since it was opened gets a fresh session.
         Priority for getting a process:
         1. Reuse an idle process (process without active session)
-        2. Start a new process if under max_processes limit
-        3. Evict LRU session and reuse its process
+        2. Share a process with other small binaries, if packing is enabled
+        3. Start a new process if under max_processes limit
+        4. Evict LRU session and reuse its process
+        
+        The process is reserved under the lock, but starting it, closing
+        evicted sessions and opening the binary happen outside it, so opens
+        of different binaries run in parallel and other calls aren't held
+        up. A second open of content that is still being opened waits for
+        the first.
         
         Args:
             binary_path: Path to the binary file
             run_auto_analysis: Whether to run IDA auto-analysis
-            
+            make_current: Whether the session becomes the current session
+            pin: Whether to pin the session before returning it; the caller
+                must unpin() it
+            session_class: "interactive" or "background"; an interactive
+                open of a background session makes it interactive
+        
         Returns:
             ProxySession for the opened binary
-            
+        
         Raises:
             FileNotFoundError: If binary file doesn't exist
             RuntimeError: If failed to open session
@@ -143,133 +585,655 @@ class SessionManager:
         if not path.exists():
             raise FileNotFoundError(f"Binary file not found: {binary_path}")
         
+        # Hash before taking the lock; a cache hit only costs a stat()
+        content_hash = self._hasher.hash_file(path)
+        size = path.stat().st_size
+        predicted = self.predictor.predict(size)
+        needed = predicted if self._memory_limited else 0
+        
+        while True:
+            with self._lock:
+                # Check if already open
+                session = self._find_open_content(binary_path_str, content_hash)
+                if session is not None:
+                    session_id = session.session_id
+                    session.touch()
+                    self._update_lru(session_id)
+                    if session_class == "interactive" and session.session_class != session_class:
+                        session.session_class = session_class
+                        self.process_manager.set_session_class(session.process_port, session_class)
+                    if make_current:
+                        self._set_current(session_id)
+                    if pin:
+                        self.pin(session_id)
+                    self._write_journal()
+                    logger.info(f"Returning existing session: {session_id}")
+                    return session
+                
+                opening = self._opening.get(content_hash)
+                if opening is None:
+                    opening = threading.Event()
+                    self._opening[content_hash] = opening
+                    if needed:
+                        self._pending_memory[content_hash] = needed
+                    break
+            # The same content is being opened by another call; share its session
+            opening.wait(self.RESTORE_WAIT_TIMEOUT)
+        
+        port = None
+        started_new_process = False
+        try:
+            port, started_new_process = self._acquire_port(needed, size, predicted, own=content_hash)
+            before = self.process_manager.sample_memory(port, max_age=0) if needed else None
+            self.process_manager.set_session_class(port, session_class)
+            ida_session_id = self._open_binary_on_port(port, path, run_auto_analysis)
+            after = self.process_manager.sample_memory(port, max_age=0) if needed else None
+        except BaseException:
+            # Whatever failed, waiting opens of the content and the port must not stay blocked
+            with self._lock:
+                if port is not None:
+                    self._reserved_ports.discard(port)
+                self._opening.pop(content_hash, None)
+                self._pending_memory.pop(content_hash, None)
+                opening.set()
+                # Clean up on failure (only if we started a new process)
+                if started_new_process:
+                    self.process_manager.stop_process(port)
+            raise
+        
         with self._lock:
-            # Check if already open
-            if binary_path_str in self._binary_to_session:
-                session_id = self._binary_to_session[binary_path_str]
-                session = self._sessions[session_id]
-                session.touch()
-                self._update_lru(session_id)
-                self._set_current(session_id)
-                logger.info(f"Returning existing session: {session_id}")
-                return session
-            
-            # Try to get a process port
-            port = None
-            started_new_process = False
-            
-            # Priority 1: Try to reuse an idle process
-            idle_port = self._get_idle_port()
-            if idle_port is not None:
-                port = idle_port
-                logger.info(f"Reusing idle process on port {port}")
+            self._reserved_ports.discard(port)
+            self._opening.pop(content_hash, None)
+            self._pending_memory.pop(content_hash, None)
+            opening.set()
             
-            # Priority 2: Start a new process if under limit
-            elif self.process_manager.process_count < self.max_processes:
-                process_info = self.process_manager.start_process()
-                port = process_info.port
-                started_new_process = True
-                logger.info(f"Started new process on port {port}")
-            
-            # Priority 3: Evict LRU and reuse its process
+            # A hibernated session of the same content comes back under its ID
+            session = self._take_hibernated(content_hash)
+            if session is None:
+                session = ProxySession.create(
+                    binary_path=binary_path_str,
+                    process_port=port,
+                    ida_session_id=ida_session_id,
+                )
             else:
-                logger.info(f"Max processes ({self.max_processes}) reached, evicting LRU for reuse")
-                port = self._evict_lru_for_reuse()
-                if port is None:
-                    raise RuntimeError("No process available and cannot evict any session")
-                logger.info(f"Reusing evicted process on port {port}")
+                session.process_port = port
+                session.ida_session_id = ida_session_id
+                session.aliases = [] if binary_path_str == session.binary_path else [binary_path_str]
+                self.wakes += 1
+            session.run_auto_analysis = run_auto_analysis
+            session.content_hash = content_hash
+            session.session_class = session_class
+            session.memory = predicted
+            if before is not None and after is not None:
+                session.memory = max(after.pss - before.pss, 0)
+                self.predictor.observe(size, session.memory)
             
-            # Call idalib_open on the process
-            request = {
-                "jsonrpc": "2.0",
-                "id": 1,
-                "method": "tools/call",
-                "params": {
-                    "name": "idalib_open",
-                    "arguments": {
-                        "input_path": binary_path_str,
-                        "run_auto_analysis": run_auto_analysis,
-                    }
-                }
-            }
+            self._update_process_info(port, ida_session_id, binary_path_str)
             
-            try:
-                # Use longer timeout for opening files (especially on first open)
-                # Check if .i64/.idb file exists to estimate timeout needed
-                import platform
-                is_windows = platform.system() == "Windows"
+            # Store session
+            self._sessions[session.session_id] = session
+            self._binary_to_session[binary_path_str] = session.session_id
+            self._hash_to_session[content_hash] = session.session_id
+            self._watch_session(session)
+            self._bind(port, session.session_id)
+            if self._packable(size):
+                self._pack_ports.add(port)
+            self._update_lru(session.session_id)
+            if make_current or self._current_session_id is None:
+                self._set_current(session.session_id)
+            if pin:
+                self.pin(session.session_id)
+            if self.index is not None:
+                self.index.session_opened(session)
+            self._write_journal()
+            
+            logger.info(f"Created new session: {session.session_id} on port {port}")
+        
+        if self.summarizer is not None:
+            self._summarize(session)
+        return session
+    
+    def _summarize(self, session: ProxySession, refresh: bool = False) -> None:
+        """Gather a session's summary, leaving it unset if that fails."""
+        try:
+            session.summary = self.summarizer.build(session, refresh=refresh)
+        except RuntimeError as e:
+            logger.warning(f"Failed to summarize session {session.session_id}: {e}")
+    
+    def summarize(self, session_id: str, refresh: bool = False) -> Dict:
+        """Get a session's summary, gathering it if it is missing or stale.
+        
+        Args:
+            session_id: Session to summarize
+            refresh: Gather the summary again even if the session has one
+        
+        Returns:
+            Summary dictionary
+        
+        Raises:
+            ValueError: If the session doesn't exist
+            RuntimeError: If summaries are disabled or gathering one failed
+        """
+        if self.summarizer is None:
+            raise RuntimeError("Binary summaries are disabled")
+        session = self.get_session(session_id)
+        if session is None:
+            hibernated = self.get_hibernated(session_id)
+            if hibernated is None:
+                raise ValueError(f"Session not found: {session_id}")
+            if hibernated.summary is not None and not refresh:
+                return hibernated.summary
+            self.wake_in_background(session_id)
+            raise RuntimeError(f"Session {session_id} is {hibernated.tier} and being reopened; retry shortly")
+        if session.summary is None or refresh:
+            session.summary = self.summarizer.build(session, refresh=refresh)
+        return session.summary
+    
+    def _acquire_port(
+        self, needed: int = 0, size: Optional[int] = None, predicted: int = 0, own: Optional[str] = None,
+    ) -> Tuple[int, bool]:
+        """Pick and reserve the process to open a new session on. Called without the lock.
+        
+        Each choice is made, and the process reserved, under the lock;
+        starting a process and closing evicted sessions happen outside it.
+        
+        Args:
+            needed: Predicted bytes of memory the new session takes, if
+                memory is limited
+            size: Size of the binary in bytes, to decide whether it may
+                share a process
+            predicted: Predicted bytes of memory the new session takes
+            own: Content hash of the open, whose pending memory is needed
+        
+        Returns:
+            Tuple of the reserved process port and whether a new process
+            was started
+        
+        Raises:
+            RuntimeError: If no process is available and no session can be
+                evicted, or the session doesn't fit in memory
+        """
+        if self._memory_limited:
+            self._make_room(needed, own)
+        
+        while True:
+            with self._lock:
+                # Priority 1: Try to reuse an idle process
+                idle_port = self._get_idle_port()
+                if idle_port is not None:
+                    logger.info(f"Reusing idle process on port {idle_port}")
+                    self._reserved_ports.add(idle_port)
+                    return idle_port, False
                 
-                # Check for existing IDA database files
-                i64_path = path.with_suffix('.i64')
-                idb_path = path.with_suffix('.idb')
-                has_database = i64_path.exists() or idb_path.exists()
+                # Priority 2: Share a process with other small binaries
+                if size is not None and self._packable(size):
+                    packed_port = self._pack_port(predicted)
+                    if packed_port is not None:
+                        logger.info(f"Packing binary into the process on port {packed_port}")
+                        self.packed_opens += 1
+                        self._reserved_ports.add(packed_port)
+                        return packed_port, False
                 
-                if has_database:
-                    # Database exists, should be fast (10-60 seconds)
-                    open_timeout = 120
+                # Priority 3: Start a new process if under limit, counting those
+                # still starting (and its own footprint fits too, unless there
+                # is nothing to evict instead)
+                start = self.process_manager.process_count + self._starting < self.max_processes and (
+                    not self._memory_limited
+                    or not self._evictable()
+                    or self._memory_shortfall(needed + self.predictor.process_footprint(), own=own) <= 0
+                )
+                if start:
+                    self._starting += 1
                 else:
-                    # First time opening, may need to create database
-                    # Even without auto-analysis, this can take time on Windows
-                    open_timeout = 600
-                
-                logger.info(f"Opening binary with timeout={open_timeout}s (has_database={has_database}, windows={is_windows})")
-                response = self.process_manager.forward_request(port, request, timeout=open_timeout)
-            except Exception as e:
-                # Clean up on failure (only if we started a new process)
-                if started_new_process:
-                    self.process_manager.stop_process(port)
-                raise RuntimeError(f"Failed to open binary: {e}")
+                    # Priority 4: Evict LRU and reuse its process
+                    logger.info(f"Max processes ({self.max_processes}) reached, evicting LRU for reuse")
+                    victims, port = self._detach_for_reuse()
             
-            # Extract session ID from response
-            if "error" in response:
-                if started_new_process:
-                    self.process_manager.stop_process(port)
-                raise RuntimeError(f"idalib_open failed: {response['error']}")
+            if start:
+                port = self._start_process()
+                if port is None:
+                    continue
+                if self._memory_limited:
+                    usage = self.process_manager.sample_memory(port, max_age=0)
+                    if usage is not None:
+                        self.predictor.observe_process(usage.pss)
+                return port, True
             
-            result = response.get("result", {})
-            if isinstance(result, dict) and "content" in result:
-                # MCP tools/call response format
-                content = result["content"]
-                if isinstance(content, list) and len(content) > 0:
-                    text_content = content[0].get("text", "{}")
-                    result_data = json.loads(text_content)
-                else:
-                    result_data = {}
+            try:
+                for victim in victims:
+                    self._close_evicted(victim)
+            except BaseException:
+                if port is not None:
+                    with self._lock:
+                        self._reserved_ports.discard(port)
+                raise
+            if port is None:
+                raise RuntimeError("No process available and cannot evict any session")
+            logger.info(f"Reusing evicted process on port {port}")
+            return port, False
+    
+    def _start_process(self) -> Optional[int]:
+        """Start a process the caller counted in _starting, and reserve it.
+        
+        Called without the lock, so a start, which may take a minute,
+        doesn't hold up other calls.
+        
+        Returns:
+            Port of the new process, or None if another caller found it
+            idle and took it before it could be reserved
+        
+        Raises:
+            RuntimeError: If the process failed to start
+        """
+        try:
+            port = self.process_manager.start_process().port
+        except BaseException:
+            with self._lock:
+                self._starting -= 1
+            raise
+        with self._lock:
+            self._starting -= 1
+            # Another caller may have found the new process idle first; it serves that one
+            if port in self._reserved_ports or port in self._port_sessions:
+                return None
+            self._reserved_ports.add(port)
+        logger.info(f"Started new process on port {port}")
+        return port
+    
+    @property
+    def _memory_limited(self) -> bool:
+        return bool(self.memory_budget or self.memory_reserve)
+    
+    def _packable(self, size: int) -> bool:
+        """Whether a binary of size bytes may share a process."""
+        return self.pack_max_sessions > 1 and 0 < self.pack_binary_size and size <= self.pack_binary_size
+    
+    def _expected_load(self, port: int, session_ids: List[str]) -> int:
+        """Queued calls plus recently used sessions of a process. Called with the lock held."""
+        now = datetime.now()
+        recent = sum(
+            1 for sid in session_ids
+            if sid in self._sessions
+            and (now - self._sessions[sid].last_accessed).total_seconds() < self.PACK_ACTIVE_WINDOW
+        )
+        return self.process_manager.queue_depth(port) + recent
+    
+    def _pack_port(self, predicted: int) -> Optional[int]:
+        """Pick a shared process with room for another small binary. Called with the lock held.
+        
+        A process qualifies while it hosts fewer than pack_max_sessions,
+        their predicted memory plus the new binary's stays within
+        pack_memory, and its expected load is below pack_max_load. Of
+        those, the least loaded, then the least full, is picked.
+        
+        Args:
+            predicted: Predicted bytes of memory the new session takes
+        
+        Returns:
+            Port of the process, or None if none has room
+        """
+        best = None
+        active = set(self.process_manager.active_ports)
+        for port in self._pack_ports:
+            session_ids = self._port_sessions.get(port, [])
+            if (
+                port not in active
+                or port in self._reserved_ports
+                or port in self._closing
+                or len(session_ids) >= self.pack_max_sessions
+                or self.process_manager.is_draining(port)
+            ):
+                continue
+            sessions = [self._sessions[sid] for sid in session_ids if sid in self._sessions]
+            if any(session.restoring for session in sessions):
+                continue
+            if self.pack_memory and sum(s.memory for s in sessions) + predicted > self.pack_memory:
+                continue
+            load = self._expected_load(port, session_ids)
+            if load >= self.pack_max_load:
+                continue
+            key = (load, len(session_ids))
+            if best is None or key < best[0]:
+                best = (key, port)
+        return best[1] if best is not None else None
+    
+    def packing_to_dict(self) -> Dict:
+        """Summarize which processes host which sessions for JSON serialization."""
+        with self._lock:
+            return {
+                "enabled": self._packable(0),
+                "binary_limit_kb": self.pack_binary_size // 1024,
+                "processes": {
+                    str(port): {
+                        "sessions": list(session_ids),
+                        "shared": port in self._pack_ports,
+                        "expected_load": self._expected_load(port, session_ids),
+                    }
+                    for port, session_ids in sorted(self._port_sessions.items())
+                },
+                "packed_opens": self.packed_opens,
+                "switches": self.process_manager.session_switches,
+            }
+    
+    def _evictable(self) -> List[str]:
+        """Unpinned sessions in eviction order. Called with the lock held.
+        
+        Background sessions go first, then interactive ones; each in LRU order.
+        """
+        unpinned = [sid for sid in self._lru_order if not self._pins.get(sid)]
+        return sorted(
+            unpinned,
+            key=lambda sid: sid not in self._sessions or self._sessions[sid].session_class != "background",
+        )
+    
+    def _memory_shortfall(self, needed: int, credit: int = 0, own: Optional[str] = None) -> int:
+        """Bytes missing for needed more bytes to fit. Called with the lock held.
+        
+        Args:
+            needed: Bytes about to be taken
+            credit: Bytes freed by evictions not yet visible in the samples
+            own: Content hash of the open needed is for, which is already
+                counted as pending
+        
+        Returns:
+            Bytes missing; zero or less if needed fits
+        """
+        pending = sum(mem for content_hash, mem in self._pending_memory.items() if content_hash != own)
+        shortfall = 0
+        if self.memory_budget:
+            used = 0
+            for port in self.process_manager.active_ports:
+                # A child's cgroup charge also covers the page cache it pulls in
+                charged = self.process_manager.cgroup_usage(port)
+                if charged is not None:
+                    used += charged.memory_current
+                    continue
+                usage = self.process_manager.sample_memory(port)
+                if usage is not None:
+                    used += usage.pss
+            shortfall = used + pending + needed - credit - self.memory_budget
+        if self.memory_reserve:
+            available = mem_available()
+            if available is not None:
+                shortfall = max(shortfall, self.memory_reserve + pending + needed - credit - available)
+        return shortfall
+    
+    def _make_room(self, needed: int, own: Optional[str] = None) -> None:
+        """Evict LRU sessions until needed bytes fit. Called without the lock.
+        
+        Args:
+            needed: Bytes about to be taken
+            own: Content hash of the open needed is for
+        
+        Raises:
+            RuntimeError: If needed doesn't fit even with every unpinned
+                session evicted
+        """
+        credit = 0
+        while True:
+            with self._lock:
+                shortfall = self._memory_shortfall(needed, credit, own)
+                if shortfall <= 0:
+                    return
+                evictable = self._evictable()
+                if not evictable:
+                    self.memory_refusals += 1
+                    raise RuntimeError(
+                        f"Not enough memory: the binary is predicted to need {needed // MIB} MiB "
+                        f"and {shortfall // MIB} MiB more are missing with no session left to evict"
+                    )
+                session = self._sessions.get(evictable[0])
+                # Freed memory doesn't show up in the samples at once
+                credit += (session.memory if session is not None else 0) or self.predictor.MIN_BINARY
+                logger.info(f"Evicting LRU session to free memory ({shortfall // MIB} MiB short)")
+                victim = self._detach_lru()
+                self.memory_evictions += 1
+            if victim is not None:
+                self._close_evicted(victim)
+    
+    def memory_to_dict(self) -> Dict:
+        """Summarize memory use and admission for JSON serialization."""
+        with self._lock:
+            processes = {}
+            for port in self.process_manager.active_ports:
+                usage = self.process_manager.sample_memory(port)
+                if usage is not None:
+                    processes[str(port)] = usage.to_dict()
+            available = mem_available()
+            return {
+                "budget_mb": self.memory_budget // MIB,
+                "reserve_mb": self.memory_reserve // MIB,
+                "available_mb": available // MIB if available is not None else None,
+                "children_pss_mb": round(sum(p["pss_mb"] for p in processes.values()), 1),
+                "pending_mb": sum(self._pending_memory.values()) // MIB,
+                "processes": processes,
+                "evictions": self.memory_evictions,
+                "refusals": self.memory_refusals,
+                "predictor": self.predictor.to_dict(),
+            }
+    
+    def pin(self, session_id: str) -> None:
+        """Keep a session from being evicted until unpin() is called.
+        
+        Pins nest: a session pinned twice needs two unpin() calls.
+        """
+        with self._lock:
+            self._pins[session_id] = self._pins.get(session_id, 0) + 1
+    
+    def unpin(self, session_id: str) -> None:
+        """Release a pin taken with pin()."""
+        with self._lock:
+            remaining = self._pins.get(session_id, 0) - 1
+            if remaining > 0:
+                self._pins[session_id] = remaining
             else:
-                result_data = result
-            
-            if not result_data.get("success"):
-                if started_new_process:
-                    self.process_manager.stop_process(port)
-                error = result_data.get("error", "Unknown error")
-                raise RuntimeError(f"idalib_open failed: {error}")
-            
-            session_data = result_data.get("session", {})
-            ida_session_id = session_data.get("session_id", "unknown")
+                self._pins.pop(session_id, None)
+    
+    def content_hash(self, binary_path: str) -> str:
+        """Get the content hash a binary's session is identified by.
+        
+        Raises:
+            OSError: If the file can't be read
+        """
+        return self._hasher.hash_file(Path(binary_path).resolve())
+    
+    def _find_open_content(self, binary_path: str, content_hash: str) -> Optional[ProxySession]:
+        """Find the session serving a binary's current content.
+        
+        Called with the lock held. A session opened from binary_path whose
+        content has changed since is closed, as its analysis is stale.
+        
+        Args:
+            binary_path: Resolved path being opened
+            content_hash: Hash of the file's current content
+        
+        Returns:
+            The matching session, or None if the content isn't open
+        """
+        session_id = self._binary_to_session.get(binary_path)
+        if session_id is not None:
+            session = self._sessions[session_id]
+            if session.content_hash is None:
+                # Resumed from a journal written before content hashing
+                session.content_hash = content_hash
+                self._hash_to_session.setdefault(content_hash, session_id)
+            if session.content_hash == content_hash:
+                return session
             
-            # Create proxy session
-            session = ProxySession.create(
-                binary_path=binary_path_str,
-                process_port=port,
-                ida_session_id=ida_session_id,
-            )
+            logger.warning(f"{binary_path} changed on disk since session {session_id} opened it")
+            if binary_path == session.binary_path:
+                self.close_session(session_id)
+            else:
+                self._drop_alias(session, binary_path)
+        
+        session_id = self._hash_to_session.get(content_hash)
+        if session_id is None:
+            return None
+        session = self._sessions[session_id]
+        session.aliases.append(binary_path)
+        self._binary_to_session[binary_path] = session_id
+        self._watch_path(binary_path, session_id)
+        logger.info(f"{binary_path} has the same content as session {session_id}, reusing it")
+        return session
+    
+    def _forget_binary(self, session: ProxySession, keep_results: bool = False) -> None:
+        """Remove a session's path, aliases and content hash from the lookups.
+        
+        Args:
+            session: Session being closed, evicted or hibernated
+            keep_results: Keep its cached results, for a warm session
+        """
+        for path in [session.binary_path] + session.aliases:
+            if self._binary_to_session.get(path) == session.session_id:
+                self._binary_to_session.pop(path, None)
+        if self._hash_to_session.get(session.content_hash) == session.session_id:
+            self._hash_to_session.pop(session.content_hash, None)
+        for path in [p for p, sid in self._watched.items() if sid == session.session_id]:
+            self._unwatch_path(path)
+        self._own_writes.pop(session.session_id, None)
+        if self.result_cache is not None and not keep_results:
+            self.result_cache.invalidate(session.session_id)
+        if self.index is not None:
+            self.index.session_closed(session)
+    
+    def _drop_alias(self, session: ProxySession, path: str) -> None:
+        """Stop mapping a path to a session whose content it no longer has."""
+        if path in session.aliases:
+            session.aliases.remove(path)
+        if self._binary_to_session.get(path) == session.session_id:
+            self._binary_to_session.pop(path, None)
+        self._unwatch_path(path)
+    
+    @staticmethod
+    def _database_paths(binary_path: Path) -> List[Path]:
+        """Paths where IDA keeps the database of a binary."""
+        return [binary_path.with_suffix(".i64"), binary_path.with_suffix(".idb")]
+    
+    def _watch_session(self, session: ProxySession) -> None:
+        """Watch a session's binary, aliases and database files for changes."""
+        paths = [session.binary_path] + session.aliases
+        paths += [str(p) for p in self._database_paths(Path(session.binary_path))]
+        for path in paths:
+            self._watch_path(path, session.session_id)
+    
+    def _watch_path(self, path: str, session_id: str) -> None:
+        """Watch one file on behalf of a session."""
+        if self.watcher is None:
+            return
+        self._watched[path] = session_id
+        self.watcher.watch(path, self._on_file_changed)
+    
+    def _unwatch_path(self, path: str) -> None:
+        """Stop watching one file."""
+        if self._watched.pop(path, None) is not None and self.watcher is not None:
+            self.watcher.unwatch(path)
+    
+    def _on_file_changed(self, path: str) -> None:
+        """Handle a watched binary or database changing on disk.
+        
+        Runs on the watcher thread. The session's cached results are
+        invalidated; with reopen_on_change, the session is also reopened
+        from disk in the background. An alias whose file changed no longer
+        has the session's content and is dropped.
+        
+        Args:
+            path: Path of the file that changed
+        """
+        with self._lock:
+            session_id = self._watched.get(path)
+            session = self._sessions.get(session_id) if session_id else None
+            if session is None:
+                return
             
-            # Update process info
-            process_info = self.process_manager.get_process(port)
-            if process_info:
-                process_info.current_ida_session = ida_session_id
-                process_info.binary_path = binary_path_str
+            if path in session.aliases:
+                logger.info(f"Alias {path} of session {session_id} changed, dropping it")
+                self._drop_alias(session, path)
+                return
             
-            # Store session
-            self._sessions[session.session_id] = session
-            self._binary_to_session[binary_path_str] = session.session_id
-            self._port_to_session[port] = session.session_id
-            self._update_lru(session.session_id)
-            self._set_current(session.session_id)
+            if path != session.binary_path and time.monotonic() < self._own_writes.get(session_id, 0):
+                # The session's own process saving its database
+                return
             
-            logger.info(f"Created new session: {session.session_id} on port {port}")
-            return session
+            logger.warning(f"{path} changed on disk, invalidating session {session_id}")
+            self._bump_generation(session)
+            reopen = self.reopen_on_change and not session.restoring
+        
+        if reopen:
+            threading.Thread(
+                target=self._reopen_changed, args=(session_id,),
+                name=f"reopen-{session_id}", daemon=True,
+            ).start()
+    
+    def _reopen_changed(self, session_id: str) -> None:
+        """Reopen a session from disk after its files changed."""
+        try:
+            session = self.restore_session(session_id)
+        except (ValueError, RuntimeError) as e:
+            logger.warning(f"Could not reopen changed session {session_id}: {e}")
+            return
+        try:
+            content_hash = self._hasher.hash_file(Path(session.binary_path))
+        except OSError as e:
+            logger.warning(f"Could not hash reopened {session.binary_path}: {e}")
+            return
+        
+        with self._lock:
+            if self._sessions.get(session_id) is not session:
+                return
+            if self._hash_to_session.get(session.content_hash) == session_id:
+                self._hash_to_session.pop(session.content_hash, None)
+            session.content_hash = content_hash
+            self._hash_to_session.setdefault(content_hash, session_id)
+            self._write_journal()
+    
+    def bump_generation(self, session_id: str) -> None:
+        """Record that a session's database may have changed.
+        
+        Cached results of the session are invalidated.
+        
+        Args:
+            session_id: Session whose database changed
+        """
+        with self._lock:
+            session = self._sessions.get(session_id)
+            if session is not None:
+                self._bump_generation(session)
+    
+    def _bump_generation(self, session: ProxySession) -> None:
+        """Bump a session's generation; called with the lock held."""
+        session.generation += 1
+        if self.result_cache is not None:
+            self.result_cache.invalidate(session.session_id)
+        if self.summarizer is not None:
+            session.summary = None
+            self.summarizer.invalidate(session.content_hash)
+        if self.index is not None:
+            self.index.session_changed(session)
+        self._drop_stale_replicas(session)
+    
+    def _drop_stale_replicas(self, session: ProxySession) -> None:
+        """Stop using replicas behind a session's generation. Called with the lock held.
+        
+        Their copies hold the database from before the change. They are
+        closed in the background; their processes count as busy until then.
+        """
+        stale = [replica for replica in session.replicas if replica.generation < session.generation]
+        if not stale:
+            return
+        session.replicas = [replica for replica in session.replicas if replica not in stale]
+        for replica in stale:
+            self._unbind(replica.port, session.session_id)
+            self._closing[replica.port] = self._closing.get(replica.port, 0) + 1
+        logger.info(f"Dropping {len(stale)} stale replica(s) of {session.session_id}")
+        
+        def close():
+            for replica in stale:
+                self._close_replica(replica)
+                with self._lock:
+                    self._closed(replica.port)
+        threading.Thread(target=close, name=f"replicas-{session.session_id}", daemon=True).start()
     
+    @_changes_sessions
     def close_session(self, session_id: str, terminate_process: bool = False) -> bool:
         """Close a session.
         
@@ -279,7 +1243,7 @@ class SessionManager:
         Args:
             session_id: Session ID to close
             terminate_process: If True, also terminate the idalib-mcp process
-            
+        
         Returns:
             True if closed successfully, False if not found
         """
@@ -287,14 +1251,21 @@ class SessionManager:
             session = self._sessions.pop(session_id, None)
             
             if session is None:
+                if self._hibernated.pop(session_id, None) is not None:
+                    if self.result_cache is not None:
+                        self.result_cache.invalidate(session_id)
+                    logger.info(f"Closed hibernated session: {session_id}")
+                    return True
                 logger.warning(f"Session not found: {session_id}")
                 return False
             
             port = session.process_port
             
+            self._release_replicas(session)
+            
             # Remove from mappings
-            self._binary_to_session.pop(session.binary_path, None)
-            self._port_to_session.pop(port, None)
+            self._forget_binary(session)
+            self._unbind(port, session_id)
             
             if session_id in self._lru_order:
                 self._lru_order.remove(session_id)
@@ -321,26 +1292,725 @@ class SessionManager:
                 self.process_manager.forward_request(port, request)
             except Exception as e:
                 logger.warning(f"Failed to close IDA session: {e}")
+            self.process_manager.forget_session(port, session.ida_session_id)
+            self._retire_work_dir(session)
             
-            # Terminate the process if requested
-            if terminate_process:
+            # Terminate the process if requested, unless it serves other sessions
+            if terminate_process and port in self._port_sessions:
+                logger.info(f"Keeping the process on port {port}, it hosts other sessions")
+            elif terminate_process:
                 self.process_manager.stop_process(port)
             
+            self._write_journal()
             logger.info(f"Closed session: {session_id}")
             return True
     
+    def checkpoint_session(self, session_id: str, deadline: Optional[Deadline] = None) -> None:
+        """Save a session's database to disk.
+        
+        The save is queued behind calls already sent to the session's process.
+        
+        Args:
+            session_id: Session ID to checkpoint
+            deadline: Point by which the save must have completed
+        
+        Raises:
+            ValueError: If session not found
+            RuntimeError: If the process failed to save the database
+        """
+        session = self.get_session(session_id)
+        if session is None:
+            raise ValueError(f"Session not found: {session_id}")
+        self._save_database(session, deadline)
+    
+    def _save_database(self, session: ProxySession, deadline: Optional[Deadline] = None) -> None:
+        """Save a session's database, which may already be detached for eviction.
+        
+        Raises:
+            RuntimeError: If the process failed to save the database
+        """
+        session_id = session.session_id
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {
+                "name": "idalib_save",
+                "arguments": {},
+            }
+        }
+        # Don't mistake our own database write for an outside change
+        with self._lock:
+            self._own_writes[session_id] = float("inf")
+        try:
+            response = self.process_manager.forward_request(
+                session.process_port, request, deadline=deadline, ida_session=session.ida_session_id
+            )
+        except Exception as e:
+            raise RuntimeError(f"Failed to save database of {session_id}: {e}")
+        finally:
+            with self._lock:
+                if session_id in self._sessions:
+                    self._own_writes[session_id] = time.monotonic() + self.OWN_WRITE_GRACE
+                else:
+                    self._own_writes.pop(session_id, None)
+        
+        if "error" in response:
+            raise RuntimeError(f"idalib_save failed: {response['error']}")
+        result = response.get("result", {})
+        if isinstance(result, dict) and result.get("isError"):
+            raise RuntimeError(f"idalib_save failed: {result.get('content')}")
+        self._sync_database(session)
+    
+    def _sync_database(self, session: ProxySession) -> None:
+        """Copy a migrated session's saved database next to its binary.
+        
+        Since a migration, the session's process works on a private copy;
+        this keeps the database beside the binary, which restores and
+        later opens use, as current as the last save.
+        """
+        work_dir = session.work_dir
+        if work_dir is None:
+            return
+        binary = Path(session.binary_path)
+        with self._lock:
+            self._own_writes[session.session_id] = float("inf")
+        try:
+            copies = self._database_paths(Path(work_dir) / binary.name)
+            for source, target in zip(copies, self._database_paths(binary)):
+                if source.exists():
+                    shutil.copy2(source, target)
+        except OSError as e:
+            raise RuntimeError(f"Failed to copy the database of {session.session_id} back: {e}")
+        finally:
+            with self._lock:
+                if session.session_id in self._sessions:
+                    self._own_writes[session.session_id] = time.monotonic() + self.OWN_WRITE_GRACE
+                else:
+                    self._own_writes.pop(session.session_id, None)
+    
+    def _retire_work_dir(self, session: ProxySession) -> None:
+        """Keep a closed session's database and delete its private copy."""
+        if session.work_dir is None:
+            return
+        try:
+            self._sync_database(session)
+        except RuntimeError as e:
+            logger.warning(str(e))
+        shutil.rmtree(session.work_dir, ignore_errors=True)
+        session.work_dir = None
+    
+    def begin_write(self, session_id: str) -> None:
+        """Note a call that may modify a session's database is starting.
+        
+        A migration in progress is abandoned rather than lose its changes.
+        """
+        with self._lock:
+            self._writes[session_id] = self._writes.get(session_id, 0) + 1
+    
+    def end_write(self, session_id: str) -> None:
+        """Note a call started with begin_write() has finished."""
+        with self._lock:
+            remaining = self._writes.get(session_id, 0) - 1
+            if remaining > 0:
+                self._writes[session_id] = remaining
+            else:
+                self._writes.pop(session_id, None)
+    
+    @contextmanager
+    def _changing(self) -> Iterator[None]:
+        """Count a change to the session table for the duration of the block.
+        
+        While a handoff has the table frozen, new changes wait for it to end;
+        once the sessions were handed over, they fail. A change made inside
+        another on the same thread goes ahead, as the outer one holds off
+        the export already.
+        
+        Raises:
+            RuntimeError: If the sessions were handed over to another proxy
+                instance, or the handoff took too long
+        """
+        depth = getattr(self._changer, "depth", 0)
+        with self._lock:
+            if depth == 0:
+                settled = self._changes_settled.wait_for(
+                    lambda: not self._frozen or self._handed_over, timeout=self.HANDOFF_WAIT_TIMEOUT
+                )
+                if self._handed_over:
+                    raise RuntimeError("Sessions were handed over to another proxy instance; retry there")
+                if not settled:
+                    raise RuntimeError("Sessions are being handed over to another proxy instance")
+            self._changes += 1
+        self._changer.depth = depth + 1
+        try:
+            yield
+        finally:
+            self._changer.depth = depth
+            with self._lock:
+                self._changes -= 1
+                self._changes_settled.notify_all()
+    
+    def freeze(self, timeout: Optional[float] = None) -> Dict:
+        """Stop changes to the session table and export it for a handoff.
+        
+        Opens, closes, migrations and restores in progress finish first;
+        new ones wait until thaw() is called. Unlike export_state(), no
+        session can appear or go away between the export and the
+        successor taking over.
+        
+        Args:
+            timeout: Seconds to wait for changes in progress, default
+                FREEZE_TIMEOUT
+        
+        Returns:
+            Session table dictionary, as from export_state()
+        
+        Raises:
+            RuntimeError: If changes were still in progress after timeout
+        """
+        with self._lock:
+            self._frozen = True
+            if not self._changes_settled.wait_for(
+                lambda: self._changes == 0,
+                timeout=self.FREEZE_TIMEOUT if timeout is None else timeout,
+            ):
+                self._frozen = False
+                self._changes_settled.notify_all()
+                raise RuntimeError(f"{self._changes} session changes still in progress")
+            return self.export_state()
+    
+    def thaw(self, handed_over: bool = False) -> None:
+        """End a freeze() once the handoff has finished.
+        
+        Args:
+            handed_over: Whether the successor took over; waiting and later
+                changes then fail instead of going ahead
+        """
+        with self._lock:
+            self._frozen = handed_over
+            self._handed_over = handed_over
+            self._changes_settled.notify_all()
+    
+    @contextmanager
+    def route(self, session: ProxySession) -> Iterator[Tuple[int, str]]:
+        """Hold the process and IDA session serving a session for one call.
+        
+        Both are read together under the lock, so a call never pairs the
+        port of one side of a migration with the IDA session of the other,
+        and a migration closes the old IDA session only once every call
+        holding it has finished.
+        
+        Yields:
+            (port, ida_session_id) to send the call to
+        """
+        with self._lock:
+            key = (session.process_port, session.ida_session_id)
+            self._routes[key] = self._routes.get(key, 0) + 1
+        try:
+            yield key
+        finally:
+            with self._lock:
+                remaining = self._routes[key] - 1
+                if remaining > 0:
+                    self._routes[key] = remaining
+                else:
+                    del self._routes[key]
+                    self._routes_released.notify_all()
+    
+    def port_sessions(self) -> Dict[int, List[str]]:
+        """The sessions (primaries and replicas) each process serves."""
+        with self._lock:
+            return {port: list(session_ids) for port, session_ids in self._port_sessions.items()}
+    
+    @_changes_sessions
+    def migrate_session(self, session_id: str, target_port: Optional[int] = None) -> ProxySession:
+        """Move a session to another process while its current one keeps serving.
+        
+        The database is saved, a private copy of the binary and database is
+        opened on the target, and the session then switches to it in one
+        step under the lock. Calls already queued on the old process finish
+        there before the session is closed on it. A call that may modify the
+        database while the copy opens abandons the migration, since the
+        copy wouldn't have its changes.
+        
+        Args:
+            session_id: Session to move
+            target_port: Process to move to (default: an idle process, or a
+                new one under max_processes)
+        
+        Returns:
+            The migrated session
+        
+        Raises:
+            ValueError: If the session doesn't exist or the target can't take it
+            RuntimeError: If no process is available, the copy could not be
+                opened, or the database changed during the migration
+        """
+        with self._lock:
+            session = self._sessions.get(session_id)
+            if session is None:
+                raise ValueError(f"Session not found: {session_id}")
+            if session.restoring or session.migrating:
+                raise RuntimeError(f"Session {session_id} is already being moved")
+            old_port = session.process_port
+            started_new_process = False
+            if target_port is not None:
+                if (
+                    target_port == old_port
+                    or target_port not in self.process_manager.active_ports
+                    or target_port in self._reserved_ports
+                ):
+                    raise ValueError(f"Cannot migrate {session_id} to the process on port {target_port}")
+                port = target_port
+            else:
+                port = self._get_idle_port()
+                if port is None:
+                    if self.process_manager.process_count + self._starting >= self.max_processes:
+                        raise RuntimeError(f"No process to migrate {session_id} to")
+                    # Started below, outside the lock
+                    self._starting += 1
+                    started_new_process = True
+            if not started_new_process:
+                self._reserved_ports.add(port)
+            session.migrating = True
+            # Anything that may change the database from here on shows up as a new generation
+            generation = session.generation
+        
+        if started_new_process:
+            try:
+                port = self._start_process()
+                if port is None:
+                    raise RuntimeError("an open took the new process")
+            except RuntimeError as e:
+                with self._lock:
+                    session.migrating = False
+                    self.migration_failures += 1
+                raise RuntimeError(f"Failed to migrate {session_id}: {e}")
+        
+        started = time.monotonic()
+        work_dir = tempfile.mkdtemp(prefix="ida-proxy-session-")
+        ida_session_id = None
+        try:
+            self.checkpoint_session(session_id)
+            copy_path = self._copy_for_replica(Path(session.binary_path), Path(work_dir))
+            self.process_manager.set_session_class(port, session.session_class)
+            ida_session_id = self._open_binary_on_port(port, copy_path, session.run_auto_analysis)
+            size = Path(session.binary_path).stat().st_size
+        except (OSError, ValueError, RuntimeError) as e:
+            error = e
+        else:
+            error = None
+        
+        with self._lock:
+            self._reserved_ports.discard(port)
+            session.migrating = False
+            if error is None and self._sessions.get(session_id) is not session:
+                error = RuntimeError("the session was closed")
+            elif error is None and (session.generation != generation or self._writes.get(session_id)):
+                error = RuntimeError("the database was modified while the copy opened")
+            if error is None:
+                old_ida_session_id, old_work_dir = session.ida_session_id, session.work_dir
+                self._unbind(old_port, session_id)
+                session.process_port = port
+                session.ida_session_id = ida_session_id
+                session.work_dir = work_dir
+                self._update_process_info(port, ida_session_id, str(copy_path))
+                self._bind(port, session_id)
+                if self._packable(size):
+                    self._pack_ports.add(port)
+                self.migrations += 1
+                self._write_journal()
+            else:
+                self.migration_failures += 1
+        
+        if error is not None:
+            if ida_session_id is not None:
+                self._close_ida_session(port, ida_session_id)
+            shutil.rmtree(work_dir, ignore_errors=True)
+            if started_new_process:
+                self.process_manager.stop_process(port)
+            raise RuntimeError(f"Failed to migrate {session_id}: {error}")
+        
+        logger.info(
+            f"Migrated session {session_id} from port {old_port} to port {port} "
+            f"in {time.monotonic() - started:.1f}s"
+        )
+        # Calls that were routed to the old process still find the session there
+        old_route = (old_port, old_ida_session_id)
+        with self._lock:
+            if not self._routes_released.wait_for(
+                lambda: old_route not in self._routes, timeout=self.MIGRATE_DRAIN_TIMEOUT
+            ):
+                logger.warning(f"Closing {session_id} on port {old_port} with calls still holding it")
+        self._close_ida_session(old_port, old_ida_session_id)
+        if old_work_dir is not None:
+            shutil.rmtree(old_work_dir, ignore_errors=True)
+        return session
+    
+    def _close_ida_session(self, port: int, ida_session_id: str) -> None:
+        """Close an IDA session on a process, ignoring failures."""
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {
+                "name": "idalib_close",
+                "arguments": {"session_id": ida_session_id},
+            }
+        }
+        try:
+            self.process_manager.forward_request(port, request)
+        except Exception as e:
+            logger.warning(f"Failed to close IDA session {ida_session_id} on port {port}: {e}")
+        self.process_manager.forget_session(port, ida_session_id)
+    
+    @_changes_sessions
+    def add_replica(self, session_id: str) -> Optional[ReplicaInfo]:
+        """Open a read-only replica of a session on another process.
+        
+        Replicas only use idle processes or spare capacity under
+        max_processes; they never evict other sessions. Each replica opens
+        a private copy of the binary and its database.
+        
+        Args:
+            session_id: Session ID to replicate
+        
+        Returns:
+            ReplicaInfo, or None if no process was available
+        
+        Raises:
+            ValueError: If session not found
+            RuntimeError: If the replica failed to open the binary
+        """
+        with self._lock:
+            session = self._sessions.get(session_id)
+            if session is None:
+                raise ValueError(f"Session not found: {session_id}")
+            # The copy is only good until the session is next written to
+            generation = session.generation
+            
+            started_new_process = False
+            port = self._get_idle_port()
+            if port is None:
+                if self.process_manager.process_count + self._starting >= self.max_processes:
+                    logger.info(f"No spare process for a replica of {session_id}")
+                    return None
+                # Started below, outside the lock
+                self._starting += 1
+                started_new_process = True
+            else:
+                # Reserve the port while the replica opens
+                self._bind(port, session_id)
+        
+        if started_new_process:
+            port = self._start_process()
+            if port is None:
+                logger.info(f"No spare process for a replica of {session_id}")
+                return None
+            with self._lock:
+                self._reserved_ports.discard(port)
+                self._bind(port, session_id)
+        
+        work_dir = tempfile.mkdtemp(prefix="ida-proxy-replica-")
+        try:
+            replica_path = self._copy_for_replica(Path(session.binary_path), Path(work_dir))
+            ida_session_id = self._open_binary_on_port(port, replica_path, session.run_auto_analysis)
+        except Exception as e:
+            shutil.rmtree(work_dir, ignore_errors=True)
+            with self._lock:
+                self._unbind(port, session_id)
+            if started_new_process:
+                self.process_manager.stop_process(port)
+            raise RuntimeError(f"Failed to open replica of {session_id}: {e}")
+        
+        replica = ReplicaInfo(port=port, ida_session_id=ida_session_id, work_dir=work_dir, generation=generation)
+        with self._lock:
+            if self._sessions.get(session_id) is not session or session.generation != generation:
+                # Session went away, or was written to, while the replica opened
+                self._unbind(port, session_id)
+                self._close_replica(replica)
+                return None
+            session.replicas.append(replica)
+            self._update_process_info(port, ida_session_id, str(replica_path))
+        
+        logger.info(f"Added replica of {session_id} on port {port}")
+        return replica
+    
+    def _copy_for_replica(self, binary_path: Path, work_dir: Path) -> Path:
+        """Place a private copy of a binary and its database in work_dir.
+        
+        The binary is hard-linked when possible since IDA only reads it; the
+        database is always copied because IDA writes to it.
+        
+        Returns:
+            Path of the binary inside work_dir
+        """
+        target = work_dir / binary_path.name
+        try:
+            os.link(binary_path, target)
+        except OSError:
+            shutil.copy2(binary_path, target)
+        for suffix in (".i64", ".idb"):
+            database = binary_path.with_suffix(suffix)
+            if database.exists():
+                shutil.copy2(database, target.with_suffix(suffix))
+        return target
+    
+    def _close_replica(self, replica: ReplicaInfo, notify: bool = True) -> None:
+        """Close a replica's IDA session and delete its private copy."""
+        if notify:
+            try:
+                request = {
+                    "jsonrpc": "2.0",
+                    "id": 1,
+                    "method": "tools/call",
+                    "params": {
+                        "name": "idalib_close",
+                        "arguments": {"session_id": replica.ida_session_id},
+                    }
+                }
+                self.process_manager.forward_request(replica.port, request)
+            except Exception as e:
+                logger.warning(f"Failed to close replica on port {replica.port}: {e}")
+        self.process_manager.forget_session(replica.port, replica.ida_session_id)
+        shutil.rmtree(replica.work_dir, ignore_errors=True)
+    
+    def _release_replicas(self, session: ProxySession, notify: bool = True) -> None:
+        """Close all replicas of a session, leaving their processes for reuse."""
+        for replica in session.replicas:
+            self._unbind(replica.port, session.session_id)
+            self._close_replica(replica, notify=notify)
+        session.replicas = []
+    
+    def drop_replica(self, session_id: str, port: int) -> None:
+        """Stop using a replica that failed, e.g. because its process crashed.
+        
+        Args:
+            session_id: Session the replica belongs to
+            port: Port of the replica process
+        """
+        with self._lock:
+            session = self._sessions.get(session_id)
+            if session is None:
+                return
+            for replica in list(session.replicas):
+                if replica.port == port:
+                    session.replicas.remove(replica)
+                    self._unbind(port, session_id)
+                    self._close_replica(replica, notify=False)
+                    logger.info(f"Dropped replica of {session_id} on port {port}")
+    
+    @_changes_sessions
+    def restore_session(self, session_id: str) -> ProxySession:
+        """Move a session onto another process, keeping its session ID.
+        
+        The old process is terminated, or only the session's IDA session
+        closed if other sessions are packed into it, and the binary is
+        reopened from its saved database on an idle spare process, a shared
+        process, or a newly started one.
+        If the session is already being restored, waits for that restore
+        to finish instead.
+        
+        Args:
+            session_id: Session ID to restore
+        
+        Returns:
+            The restored session
+        
+        Raises:
+            ValueError: If session not found
+            RuntimeError: If the replacement process could not open the binary
+        """
+        with self._lock:
+            session = self._sessions.get(session_id)
+            if session is None:
+                raise ValueError(f"Session not found: {session_id}")
+            if session.restoring:
+                done = self._restore_done[session_id]
+            else:
+                done = None
+                session.restoring = True
+                self._restore_done[session_id] = threading.Event()
+                old_port = session.process_port
+                self._unbind(old_port, session_id)
+                # Not idle until the session is off it
+                self._closing[old_port] = self._closing.get(old_port, 0) + 1
+        
+        if done is not None:
+            logger.info(f"Waiting for restore of session {session_id} in progress")
+            if not done.wait(timeout=self.RESTORE_WAIT_TIMEOUT):
+                raise RuntimeError(f"Timed out waiting for session {session_id} to be restored")
+            with self._lock:
+                restored = self._sessions.get(session_id)
+            if restored is None:
+                raise RuntimeError(f"Session {session_id} could not be restored")
+            return restored
+        
+        try:
+            return self._restore_on_new_process(session, old_port)
+        finally:
+            with self._lock:
+                self._restore_done.pop(session_id).set()
+    
+    def _restore_on_new_process(self, session: ProxySession, old_port: int) -> ProxySession:
+        """Do the work of restore_session for a session marked as restoring."""
+        session_id = session.session_id
+        started = time.monotonic()
+        with self._lock:
+            # Sessions packed into the same process stay there
+            shared = old_port in self._port_sessions
+        if shared:
+            logger.warning(f"Restoring session {session_id}: leaving the shared process on port {old_port}")
+            self._close_ida_session(old_port, session.ida_session_id)
+        else:
+            logger.warning(f"Restoring session {session_id}: replacing process on port {old_port}")
+            self.process_manager.stop_process(old_port)
+        
+        # Prefer a warm spare, then a shared process, over paying for a process start
+        try:
+            packable = self._packable(Path(session.binary_path).stat().st_size)
+        except OSError:
+            packable = False
+        with self._lock:
+            new_port = self._get_idle_port()
+            if new_port is None and packable:
+                new_port = self._pack_port(session.memory)
+            started_new_process = new_port is None
+            if new_port is not None:
+                self._bind(new_port, session_id)
+            # Only now, so the session isn't packed back into the process it left
+            self._closed(old_port)
+        
+        try:
+            if started_new_process:
+                new_port = self.process_manager.start_process().port
+            self.process_manager.set_session_class(new_port, session.session_class)
+            ida_session_id = self._open_binary_on_port(
+                new_port, Path(session.binary_path), session.run_auto_analysis
+            )
+        except Exception as e:
+            if new_port is not None:
+                if started_new_process:
+                    self.process_manager.stop_process(new_port)
+                else:
+                    with self._lock:
+                        self._unbind(new_port, session_id)
+            logger.error(f"Failed to restore session {session_id}: {e}")
+            with self._lock:
+                session.restoring = False
+                self._drop_session(session_id)
+            raise RuntimeError(f"Failed to restore session {session_id}: {e}")
+        
+        # The database beside the binary is as current as the last save
+        if session.work_dir is not None:
+            shutil.rmtree(session.work_dir, ignore_errors=True)
+            session.work_dir = None
+        
+        with self._lock:
+            session.process_port = new_port
+            session.ida_session_id = ida_session_id
+            session.restoring = False
+            self._update_process_info(new_port, ida_session_id, session.binary_path)
+            closed_meanwhile = session_id not in self._sessions
+            if closed_meanwhile:
+                self._unbind(new_port, session_id)
+                self.process_manager.forget_session(new_port, ida_session_id)
+                # A shared process still serves its other sessions
+                stop_new_process = new_port not in self._port_sessions
+            else:
+                self._bind(new_port, session_id)
+                if packable:
+                    self._pack_ports.add(new_port)
+                # Changes not saved before the restore are gone
+                self._bump_generation(session)
+                self._write_journal()
+        
+        if closed_meanwhile:
+            if stop_new_process:
+                logger.info(f"Session {session_id} was closed during restore, stopping port {new_port}")
+                self.process_manager.stop_process(new_port)
+            return session
+        
+        logger.info(
+            f"Restored session {session_id} on port {new_port} "
+            f"in {time.monotonic() - started:.1f}s"
+        )
+        return session
+    
+    def _drop_session(self, session_id: str) -> None:
+        """Forget a session without contacting its process."""
+        session = self._sessions.pop(session_id, None)
+        if session is None:
+            return
+        self._release_replicas(session, notify=False)
+        self._forget_binary(session)
+        self._unbind(session.process_port, session_id)
+        if session.work_dir is not None:
+            shutil.rmtree(session.work_dir, ignore_errors=True)
+        if session_id in self._lru_order:
+            self._lru_order.remove(session_id)
+        if self._current_session_id == session_id:
+            self._current_session_id = self._lru_order[-1] if self._lru_order else None
+            if self._current_session_id and self._current_session_id in self._sessions:
+                self._sessions[self._current_session_id].is_current = True
+        self._write_journal()
+    
+    def _on_process_wedged(self, port: int) -> None:
+        """Replace a wedged process in the background.
+        
+        Runs off the reporting thread, which may still hold the process's
+        dispatch lock while open_session holds ours.
+        
+        Args:
+            port: Port of the wedged process
+        """
+        def restore():
+            with self._lock:
+                sessions = [
+                    self._sessions[sid] for sid in self._port_sessions.get(port, []) if sid in self._sessions
+                ]
+            
+            primaries = []
+            for session in sessions:
+                if session.process_port != port:
+                    # A replica went bad; the primary is fine
+                    self.drop_replica(session.session_id, port)
+                else:
+                    primaries.append(session.session_id)
+            
+            if not primaries:
+                # No session depends on it, just get rid of the process
+                self.process_manager.stop_process(port)
+                return
+            
+            # Every session of a shared process moves off it
+            for session_id in primaries:
+                try:
+                    self.restore_session(session_id)
+                except (ValueError, RuntimeError) as e:
+                    logger.warning(f"Automatic restore of {session_id} failed: {e}")
+        
+        threading.Thread(
+            target=restore, name=f"restore-{port}", daemon=True
+        ).start()
+    
+    @_changes_sessions
     def switch_session(self, session_id: str) -> ProxySession:
         """Switch to a different session.
         
         Args:
             session_id: Session ID to switch to
-            
+        
         Returns:
             The switched-to session
-            
+        
         Raises:
             ValueError: If session not found
+            RuntimeError: If a hibernated session could not be reopened
         """
+        if self.get_session(session_id) is None and self.get_hibernated(session_id) is not None:
+            self.wake_session(session_id)
+        
         with self._lock:
             session = self._sessions.get(session_id)
             
@@ -350,6 +2020,7 @@ class SessionManager:
             session.touch()
             self._update_lru(session_id)
             self._set_current(session_id)
+            self._write_journal()
             
             logger.info(f"Switched to session: {session_id}")
             return session
@@ -374,7 +2045,7 @@ class SessionManager:
         
         Args:
             session_id: Session ID to retrieve
-            
+        
         Returns:
             ProxySession or None if not found
         """
@@ -393,20 +2064,33 @@ class SessionManager:
             return self._sessions.get(self._current_session_id)
     
     def list_sessions(self) -> List[Dict]:
-        """List all active sessions.
+        """List all sessions, hot ones first, then hibernated ones.
         
         Returns:
             List of session dictionaries
         """
         with self._lock:
-            return [session.to_dict() for session in self._sessions.values()]
+            sessions = list(self._sessions.values())
+            hibernated = list(self._hibernated.values())
+            shared = {port: len(session_ids) for port, session_ids in self._port_sessions.items()}
+        return [
+            dict(
+                session.to_dict(),
+                process_sessions=shared.get(session.process_port, 0),
+                placement=self.process_manager.placement_of(session.process_port),
+            )
+            for session in sessions
+        ] + [
+            dict(session.to_dict(), process_sessions=0, placement=None)
+            for session in reversed(hibernated)
+        ]
     
     def get_session_by_binary(self, binary_path: str) -> Optional[ProxySession]:
         """Get session by binary path.
         
         Args:
             binary_path: Path to the binary file
-            
+        
         Returns:
             ProxySession or None if not found
         """
@@ -428,7 +2112,169 @@ class SessionManager:
     def close_all(self) -> None:
         """Close all sessions."""
         with self._lock:
-            session_ids = list(self._sessions.keys())
+            session_ids = list(self._sessions.keys()) + list(self._hibernated.keys())
         
         for session_id in session_ids:
             self.close_session(session_id)
+    
+    def _write_journal(self) -> None:
+        """Persist the session table, if journaling is enabled.
+        
+        Called with the lock held so writes land in the order of the changes.
+        """
+        if self.journal is None:
+            return
+        self.journal.write(self.export_state())
+    
+    def export_state(self) -> Dict:
+        """Describe the session table and owned processes.
+        
+        The result is JSON-serializable and can be passed to
+        resume_from_state() in another proxy instance.
+        
+        Returns:
+            Session table dictionary
+        """
+        with self._lock:
+            return {
+                "proxy_pid": os.getpid(),
+                "current_session_id": self._current_session_id,
+                "lru_order": list(self._lru_order),
+                "sessions": [
+                    {
+                        "session_id": session.session_id,
+                        "binary_path": session.binary_path,
+                        "process_port": session.process_port,
+                        "ida_session_id": session.ida_session_id,
+                        "created_at": session.created_at.isoformat(),
+                        "last_accessed": session.last_accessed.isoformat(),
+                        "run_auto_analysis": session.run_auto_analysis,
+                        "content_hash": session.content_hash,
+                        "aliases": list(session.aliases),
+                        "work_dir": session.work_dir,
+                    }
+                    for session in self._sessions.values()
+                ],
+                "processes": self.process_manager.export_processes(),
+            }
+    
+    def resume_from_journal(self) -> int:
+        """Reattach to the sessions of a previous proxy instance.
+        
+        Children that are still running are adopted with their databases
+        loaded. Sessions whose child is gone keep their session ID and are
+        reopened from their saved database in the background.
+        
+        Returns:
+            Number of sessions resumed on running children
+        """
+        if self.journal is None:
+            return 0
+        state = self.journal.read()
+        if state is None:
+            return 0
+        resumed = self.resume_from_state(state)
+        logger.info(f"Resumed {resumed} sessions from journal {self.journal.path}")
+        return resumed
+    
+    def resume_from_state(self, state: Dict, probe: bool = True) -> int:
+        """Take over the sessions described by another instance's export_state().
+        
+        Args:
+            state: Session table from export_state() or the journal
+            probe: Whether children must answer a health check to be adopted.
+                Off for a live handoff, where children may be busy finishing
+                the previous instance's calls.
+        
+        Returns:
+            Number of sessions resumed on running children
+        """
+        adopted = {}
+        for record in state.get("processes", []):
+            try:
+                info = self.process_manager.adopt_process(record, probe=probe)
+            except (KeyError, TypeError, ValueError) as e:
+                logger.warning(f"Skipping malformed journaled process {record}: {e}")
+                continue
+            if info is not None:
+                adopted[info.port] = info
+        
+        lost = []
+        with self._lock:
+            for record in state.get("sessions", []):
+                try:
+                    session = ProxySession(
+                        session_id=record["session_id"],
+                        binary_path=record["binary_path"],
+                        binary_name=Path(record["binary_path"]).name,
+                        process_port=int(record["process_port"]),
+                        ida_session_id=record["ida_session_id"],
+                        created_at=datetime.fromisoformat(record["created_at"]),
+                        last_accessed=datetime.fromisoformat(record["last_accessed"]),
+                        run_auto_analysis=record.get("run_auto_analysis", True),
+                        content_hash=record.get("content_hash"),
+                        aliases=list(record.get("aliases", [])),
+                        work_dir=record.get("work_dir"),
+                    )
+                except (KeyError, TypeError, ValueError) as e:
+                    logger.warning(f"Skipping malformed journaled session {record}: {e}")
+                    continue
+                if session.session_id in self._sessions:
+                    continue
+                
+                self._sessions[session.session_id] = session
+                for path in [session.binary_path] + session.aliases:
+                    self._binary_to_session[path] = session.session_id
+                if session.content_hash:
+                    self._hash_to_session[session.content_hash] = session.session_id
+                self._watch_session(session)
+                if self.index is not None:
+                    self.index.session_opened(session)
+                info = adopted.get(session.process_port)
+                if info is not None and (
+                    session.ida_session_id in info.ida_sessions
+                    or info.current_ida_session == session.ida_session_id
+                ):
+                    self._bind(session.process_port, session.session_id)
+                    try:
+                        if self._packable(Path(session.binary_path).stat().st_size):
+                            self._pack_ports.add(session.process_port)
+                    except OSError:
+                        pass
+                else:
+                    lost.append(session.session_id)
+            
+            journaled_order = [sid for sid in state.get("lru_order", []) if sid in self._sessions]
+            self._lru_order = journaled_order + [
+                sid for sid in self._sessions if sid not in journaled_order
+            ]
+            current = state.get("current_session_id")
+            if current in self._sessions:
+                self._set_current(current)
+            self._write_journal()
+        
+        for session_id in lost:
+            logger.info(f"Process of journaled session {session_id} is gone, reopening it")
+            threading.Thread(
+                target=self._restore_quietly, args=(session_id,),
+                name=f"resume-{session_id}", daemon=True,
+            ).start()
+        
+        return len(self._sessions) - len(lost)
+    
+    def _restore_quietly(self, session_id: str) -> None:
+        """Restore a session from a background thread, logging failures."""
+        try:
+            self.restore_session(session_id)
+        except (ValueError, RuntimeError) as e:
+            logger.warning(f"Could not reopen journaled session {session_id}: {e}")
+    
+    def detach(self) -> None:
+        """Stop managing sessions but leave them open for a successor proxy.
+        
+        Replicas are closed since their private copies aren't journaled.
+        """
+        with self._lock:
+            for session in self._sessions.values():
+                self._release_replicas(session)
+            self._write_journal()
@@ -0,0 +1,358 @@
+"""Function similarity search for IDA Pro Proxy MCP"""
+
+import bisect
+import logging
+import mmap
+import multiprocessing
+import os
+import threading
+import time
+from array import array
+from concurrent.futures import ProcessPoolExecutor, ThreadPoolExecutor
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Set, Tuple
+
+from .elf_reader import ElfFile
+from .func_index import FUNCTION, BinaryIndex, FunctionIndex
+from .hashing import FileHasher
+
+logger = logging.getLogger(__name__)
+
+# Values in a fingerprint
+BINS = 64
+# LSH bands; each covers BINS // BANDS values
+BANDS = 16
+ROWS = BINS // BANDS
+# Bytes per n-gram; matches the width of the "I" array type
+SHINGLE = 4
+# Functions outside these sizes are not fingerprinted
+MIN_BYTES = 16
+MAX_BYTES = 1024 * 1024
+
+_MULT = 0x9E3779B97F4A7C15
+_MASK = (1 << 64) - 1
+_EMPTY = 0xFFFFFFFF
+
+
+def fingerprint(data: bytes) -> List[int]:
+    """MinHash fingerprint of the byte n-grams of a function.
+    
+    One-permutation MinHash: each distinct n-gram is hashed once, the top
+    bits of the hash pick one of BINS bins and each bin keeps its smallest
+    value. Empty bins borrow the value of the next filled bin, so short
+    functions still compare well. The fraction of equal values of two
+    fingerprints estimates the Jaccard similarity of their n-gram sets.
+    
+    Args:
+        data: Function bytes, at least SHINGLE long
+    
+    Returns:
+        BINS 32-bit values
+    """
+    view = memoryview(data)
+    shingles: Set[int] = set()
+    for start in range(SHINGLE):
+        end = start + (len(data) - start) // SHINGLE * SHINGLE
+        shingles.update(view[start:end].cast("I"))
+    
+    bins = [_EMPTY] * BINS
+    for x in shingles:
+        h = (x * _MULT) & _MASK
+        b = h >> 58
+        v = (h >> 16) & 0xFFFFFFFF
+        if v < bins[b]:
+            bins[b] = v
+    
+    filled = [i for i, v in enumerate(bins) if v != _EMPTY]
+    if len(filled) < BINS:
+        dense = list(bins)
+        for i in range(BINS):
+            if bins[i] == _EMPTY:
+                j = filled[bisect.bisect_left(filled, i) % len(filled)]
+                dense[i] = (bins[j] + ((j - i) % BINS) * 0x9E3779B1) & 0xFFFFFFFF
+        bins = dense
+    return bins
+
+
+def _fingerprint_spans(path: str, spans: List[Tuple[int, int]]) -> bytes:
+    """Fingerprint (offset, size) byte ranges of a file; runs in a worker process."""
+    out = array("I")
+    with open(path, "rb") as f, mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+        for offset, size in spans:
+            out.extend(fingerprint(mapped[offset:offset + size]))
+    return out.tobytes()
+
+
+def _band_keys(values) -> List[int]:
+    """LSH bucket key of each band of a fingerprint."""
+    return [hash((band,) + tuple(values[band * ROWS:(band + 1) * ROWS])) for band in range(BANDS)]
+
+
+@dataclass
+class BinaryFingerprints:
+    """Fingerprints of the functions of one binary.
+    
+    Attributes:
+        content_hash: Content hash of the binary
+        names: Function names
+        addrs: Function addresses
+        sizes: Function sizes
+        values: BINS values per function, flattened
+        buckets: LSH bucket key -> indices of the functions in it
+    """
+    content_hash: str
+    names: List[str] = field(default_factory=list)
+    addrs: array = field(default_factory=lambda: array("Q"))
+    sizes: array = field(default_factory=lambda: array("Q"))
+    values: array = field(default_factory=lambda: array("I"))
+    buckets: Dict[int, List[int]] = field(default_factory=dict)
+    
+    def __len__(self) -> int:
+        return len(self.names)
+    
+    def signature(self, i: int) -> array:
+        return self.values[i * BINS:(i + 1) * BINS]
+    
+    def add(self, name: str, addr: int, size: int, values) -> None:
+        i = len(self.names)
+        self.names.append(name)
+        self.addrs.append(addr)
+        self.sizes.append(size)
+        self.values.extend(values)
+        for key in _band_keys(values):
+            self.buckets.setdefault(key, []).append(i)
+    
+    def find(self, addr: Optional[int] = None, name: Optional[str] = None) -> Optional[int]:
+        """Index of the function at addr, or else named name."""
+        for i in range(len(self.names)):
+            if (addr is not None and self.addrs[i] == addr) or (
+                addr is None and self.names[i] == name
+            ):
+                return i
+        return None
+
+
+def similarity(a, b) -> float:
+    """Estimated Jaccard similarity of two fingerprints."""
+    return sum(1 for x, y in zip(a, b) if x == y) / BINS
+
+
+class SimilarityIndex:
+    """Finds functions similar to a given one across indexed binaries.
+    
+    Whenever the FunctionIndex builds a binary's index, the binary's
+    functions are fingerprinted from the file on disk (ELF only; IDA is not
+    involved) and bucketed for LSH. Fingerprints are kept per content hash
+    for as long as the function index keeps the binary, and those of
+    functions whose address and size are unchanged are reused when the
+    index is refreshed. Large binaries are fingerprinted on a pool of
+    worker processes.
+    """
+    
+    # Functions below which a binary is fingerprinted in-process
+    PARALLEL_THRESHOLD = 512
+    # Chunks per worker process, for load balancing
+    CHUNKS_PER_WORKER = 4
+    
+    def __init__(self, function_index: FunctionIndex, workers: int = 0):
+        """Initialize the similarity index.
+        
+        Args:
+            function_index: Index supplying the functions of each binary
+            workers: Worker processes for fingerprinting (0 for one per CPU)
+        """
+        self.function_index = function_index
+        self.workers = workers or os.cpu_count() or 1
+        self._lock = threading.Lock()
+        self._binaries: Dict[str, BinaryFingerprints] = {}  # content hash -> fingerprints
+        self._pending: Set[str] = set()
+        self._errors: Dict[str, str] = {}  # content hash -> fingerprinting error
+        self._hasher = FileHasher()
+        self._executor = ThreadPoolExecutor(max_workers=1, thread_name_prefix="fingerprint")
+        self._pool: Optional[ProcessPoolExecutor] = None
+        function_index.add_listener(self._on_indexed)
+    
+    def _on_indexed(self, entry: BinaryIndex) -> None:
+        with self._lock:
+            self._pending.add(entry.content_hash)
+        self._executor.submit(self._build, entry)
+    
+    def _build(self, entry: BinaryIndex) -> None:
+        """Fingerprint the functions of a freshly indexed binary."""
+        key = entry.content_hash
+        started = time.monotonic()
+        try:
+            fingerprints, reused = self._fingerprint(entry)
+        except (OSError, ValueError, RuntimeError) as e:
+            logger.info(f"Not fingerprinting {entry.binary_path}: {e}")
+            with self._lock:
+                self._pending.discard(key)
+                self._errors[key] = str(e)
+            return
+        
+        with self._lock:
+            self._pending.discard(key)
+            self._errors.pop(key, None)
+            self._binaries[key] = fingerprints
+            kept = {e.content_hash for e in self.function_index.entries()}
+            for stale in [k for k in self._binaries if k not in kept]:
+                del self._binaries[stale]
+        logger.info(
+            f"Fingerprinted {len(fingerprints)} functions of {entry.binary_path} "
+            f"({reused} reused) in {time.monotonic() - started:.2f}s"
+        )
+    
+    def _fingerprint(self, entry: BinaryIndex) -> Tuple[BinaryFingerprints, int]:
+        """Fingerprint a binary's functions, reusing unchanged ones."""
+        if self._hasher.hash_file(Path(entry.binary_path)) != entry.content_hash:
+            raise ValueError("the file changed since it was opened")
+        elf = ElfFile(entry.binary_path)
+        table = entry.tables.get(FUNCTION)
+        if table is None:
+            raise ValueError("no functions indexed")
+        
+        with self._lock:
+            old = self._binaries.get(entry.content_hash)
+        previous = {}
+        if old is not None:
+            previous = {(old.addrs[i], old.sizes[i]): i for i in range(len(old))}
+        
+        functions = []  # (name, addr, size, offset, index in old)
+        for i in range(len(table)):
+            addr, size = table.addrs[i], min(table.sizes[i], MAX_BYTES)
+            if size < MIN_BYTES:
+                continue
+            offset = elf.offset_of(addr, size)
+            if offset is not None:
+                functions.append((table.names[i], addr, size, offset, previous.get((addr, size))))
+        
+        todo = [(offset, size) for _, _, size, offset, reuse in functions if reuse is None]
+        computed = array("I")
+        computed.frombytes(self._run(entry.binary_path, todo))
+        
+        fingerprints = BinaryFingerprints(entry.content_hash)
+        n = 0
+        for name, addr, size, _, reuse in functions:
+            if reuse is not None:
+                values = old.signature(reuse)
+            else:
+                values = computed[n * BINS:(n + 1) * BINS]
+                n += 1
+            fingerprints.add(name, addr, size, values)
+        return fingerprints, len(functions) - len(todo)
+    
+    def _run(self, path: str, spans: List[Tuple[int, int]]) -> bytes:
+        """Fingerprint byte ranges, on the worker processes if there are many."""
+        if len(spans) < self.PARALLEL_THRESHOLD or self.workers == 1:
+            return _fingerprint_spans(path, spans)
+        if self._pool is None:
+            # Spawned rather than forked: the proxy is multithreaded
+            self._pool = ProcessPoolExecutor(
+                max_workers=self.workers, mp_context=multiprocessing.get_context("spawn")
+            )
+        size = -(-len(spans) // (self.workers * self.CHUNKS_PER_WORKER))
+        chunks = [spans[i:i + size] for i in range(0, len(spans), size)]
+        return b"".join(self._pool.map(_fingerprint_spans, [path] * len(chunks), chunks))
+    
+    def similar(
+        self,
+        key: str,
+        addr: Optional[int] = None,
+        name: Optional[str] = None,
+        top_k: int = 10,
+        min_similarity: float = 0.5,
+        include_closed: bool = True,
+    ) -> Dict[str, Any]:
+        """Find the functions most similar to one function.
+        
+        Args:
+            key: Content hash of the binary containing the function
+            addr: Address of the function
+            name: Name of the function, if addr is not given
+            top_k: Maximum number of matches
+            min_similarity: Smallest estimated similarity reported (0-1)
+            include_closed: Whether to search binaries no longer open
+        
+        Returns:
+            Dictionary with the ``function`` searched for, ``matches`` by
+            descending similarity, ``count`` and ``pending`` (binaries not
+            fingerprinted yet)
+        
+        Raises:
+            ValueError: If the function is unknown or not fingerprinted
+        """
+        if addr is None and name is None:
+            raise ValueError("addr or name is required")
+        entries = {e.content_hash: e for e in self.function_index.entries()}
+        with self._lock:
+            binaries = {k: b for k, b in self._binaries.items() if k in entries}
+            pending = sorted(entries[k].binary_path for k in self._pending if k in entries)
+            error = self._errors.get(key)
+        
+        target = binaries.get(key)
+        if target is None:
+            if error is not None:
+                raise ValueError(f"The binary could not be fingerprinted: {error}")
+            raise ValueError("The binary has not been fingerprinted yet; retry shortly")
+        i = target.find(addr, name)
+        if i is None:
+            what = hex(addr) if addr is not None else name
+            raise ValueError(
+                f"No fingerprinted function {what} (functions under {MIN_BYTES} bytes are skipped)"
+            )
+        signature = target.signature(i)
+        keys = _band_keys(signature)
+        
+        matches = []
+        for other_key, other in binaries.items():
+            entry = entries[other_key]
+            if entry.session_id is None and not include_closed:
+                continue
+            candidates = set()
+            for band_key in keys:
+                candidates.update(other.buckets.get(band_key, ()))
+            if other is target:
+                candidates.discard(i)
+            for j in candidates:
+                score = similarity(signature, other.signature(j))
+                if score >= min_similarity:
+                    matches.append((score, entry, other, j))
+        matches.sort(key=lambda m: -m[0])
+        
+        return {
+            "function": {
+                "name": target.names[i],
+                "addr": hex(target.addrs[i]),
+                "size": target.sizes[i],
+            },
+            "matches": [
+                {
+                    "similarity": round(score, 3),
+                    "name": other.names[j],
+                    "addr": hex(other.addrs[j]),
+                    "size": other.sizes[j],
+                    "binary": entry.binary_path,
+                    "session_id": entry.session_id,
+                }
+                for score, entry, other, j in matches[:top_k]
+            ],
+            "count": min(len(matches), top_k),
+            "pending": pending,
+        }
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize the index for JSON serialization."""
+        with self._lock:
+            return {
+                "binaries": len(self._binaries),
+                "functions": sum(len(b) for b in self._binaries.values()),
+                "pending": len(self._pending),
+                "errors": len(self._errors),
+            }
+    
+    def close(self) -> None:
+        """Stop fingerprinting and the worker processes."""
+        self._executor.shutdown(wait=False, cancel_futures=True)
+        if self._pool is not None:
+            self._pool.shutdown(wait=False, cancel_futures=True)
@@ -0,0 +1,233 @@
+"""Binary summaries gathered at open time for IDA Pro Proxy MCP"""
+
+import logging
+import re
+import threading
+import time
+from collections import OrderedDict
+from typing import Any, Dict, List, Optional
+
+from .elf_reader import ELF_TYPES, MACHINES, ElfFile
+from .func_index import page_items, parse_int, tool_result
+from .models import ProxySession
+from .process_manager import ProcessManager
+
+logger = logging.getLogger(__name__)
+
+# Strings worth showing first: URLs, paths, format strings, file names and
+# words that tend to mark credentials, debugging or error handling
+INTERESTING_STRING = re.compile(
+    r"[a-z]+://|(^|[\s\"'])/(bin|dev|etc|home|proc|sys|tmp|usr|var)/|%[-+ #0-9.]*[sdiuxXpfgcl]"
+    r"|\.(so|dll|exe|conf|cfg|ini|json|xml|db|key|pem)\b"
+    r"|passw|secret|token|api.?key|private|admin|debug|error|fail|invalid|denied",
+    re.IGNORECASE,
+)
+
+
+class BinarySummarizer:
+    """Gathers the overview agents ask for right after opening a binary.
+    
+    The function count, entry points, imports and strings come from the
+    child in one JSON-RPC batch once the open (and its auto-analysis) is
+    done; headers and sections of ELF files come from the file itself.
+    Summaries are kept per content hash, so reopening the same content,
+    e.g. after eviction, costs no child call at all.
+    
+    Attributes:
+        max_entries: Number of summaries kept
+    """
+    
+    # Largest functions, entry points, imports and strings listed
+    LARGEST_FUNCTIONS = 10
+    MAX_ENTRY_POINTS = 50
+    MAX_IMPORTS = 200
+    MAX_STRINGS = 50
+    # Strings fetched from the child to pick the interesting ones from
+    STRING_SAMPLE = 5000
+    # Timeout for the whole batch (seconds)
+    CALL_TIMEOUT = 300
+    
+    def __init__(self, process_manager: ProcessManager, max_entries: int = 256):
+        self.process_manager = process_manager
+        self.max_entries = max_entries
+        self._summaries: "OrderedDict[str, Dict[str, Any]]" = OrderedDict()
+        self._lock = threading.Lock()
+        self.hits = 0
+        self.builds = 0
+        self.failures = 0
+    
+    @staticmethod
+    def _key(session: ProxySession) -> str:
+        return session.content_hash or session.session_id
+    
+    def get(self, content_hash: str) -> Optional[Dict[str, Any]]:
+        """Get the cached summary of some content, if any."""
+        with self._lock:
+            summary = self._summaries.get(content_hash)
+            if summary is not None:
+                self._summaries.move_to_end(content_hash)
+            return summary
+    
+    def invalidate(self, content_hash: Optional[str]) -> None:
+        """Drop the cached summary of some content, e.g. after its database changed."""
+        with self._lock:
+            self._summaries.pop(content_hash, None)
+    
+    def build(self, session: ProxySession, refresh: bool = False) -> Dict[str, Any]:
+        """Get a session's summary, gathering it from its process if needed.
+        
+        A summary with parts that failed is returned but not cached, so the
+        next request tries again.
+        
+        Args:
+            session: Session to summarize
+            refresh: Gather the summary again even if one is cached
+        
+        Returns:
+            Summary dictionary
+        
+        Raises:
+            RuntimeError: If the batch could not be sent to the process
+        """
+        key = self._key(session)
+        if not refresh:
+            cached = self.get(key)
+            if cached is not None:
+                with self._lock:
+                    self.hits += 1
+                return cached
+        
+        started = time.monotonic()
+        calls = [
+            # A count of 0 lists everything
+            ("list_funcs", {"queries": {"offset": 0, "count": 0, "filter": "*"}}),
+            ("entrypoints", {}),
+            ("imports", {"offset": 0, "count": 0}),
+            ("strings", {"queries": {"offset": 0, "count": self.STRING_SAMPLE, "filter": "*"}}),
+        ]
+        requests = [
+            {
+                "jsonrpc": "2.0",
+                "id": i,
+                "method": "tools/call",
+                "params": {"name": name, "arguments": arguments},
+            }
+            for i, (name, arguments) in enumerate(calls)
+        ]
+        try:
+            responses = self.process_manager.forward_batch(
+                session.process_port, requests, timeout=self.CALL_TIMEOUT, ida_session=session.ida_session_id
+            )
+        except RuntimeError:
+            with self._lock:
+                self.failures += 1
+            raise
+        
+        items: Dict[str, List[Dict[str, Any]]] = {}
+        errors: Dict[str, str] = {}
+        for (name, _), response in zip(calls, responses):
+            try:
+                items[name], _ = page_items(tool_result(name, response))
+            except (RuntimeError, ValueError) as e:
+                errors[name] = str(e)
+        
+        summary: Dict[str, Any] = {
+            "binary_path": session.binary_path,
+            "content_hash": session.content_hash,
+            "file": self._file_info(session.binary_path),
+        }
+        if "list_funcs" in items:
+            summary.update(self._functions(items["list_funcs"]))
+        if "entrypoints" in items:
+            summary["entry_points"] = [
+                {"name": e.get("name"), "addr": hex(parse_int(e.get("addr")))}
+                for e in items["entrypoints"][:self.MAX_ENTRY_POINTS]
+            ]
+        if "imports" in items:
+            summary.update(self._imports(items["imports"]))
+        if "strings" in items:
+            summary.update(self._strings(items["strings"]))
+        if errors:
+            summary["errors"] = errors
+        summary["build_time"] = round(time.monotonic() - started, 3)
+        
+        with self._lock:
+            self.builds += 1
+            if errors:
+                self.failures += 1
+            else:
+                self._summaries[key] = summary
+                self._summaries.move_to_end(key)
+                while len(self._summaries) > self.max_entries:
+                    self._summaries.popitem(last=False)
+        logger.info(
+            f"Summarized session {session.session_id} in {summary['build_time']}s"
+            + (f" ({len(errors)} parts failed)" if errors else "")
+        )
+        return summary
+    
+    def _functions(self, funcs: List[Dict[str, Any]]) -> Dict[str, Any]:
+        sized = sorted(
+            ((parse_int(f.get("size", 0)), f.get("name"), parse_int(f.get("addr"))) for f in funcs),
+            key=lambda f: f[0],
+            reverse=True,
+        )
+        return {
+            "function_count": len(funcs),
+            "largest_functions": [
+                {"name": name, "addr": hex(addr), "size": size}
+                for size, name, addr in sized[:self.LARGEST_FUNCTIONS]
+            ],
+        }
+    
+    def _imports(self, imports: List[Dict[str, Any]]) -> Dict[str, Any]:
+        modules: Dict[str, int] = {}
+        for imp in imports:
+            module = imp.get("module") or ""
+            modules[module] = modules.get(module, 0) + 1
+        return {
+            "import_count": len(imports),
+            "import_modules": modules,
+            "imports": [
+                imp.get("imported_name") or imp.get("name") for imp in imports[:self.MAX_IMPORTS]
+            ],
+        }
+    
+    def _strings(self, strings: List[Dict[str, Any]]) -> Dict[str, Any]:
+        interesting = []
+        for item in strings:
+            text = item.get("string") or item.get("text") or ""
+            if INTERESTING_STRING.search(text):
+                interesting.append({"addr": hex(parse_int(item.get("addr"))), "string": text})
+                if len(interesting) == self.MAX_STRINGS:
+                    break
+        return {"strings_sampled": len(strings), "interesting_strings": interesting}
+    
+    @staticmethod
+    def _file_info(path: str) -> Optional[Dict[str, Any]]:
+        """Headers and sections read from the file, for ELF files."""
+        try:
+            if not ElfFile.is_elf(path):
+                return None
+            elf = ElfFile(path)
+        except (OSError, ValueError):
+            return None
+        return {
+            "format": f"ELF{elf.bits}",
+            "type": ELF_TYPES.get(elf.type, hex(elf.type)),
+            "machine": MACHINES.get(elf.machine, str(elf.machine)),
+            "entry": hex(elf.entry),
+            "interpreter": elf.interpreter,
+            "needed": elf.needed,
+            "sections": [s.to_dict() for s in elf.sections if s.name],
+        }
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize the cache for JSON serialization."""
+        with self._lock:
+            return {
+                "summaries": len(self._summaries),
+                "hits": self.hits,
+                "builds": self.builds,
+                "failures": self.failures,
+            }
@@ -0,0 +1,590 @@
+"""Idle-time and call-graph-guided decompilation to warm the result cache for IDA Pro Proxy MCP"""
+
+import bisect
+import logging
+import threading
+import time
+from collections import OrderedDict, deque
+from concurrent.futures import Future, ThreadPoolExecutor
+from typing import Any, Callable, Deque, Dict, List, Optional, Tuple
+
+from .cancellation import CancelToken
+from .func_index import (
+    EXPORT, FUNCTION, IMPORT, BinaryIndex, FunctionIndex, page_items, parse_int, tool_result,
+)
+from .models import ProxySession
+from .result_cache import ResultCache
+from .session_manager import SessionManager
+
+logger = logging.getLogger(__name__)
+
+# Imports whose callers are usually worth a look first
+DANGEROUS_IMPORTS = frozenset({
+    "gets", "system", "popen", "execl", "execle", "execlp", "execv", "execve", "execvp",
+    "strcpy", "strcat", "stpcpy", "sprintf", "vsprintf", "scanf", "sscanf", "fscanf",
+    "memcpy", "strncpy", "strncat", "alloca", "realpath", "getenv", "dlopen",
+})
+
+
+def _import_base_name(name: str) -> str:
+    """Strip decorations like a leading underscore or a symbol version."""
+    return name.split("@", 1)[0].lstrip("_")
+
+
+def _graph_addrs(items: List[Any], key: str) -> List[int]:
+    """Addresses of the internal functions in a callees or callers result."""
+    addrs = []
+    for item in items:
+        if not isinstance(item, dict):
+            continue
+        for entry in item.get(key, [item]):
+            if isinstance(entry, dict) and entry.get("type") != "external" and entry.get("addr") is not None:
+                addrs.append(parse_int(entry["addr"]))
+    return addrs
+
+
+class CacheWarmer:
+    """Decompiles functions of the current session while its process is idle.
+    
+    Agents think for seconds between calls, leaving their process idle.
+    Once the current session's process has had nothing queued for
+    IDLE_DELAY, the warmer decompiles its functions one at a time and puts
+    the results into the result cache, so an agent's first decompile of
+    them is a cache hit. Entry points go first, then functions calling
+    dangerous imports such as ``gets``, ``system`` or ``strcpy``, then the
+    rest by descending size. A warming call, like the call-graph lookups
+    behind the plan and the prefetches, is cancelled as soon as a real call
+    queues behind it.
+    
+    The plan comes from the function index, so a session is warmed once it
+    has been indexed; a new generation gets a new plan.
+    
+    After an agent's decompile of a function, its direct callees and then
+    its callers are prefetched the same way, ahead of the plan, and their
+    neighbours in turn up to prefetch_depth calls away. A session's next
+    decompile replaces its queued prefetches. Every result put into the
+    cache is tracked until an agent reads it (a hit) or it goes stale
+    unread (waste).
+    
+    Attributes:
+        limit: Functions decompiled per session generation
+        prefetch_depth: Call-graph distance prefetched around a decompiled
+            function (0 disables prefetching)
+    """
+    
+    TOOL = "decompile"
+    # Seconds a process must have been idle before warming starts
+    IDLE_DELAY = 1.0
+    # Seconds between idleness checks
+    POLL_INTERVAL = 0.25
+    # Seconds between checks for a real call queueing behind a warming call
+    PREEMPT_POLL = 0.01
+    # Timeout of one warming or call-graph call
+    CALL_TIMEOUT = 120
+    # Functions prefetched around one decompiled function
+    PREFETCH_MAX = 32
+    
+    def __init__(
+        self,
+        session_manager: SessionManager,
+        result_cache: ResultCache,
+        index: FunctionIndex,
+        limit: int = 200,
+        prefetch_depth: int = 1,
+    ):
+        """Initialize the warmer and start its background thread.
+        
+        Args:
+            session_manager: Provides the current session and its process
+            result_cache: Cache the results are put into
+            index: Function index the warming plan is built from
+            limit: Functions decompiled per session generation
+            prefetch_depth: Call-graph distance prefetched around a
+                decompiled function
+        """
+        self.session_manager = session_manager
+        self.process_manager = session_manager.process_manager
+        self.result_cache = result_cache
+        self.index = index
+        self.limit = limit
+        self.prefetch_depth = prefetch_depth
+        self._lock = threading.Lock()
+        self._plan_key: Optional[Tuple[str, int, float]] = None  # session, generation, index build
+        self._plan: List[int] = []
+        self._position = 0
+        self._idle_since: Optional[float] = None
+        # (session_id, generation, function, distance from the decompiled function)
+        self._prefetch: Deque[Tuple[str, int, int, int]] = deque()
+        self._prefetch_budget: Dict[str, int] = {}  # session_id -> functions still to queue
+        self._graphs: Dict[str, Tuple[int, Dict[int, List[int]]]] = {}  # session_id -> generation, neighbours
+        # (session_id, generation, addr) -> "warm" or "prefetch", for results not read yet
+        self._speculative: "OrderedDict[Tuple[str, int, str], str]" = OrderedDict()
+        self._wake = threading.Event()
+        self._executor = ThreadPoolExecutor(max_workers=1, thread_name_prefix="warmer-call")
+        self._stop = threading.Event()
+        self.warmed = 0
+        self.preempted = 0
+        self.already_cached = 0
+        self.failures = 0
+        self.prefetched = 0
+        self.prefetch_cancelled = 0
+        self.hits = {"warm": 0, "prefetch": 0}
+        self.wasted = {"warm": 0, "prefetch": 0}
+        self._thread = threading.Thread(target=self._run, name="cache-warmer", daemon=True)
+        self._thread.start()
+    
+    def served(self, session: ProxySession, tool_name: str, arguments: Dict[str, Any], cached: bool) -> None:
+        """Note a call the router served successfully.
+        
+        A cached decompile of a warmed or prefetched function counts as a
+        hit, and a decompile queues prefetches of its call-graph neighbours.
+        
+        Args:
+            session: Session the call ran on
+            tool_name: Tool called
+            arguments: Tool arguments, without the session
+            cached: Whether the result came from the cache
+        """
+        if tool_name != self.TOOL:
+            return
+        function = arguments.get("addr")
+        if cached and isinstance(function, str):
+            with self._lock:
+                source = self._speculative.pop((session.session_id, session.generation, function), None)
+                if source is not None:
+                    self.hits[source] += 1
+        if self.prefetch_depth <= 0:
+            return
+        addr = self._resolve(session, function)
+        if addr is None:
+            return
+        with self._lock:
+            kept = deque(item for item in self._prefetch if item[0] != session.session_id)
+            self.prefetch_cancelled += sum(1 for item in self._prefetch if item[3] > 0) - \
+                sum(1 for item in kept if item[3] > 0)
+            kept.append((session.session_id, session.generation, addr, 0))
+            self._prefetch = kept
+            self._prefetch_budget[session.session_id] = self.PREFETCH_MAX
+        self._wake.set()
+    
+    def _resolve(self, session: ProxySession, function: Any) -> Optional[int]:
+        """Address of a function given by address or name."""
+        if isinstance(function, int):
+            return function
+        if not isinstance(function, str):
+            return None
+        try:
+            return int(function, 0)
+        except ValueError:
+            pass
+        entry = self.index.get(session.content_hash or session.session_id)
+        table = entry.tables.get(FUNCTION) if entry is not None else None
+        if table is None:
+            return None
+        matches = table.exact(function)
+        return table.addrs[matches.start] if matches else None
+    
+    def _run(self) -> None:
+        while not self._stop.is_set():
+            self._wake.wait(self.POLL_INTERVAL)
+            self._wake.clear()
+            try:
+                self._sweep()
+                while not self._stop.is_set() and self._step():
+                    pass
+            except Exception as e:
+                logger.warning(f"Cache warmer step failed: {e}")
+    
+    def _idle(self, port: int) -> bool:
+        return not self.process_manager.queue_depth(port) and not self.process_manager.is_draining(port)
+    
+    def _step(self) -> bool:
+        """Prefetch or warm one function if its session is idle.
+        
+        Returns:
+            True if the next function may follow at once
+        """
+        prefetched = self._step_prefetch()
+        if prefetched is not None:
+            return prefetched
+        if self.limit <= 0:
+            return False
+        
+        session = self.session_manager.get_current_session()
+        if session is None or session.restoring:
+            self._idle_since = None
+            return False
+        if not self._idle(session.process_port):
+            self._idle_since = None
+            return False
+        now = time.monotonic()
+        if self._idle_since is None:
+            self._idle_since = now
+        if now - self._idle_since < self.IDLE_DELAY:
+            return False
+        
+        addr = self._next_function(session)
+        if addr is None:
+            return False
+        outcome = self._warm(session, addr, "warm")
+        if outcome == "preempted":
+            with self._lock:
+                # Try this function again next time the process is idle
+                if self._position > 0:
+                    self._position -= 1
+        return outcome != "preempted"
+    
+    def _step_prefetch(self) -> Optional[bool]:
+        """Work on the first queued prefetch.
+        
+        Returns:
+            None if nothing is queued, otherwise whether the next step may
+            follow at once
+        """
+        with self._lock:
+            if not self._prefetch:
+                return None
+            item = self._prefetch[0]
+        session_id, generation, addr, distance = item
+        session = self.session_manager.get_session(session_id)
+        stale = session is None or session.generation != generation
+        if not stale and (session.restoring or not self._idle(session.process_port)):
+            return False
+        with self._lock:
+            if self._prefetch and self._prefetch[0] == item:
+                self._prefetch.popleft()
+            if stale:
+                self.prefetch_cancelled += distance > 0
+        if stale:
+            return True
+        
+        if distance < self.prefetch_depth:
+            neighbours = self._neighbours(session, addr)
+            if neighbours is None:
+                with self._lock:
+                    self._prefetch.appendleft(item)
+                return False
+            with self._lock:
+                queued = {(i[0], i[2]) for i in self._prefetch}
+                for neighbour in neighbours:
+                    if self._prefetch_budget.get(session_id, 0) <= 0:
+                        break
+                    if neighbour != addr and (session_id, neighbour) not in queued:
+                        queued.add((session_id, neighbour))
+                        self._prefetch.append((session_id, generation, neighbour, distance + 1))
+                        self._prefetch_budget[session_id] -= 1
+        if distance == 0:
+            # The agent decompiled this one itself
+            return True
+        if self.result_cache.get(session_id, generation, self.TOOL, self._arguments(addr)):
+            return True
+        outcome = self._warm(session, addr, "prefetch")
+        if outcome == "preempted":
+            with self._lock:
+                self._prefetch.appendleft(item)
+        return outcome != "preempted"
+    
+    def _neighbours(self, session: ProxySession, addr: int) -> Optional[List[int]]:
+        """Callees, then callers, of a function; learned once per generation.
+        
+        Returns:
+            The neighbours, or None if a real call preempted the lookup
+        """
+        with self._lock:
+            generation, graph = self._graphs.get(session.session_id, (None, {}))
+            if generation != session.generation:
+                graph = {}
+                self._graphs[session.session_id] = (session.generation, graph)
+            if addr in graph:
+                return graph[addr]
+        
+        requests = [
+            {
+                "jsonrpc": "2.0",
+                "id": i,
+                "method": "tools/call",
+                "params": {"name": name, "arguments": {"addrs": hex(addr)}},
+            }
+            for i, name in enumerate(("callees", "callers"))
+        ]
+        future, preempted = self._preemptible(
+            session.process_port,
+            lambda token: self.process_manager.forward_batch(
+                session.process_port, requests, timeout=self.CALL_TIMEOUT, cancel_token=token,
+                ida_session=session.ida_session_id,
+            ),
+            own=len(requests),
+        )
+        if preempted:
+            return None
+        try:
+            responses = future.result()
+            callees, _ = page_items(tool_result("callees", responses[0]))
+            callers, _ = page_items(tool_result("callers", responses[1]))
+        except (RuntimeError, ValueError) as e:
+            logger.debug(f"Could not get the call graph around {hex(addr)} in {session.session_id}: {e}")
+            return []
+        
+        neighbours = []
+        for neighbour in _graph_addrs(callees, "callees") + _graph_addrs(callers, "callers"):
+            if neighbour not in neighbours:
+                neighbours.append(neighbour)
+        with self._lock:
+            graph[addr] = neighbours
+        return neighbours
+    
+    def _sweep(self) -> None:
+        """Count tracked results whose session closed or changed as wasted."""
+        with self._lock:
+            tracked = list(self._speculative)
+        generations = {}
+        for session_id, _, _ in tracked:
+            if session_id not in generations:
+                session = self.session_manager.get_session(session_id)
+                generations[session_id] = session.generation if session is not None else None
+        with self._lock:
+            for key in tracked:
+                if generations[key[0]] != key[1] and key in self._speculative:
+                    self.wasted[self._speculative.pop(key)] += 1
+            for session_id in [sid for sid, g in generations.items() if g is None]:
+                self._graphs.pop(session_id, None)
+                self._prefetch_budget.pop(session_id, None)
+    
+    def _next_function(self, session: ProxySession) -> Optional[int]:
+        """Next function of the session's plan that is not cached yet."""
+        entry = self.index.get(session.content_hash or session.session_id)
+        if entry is None or FUNCTION not in entry.tables:
+            return None
+        key = (session.session_id, session.generation, entry.built_at)
+        with self._lock:
+            if key != self._plan_key:
+                self._plan_key = key
+                self._plan = []
+                self._position = 0
+                planning = True
+            else:
+                planning = False
+        if planning:
+            plan = self._build_plan(session, entry)
+            with self._lock:
+                if self._plan_key == key:
+                    if plan is None:
+                        # Plan again next time the process is idle
+                        self._plan_key = None
+                        return None
+                    self._plan = plan
+        
+        while True:
+            with self._lock:
+                if self._plan_key != key or self._position >= len(self._plan):
+                    return None
+                addr = self._plan[self._position]
+                self._position += 1
+            if self.result_cache.get(session.session_id, session.generation, self.TOOL, self._arguments(addr)):
+                self.already_cached += 1
+                continue
+            return addr
+    
+    def _build_plan(self, session: ProxySession, entry: BinaryIndex) -> Optional[List[int]]:
+        """Order a session's functions for warming.
+        
+        Returns:
+            Function addresses in warming order, or None if a real call
+            preempted the lookup of dangerous imports' callers
+        """
+        functions = entry.tables[FUNCTION]
+        starts = sorted(zip(functions.addrs, functions.sizes))
+        sizes = dict(starts)
+        plan: List[int] = []
+        seen = set()
+        
+        def add(addr: int) -> None:
+            if addr in sizes and addr not in seen:
+                seen.add(addr)
+                plan.append(addr)
+        
+        exports = entry.tables.get(EXPORT)
+        if exports is not None:
+            for addr in exports.addrs:
+                add(addr)
+        
+        imports = entry.tables.get(IMPORT)
+        if imports is not None:
+            dangerous = [
+                imports.addrs[i] for i, name in enumerate(imports.names)
+                if _import_base_name(name) in DANGEROUS_IMPORTS
+            ]
+            callers = self._callers(session, dangerous, starts)
+            if callers is None:
+                return None
+            for addr in callers:
+                add(addr)
+        
+        for addr, _ in sorted(starts, key=lambda s: s[1], reverse=True):
+            add(addr)
+        return plan[:self.limit]
+    
+    def _callers(
+        self, session: ProxySession, targets: List[int], starts: List[Tuple[int, int]]
+    ) -> Optional[List[int]]:
+        """Start addresses of the functions referencing any of the targets.
+        
+        Returns:
+            The callers, or None if a real call preempted the lookup
+        """
+        if not targets:
+            return []
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {"name": "xrefs_to", "arguments": {"addrs": [hex(a) for a in targets]}},
+        }
+        future, preempted = self._preemptible(
+            session.process_port,
+            lambda token: self.process_manager.forward_request(
+                session.process_port, request, self.CALL_TIMEOUT, token, ida_session=session.ida_session_id,
+            ),
+        )
+        if preempted:
+            return None
+        try:
+            response = future.result()
+            items, _ = page_items(tool_result("xrefs_to", response))
+        except (RuntimeError, ValueError) as e:
+            logger.info(f"Could not find callers of dangerous imports in {session.session_id}: {e}")
+            return []
+        
+        addrs = [start for start, _ in starts]
+        callers = []
+        # Either one entry per target with its "xrefs", or a flat list of xrefs
+        xrefs = []
+        for item in items:
+            if isinstance(item, dict):
+                xrefs.extend(x for x in item.get("xrefs", [item]) if isinstance(x, dict))
+        for xref in xrefs:
+            function = xref.get("fn")
+            if isinstance(function, dict) and function.get("addr") is not None:
+                callers.append(parse_int(function["addr"]))
+                continue
+            addr = parse_int(xref.get("from", xref.get("addr")))
+            i = bisect.bisect_right(addrs, addr) - 1
+            if i >= 0 and addr < starts[i][0] + max(starts[i][1], 1):
+                callers.append(starts[i][0])
+        return callers
+    
+    @staticmethod
+    def _arguments(addr: int) -> Dict[str, Any]:
+        return {"addr": hex(addr)}
+    
+    def _preemptible(self, port: int, call: Callable[[CancelToken], Any], own: int = 1) -> Tuple[Future, bool]:
+        """Run a call to a process on the warmer's thread, yielding to real calls.
+        
+        Args:
+            port: Port of the process the call goes to
+            call: Sends the call, given the token cancelling it
+            own: Requests the call puts in flight on the process
+        
+        Returns:
+            The call's future, and whether it was cancelled because a real
+            call queued behind it or the warmer stopped
+        """
+        # A warming call that never drains isn't worth restarting the process for
+        token = CancelToken(escalate=False)
+        future: Future = self._executor.submit(call, token)
+        while not future.done():
+            if self._stop.is_set() or self.process_manager.queue_depth(port) > own:
+                token.cancel("preempted by a client call")
+                self.preempted += 1
+                self._idle_since = None
+                return future, True
+            time.sleep(self.PREEMPT_POLL)
+        return future, False
+    
+    def _warm(self, session: ProxySession, addr: int, source: str) -> str:
+        """Decompile one function into the cache, yielding to real calls.
+        
+        Returns:
+            "warmed", "failed" or "preempted"
+        """
+        port = session.process_port
+        generation = session.generation
+        arguments = self._arguments(addr)
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {"name": self.TOOL, "arguments": arguments},
+        }
+        future, preempted = self._preemptible(
+            port,
+            lambda token: self.process_manager.forward_request(
+                port, request, self.CALL_TIMEOUT, token, ida_session=session.ida_session_id,
+            ),
+        )
+        
+        def store(done: Future) -> None:
+            try:
+                response = done.result()
+            except Exception:
+                return
+            result = response.get("result")
+            if "error" in response or not isinstance(result, dict) or result.get("isError"):
+                return
+            # The generation check keeps a result that raced a database change out
+            if session.generation == generation:
+                self.result_cache.put(session.session_id, generation, self.TOOL, arguments, result)
+                with self._lock:
+                    self._speculative[(session.session_id, generation, arguments["addr"])] = source
+                    while len(self._speculative) > self.result_cache.max_entries:
+                        _, evicted = self._speculative.popitem(last=False)
+                        self.wasted[evicted] += 1
+        
+        if preempted:
+            # The child may finish the call anyway
+            future.add_done_callback(store)
+            return "preempted"
+        
+        try:
+            response = future.result()
+        except Exception as e:
+            logger.debug(f"Warming {hex(addr)} in {session.session_id} failed: {e}")
+            self.failures += 1
+            return "failed"
+        if "error" in response or (response.get("result") or {}).get("isError"):
+            self.failures += 1
+            return "failed"
+        store(future)
+        if source == "prefetch":
+            self.prefetched += 1
+        else:
+            self.warmed += 1
+        return "warmed"
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Summarize the warmer for JSON serialization."""
+        with self._lock:
+            remaining = max(len(self._plan) - self._position, 0)
+            prefetch_queued = sum(1 for item in self._prefetch if item[3] > 0)
+            return {
+                "warmed": self.warmed,
+                "preempted": self.preempted,
+                "already_cached": self.already_cached,
+                "failures": self.failures,
+                "remaining": remaining,
+                "warm_hits": self.hits["warm"],
+                "warm_wasted": self.wasted["warm"],
+                "prefetched": self.prefetched,
+                "prefetch_queued": prefetch_queued,
+                "prefetch_cancelled": self.prefetch_cancelled,
+                "prefetch_hits": self.hits["prefetch"],
+                "prefetch_wasted": self.wasted["prefetch"],
+            }
+    
+    def close(self) -> None:
+        """Stop warming, cancelling a warming call in flight."""
+        self._stop.set()
+        self._wake.set()
+        if self._thread is not threading.current_thread():
+            self._thread.join(timeout=5)
+        self._executor.shutdown(wait=False)
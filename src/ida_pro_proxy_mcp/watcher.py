@@ -0,0 +1,175 @@
+"""inotify-based watching of binaries and their databases"""
+
+import ctypes
+import ctypes.util
+import logging
+import os
+import select
+import struct
+import sys
+import threading
+from typing import Callable, Dict, Optional
+
+logger = logging.getLogger(__name__)
+
+# From <sys/inotify.h>
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_TO = 0x00000080
+IN_CREATE = 0x00000100
+IN_DELETE = 0x00000200
+IN_IGNORED = 0x00008000
+IN_NONBLOCK = 0o4000
+IN_CLOEXEC = 0o2000000
+
+# A file's content changed: written and closed, renamed over, created or removed
+WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE
+
+_EVENT = struct.Struct("iIII")  # wd, mask, cookie, len
+
+
+class FileWatcher:
+    """Calls back when watched files change, using inotify.
+    
+    Parent directories are watched rather than the files themselves, so
+    files replaced by rename are still followed. Events are read on a
+    background thread that blocks in select(); nothing is polled. On
+    platforms without inotify, watch() does nothing and available is False.
+    """
+    
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._callbacks: Dict[str, Callable[[str], None]] = {}  # path -> callback
+        self._dir_wds: Dict[str, int] = {}  # directory -> watch descriptor
+        self._wd_dirs: Dict[int, str] = {}  # watch descriptor -> directory
+        self._libc = None
+        self._fd = -1
+        self._wake_r, self._wake_w = -1, -1
+        self._thread: Optional[threading.Thread] = None
+        
+        if not sys.platform.startswith("linux"):
+            logger.info("File watching needs inotify (Linux); binaries won't be watched")
+            return
+        try:
+            libc = ctypes.CDLL(ctypes.util.find_library("c") or None, use_errno=True)
+            fd = libc.inotify_init1(IN_NONBLOCK | IN_CLOEXEC)
+        except (OSError, AttributeError) as e:
+            logger.warning(f"inotify unavailable, binaries won't be watched: {e}")
+            return
+        if fd < 0:
+            logger.warning(
+                f"inotify_init1 failed, binaries won't be watched: {os.strerror(ctypes.get_errno())}"
+            )
+            return
+        libc.inotify_add_watch.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+        libc.inotify_rm_watch.argtypes = [ctypes.c_int, ctypes.c_int]
+        self._libc = libc
+        self._fd = fd
+        self._wake_r, self._wake_w = os.pipe()
+        self._thread = threading.Thread(target=self._run, name="file-watcher", daemon=True)
+        self._thread.start()
+    
+    @property
+    def available(self) -> bool:
+        """Whether changes are actually being watched."""
+        return self._fd >= 0
+    
+    def watch(self, path: str, callback: Callable[[str], None]) -> None:
+        """Call callback(path) whenever the file at path changes.
+        
+        Replaces any callback already registered for path.
+        
+        Args:
+            path: Absolute path of the file to watch
+            callback: Called on the watcher thread with the changed path
+        """
+        if not self.available:
+            return
+        directory = os.path.dirname(path)
+        with self._lock:
+            self._callbacks[path] = callback
+            if directory in self._dir_wds:
+                return
+            wd = self._libc.inotify_add_watch(self._fd, os.fsencode(directory), WATCH_MASK)
+            if wd < 0:
+                self._callbacks.pop(path, None)
+                logger.warning(
+                    f"Cannot watch {directory}: {os.strerror(ctypes.get_errno())}"
+                )
+                return
+            self._dir_wds[directory] = wd
+            self._wd_dirs[wd] = directory
+    
+    def unwatch(self, path: str) -> None:
+        """Stop watching a file."""
+        if not self.available:
+            return
+        directory = os.path.dirname(path)
+        with self._lock:
+            if self._callbacks.pop(path, None) is None:
+                return
+            if any(os.path.dirname(p) == directory for p in self._callbacks):
+                return
+            wd = self._dir_wds.pop(directory, None)
+            if wd is not None:
+                self._wd_dirs.pop(wd, None)
+                self._libc.inotify_rm_watch(self._fd, wd)
+    
+    def close(self) -> None:
+        """Stop the watcher thread and release the inotify instance."""
+        if not self.available:
+            return
+        os.write(self._wake_w, b"x")
+        self._thread.join(timeout=5)
+        with self._lock:
+            os.close(self._fd)
+            os.close(self._wake_r)
+            os.close(self._wake_w)
+            self._fd = -1
+            self._callbacks.clear()
+            self._dir_wds.clear()
+            self._wd_dirs.clear()
+    
+    def _run(self) -> None:
+        while True:
+            readable, _, _ = select.select([self._fd, self._wake_r], [], [])
+            if self._wake_r in readable:
+                return
+            try:
+                data = os.read(self._fd, 64 * 1024)
+            except BlockingIOError:
+                continue
+            except OSError as e:
+                logger.warning(f"Stopped watching files: {e}")
+                return
+            for path in self._changed_paths(data):
+                with self._lock:
+                    callback = self._callbacks.get(path)
+                if callback is None:
+                    continue
+                try:
+                    callback(path)
+                except Exception as e:
+                    logger.warning(f"File change handler for {path} failed: {e}")
+    
+    def _changed_paths(self, data: bytes):
+        """Decode a buffer of inotify events into changed paths, in order."""
+        offset = 0
+        seen = set()
+        while offset + _EVENT.size <= len(data):
+            wd, mask, _, name_len = _EVENT.unpack_from(data, offset)
+            name = data[offset + _EVENT.size:offset + _EVENT.size + name_len].rstrip(b"\0")
+            offset += _EVENT.size + name_len
+            with self._lock:
+                directory = self._wd_dirs.get(wd)
+                if mask & IN_IGNORED and directory is not None:
+                    # The directory itself went away
+                    self._wd_dirs.pop(wd, None)
+                    self._dir_wds.pop(directory, None)
+                    continue
+            if directory is None or not name:
+                continue
+            path = os.path.join(directory, os.fsdecode(name))
+            # A burst of events for one file in one read is one change
+            if path not in seen:
+                seen.add(path)
+                yield path
@@ -1,7 +1,66 @@
 """Pytest configuration and shared fixtures"""
 
+import struct
 import sys
 from pathlib import Path
 
+import pytest
+
 # Add src to path for imports
 sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+
+@pytest.fixture
+def make_elf(tmp_path):
+    """Create a little-endian 64-bit ELF file.
+    
+    The code and rodata are loaded by one segment at vaddr. Imports are
+    undefined dynamic symbols and exports functions defined in .text.
+    """
+    def make(name, code, vaddr=0x400000, rodata=b"", imports=(), exports=(), needed=()):
+        body = code + rodata
+        dynstr = b"\0"
+        
+        def add_string(text):
+            nonlocal dynstr
+            offset = len(dynstr)
+            dynstr += text.encode() + b"\0"
+            return offset
+        
+        dynsym = b"\0" * 24
+        for symbol in imports:
+            dynsym += struct.pack("<IBBHQQ", add_string(symbol), 0x12, 0, 0, 0, 0)
+        for symbol, offset, size in exports:
+            dynsym += struct.pack("<IBBHQQ", add_string(symbol), 0x12, 0, 1, vaddr + offset, size)
+        dynamic = b"".join(struct.pack("<QQ", 1, add_string(lib)) for lib in needed)
+        dynamic += struct.pack("<QQ", 0, 0)
+        shstrtab = b"\0.text\0.rodata\0.dynstr\0.dynsym\0.dynamic\0.shstrtab\0"
+        
+        data = bytearray(0x1000) + body
+        offsets = []
+        for blob in (dynstr, dynsym, dynamic, shstrtab):
+            offsets.append(len(data))
+            data += blob
+        shoff = len(data)
+        sections = [
+            (0, 0, 0, 0, 0, 0, 0),
+            (1, 1, 6, vaddr, 0x1000, len(code), 0),
+            (7, 1, 2, vaddr + len(code), 0x1000 + len(code), len(rodata), 0),
+            (15, 3, 2, 0, offsets[0], len(dynstr), 0),
+            (23, 11, 2, 0, offsets[1], len(dynsym), 3),
+            (31, 6, 3, 0, offsets[2], len(dynamic), 3),
+            (40, 3, 0, 0, offsets[3], len(shstrtab), 0),
+        ]
+        for name_offset, sh_type, flags, addr, offset, size, link in sections:
+            entsize = 24 if sh_type == 11 else 16 if sh_type == 6 else 0
+            data += struct.pack("<IIQQQQIIQQ", name_offset, sh_type, flags, addr, offset, size, link, 0, 1, entsize)
+        
+        ident = b"\x7fELF\x02\x01\x01" + b"\0" * 9
+        data[:64] = struct.pack(
+            "<16sHHIQQQIHHHHHH", ident, 3, 62, 1, vaddr, 64, shoff, 0, 64, 56, 1, 64, len(sections), 6
+        )
+        data[64:120] = struct.pack("<IIQQQQQQ", 1, 5, 0x1000, vaddr, vaddr, len(body), len(body), 0x1000)
+        path = tmp_path / name
+        path.write_bytes(bytes(data))
+        return path
+    return make
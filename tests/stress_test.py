@@ -82,8 +82,13 @@ class MCPClient:
             conn.close()
     
     def call_tool(self, name: str, arguments: Dict[str, Any], timeout: int = 120) -> Dict[str, Any]:
-        """Convenience method to call a tool."""
-        return self.send_request("tools/call", {"name": name, "arguments": arguments}, timeout=timeout)
+        """Convenience method to call a tool.
+        
+        The timeout is also sent as the call's deadline so the proxy can drop
+        the call instead of running it after we stopped waiting.
+        """
+        params = {"name": name, "arguments": arguments, "_meta": {"timeout": timeout}}
+        return self.send_request("tools/call", params, timeout=timeout)
     
     def parse_tool_result(self, response: Dict[str, Any]) -> Dict[str, Any]:
         """Parse tool result from MCP response."""
@@ -0,0 +1,32 @@
+"""Tests for the in-process API"""
+
+import pytest
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.api import LocalProxy, ToolError
+
+
+class TestLocalProxy:
+    """Tests for the in-process API"""
+    
+    def test_unwrap_prefers_structured_content(self):
+        """Structured results are returned as is"""
+        response = {"result": {"content": [], "structuredContent": {"count": 1}}}
+        
+        assert LocalProxy.unwrap(response) == {"count": 1}
+    
+    def test_unwrap_parses_text_content(self):
+        """Text results are parsed as JSON when possible"""
+        response = {"result": {"content": [{"type": "text", "text": "[1, 2]"}]}}
+        
+        assert LocalProxy.unwrap(response) == [1, 2]
+    
+    def test_unwrap_raises_tool_errors(self):
+        """Error results raise ToolError"""
+        response = {"result": {"content": [{"type": "text", "text": "no such address"}], "isError": True}}
+        
+        with pytest.raises(ToolError, match="no such address"):
+            LocalProxy.unwrap(response)
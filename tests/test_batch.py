@@ -0,0 +1,165 @@
+"""Tests for the offline batch runner"""
+
+import json
+import pytest
+from pathlib import Path
+from unittest.mock import Mock, MagicMock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.api import LocalProxy, ToolError
+from ida_pro_proxy_mcp.batch import BatchJob, BatchRunner, load_checkpoint, read_jobs
+from ida_pro_proxy_mcp.models import ProxyConfig
+from ida_pro_proxy_mcp.process_manager import ProcessManager
+from ida_pro_proxy_mcp.session_manager import SessionManager
+
+
+@pytest.fixture
+def proxy():
+    """Create a LocalProxy-like object over a mocked process pool"""
+    process_manager = Mock(spec=ProcessManager)
+    process_manager.process_count = 0
+    process_manager.active_ports = []
+    process_manager.is_draining.return_value = False
+    
+    def start_process_side_effect(*args, **kwargs):
+        process_manager.process_count += 1
+        mock_info = MagicMock()
+        mock_info.port = 8744 + process_manager.process_count
+        process_manager.active_ports.append(mock_info.port)
+        return mock_info
+    
+    process_manager.start_process.side_effect = start_process_side_effect
+    process_manager.forward_request.return_value = {
+        "jsonrpc": "2.0",
+        "id": 1,
+        "result": {"success": True, "session": {"session_id": "abc12"}},
+    }
+    proxy = Mock(spec=LocalProxy)
+    proxy.config = ProxyConfig(max_processes=2)
+    proxy.session_manager = SessionManager(max_processes=2, process_manager=process_manager)
+    proxy.call.return_value = {"functions": []}
+    return proxy
+
+
+@pytest.fixture
+def binaries(tmp_path):
+    """Create a few distinct binaries"""
+    paths = []
+    for i in range(3):
+        path = tmp_path / f"bin{i}.elf"
+        path.write_bytes(b"\x7fELF" + bytes([i]))
+        paths.append(str(path))
+    return paths
+
+
+def write_jobs(path, jobs):
+    path.write_text("".join(json.dumps(job) + "\n" for job in jobs))
+    return str(path)
+
+
+def read_results(path):
+    return [json.loads(line) for line in Path(path).read_text().splitlines()]
+
+
+class TestReadJobs:
+    """Tests for parsing jobs files"""
+    
+    def test_ids_default_to_line_numbers(self, tmp_path, binaries):
+        """Jobs without an id are identified by their line number"""
+        path = write_jobs(tmp_path / "jobs.jsonl", [
+            {"binary": binaries[0], "tool": "imports"},
+            {"binary": binaries[1], "tool": "decompile", "arguments": {"addr": "0x10"}, "id": "d1"},
+        ])
+        
+        jobs = read_jobs(path)
+        
+        assert [job.job_id for job in jobs] == ["1", "d1"]
+        assert jobs[1].arguments == {"addr": "0x10"}
+    
+    def test_invalid_job_names_line(self, tmp_path):
+        """A job without a tool is rejected with its line number"""
+        path = write_jobs(tmp_path / "jobs.jsonl", [{"binary": "/bin/true"}])
+        
+        with pytest.raises(ValueError, match=":1:"):
+            read_jobs(path)
+
+
+class TestCheckpoint:
+    """Tests for resuming from a results file"""
+    
+    def test_recorded_jobs_skipped_and_partial_line_dropped(self, tmp_path):
+        """Recorded jobs are done; a torn last line is truncated"""
+        path = tmp_path / "results.jsonl"
+        path.write_text('{"id": "1", "result": {}}\n{"id": "2", "error": "x"}\n{"id": "3", "res')
+        
+        assert load_checkpoint(str(path)) == {"1", "2"}
+        assert path.read_text().endswith('"x"}\n')
+    
+    def test_failed_jobs_retried_on_request(self, tmp_path):
+        """With retry_failed, jobs recorded as errors run again"""
+        path = tmp_path / "results.jsonl"
+        path.write_text('{"id": "1", "result": {}}\n{"id": "2", "error": "x"}\n')
+        
+        assert load_checkpoint(str(path), retry_failed=True) == {"1"}
+    
+    def test_missing_file_means_nothing_done(self, tmp_path):
+        """Without a results file every job runs"""
+        assert load_checkpoint(str(tmp_path / "missing.jsonl")) == set()
+
+
+class TestBatchRunner:
+    """Tests for running batches"""
+    
+    def test_every_job_recorded(self, proxy, binaries, tmp_path):
+        """Each job's result is appended to the results file"""
+        jobs = [BatchJob(str(i), binary, "imports") for i, binary in enumerate(binaries)]
+        results_path = str(tmp_path / "results.jsonl")
+        
+        summary = BatchRunner(proxy).run(jobs, results_path)
+        
+        assert summary.succeeded == 3 and summary.failed == 0
+        assert sorted(r["id"] for r in read_results(results_path)) == ["0", "1", "2"]
+        assert proxy.session_manager.session_count == 0
+    
+    def test_jobs_of_one_binary_share_an_open(self, proxy, binaries, tmp_path):
+        """A binary is opened once for all of its jobs"""
+        jobs = [BatchJob(str(i), binaries[0], "decompile", {"addr": hex(i)}) for i in range(4)]
+        process_manager = proxy.session_manager.process_manager
+        
+        BatchRunner(proxy).run(jobs, str(tmp_path / "results.jsonl"))
+        
+        opens = [
+            c for c in process_manager.forward_request.call_args_list
+            if c.args[1]["params"]["name"] == "idalib_open"
+        ]
+        assert len(opens) == 1
+        assert proxy.call.call_count == 4
+    
+    def test_resume_skips_recorded_jobs(self, proxy, binaries, tmp_path):
+        """A rerun only runs jobs missing from the results file"""
+        jobs = [BatchJob(str(i), binary, "imports") for i, binary in enumerate(binaries)]
+        results_path = tmp_path / "results.jsonl"
+        results_path.write_text('{"id": "0", "result": {}}\n')
+        
+        summary = BatchRunner(proxy).run(jobs, str(results_path))
+        
+        assert summary.skipped == 1 and summary.succeeded == 2
+        assert proxy.call.call_count == 2
+    
+    def test_failures_recorded(self, proxy, binaries, tmp_path):
+        """Tool errors and missing binaries are recorded as errors"""
+        proxy.call.side_effect = ToolError("bad address")
+        jobs = [
+            BatchJob("ok", binaries[0], "decompile"),
+            BatchJob("missing", str(tmp_path / "missing.elf"), "imports"),
+        ]
+        results_path = str(tmp_path / "results.jsonl")
+        
+        summary = BatchRunner(proxy).run(jobs, results_path)
+        
+        records = {r["id"]: r for r in read_results(results_path)}
+        assert summary.failed == 2
+        assert records["ok"]["error"] == "bad address"
+        assert "not found" in records["missing"]["error"]
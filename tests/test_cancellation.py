@@ -0,0 +1,104 @@
+"""Tests for cancellation tokens and client disconnect detection"""
+
+import socket
+import time
+from pathlib import Path
+from unittest.mock import Mock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.cancellation import CancelToken, Deadline, DisconnectWatcher
+
+
+class TestCancelToken:
+    """Tests for CancelToken"""
+    
+    def test_cancel_runs_callbacks_once(self):
+        """Callbacks run on cancel, and only once"""
+        token = CancelToken()
+        callback = Mock()
+        token.add_callback(callback)
+        
+        token.cancel("client disconnected")
+        token.cancel("again")
+        
+        callback.assert_called_once()
+        assert token.cancelled is True
+        assert token.reason == "client disconnected"
+    
+    def test_removed_callback_not_run(self):
+        """Removed callbacks are not run"""
+        token = CancelToken()
+        callback = Mock()
+        token.add_callback(callback)
+        token.remove_callback(callback)
+        
+        token.cancel()
+        
+        callback.assert_not_called()
+    
+    def test_callback_added_after_cancel_runs_immediately(self):
+        """A callback registered on a cancelled token runs right away"""
+        token = CancelToken()
+        token.cancel()
+        callback = Mock()
+        
+        token.add_callback(callback)
+        
+        callback.assert_called_once()
+
+
+class TestDisconnectWatcher:
+    """Tests for DisconnectWatcher"""
+    
+    def test_peer_close_cancels_token(self):
+        """Closing the client side cancels the token"""
+        server_sock, client_sock = socket.socketpair()
+        token = CancelToken()
+        
+        with DisconnectWatcher(server_sock, token):
+            client_sock.close()
+            deadline = time.monotonic() + 5
+            while not token.cancelled and time.monotonic() < deadline:
+                time.sleep(0.05)
+        
+        server_sock.close()
+        assert token.cancelled is True
+        assert token.reason == "client disconnected"
+    
+    def test_open_connection_not_cancelled(self):
+        """A client that stays connected does not cancel the token"""
+        server_sock, client_sock = socket.socketpair()
+        token = CancelToken()
+        
+        with DisconnectWatcher(server_sock, token):
+            time.sleep(0.2)
+        
+        client_sock.close()
+        time.sleep(DisconnectWatcher.POLL_INTERVAL + 0.2)
+        server_sock.close()
+        assert token.cancelled is False
+
+
+class TestDeadline:
+    """Tests for Deadline parsing"""
+    
+    def test_from_relative_timeout(self):
+        """A relative timeout in _meta becomes a deadline"""
+        deadline = Deadline.from_meta({"timeout": 120})
+        
+        assert 119 < deadline.remaining() <= 120
+        assert deadline.expired() is False
+    
+    def test_from_absolute_deadline(self):
+        """An absolute Unix-time deadline is converted to remaining time"""
+        deadline = Deadline.from_meta({"deadline": time.time() - 1})
+        
+        assert deadline.expired() is True
+    
+    def test_missing_or_malformed(self):
+        """No deadline is parsed from missing or malformed _meta"""
+        assert Deadline.from_meta(None) is None
+        assert Deadline.from_meta({}) is None
+        assert Deadline.from_meta({"timeout": "soon"}) is None
@@ -0,0 +1,75 @@
+"""Tests for cgroup v2 isolation of child processes"""
+
+import os
+import pytest
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.cgroups import CgroupManager
+from ida_pro_proxy_mcp.memory import MIB
+
+
+@pytest.fixture
+def root(tmp_path):
+    """A delegated cgroup, faked with plain files"""
+    (tmp_path / "cgroup.controllers").write_text("cpuset cpu io memory pids\n")
+    return tmp_path
+
+
+class TestCgroupManager:
+    """Tests for placing children in cgroups and reading their usage"""
+    
+    def test_child_placed_with_class_settings(self, root):
+        """A child gets its own leaf with the weights and limits of its class"""
+        cgroups = CgroupManager(str(root), memory_max=1000 * MIB)
+        assert cgroups.available
+        assert (root / "cgroup.subtree_control").read_text() == "+cpu +memory +io"
+        
+        cgroups.attach(8745, os.getpid())
+        leaf = root / "idalib-8745"
+        assert leaf.is_dir()
+        assert (leaf / "cpu.weight").read_text() == "300"
+        assert (leaf / "io.weight").read_text() == "default 300"
+        assert (leaf / "memory.max").read_text() == str(1000 * MIB)
+        assert (leaf / "cgroup.procs").read_text().isdigit()
+        
+        cgroups.set_class(8745, "background")
+        assert (leaf / "cpu.weight").read_text() == "100"
+        assert (leaf / "memory.high").read_text() == str(500 * MIB)
+        assert cgroups.session_class(8745) == "background"
+    
+    def test_usage_read_from_cgroup_files(self, root):
+        """CPU, memory and IO usage come from the leaf's accounting files"""
+        cgroups = CgroupManager(str(root))
+        cgroups.attach(8745, os.getpid())
+        leaf = root / "idalib-8745"
+        (leaf / "cpu.stat").write_text("usage_usec 2500000\nuser_usec 2000000\n")
+        (leaf / "memory.current").write_text(str(300 * MIB))
+        (leaf / "memory.events").write_text("low 0\nhigh 4\nmax 0\noom 0\noom_kill 1\n")
+        (leaf / "io.stat").write_text("8:0 rbytes=1048576 wbytes=2097152 rios=10 wios=5\n")
+        
+        usage = cgroups.usage(8745)
+        
+        assert usage.to_dict() == {
+            "cpu_seconds": 2.5,
+            "memory_mb": 300.0,
+            "memory_peak_mb": None,
+            "io_read_mb": 1.0,
+            "io_write_mb": 2.0,
+            "memory_high_events": 4,
+            "oom_kills": 1,
+        }
+        assert cgroups.to_dict()["children"]["8745"]["session_class"] == "interactive"
+    
+    def test_degrades_without_delegation(self, tmp_path):
+        """Without a usable cgroup, isolation is off and every call is a no-op"""
+        cgroups = CgroupManager(str(tmp_path / "missing"))
+        
+        assert not cgroups.available
+        assert cgroups.reason
+        cgroups.attach(8745, os.getpid())
+        cgroups.set_class(8745, "background")
+        assert cgroups.usage(8745) is None
+        assert cgroups.to_dict()["children"] == {}
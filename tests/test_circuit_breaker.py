@@ -0,0 +1,95 @@
+"""Tests for CircuitBreaker"""
+
+from pathlib import Path
+from unittest.mock import patch
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.circuit_breaker import CircuitBreaker
+
+
+class TestCircuitBreaker:
+    """Tests for breaker state transitions"""
+    
+    def test_starts_closed(self):
+        """A new breaker admits requests"""
+        breaker = CircuitBreaker()
+        
+        assert breaker.state == CircuitBreaker.CLOSED
+        assert breaker.allow_request() is True
+    
+    def test_opens_after_consecutive_failures(self):
+        """Consecutive errors up to the threshold open the breaker"""
+        breaker = CircuitBreaker(failure_threshold=3, reset_timeout=30)
+        
+        breaker.record_failure()
+        breaker.record_failure()
+        assert breaker.state == CircuitBreaker.CLOSED
+        
+        breaker.record_failure()
+        assert breaker.state == CircuitBreaker.OPEN
+        assert breaker.allow_request() is False
+    
+    def test_success_resets_failure_count(self):
+        """A success in between resets the consecutive failure count"""
+        breaker = CircuitBreaker(failure_threshold=2)
+        
+        breaker.record_failure()
+        breaker.record_success()
+        breaker.record_failure()
+        
+        assert breaker.state == CircuitBreaker.CLOSED
+    
+    def test_timeout_opens_immediately(self):
+        """A single timeout opens the breaker"""
+        breaker = CircuitBreaker(failure_threshold=3)
+        
+        breaker.record_failure(timeout=True)
+        
+        assert breaker.state == CircuitBreaker.OPEN
+    
+    def test_timeout_threshold(self):
+        """Only timeout_threshold timeouts in a row open the breaker"""
+        breaker = CircuitBreaker(failure_threshold=5, timeout_threshold=2)
+        
+        breaker.record_failure(timeout=True)
+        breaker.record_failure()
+        breaker.record_failure(timeout=True)
+        assert breaker.state == CircuitBreaker.CLOSED
+        
+        breaker.record_failure(timeout=True)
+        assert breaker.state == CircuitBreaker.OPEN
+    
+    def test_half_open_admits_single_probe(self):
+        """After reset_timeout exactly one probe is admitted"""
+        breaker = CircuitBreaker(failure_threshold=1, reset_timeout=10)
+        
+        with patch('ida_pro_proxy_mcp.circuit_breaker.time.monotonic', return_value=100.0):
+            breaker.record_failure()
+        
+        with patch('ida_pro_proxy_mcp.circuit_breaker.time.monotonic', return_value=111.0):
+            assert breaker.allow_request() is True
+            assert breaker.state == CircuitBreaker.HALF_OPEN
+            assert breaker.is_probe() is True
+            assert breaker.allow_request() is False
+    
+    def test_successful_probe_closes(self):
+        """A successful probe closes the breaker"""
+        breaker = CircuitBreaker(failure_threshold=1, reset_timeout=0)
+        breaker.record_failure()
+        
+        assert breaker.allow_request() is True
+        breaker.record_success()
+        
+        assert breaker.state == CircuitBreaker.CLOSED
+        assert breaker.allow_request() is True
+    
+    def test_failed_probe_reports_wedged(self):
+        """A failed probe re-opens the breaker and reports the process wedged"""
+        breaker = CircuitBreaker(failure_threshold=1, reset_timeout=0)
+        
+        assert breaker.record_failure() is False
+        assert breaker.allow_request() is True
+        assert breaker.record_failure(timeout=True) is True
+        assert breaker.state == CircuitBreaker.OPEN
@@ -0,0 +1,65 @@
+"""Tests for the minimal ELF reader"""
+
+import pytest
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.elf_reader import ElfFile
+
+
+class TestElfFile:
+    """Tests for reading ELF headers"""
+    
+    def test_segments_read(self, make_elf):
+        """The header and loadable segments are parsed"""
+        elf = ElfFile(str(make_elf("a.elf", b"\x90" * 64)))
+        
+        assert elf.bits == 64
+        assert elf.little_endian is True
+        assert elf.machine == 62
+        assert [(s.vaddr, s.offset, s.filesz) for s in elf.segments] == [(0x400000, 0x1000, 64)]
+    
+    def test_offset_of(self, make_elf):
+        """Addresses map to file offsets only where backed by file bytes"""
+        elf = ElfFile(str(make_elf("a.elf", b"\x90" * 64)))
+        
+        assert elf.offset_of(0x400010, 16) == 0x1010
+        assert elf.offset_of(0x400038, 16) is None
+        assert elf.offset_of(0x3fffff) is None
+    
+    def test_not_elf_rejected(self, tmp_path):
+        """Files without the ELF magic are rejected"""
+        path = tmp_path / "a.exe"
+        path.write_bytes(b"MZ" + b"\0" * 100)
+        
+        assert ElfFile.is_elf(str(path)) is False
+        with pytest.raises(ValueError):
+            ElfFile(str(path))
+    
+    def test_sections_and_dynamic(self, make_elf):
+        """Sections, needed libraries and symbols are read"""
+        path = make_elf(
+            "lib.so", b"\x90" * 32,
+            imports=["gets"], exports=[("get_username", 0, 32)], needed=["libc.so.6"],
+        )
+        elf = ElfFile(str(path))
+        
+        assert [s.name for s in elf.sections][1:3] == [".text", ".rodata"]
+        assert elf.needed == ["libc.so.6"]
+        assert [s.name for s in elf.imports()] == ["gets"]
+        exported = [s for s in elf.symbols() if s.defined]
+        assert [(s.name, s.value, s.size) for s in exported] == [("get_username", 0x400000, 32)]
+    
+    def test_strings(self, make_elf):
+        """Printable runs are found in the file or one section"""
+        path = make_elf("a.elf", b"\x90" * 16, rodata=b"\0user: %s\0ab\0password\0")
+        elf = ElfFile(str(path))
+        
+        rodata = [text for _, text in elf.strings(section=".rodata")]
+        
+        assert rodata == ["user: %s", "password"]
+        assert "password" in [text for _, text in elf.strings()]
+        with pytest.raises(ValueError):
+            elf.strings(section=".data")
@@ -0,0 +1,85 @@
+"""Tests for the ELF metadata tools"""
+
+import pytest
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.elf_tools import ElfTools
+
+
+@pytest.fixture
+def library(make_elf):
+    """Create a shared library with imports, exports and strings"""
+    return make_elf(
+        "libfoo.so", b"\x90" * 64,
+        rodata=b"\0usage: foo\0error: %s\0",
+        imports=["gets", "strcpy"],
+        exports=[("foo_init", 0, 16), ("foo_read", 16, 48)],
+        needed=["libc.so.6"],
+    )
+
+
+class TestElfTools:
+    """Tests for answering ELF queries"""
+    
+    def test_info(self, library):
+        """Headers and dynamic information are summarized"""
+        info = ElfTools().info(str(library))
+        
+        assert info["class"] == "ELF64"
+        assert info["machine"] == "x86-64"
+        assert info["type"] == "DYN"
+        assert info["needed"] == ["libc.so.6"]
+        assert ".rodata" in [s["name"] for s in info["sections"]]
+    
+    def test_symbols_filtered_and_paged(self, library):
+        """Symbols can be filtered by glob and paged"""
+        tools = ElfTools()
+        
+        first = tools.symbols(str(library), filter="foo_*", count=1)
+        second = tools.symbols(str(library), filter="foo_*", offset=first["next_offset"])
+        
+        assert first["total"] == 2
+        assert [s["name"] for s in first["symbols"] + second["symbols"]] == ["foo_init", "foo_read"]
+        assert second["next_offset"] is None
+        assert tools.symbols(str(library), defined_only=True)["total"] == 2
+    
+    def test_imports(self, library):
+        """Imports list the undefined dynamic symbols"""
+        imports = ElfTools().imports(str(library))
+        
+        assert [i["name"] for i in imports["imports"]] == ["gets", "strcpy"]
+        assert imports["needed"] == ["libc.so.6"]
+    
+    def test_strings_have_addresses(self, library):
+        """Strings in loaded sections report their load address"""
+        result = ElfTools().strings(str(library), section=".rodata", contains="error")
+        
+        # .rodata follows 64 bytes of code; "error: %s" is 12 bytes into it
+        assert result["strings"] == [
+            {"offset": 0x1000 + 64 + 12, "addr": hex(0x400000 + 64 + 12), "string": "error: %s"}
+        ]
+    
+    def test_parsed_once_per_content(self, library, tmp_path):
+        """Copies of a file share one parse; a changed file is parsed again"""
+        tools = ElfTools()
+        copy = tmp_path / "copy.so"
+        copy.write_bytes(library.read_bytes())
+        
+        tools.info(str(library))
+        tools.info(str(copy))
+        assert (tools.hits, tools.misses) == (1, 1)
+        
+        copy.write_bytes(library.read_bytes() + b"\0")
+        tools.info(str(copy))
+        assert tools.misses == 2
+    
+    def test_not_elf(self, tmp_path):
+        """Files that are not ELF are rejected"""
+        path = tmp_path / "a.bin"
+        path.write_bytes(b"\0" * 64)
+        
+        with pytest.raises(ValueError):
+            ElfTools().info(str(path))
@@ -0,0 +1,163 @@
+"""Tests for fanning a tool call out over many binaries"""
+
+import pytest
+import threading
+import time
+from pathlib import Path
+from unittest.mock import Mock, MagicMock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.cancellation import CancelToken
+from ida_pro_proxy_mcp.fanout import MapRun, expand_inputs
+from ida_pro_proxy_mcp.process_manager import ProcessManager
+from ida_pro_proxy_mcp.session_manager import SessionManager
+
+
+OK = {"jsonrpc": "2.0", "id": 1, "result": {"content": [{"type": "text", "text": "[]"}]}}
+
+
+@pytest.fixture
+def mock_process_manager():
+    """Create a mock ProcessManager whose processes stay around for reuse"""
+    manager = Mock(spec=ProcessManager)
+    manager.process_count = 0
+    manager.active_ports = []
+    manager.is_draining.return_value = False
+    
+    def start_process_side_effect(*args, **kwargs):
+        manager.process_count += 1
+        mock_info = MagicMock()
+        mock_info.port = 8744 + manager.process_count
+        manager.active_ports.append(mock_info.port)
+        return mock_info
+    
+    manager.start_process.side_effect = start_process_side_effect
+    manager.forward_request.return_value = {
+        "jsonrpc": "2.0",
+        "id": 1,
+        "result": {"success": True, "session": {"session_id": "abc12"}},
+    }
+    return manager
+
+
+@pytest.fixture
+def corpus(tmp_path):
+    """Create a directory of distinct binaries"""
+    paths = []
+    for i in range(5):
+        path = tmp_path / f"bin{i}.elf"
+        path.write_bytes(b"\x7fELF" + bytes([i]))
+        paths.append(str(path))
+    return paths
+
+
+class TestExpandInputs:
+    """Tests for expanding paths and globs"""
+    
+    def test_glob_expanded_and_deduplicated(self, corpus, tmp_path):
+        """Globs expand to sorted files, each listed once"""
+        paths = expand_inputs([str(tmp_path / "*.elf"), corpus[0]])
+        
+        assert paths == sorted(corpus)
+    
+    def test_directories_skipped_and_missing_kept(self, tmp_path):
+        """Directories matched by a glob are skipped; literal paths are kept"""
+        (tmp_path / "sub.elf").mkdir()
+        missing = str(tmp_path / "missing.elf")
+        
+        assert expand_inputs([str(tmp_path / "*.elf"), missing]) == [missing]
+
+
+class TestMapRun:
+    """Tests for running a tool over a corpus"""
+    
+    def test_results_in_input_order(self, mock_process_manager, corpus):
+        """Every binary gets a result, returned in input order"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        streamed = []
+        run = MapRun(manager, lambda session_id, args: OK, {}, parallelism=2)
+        
+        results = run.run(corpus, streamed.append)
+        
+        assert [r["binary"] for r in results] == corpus
+        assert all(r["result"] == OK["result"] for r in results)
+        assert sorted(r["binary"] for r in streamed) == sorted(corpus)
+    
+    def test_opened_sessions_closed(self, mock_process_manager, corpus):
+        """Sessions opened for the run are closed; the current session is kept"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        current = manager.open_session(corpus[0])
+        run = MapRun(manager, lambda session_id, args: OK, {}, parallelism=2)
+        
+        run.run(corpus)
+        
+        assert manager.session_count == 1
+        assert manager.get_current_session() is current
+        assert mock_process_manager.process_count <= 2
+    
+    def test_parallelism_bounded(self, mock_process_manager, corpus):
+        """No more than parallelism binaries are worked on at once"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        lock = threading.Lock()
+        running = [0]
+        peak = [0]
+        
+        def call_tool(session_id, args):
+            with lock:
+                running[0] += 1
+                peak[0] = max(peak[0], running[0])
+            time.sleep(0.05)
+            with lock:
+                running[0] -= 1
+            return OK
+        
+        MapRun(manager, call_tool, {}, parallelism=2).run(corpus)
+        
+        assert peak[0] == 2
+    
+    def test_same_content_opened_once(self, mock_process_manager, tmp_path):
+        """Copies of one binary share a single open and call"""
+        paths = []
+        for name in ("a.elf", "b.elf"):
+            path = tmp_path / name
+            path.write_bytes(b"\x7fELF")
+            paths.append(str(path))
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        call_tool = Mock(return_value=OK)
+        
+        results = MapRun(manager, call_tool, {}, parallelism=2).run(paths)
+        
+        assert call_tool.call_count == 1
+        assert results[1]["same_content_as"] == paths[0]
+        assert results[1]["result"] == OK["result"]
+    
+    def test_tool_error_reported_per_binary(self, mock_process_manager, corpus):
+        """A failing call is reported for its binary without stopping the run"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        failure = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "result": {"content": [], "structuredContent": {"error": "bad address"}, "isError": True},
+        }
+        
+        def call_tool(session_id, args):
+            return failure if manager.get_session(session_id).binary_path == corpus[1] else OK
+        
+        results = MapRun(manager, call_tool, {}, parallelism=2).run(corpus)
+        
+        assert results[1]["error"] == "bad address"
+        assert all("result" in r for i, r in enumerate(results) if i != 1)
+    
+    def test_cancelled_run_skips_remaining(self, mock_process_manager, corpus):
+        """After cancellation, binaries not yet started are skipped"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        token = CancelToken()
+        token.cancel("client went away")
+        call_tool = Mock(return_value=OK)
+        
+        results = MapRun(manager, call_tool, {}, parallelism=2, cancel_token=token).run(corpus)
+        
+        call_tool.assert_not_called()
+        assert all("Cancelled" in r["error"] for r in results)
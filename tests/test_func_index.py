@@ -0,0 +1,178 @@
+"""Tests for the cross-binary function index"""
+
+import json
+import pytest
+import time
+from pathlib import Path
+from unittest.mock import Mock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.func_index import FunctionIndex, SymbolTable
+from ida_pro_proxy_mcp.models import ProxySession
+from ida_pro_proxy_mcp.process_manager import ProcessManager
+
+
+def _response(data):
+    return {
+        "jsonrpc": "2.0",
+        "id": 1,
+        "result": {"content": [{"type": "text", "text": json.dumps(data)}]},
+    }
+
+
+def _wait_for(condition, timeout=5.0):
+    deadline = time.monotonic() + timeout
+    while not condition():
+        assert time.monotonic() < deadline, "Timed out waiting for the index"
+        time.sleep(0.01)
+
+
+@pytest.fixture
+def symbols():
+    """Symbols each mock process reports, by tool"""
+    return {
+        "list_funcs": [
+            {"addr": "0x1000", "name": "main", "size": "0x40"},
+            {"addr": "0x1040", "name": "crypt_init", "size": "0x20"},
+            {"addr": "0x1060", "name": "crypt_update", "size": "0x80"},
+        ],
+        "imports": [{"addr": "0x3000", "imported_name": "memcpy", "module": "libc.so.6"}],
+        "entrypoints": [{"addr": "0x1000", "name": "_start"}],
+    }
+
+
+@pytest.fixture
+def mock_process_manager(symbols):
+    """Create a mock ProcessManager answering the index's paginated calls"""
+    manager = Mock(spec=ProcessManager)
+    
+    def forward_request(port, request, timeout=None, ida_session=None):
+        params = request["params"]
+        items = symbols[params["name"]]
+        if params["name"] == "entrypoints":
+            return _response(items)
+        query = params["arguments"].get("queries", params["arguments"])
+        offset, count = query["offset"], query["count"]
+        page = items[offset:offset + count]
+        next_offset = offset + count if offset + count < len(items) else None
+        return _response([{"data": page, "next_offset": next_offset}])
+    
+    manager.forward_request.side_effect = forward_request
+    return manager
+
+
+@pytest.fixture
+def index(mock_process_manager):
+    """Create an index that pages two symbols at a time and refreshes quickly"""
+    index = FunctionIndex(mock_process_manager)
+    index.PAGE_SIZE = 2
+    index.REFRESH_DELAY = 0.05
+    yield index
+    index.close()
+
+
+def _session(session_id="s1", content_hash="hash1"):
+    session = ProxySession.create("/bin/" + session_id, 8745, "ida-" + session_id)
+    session.session_id = session_id
+    session.content_hash = content_hash
+    return session
+
+
+class TestSymbolTable:
+    """Tests for name lookups in one table"""
+    
+    @pytest.fixture
+    def table(self):
+        return SymbolTable([
+            ("crypt_update", 0x1060, 0x80, ""),
+            ("main", 0x1000, 0x40, ""),
+            ("crypt_init", 0x1040, 0x20, ""),
+            ("crypt_init", 0x2040, 0x20, ""),
+        ])
+    
+    def test_exact(self, table):
+        """Exact lookups find every symbol of that name"""
+        assert [table.addrs[i] for i in table.exact("crypt_init")] == [0x1040, 0x2040]
+        assert len(table.exact("crypt")) == 0
+    
+    def test_prefix(self, table):
+        """Prefix lookups find the names starting with the prefix"""
+        assert [table.names[i] for i in table.prefix("crypt_")] == [
+            "crypt_init", "crypt_init", "crypt_update"
+        ]
+    
+    def test_glob(self, table):
+        """Glob lookups match the whole name"""
+        assert [table.names[i] for i in table.glob("*_up*")] == ["crypt_update"]
+        assert [table.names[i] for i in table.glob("m?in")] == ["main"]
+
+
+class TestFunctionIndex:
+    """Tests for indexing sessions and looking symbols up"""
+    
+    def test_session_indexed_across_pages(self, index):
+        """An opened session's functions, imports and exports are indexed"""
+        index.session_opened(_session())
+        _wait_for(lambda: not index.lookup(prefix="")["pending"])
+        
+        result = index.lookup(pattern="crypt_*")
+        
+        assert [m["name"] for m in result["matches"]] == ["crypt_init", "crypt_update"]
+        assert result["matches"][1]["addr"] == "0x1060"
+        assert result["matches"][1]["size"] == 0x80
+        memcpy = index.lookup(name="memcpy")["matches"][0]
+        assert memcpy["kind"] == "import"
+        assert memcpy["module"] == "libc.so.6"
+        assert index.lookup(name="_start", kinds=["export"])["count"] == 1
+    
+    def test_closed_session_kept(self, index):
+        """A closed session's symbols stay searchable unless excluded"""
+        session = _session()
+        index.session_opened(session)
+        _wait_for(lambda: not index.lookup(prefix="")["pending"])
+        
+        index.session_closed(session)
+        
+        match = index.lookup(name="main")["matches"][0]
+        assert match["session_id"] is None
+        assert index.lookup(name="main", include_closed=False)["count"] == 0
+    
+    def test_change_refreshes(self, index, symbols):
+        """After a session changes, its index is rebuilt"""
+        session = _session()
+        index.session_opened(session)
+        _wait_for(lambda: not index.lookup(prefix="")["pending"])
+        
+        symbols["list_funcs"][0]["name"] = "entry"
+        session.generation += 1
+        index.session_changed(session)
+        
+        _wait_for(lambda: index.lookup(name="entry")["count"] == 1)
+        assert index.lookup(name="main")["count"] == 0
+    
+    def test_limit_truncates(self, index):
+        """No more than limit matches are returned"""
+        index.session_opened(_session())
+        _wait_for(lambda: not index.lookup(prefix="")["pending"])
+        
+        result = index.lookup(prefix="", limit=2)
+        
+        assert result["count"] == 2
+        assert result["truncated"] is True
+    
+    def test_failed_index_reported(self, index, mock_process_manager):
+        """A session that cannot be indexed is reported in the stats"""
+        mock_process_manager.forward_request.side_effect = RuntimeError("process gone")
+        index.session_opened(_session())
+        
+        _wait_for(lambda: index.to_dict()["errors"])
+        assert "process gone" in index.to_dict()["errors"]["s1"]
+    
+    def test_query_required(self, index):
+        """A lookup needs a name, prefix or pattern"""
+        with pytest.raises(ValueError):
+            index.lookup()
+        with pytest.raises(ValueError):
+            index.lookup(name="main", kinds=["section"])
@@ -0,0 +1,174 @@
+"""Tests for listening-socket and child handoff between proxy instances"""
+
+import os
+import socket
+import threading
+from pathlib import Path
+from unittest.mock import MagicMock, Mock
+
+import pytest
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.handoff import (
+    TAKEOVER_REQUEST,
+    HandoffError,
+    HandoffListener,
+    confirm_takeover,
+    request_takeover,
+)
+from ida_pro_proxy_mcp.process_manager import ProcessManager
+from ida_pro_proxy_mcp.session_manager import SessionManager
+
+
+@pytest.fixture
+def listen_socket():
+    """Create a listening TCP socket standing in for the HTTP server's"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.bind(("127.0.0.1", 0))
+    sock.listen(8)
+    yield sock
+    sock.close()
+
+
+@pytest.fixture
+def session_manager():
+    """Create a SessionManager whose children open every binary"""
+    process_manager = Mock(spec=ProcessManager)
+    process_manager.process_count = 0
+    process_manager.active_ports = []
+    process_manager.export_processes.return_value = []
+    
+    def start_process(*args, **kwargs):
+        process_manager.process_count += 1
+        info = MagicMock()
+        info.port = 8744 + process_manager.process_count
+        return info
+    
+    process_manager.start_process.side_effect = start_process
+    process_manager.forward_request.return_value = {
+        "jsonrpc": "2.0", "id": 1, "result": {"success": True, "session": {"session_id": "abc12"}},
+    }
+    return SessionManager(max_processes=2, process_manager=process_manager)
+
+
+class TestHandoff:
+    """Tests for HandoffListener and the successor side"""
+    
+    def _listener(self, tmp_path, listen_socket, state):
+        completed = threading.Event()
+        listener = HandoffListener(
+            str(tmp_path / "handoff.sock"), listen_socket, lambda: state, completed.set
+        )
+        listener.start()
+        return listener, completed
+    
+    def test_successor_receives_socket_and_state(self, tmp_path, listen_socket):
+        """The successor gets the same listening socket and the session table"""
+        state = {"sessions": [{"session_id": "a.elf-1"}], "processes": []}
+        listener, completed = self._listener(tmp_path, listen_socket, state)
+        
+        inherited, received, control = request_takeover(listener.path, timeout=5)
+        try:
+            assert received == state
+            assert inherited.getsockname() == listen_socket.getsockname()
+            assert not completed.is_set()
+            
+            # Connections are accepted on the inherited socket
+            client = socket.create_connection(listen_socket.getsockname(), timeout=5)
+            conn, _ = inherited.accept()
+            conn.close()
+            client.close()
+            
+            confirm_takeover(control)
+            assert completed.wait(timeout=5)
+            assert not os.path.exists(listener.path)
+        finally:
+            inherited.close()
+    
+    def test_failed_successor_leaves_instance_serving(self, tmp_path, listen_socket):
+        """A successor that goes away before confirming changes nothing"""
+        listener, completed = self._listener(tmp_path, listen_socket, {"sessions": []})
+        try:
+            inherited, _, control = request_takeover(listener.path, timeout=5)
+            inherited.close()
+            control.close()
+            
+            # The listener accepts another takeover attempt
+            retry = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            retry.settimeout(5)
+            retry.connect(listener.path)
+            retry.sendall(TAKEOVER_REQUEST)
+            assert retry.recv(8)
+            retry.close()
+            assert not completed.is_set()
+        finally:
+            listener.close()
+    
+    def _frozen_listener(self, tmp_path, listen_socket, manager):
+        listener = HandoffListener(
+            str(tmp_path / "handoff.sock"), listen_socket, manager.freeze,
+            lambda: manager.thaw(handed_over=True), manager.thaw,
+        )
+        listener.start()
+        return listener
+    
+    def _open_in_background(self, manager, path):
+        outcome = []
+        
+        def run():
+            try:
+                outcome.append(manager.open_session(str(path)))
+            except RuntimeError as e:
+                outcome.append(e)
+        thread = threading.Thread(target=run, daemon=True)
+        thread.start()
+        return thread, outcome
+    
+    def test_open_during_handoff_left_to_successor(self, tmp_path, listen_socket, session_manager):
+        """An open arriving between the export and the confirmation fails rather than go missing"""
+        binary = tmp_path / "a.elf"
+        binary.write_bytes(b"\x7fELF")
+        self._frozen_listener(tmp_path, listen_socket, session_manager)
+        
+        inherited, state, control = request_takeover(str(tmp_path / "handoff.sock"), timeout=5)
+        try:
+            opener, outcome = self._open_in_background(session_manager, binary)
+            opener.join(0.2)
+            assert opener.is_alive()
+            
+            confirm_takeover(control)
+            opener.join(5)
+        finally:
+            inherited.close()
+        
+        assert state["sessions"] == []
+        assert session_manager.session_count == 0
+        assert isinstance(outcome[0], RuntimeError)
+        assert "handed over" in str(outcome[0])
+    
+    def test_open_resumes_after_failed_handoff(self, tmp_path, listen_socket, session_manager):
+        """An open held back by a handoff goes ahead once the successor gives up"""
+        binary = tmp_path / "a.elf"
+        binary.write_bytes(b"\x7fELF")
+        listener = self._frozen_listener(tmp_path, listen_socket, session_manager)
+        try:
+            inherited, _, control = request_takeover(listener.path, timeout=5)
+            opener, outcome = self._open_in_background(session_manager, binary)
+            opener.join(0.2)
+            assert opener.is_alive()
+            
+            inherited.close()
+            control.close()
+            opener.join(5)
+        finally:
+            listener.close()
+        
+        assert session_manager.session_count == 1
+        assert outcome[0].session_id == session_manager.list_sessions()[0]["session_id"]
+    
+    def test_takeover_without_running_instance(self, tmp_path):
+        """Taking over with nobody listening fails cleanly"""
+        with pytest.raises(HandoffError):
+            request_takeover(str(tmp_path / "missing.sock"), timeout=1)
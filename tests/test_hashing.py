@@ -0,0 +1,67 @@
+"""Tests for content hashing of binaries"""
+
+import hashlib
+import os
+from pathlib import Path
+from unittest.mock import patch
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.hashing import FileHasher
+
+
+class TestFileHasher:
+    """Tests for FileHasher"""
+    
+    def test_hash_matches_sha256(self, tmp_path):
+        """The digest is the SHA-256 of the file contents"""
+        path = tmp_path / "a.bin"
+        data = os.urandom(3 * FileHasher.CHUNK_SIZE + 17)
+        path.write_bytes(data)
+        
+        assert FileHasher().hash_file(path) == hashlib.sha256(data).hexdigest()
+    
+    def test_large_file_hashed_via_mmap(self, tmp_path):
+        """Files above the threshold are mapped and give the same digest"""
+        path = tmp_path / "big.bin"
+        data = os.urandom(4096)
+        path.write_bytes(data)
+        hasher = FileHasher()
+        hasher.MMAP_THRESHOLD = 1024
+        
+        assert hasher.hash_file(path) == hashlib.sha256(data).hexdigest()
+    
+    def test_unchanged_file_not_reread(self, tmp_path):
+        """A cache hit only stats the file"""
+        path = tmp_path / "a.bin"
+        path.write_bytes(b"binary1")
+        hasher = FileHasher()
+        first = hasher.hash_file(path)
+        
+        with patch.object(hasher, "_compute") as compute:
+            assert hasher.hash_file(path) == first
+            compute.assert_not_called()
+    
+    def test_modified_file_rehashed(self, tmp_path):
+        """A new mtime or size invalidates the cached digest"""
+        path = tmp_path / "a.bin"
+        path.write_bytes(b"binary1")
+        hasher = FileHasher()
+        first = hasher.hash_file(path)
+        
+        path.write_bytes(b"binary2")
+        st = path.stat()
+        os.utime(path, ns=(st.st_atime_ns, st.st_mtime_ns + 1_000_000))
+        
+        assert hasher.hash_file(path) != first
+    
+    def test_cache_is_bounded(self, tmp_path):
+        """Old entries are evicted beyond max_entries"""
+        hasher = FileHasher(max_entries=2)
+        for i in range(3):
+            path = tmp_path / f"{i}.bin"
+            path.write_bytes(f"binary{i}".encode())
+            hasher.hash_file(path)
+        
+        assert len(hasher._cache) == 2
@@ -0,0 +1,49 @@
+"""Tests for the on-disk session journal"""
+
+import json
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.journal import SessionJournal
+
+
+class TestSessionJournal:
+    """Tests for SessionJournal"""
+    
+    def test_write_then_read(self, tmp_path):
+        """Written state reads back with the format version"""
+        journal = SessionJournal(str(tmp_path / "state" / "sessions.json"))
+        
+        journal.write({"sessions": [{"session_id": "a.elf-1"}], "current_session_id": "a.elf-1"})
+        state = journal.read()
+        
+        assert state["version"] == SessionJournal.VERSION
+        assert state["current_session_id"] == "a.elf-1"
+        assert state["sessions"] == [{"session_id": "a.elf-1"}]
+    
+    def test_write_leaves_no_temp_files(self, tmp_path):
+        """Each write atomically replaces the journal file"""
+        journal = SessionJournal(str(tmp_path / "sessions.json"))
+        
+        journal.write({"sessions": []})
+        journal.write({"sessions": [{"session_id": "b.elf-2"}]})
+        
+        assert [p.name for p in tmp_path.iterdir()] == ["sessions.json"]
+        assert journal.read()["sessions"] == [{"session_id": "b.elf-2"}]
+    
+    def test_missing_journal(self, tmp_path):
+        """No journal file means nothing to resume"""
+        assert SessionJournal(str(tmp_path / "sessions.json")).read() is None
+    
+    def test_corrupt_or_foreign_journal_ignored(self, tmp_path):
+        """Unparseable journals and unknown versions are ignored"""
+        path = tmp_path / "sessions.json"
+        journal = SessionJournal(str(path))
+        
+        path.write_text("{not json")
+        assert journal.read() is None
+        
+        path.write_text(json.dumps({"version": 999, "sessions": []}))
+        assert journal.read() is None
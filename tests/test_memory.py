@@ -0,0 +1,64 @@
+"""Tests for memory sampling and prediction"""
+
+import os
+import subprocess
+import pytest
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.memory import MIB, MemoryPredictor, mem_available, process_tree, read_memory
+
+needs_proc = pytest.mark.skipif(not Path("/proc/meminfo").exists(), reason="needs /proc")
+
+
+@needs_proc
+class TestSampling:
+    """Tests for reading memory from /proc"""
+    
+    def test_process_tree_includes_descendants(self):
+        """A wrapper's child counts as part of the process"""
+        child = subprocess.Popen([sys.executable, "-c", "import time; time.sleep(30)"])
+        try:
+            assert child.pid in process_tree(os.getpid())
+            
+            alone = read_memory(child.pid)
+            together = read_memory(os.getpid())
+            assert together.rss > alone.rss > 0
+        finally:
+            child.kill()
+            child.wait()
+    
+    def test_gone_process_has_no_sample(self):
+        """A process that exited is not sampled"""
+        child = subprocess.Popen([sys.executable, "-c", "pass"])
+        child.wait()
+        
+        assert read_memory(child.pid) is None
+        assert mem_available() > 0
+
+
+class TestMemoryPredictor:
+    """Tests for predicting the memory of an open"""
+    
+    def test_learns_ratio_from_large_binaries(self):
+        """Observations of large binaries move the ratio; small ones are ignored"""
+        predictor = MemoryPredictor()
+        assert predictor.predict(1024) == MemoryPredictor.MIN_BINARY
+        
+        predictor.observe(4 * 1024, 2000 * MIB)
+        assert predictor.observations == 0
+        
+        for _ in range(30):
+            predictor.observe(100 * MIB, 3000 * MIB)
+        assert 29 < predictor.ratio < 31
+        assert predictor.predict(10 * MIB) == pytest.approx(300 * MIB, rel=0.05)
+    
+    def test_ratio_clamped(self):
+        """An outlier can't make the ratio absurd"""
+        predictor = MemoryPredictor()
+        for _ in range(30):
+            predictor.observe(2 * MIB, 100000 * MIB)
+        
+        assert predictor.ratio <= MemoryPredictor.MAX_RATIO
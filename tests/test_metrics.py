@@ -0,0 +1,62 @@
+"""Tests for runtime metrics"""
+
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.metrics import LatencyTracker, Metrics
+
+
+class TestLatencyTracker:
+    """Tests for per-tool latency percentiles"""
+    
+    def test_percentile(self):
+        """Percentiles are computed over the recorded samples"""
+        tracker = LatencyTracker()
+        for i in range(1, 101):
+            tracker.observe("decompile", i / 100)
+        
+        assert tracker.percentile("decompile", 50) == 0.51
+        assert tracker.percentile("decompile", 95) == 0.96
+    
+    def test_min_samples(self):
+        """No percentile is reported below min_samples"""
+        tracker = LatencyTracker()
+        tracker.observe("decompile", 1.0)
+        
+        assert tracker.percentile("decompile", 95, min_samples=2) is None
+        assert tracker.percentile("unknown", 95) is None
+    
+    def test_window_keeps_recent_samples(self):
+        """Only the most recent window of samples is kept"""
+        tracker = LatencyTracker(window=10)
+        for _ in range(10):
+            tracker.observe("disasm", 5.0)
+        for _ in range(10):
+            tracker.observe("disasm", 1.0)
+        
+        assert tracker.percentile("disasm", 99) == 1.0
+
+
+class TestMetrics:
+    """Tests for the metrics registry"""
+    
+    def test_hedge_rates(self):
+        """Hedge and win rates are derived from the counters"""
+        metrics = Metrics()
+        metrics.increment("hedge_eligible", 10)
+        metrics.increment("hedges_sent", 2)
+        metrics.increment("hedge_wins")
+        
+        snapshot = metrics.snapshot()
+        
+        assert snapshot["hedging"]["hedge_rate"] == 0.2
+        assert snapshot["hedging"]["win_rate"] == 0.5
+    
+    def test_collectors_included(self):
+        """Registered collectors contribute to snapshots"""
+        metrics = Metrics()
+        metrics.add_collector("pool", lambda: {"processes": 2})
+        
+        assert metrics.snapshot()["pool"] == {"processes": 2}
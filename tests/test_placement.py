@@ -0,0 +1,64 @@
+"""Tests for CPU and NUMA placement of child processes"""
+
+import os
+import pytest
+from pathlib import Path
+from unittest.mock import patch
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp import placement as placement_module
+from ida_pro_proxy_mcp.placement import PlacementPolicy, format_cpulist, parse_cpulist
+
+
+@pytest.fixture
+def two_nodes(tmp_path):
+    """Eight CPUs on two NUMA nodes, faked with plain files"""
+    for node, cpus in ((0, "0-3"), (1, "4-7")):
+        (tmp_path / f"node{node}").mkdir()
+        (tmp_path / f"node{node}" / "cpulist").write_text(cpus + "\n")
+    with patch.object(placement_module, "NODE_ROOT", tmp_path), \
+            patch("os.sched_getaffinity", return_value=set(range(8))):
+        yield
+
+
+class TestPlacementPolicy:
+    """Tests for pinning children to core sets"""
+    
+    def test_cpulist_round_trip(self):
+        """Kernel CPU lists parse to CPUs and format back to ranges"""
+        assert parse_cpulist("0-2,5,8-9\n") == [0, 1, 2, 5, 8, 9]
+        assert format_cpulist([9, 8, 5, 0, 1, 2]) == "0-2,5,8-9"
+    
+    def test_children_spread_across_nodes(self, two_nodes):
+        """The proxy keeps a CPU, and children take the least used core set, one node each"""
+        policy = PlacementPolicy(max_children=2, proxy_cores=1)
+        
+        with patch.object(policy, "_cpu_busy", return_value={}):
+            first = policy.place(8745)
+            second = policy.place(8746)
+            third = policy.place(8747)
+        
+        assert policy.proxy_cpus == [0]
+        assert first.to_dict() == {"cpus": "1-3", "numa_node": 0, "membind": False}
+        assert second.to_dict() == {"cpus": "4-7", "numa_node": 1, "membind": False}
+        assert third.node == 0
+        # With the sets equally used, the less busy one wins
+        for port in (8745, 8746, 8747):
+            policy.release(port)
+        with patch.object(policy, "_cpu_busy", return_value={1: 0.9, 4: 0.1}):
+            assert policy.place(8748).node == 1
+        assert [s["ports"] for s in policy.to_dict()["slots"]] == [[], [8748]]
+    
+    def test_apply_pins_every_thread(self):
+        """Every thread of the child's process tree is pinned to its CPUs"""
+        policy = PlacementPolicy(max_children=1, proxy_cores=0)
+        placement = policy.place(8745)
+        
+        with patch("os.sched_setaffinity") as setaffinity:
+            policy.apply(8745, os.getpid())
+        
+        pinned = {call.args[0] for call in setaffinity.call_args_list}
+        assert pinned >= {int(tid) for tid in os.listdir("/proc/self/task")}
+        assert all(call.args[1] == placement.cpus for call in setaffinity.call_args_list)
@@ -1,6 +1,7 @@
 """Tests for ProcessManager"""
 
 import pytest
+import time
 from pathlib import Path
 from unittest.mock import Mock, patch, MagicMock
 
@@ -209,6 +210,30 @@ class TestProcessHealth:
         manager = ProcessManager()
         
         assert manager.check_process_health(9999) is False
+    
+    @pytest.mark.skipif(not Path("/proc/self/status").exists(), reason="needs /proc")
+    def test_sample_memory(self):
+        """A child's memory is sampled from /proc and reused while fresh"""
+        import subprocess
+        import sys as system
+        process = subprocess.Popen([system.executable, "-c", "import time; time.sleep(30)"])
+        try:
+            manager = ProcessManager()
+            info = manager.adopt_process(
+                {"port": 9100, "pid": process.pid, "binary_path": "", "started_at": "2026-01-01T00:00:00"},
+                probe=False,
+            )
+            
+            usage = manager.sample_memory(info.port)
+            
+            assert usage.rss > 0 and usage.pss > 0
+            assert manager.sample_memory(info.port) is usage
+            assert manager.sample_memory(info.port, max_age=0) is not usage
+            assert manager.sample_memory(9999) is None
+            manager.detach_all()
+        finally:
+            process.kill()
+            process.wait()
 
 
 class TestRequestForwarding:
@@ -257,3 +282,541 @@ class TestRequestForwarding:
         
         with pytest.raises(RuntimeError, match="not healthy"):
             manager.forward_request(info.port, {"test": "request"})
+
+
+class TestCircuitBreaking:
+    """Tests for per-process circuit breaking in request forwarding"""
+    
+    def _manager_with_process(self, **kwargs):
+        """Create a manager tracking one fake running process on BASE_PORT"""
+        from ida_pro_proxy_mcp.models import ProcessInfo
+        
+        manager = ProcessManager(**kwargs)
+        mock_process = MagicMock()
+        mock_process.poll.return_value = None
+        port = manager.allocate_port()
+        manager._processes[port] = ProcessInfo(
+            port=port, pid=12345, process=mock_process, binary_path=""
+        )
+        return manager, port
+    
+    @patch('ida_pro_proxy_mcp.process_manager.http.client.HTTPConnection')
+    def test_timeout_fails_fast_afterwards(self, mock_http):
+        """After a timeout, further requests fail fast without contacting the child"""
+        from ida_pro_proxy_mcp.circuit_breaker import CircuitOpenError
+        
+        mock_conn = MagicMock()
+        mock_conn.getresponse.side_effect = TimeoutError("timed out")
+        mock_http.return_value = mock_conn
+        manager, port = self._manager_with_process(breaker_reset_timeout=60)
+        
+        with pytest.raises(RuntimeError, match="timed out"):
+            manager.forward_request(port, {"method": "tools/call"})
+        
+        mock_http.reset_mock()
+        with pytest.raises(CircuitOpenError):
+            manager.forward_request(port, {"method": "tools/call"})
+        mock_http.assert_not_called()
+    
+    @patch('ida_pro_proxy_mcp.process_manager.http.client.HTTPConnection')
+    def test_timeout_threshold_configurable(self, mock_http):
+        """With breaker_timeout_threshold=2 the second timeout in a row opens the breaker"""
+        mock_conn = MagicMock()
+        mock_conn.getresponse.side_effect = TimeoutError("timed out")
+        mock_http.return_value = mock_conn
+        manager, port = self._manager_with_process(breaker_timeout_threshold=2, breaker_reset_timeout=60)
+        
+        with pytest.raises(RuntimeError, match="timed out"):
+            manager.forward_request(port, {"method": "tools/call"})
+        assert manager.get_breaker(port).state == "closed"
+        
+        with pytest.raises(RuntimeError, match="timed out"):
+            manager.forward_request(port, {"method": "tools/call"})
+        assert manager.get_breaker(port).state == "open"
+    
+    @patch('ida_pro_proxy_mcp.process_manager.http.client.HTTPConnection')
+    def test_failed_probe_reports_wedged(self, mock_http):
+        """A failed half-open probe invokes on_wedged with a capped timeout"""
+        mock_conn = MagicMock()
+        mock_conn.getresponse.side_effect = TimeoutError("timed out")
+        mock_http.return_value = mock_conn
+        manager, port = self._manager_with_process(
+            breaker_reset_timeout=0, breaker_probe_timeout=5
+        )
+        manager.on_wedged = Mock()
+        
+        with pytest.raises(RuntimeError):
+            manager.forward_request(port, {"method": "tools/call"})
+        manager.on_wedged.assert_not_called()
+        
+        with pytest.raises(RuntimeError):
+            manager.forward_request(port, {"method": "tools/call"}, timeout=300)
+        
+        manager.on_wedged.assert_called_once_with(port)
+        assert mock_http.call_args.kwargs["timeout"] == 5
+    
+    @patch('ida_pro_proxy_mcp.process_manager.http.client.HTTPConnection')
+    def test_successful_probe_closes_breaker(self, mock_http):
+        """A successful probe closes the breaker again"""
+        mock_conn = MagicMock()
+        mock_response = MagicMock()
+        mock_response.read.return_value = b'{"jsonrpc": "2.0", "id": 1, "result": {}}'
+        mock_conn.getresponse.side_effect = [TimeoutError("timed out"), mock_response]
+        mock_http.return_value = mock_conn
+        manager, port = self._manager_with_process(breaker_reset_timeout=0)
+        
+        with pytest.raises(RuntimeError):
+            manager.forward_request(port, {"method": "tools/call"})
+        manager.forward_request(port, {"method": "tools/call"})
+        
+        assert manager.get_breaker(port).state == "closed"
+    
+    @patch('ida_pro_proxy_mcp.process_manager.http.client.HTTPConnection')
+    def test_failed_switch_settles_probe(self, mock_http):
+        """An idalib_switch that fails as the half-open probe frees it without reporting a wedge"""
+        switch_failed = MagicMock()
+        switch_failed.read.return_value = b'{"jsonrpc": "2.0", "id": 1, "result": {"isError": true, "content": []}}'
+        ok = MagicMock()
+        ok.read.return_value = b'{"jsonrpc": "2.0", "id": 1, "result": {}}'
+        mock_conn = MagicMock()
+        mock_conn.getresponse.side_effect = [switch_failed, ok]
+        mock_http.return_value = mock_conn
+        manager, port = self._manager_with_process(breaker_reset_timeout=0)
+        manager.get_process(port).ida_sessions = ["a1", "b2"]
+        manager.on_wedged = Mock()
+        manager.get_breaker(port).record_failure(timeout=True)
+        request = {"jsonrpc": "2.0", "id": 1, "method": "tools/call"}
+        
+        with pytest.raises(RuntimeError, match="Could not switch"):
+            manager.forward_request(port, request, ida_session="a1")
+        manager.forward_request(port, request)
+        
+        manager.on_wedged.assert_not_called()
+        assert manager.get_breaker(port).state == "closed"
+
+
+class FakeChild:
+    """Minimal HTTP child that records requests and answers slowly"""
+    
+    def __init__(self, delay: float = 0.0, batch: bool = True):
+        import json
+        import threading
+        from http.server import ThreadingHTTPServer, BaseHTTPRequestHandler
+        
+        self.delay = delay
+        self.requests = []
+        fake = self
+        
+        class Handler(BaseHTTPRequestHandler):
+            def do_POST(self):
+                body = json.loads(self.rfile.read(int(self.headers["Content-Length"])))
+                fake.requests.append(body)
+                if isinstance(body, list):
+                    reply = [{"jsonrpc": "2.0", "id": r["id"], "result": {"n": r["params"]}} for r in body]
+                    if not batch:
+                        reply = {"jsonrpc": "2.0", "id": None, "error": {"code": -32600, "message": "Invalid Request"}}
+                else:
+                    if "id" in body:
+                        time.sleep(fake.delay)
+                    reply = {"jsonrpc": "2.0", "id": body.get("id"), "result": {}}
+                data = json.dumps(reply).encode()
+                self.send_response(200)
+                self.send_header("Content-Length", str(len(data)))
+                self.end_headers()
+                self.wfile.write(data)
+            
+            def log_message(self, *args):
+                pass
+        
+        self.server = ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+        self.port = self.server.server_address[1]
+        threading.Thread(target=self.server.serve_forever, daemon=True).start()
+    
+    def notifications(self):
+        return [
+            r for r in self.requests
+            if isinstance(r, dict) and r.get("method") == "notifications/cancelled"
+        ]
+    
+    def close(self):
+        self.server.shutdown()
+        self.server.server_close()
+
+
+class TestCancellation:
+    """Tests for in-flight tracking and cancellation propagation"""
+    
+    def _manager_for(self, child, **kwargs):
+        from ida_pro_proxy_mcp.models import ProcessInfo
+        
+        manager = ProcessManager(**kwargs)
+        mock_process = MagicMock()
+        mock_process.poll.return_value = None
+        manager._processes[child.port] = ProcessInfo(
+            port=child.port, pid=12345, process=mock_process, binary_path=""
+        )
+        return manager
+    
+    def test_child_id_rewritten_and_restored(self):
+        """Requests get a proxy-assigned child ID; responses keep the caller's ID"""
+        child = FakeChild()
+        try:
+            manager = self._manager_for(child)
+            response = manager.forward_request(child.port, {"jsonrpc": "2.0", "id": "abc", "method": "tools/call"})
+            
+            assert response["id"] == "abc"
+            assert isinstance(child.requests[0]["id"], int)
+            assert manager.get_in_flight(child.port) == []
+        finally:
+            child.close()
+    
+    def test_cancel_token_sends_cancelled_notification(self):
+        """Cancelling the token notifies the child and marks the call abandoned"""
+        from ida_pro_proxy_mcp.cancellation import CancelToken
+        import threading
+        
+        child = FakeChild(delay=1.0)
+        try:
+            manager = self._manager_for(child, cancel_grace=30)
+            token = CancelToken()
+            worker = threading.Thread(
+                target=manager.forward_request,
+                args=(child.port, {"jsonrpc": "2.0", "id": 7, "method": "tools/call"}),
+                kwargs={"cancel_token": token},
+            )
+            worker.start()
+            time.sleep(0.3)
+            
+            token.cancel("client disconnected")
+            assert manager.is_draining(child.port) is True
+            
+            worker.join(timeout=5)
+            notifications = child.notifications()
+            assert len(notifications) == 1
+            assert notifications[0]["params"]["requestId"] == child.requests[0]["id"]
+            assert manager.is_draining(child.port) is False
+        finally:
+            child.close()
+    
+    def test_timeout_cancels_and_drains_in_background(self):
+        """A timed-out call is cancelled and tracked until the child drains it"""
+        child = FakeChild(delay=1.0)
+        try:
+            manager = self._manager_for(child, cancel_grace=30)
+            
+            with pytest.raises(RuntimeError):
+                manager.forward_request(child.port, {"jsonrpc": "2.0", "id": 1, "method": "tools/call"}, timeout=0.3)
+            
+            assert len(child.notifications()) == 1
+            assert manager.is_draining(child.port) is True
+            
+            deadline = time.monotonic() + 5
+            while manager.is_draining(child.port) and time.monotonic() < deadline:
+                time.sleep(0.05)
+            assert manager.is_draining(child.port) is False
+        finally:
+            child.close()
+    
+    def test_queued_call_fails_fast_when_breaker_opens(self):
+        """A call queued behind one that times out fails fast instead of waiting out the drain"""
+        import threading
+        from ida_pro_proxy_mcp.circuit_breaker import CircuitOpenError
+        
+        child = FakeChild(delay=3.0)
+        try:
+            manager = self._manager_for(child, cancel_grace=30, breaker_reset_timeout=60)
+            first = threading.Thread(
+                target=lambda: pytest.raises(
+                    RuntimeError, manager.forward_request,
+                    child.port, {"jsonrpc": "2.0", "id": 1, "method": "tools/call"}, timeout=0.3,
+                ),
+            )
+            first.start()
+            time.sleep(0.1)
+            
+            started = time.monotonic()
+            with pytest.raises(CircuitOpenError):
+                manager.forward_request(child.port, {"jsonrpc": "2.0", "id": 2, "method": "tools/call"}, timeout=30)
+            
+            assert time.monotonic() - started < 1.5
+            assert manager.is_draining(child.port) is True
+            assert [r["id"] for r in child.requests if "id" in r] == [child.requests[0]["id"]]
+            first.join(timeout=5)
+        finally:
+            child.close()
+    
+    def test_undrained_cancel_escalates_to_wedged(self):
+        """A cancelled call that never drains reports the process as wedged"""
+        child = FakeChild(delay=3.0)
+        try:
+            manager = self._manager_for(child, cancel_grace=1, breaker_reset_timeout=60)
+            manager.on_wedged = Mock()
+            
+            with pytest.raises(RuntimeError):
+                manager.forward_request(child.port, {"jsonrpc": "2.0", "id": 1, "method": "tools/call"}, timeout=0.2)
+            
+            time.sleep(1.5)
+            manager.on_wedged.assert_called_once_with(child.port)
+        finally:
+            child.close()
+
+
+class TestBatching:
+    """Tests for forwarding several requests in one round trip"""
+    
+    def _manager_for(self, child):
+        from ida_pro_proxy_mcp.models import ProcessInfo
+        
+        manager = ProcessManager()
+        mock_process = MagicMock()
+        mock_process.poll.return_value = None
+        manager._processes[child.port] = ProcessInfo(
+            port=child.port, pid=12345, process=mock_process, binary_path=""
+        )
+        return manager
+    
+    def _requests(self):
+        return [
+            {"jsonrpc": "2.0", "id": i, "method": "tools/call", "params": i * 10}
+            for i in range(3)
+        ]
+    
+    def test_batch_sent_in_one_request(self):
+        """The requests go out as one JSON-RPC batch; responses come back in order"""
+        child = FakeChild()
+        try:
+            manager = self._manager_for(child)
+            responses = manager.forward_batch(child.port, self._requests())
+            
+            assert len(child.requests) == 1
+            assert isinstance(child.requests[0], list)
+            assert [r["id"] for r in responses] == [0, 1, 2]
+            assert [r["result"]["n"] for r in responses] == [0, 10, 20]
+            assert manager.get_in_flight(child.port) == []
+        finally:
+            child.close()
+    
+    def test_child_without_batches_gets_calls_one_at_a_time(self):
+        """A child that rejects the batch is sent each request, now and later"""
+        child = FakeChild(batch=False)
+        try:
+            manager = self._manager_for(child)
+            responses = manager.forward_batch(child.port, self._requests())
+            
+            assert [r["id"] for r in responses] == [0, 1, 2]
+            assert len(child.requests) == 4
+            
+            manager.forward_batch(child.port, self._requests())
+            assert len(child.requests) == 7
+        finally:
+            child.close()
+    
+    def test_cancel_token_cancels_every_request(self):
+        """Cancelling a batch's token sends notifications/cancelled for each of its requests"""
+        from ida_pro_proxy_mcp.cancellation import CancelToken
+        
+        child = FakeChild()
+        try:
+            manager = self._manager_for(child)
+            token = CancelToken(escalate=False)
+            token.cancel("preempted")
+            manager.forward_batch(child.port, self._requests(), cancel_token=token)
+            
+            cancelled = [n["params"]["requestId"] for n in child.notifications()]
+            batch = next(r for r in child.requests if isinstance(r, list))
+            assert cancelled == [r["id"] for r in batch]
+        finally:
+            child.close()
+
+
+class TestSessionSwitching:
+    """Tests for selecting a database in a process that hosts several"""
+    
+    def _manager_for(self, child):
+        from ida_pro_proxy_mcp.models import ProcessInfo
+        
+        manager = ProcessManager()
+        mock_process = MagicMock()
+        mock_process.poll.return_value = None
+        manager._processes[child.port] = ProcessInfo(
+            port=child.port, pid=12345, process=mock_process, binary_path="", ida_sessions=["a1", "b2"],
+        )
+        return manager
+    
+    def _call(self, name):
+        return {"jsonrpc": "2.0", "id": 1, "method": "tools/call", "params": {"name": name, "arguments": {}}}
+    
+    def test_switch_sent_only_when_database_changes(self):
+        """A call for another database, or after an open, is preceded by idalib_switch"""
+        child = FakeChild()
+        try:
+            manager = self._manager_for(child)
+            for name, ida_session in [
+                ("decompile", "a1"), ("decompile", "a1"), ("decompile", "b2"),
+                ("idalib_open", None), ("decompile", "b2"),
+            ]:
+                manager.forward_request(child.port, self._call(name), ida_session=ida_session)
+            
+            sent = [(r["params"]["name"], r["params"]["arguments"].get("session_id")) for r in child.requests]
+            assert sent == [
+                ("idalib_switch", "a1"), ("decompile", None), ("decompile", None),
+                ("idalib_switch", "b2"), ("decompile", None), ("idalib_open", None),
+                ("idalib_switch", "b2"), ("decompile", None),
+            ]
+            assert manager.session_switches == 3
+            assert manager.get_process(child.port).current_ida_session == "b2"
+        finally:
+            child.close()
+    
+    def test_single_database_never_switched(self):
+        """A process hosting one IDA session gets its calls without idalib_switch"""
+        child = FakeChild()
+        try:
+            manager = self._manager_for(child)
+            manager.get_process(child.port).ida_sessions = ["a1"]
+            for name in ["decompile", "idalib_open", "decompile"]:
+                manager.forward_request(child.port, self._call(name), ida_session="a1")
+            
+            assert [r["params"]["name"] for r in child.requests] == ["decompile", "idalib_open", "decompile"]
+            assert manager.session_switches == 0
+        finally:
+            child.close()
+    
+    def test_batch_switches_once(self):
+        """A batch for another database is preceded by a single idalib_switch"""
+        child = FakeChild()
+        try:
+            manager = self._manager_for(child)
+            manager.forward_batch(child.port, [self._call("callees"), self._call("callers")], ida_session="a1")
+            
+            assert child.requests[0]["params"]["name"] == "idalib_switch"
+            assert isinstance(child.requests[1], list)
+        finally:
+            child.close()
+
+
+class TestDeadlines:
+    """Tests for deadline-aware dispatch"""
+    
+    def _manager_for(self, child, **kwargs):
+        from ida_pro_proxy_mcp.models import ProcessInfo
+        
+        manager = ProcessManager(**kwargs)
+        mock_process = MagicMock()
+        mock_process.poll.return_value = None
+        manager._processes[child.port] = ProcessInfo(
+            port=child.port, pid=12345, process=mock_process, binary_path=""
+        )
+        return manager
+    
+    def test_expired_deadline_not_dispatched(self):
+        """A request whose deadline already passed is never sent"""
+        from ida_pro_proxy_mcp.cancellation import Deadline, DeadlineExceededError
+        
+        child = FakeChild()
+        try:
+            manager = self._manager_for(child)
+            
+            with pytest.raises(DeadlineExceededError):
+                manager.forward_request(
+                    child.port, {"jsonrpc": "2.0", "id": 1, "method": "tools/call"}, deadline=Deadline(-1)
+                )
+            
+            assert child.requests == []
+        finally:
+            child.close()
+    
+    def test_queued_call_expires_without_reaching_child(self):
+        """A call whose deadline passes while queued behind another is skipped"""
+        import threading
+        from ida_pro_proxy_mcp.cancellation import Deadline, DeadlineExceededError
+        
+        child = FakeChild(delay=1.0)
+        try:
+            manager = self._manager_for(child)
+            first = threading.Thread(
+                target=manager.forward_request,
+                args=(child.port, {"jsonrpc": "2.0", "id": 1, "method": "tools/call"}),
+            )
+            first.start()
+            time.sleep(0.2)
+            assert manager.queue_depth(child.port) == 1
+            
+            with pytest.raises(DeadlineExceededError, match="queued"):
+                manager.forward_request(
+                    child.port, {"jsonrpc": "2.0", "id": 2, "method": "tools/call"}, deadline=Deadline(0.3)
+                )
+            
+            first.join(timeout=5)
+            assert len(child.requests) == 1
+        finally:
+            child.close()
+    
+    def test_deadline_timeout_does_not_open_breaker(self):
+        """Running out of client budget raises DeadlineExceededError and keeps the breaker closed"""
+        from ida_pro_proxy_mcp.cancellation import Deadline, DeadlineExceededError
+        
+        child = FakeChild(delay=1.0)
+        try:
+            manager = self._manager_for(child)
+            
+            with pytest.raises(DeadlineExceededError):
+                manager.forward_request(
+                    child.port, {"jsonrpc": "2.0", "id": 1, "method": "tools/call"}, deadline=Deadline(0.3)
+                )
+            
+            assert manager.get_breaker(child.port).state == "closed"
+            assert child.notifications()[0]["params"]["reason"] == "deadline exceeded"
+        finally:
+            child.close()
+
+
+class TestAdoption:
+    """Tests for adopting children left running by a previous proxy"""
+    
+    def _record(self, port, pid, **extra):
+        record = {
+            "port": port,
+            "pid": pid,
+            "binary_path": "/path/to/test.elf",
+            "started_at": "2026-01-01T00:00:00",
+            "current_ida_session": "abc12",
+            "is_default": False,
+        }
+        record.update(extra)
+        return record
+    
+    def test_adopt_running_child(self):
+        """A live child answering on its port is adopted as it is"""
+        import os
+        child = FakeChild()
+        try:
+            manager = ProcessManager()
+            info = manager.adopt_process(self._record(child.port, os.getpid(), is_default=True))
+            
+            assert info is not None
+            assert info._adopted is True
+            assert info.is_alive() is True
+            assert info.current_ida_session == "abc12"
+            assert manager.get_default_port() == child.port
+            assert manager.allocate_port() > child.port
+            assert manager.export_processes()[0]["port"] == child.port
+            
+            # Leave the test process alone
+            manager.detach_all()
+            assert manager.process_count == 0
+        finally:
+            child.close()
+    
+    def test_adopt_skips_dead_process(self):
+        """A journaled process that exited is not adopted, nor its port reused"""
+        import subprocess
+        import sys as system
+        process = subprocess.Popen([system.executable, "-c", "pass"])
+        process.wait()
+        manager = ProcessManager()
+        
+        assert manager.adopt_process(self._record(9100, process.pid)) is None
+        assert manager.process_count == 0
+        assert manager.allocate_port() == 9101
+
@@ -0,0 +1,64 @@
+"""Tests for queue-depth rebalancing of sessions"""
+
+import pytest
+from pathlib import Path
+from unittest.mock import Mock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.models import ProxySession
+from ida_pro_proxy_mcp.process_manager import ProcessManager
+from ida_pro_proxy_mcp.rebalancer import Rebalancer
+from ida_pro_proxy_mcp.session_manager import SessionManager
+
+
+@pytest.fixture
+def pool():
+    """Two sessions sharing port 8745 and one alone on port 8746"""
+    sessions = {
+        sid: ProxySession(sid, f"/bin/{sid}", sid, port, sid)
+        for sid, port in (("a", 8745), ("b", 8745), ("c", 8746))
+    }
+    manager = Mock(spec=SessionManager)
+    manager.process_manager = Mock(spec=ProcessManager)
+    manager.process_manager.active_ports = [8745, 8746]
+    manager.port_sessions.return_value = {8745: ["a", "b"], 8746: ["c"]}
+    manager.get_session.side_effect = sessions.get
+    return manager, sessions
+
+
+class TestRebalancer:
+    """Tests for moving busy sessions off shared processes"""
+    
+    def test_busiest_session_of_deep_shared_process_moved(self, pool):
+        """The session with the most recent calls leaves a shared process running deep queues"""
+        manager, sessions = pool
+        depths = {8745: 0, 8746: 0}
+        manager.process_manager.queue_depth.side_effect = depths.get
+        rebalancer = Rebalancer(manager, interval=3600, threshold=2.0)
+        try:
+            assert rebalancer.tick() is None
+            sessions["a"].calls, sessions["b"].calls = 3, 9
+            depths[8745] = 6
+            
+            moved = rebalancer.tick()
+        finally:
+            rebalancer.close()
+        
+        assert moved is sessions["b"]
+        manager.migrate_session.assert_called_once_with("b")
+        assert rebalancer.to_dict()["queue_depth"] == {"8745": 3.0, "8746": 0.0}
+        assert rebalancer.migrations == 1
+    
+    def test_single_session_process_left_alone(self, pool):
+        """A process serving one session is not rebalanced however deep its queue"""
+        manager, sessions = pool
+        manager.process_manager.queue_depth.side_effect = {8745: 0, 8746: 10}.get
+        rebalancer = Rebalancer(manager, interval=3600, threshold=2.0)
+        try:
+            assert rebalancer.tick() is None
+        finally:
+            rebalancer.close()
+        
+        manager.migrate_session.assert_not_called()
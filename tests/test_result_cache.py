@@ -0,0 +1,59 @@
+"""Tests for ResultCache"""
+
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.result_cache import ResultCache
+
+
+RESULT = {"content": [{"type": "text", "text": "int main(void)"}]}
+
+
+class TestResultCache:
+    """Tests for caching tool results"""
+    
+    def test_hit_after_put(self):
+        """A stored result is returned for the same call"""
+        cache = ResultCache()
+        cache.put("s1", 0, "decompile", {"addr": "0x401000"}, RESULT)
+        
+        assert cache.get("s1", 0, "decompile", {"addr": "0x401000"}) == RESULT
+    
+    def test_argument_order_ignored(self):
+        """Arguments are matched regardless of key order"""
+        cache = ResultCache()
+        cache.put("s1", 0, "disasm", {"addr": "0x10", "max": 5}, RESULT)
+        
+        assert cache.get("s1", 0, "disasm", {"max": 5, "addr": "0x10"}) == RESULT
+    
+    def test_other_generation_misses(self):
+        """Results of an older generation are not returned"""
+        cache = ResultCache()
+        cache.put("s1", 0, "decompile", {"addr": "0x401000"}, RESULT)
+        
+        assert cache.get("s1", 1, "decompile", {"addr": "0x401000"}) is None
+    
+    def test_invalidate_drops_session(self):
+        """invalidate() removes only the given session's results"""
+        cache = ResultCache()
+        cache.put("s1", 0, "decompile", {"addr": "0x1"}, RESULT)
+        cache.put("s1", 0, "decompile", {"addr": "0x2"}, RESULT)
+        cache.put("s2", 0, "decompile", {"addr": "0x1"}, RESULT)
+        
+        assert cache.invalidate("s1") == 2
+        assert cache.get("s1", 0, "decompile", {"addr": "0x1"}) is None
+        assert cache.get("s2", 0, "decompile", {"addr": "0x1"}) == RESULT
+    
+    def test_least_recently_used_evicted(self):
+        """The cache keeps at most max_entries, evicting the least recently used"""
+        cache = ResultCache(max_entries=2)
+        cache.put("s1", 0, "decompile", {"addr": "0x1"}, RESULT)
+        cache.put("s1", 0, "decompile", {"addr": "0x2"}, RESULT)
+        cache.get("s1", 0, "decompile", {"addr": "0x1"})
+        cache.put("s1", 0, "decompile", {"addr": "0x3"}, RESULT)
+        
+        assert cache.get("s1", 0, "decompile", {"addr": "0x2"}) is None
+        assert cache.get("s1", 0, "decompile", {"addr": "0x1"}) == RESULT
+        assert cache.to_dict() == {"entries": 2, "max_entries": 2}
@@ -2,21 +2,28 @@
 
 import pytest
 import json
+from contextlib import nullcontext
 from pathlib import Path
 from unittest.mock import Mock, MagicMock
 
 import sys
 sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
 
+from ida_pro_proxy_mcp.func_index import FunctionIndex
 from ida_pro_proxy_mcp.router import RequestRouter
 from ida_pro_proxy_mcp.session_manager import SessionManager
 from ida_pro_proxy_mcp.models import ProxySession
+from ida_pro_proxy_mcp.result_cache import ResultCache
+from ida_pro_proxy_mcp.similarity import SimilarityIndex
+from ida_pro_proxy_mcp.warmer import CacheWarmer
 
 
 @pytest.fixture
 def mock_session_manager():
     """Create a mock SessionManager"""
     manager = Mock(spec=SessionManager)
+    manager.get_hibernated.return_value = None
+    manager.route.side_effect = lambda session: nullcontext((session.process_port, session.ida_session_id))
     manager.process_manager = Mock()
     manager.process_manager.check_process_health.return_value = True
     manager.process_manager.forward_request.return_value = {
@@ -37,6 +44,8 @@ def mock_session():
     session.process_port = 8745
     session.ida_session_id = "abc12"
     session.is_current = True
+    session.restoring = False
+    session.summary = None
     session.to_dict.return_value = {
         "session_id": "test.elf-abc12",
         "binary_path": "/path/to/test.elf",
@@ -320,13 +329,71 @@ class TestCrashDetection:
     def test_detect_crashed_process(self, mock_session_manager, mock_session):
         """
         Property 11: Crash detection
-        Should detect crashed process and return error
+        Should detect crashed process and restore the session in place
         """
         mock_session_manager.get_session.return_value = mock_session
         mock_session_manager.process_manager.check_process_health.return_value = False
         router = RequestRouter(mock_session_manager)
         
-        request = {
+        response = router.route(self._decompile())
+        
+        assert "isError" not in response["result"]
+        mock_session_manager.restore_session.assert_called_with("test.elf-abc12")
+        mock_session_manager.close_session.assert_not_called()
+        mock_session_manager.process_manager.forward_request.assert_called()
+        assert router.metrics.get("crash_recoveries") == 1
+    
+    def test_unrecoverable_crash_returns_error(self, mock_session_manager, mock_session):
+        """A session that cannot be restored is reported as gone"""
+        mock_session_manager.get_session.return_value = mock_session
+        mock_session_manager.process_manager.check_process_health.return_value = False
+        mock_session_manager.restore_session.side_effect = RuntimeError("open failed")
+        router = RequestRouter(mock_session_manager)
+        
+        response = router.route(self._decompile())
+        
+        assert response["result"]["isError"] is True
+        result_text = response["result"]["content"][0]["text"]
+        assert "no longer available" in result_text
+        mock_session_manager.process_manager.forward_request.assert_not_called()
+    
+    def test_read_only_call_retried_after_crash(self, mock_session_manager, mock_session):
+        """A read-only call that dies with its process is retried once after restore"""
+        mock_session_manager.get_session.return_value = mock_session
+        process_manager = mock_session_manager.process_manager
+        process_manager.check_process_health.side_effect = [True, False]
+        process_manager.forward_request.side_effect = [
+            RuntimeError("Connection reset"),
+            {"jsonrpc": "2.0", "id": 1, "result": {"content": []}},
+        ]
+        router = RequestRouter(mock_session_manager)
+        
+        response = router.route(self._decompile())
+        
+        assert response["id"] == 1
+        assert "isError" not in response["result"]
+        assert process_manager.forward_request.call_count == 2
+        mock_session_manager.restore_session.assert_called_once_with("test.elf-abc12")
+    
+    def test_mutating_call_not_retried_after_crash(self, mock_session_manager, mock_session):
+        """A call that may modify the database is not replayed after restore"""
+        mock_session_manager.get_session.return_value = mock_session
+        process_manager = mock_session_manager.process_manager
+        process_manager.check_process_health.side_effect = [True, False]
+        process_manager.forward_request.side_effect = RuntimeError("Connection reset")
+        router = RequestRouter(mock_session_manager)
+        
+        request = self._decompile()
+        request["params"]["name"] = "rename"
+        response = router.route(request)
+        
+        assert response["result"]["isError"] is True
+        assert "not retried" in response["result"]["content"][0]["text"]
+        assert process_manager.forward_request.call_count == 1
+        mock_session_manager.restore_session.assert_called_once_with("test.elf-abc12")
+    
+    def _decompile(self):
+        return {
             "jsonrpc": "2.0",
             "id": 1,
             "method": "tools/call",
@@ -338,11 +405,469 @@ class TestCrashDetection:
                 }
             }
         }
+
+
+class TestDraining:
+    """Tests for refusing calls while the server drains"""
+    
+    def test_calls_refused_after_stop_admission(self, mock_session_manager, mock_session):
+        """New tool calls get a draining error and are not forwarded"""
+        mock_session_manager.get_current_session.return_value = mock_session
+        router = RequestRouter(mock_session_manager)
+        router.stop_admission()
+        
+        response = router.route({
+            "jsonrpc": "2.0",
+            "id": 7,
+            "method": "tools/call",
+            "params": {"name": "decompile", "arguments": {"addr": "0x401000"}},
+        })
+        
+        assert response["id"] == 7
+        assert response["error"]["code"] == RequestRouter.SERVER_DRAINING
+        mock_session_manager.process_manager.forward_request.assert_not_called()
+
+
+class TestResultCaching:
+    """Tests for serving read-only calls from the result cache"""
+    
+    def _call(self, name, arguments):
+        return {
+            "jsonrpc": "2.0",
+            "id": 3,
+            "method": "tools/call",
+            "params": {"name": name, "arguments": arguments},
+        }
+    
+    def test_repeated_read_only_call_served_from_cache(self, mock_session_manager, mock_session):
+        """A second identical read-only call is not forwarded"""
+        mock_session.generation = 0
+        mock_session_manager.get_current_session.return_value = mock_session
+        router = RequestRouter(mock_session_manager, result_cache=ResultCache())
+        
+        first = router.route(self._call("decompile", {"addr": "0x401000"}))
+        second = router.route(self._call("decompile", {"addr": "0x401000"}))
+        
+        assert second["result"] == first["result"]
+        assert second["id"] == 3
+        assert mock_session_manager.process_manager.forward_request.call_count == 1
+    
+    def test_new_generation_misses(self, mock_session_manager, mock_session):
+        """After the session's generation changes, calls are forwarded again"""
+        mock_session.generation = 0
+        mock_session_manager.get_current_session.return_value = mock_session
+        router = RequestRouter(mock_session_manager, result_cache=ResultCache())
+        
+        router.route(self._call("decompile", {"addr": "0x401000"}))
+        mock_session.generation = 1
+        router.route(self._call("decompile", {"addr": "0x401000"}))
+        
+        assert mock_session_manager.process_manager.forward_request.call_count == 2
+    
+    def test_mutating_call_bumps_generation(self, mock_session_manager, mock_session):
+        """A call that may modify the database invalidates the session's results"""
+        mock_session.generation = 0
+        mock_session_manager.get_current_session.return_value = mock_session
+        router = RequestRouter(mock_session_manager, result_cache=ResultCache())
+        
+        router.route(self._call("rename", {"batch": {}}))
+        
+        mock_session_manager.bump_generation.assert_called_once_with(mock_session.session_id)
+    
+    def test_tool_errors_not_cached(self, mock_session_manager, mock_session):
+        """Results flagged as errors are forwarded again next time"""
+        mock_session.generation = 0
+        mock_session_manager.get_current_session.return_value = mock_session
+        mock_session_manager.process_manager.forward_request.return_value = {
+            "jsonrpc": "2.0", "id": 1, "result": {"content": [], "isError": True},
+        }
+        router = RequestRouter(mock_session_manager, result_cache=ResultCache())
+        
+        router.route(self._call("decompile", {"addr": "0x401000"}))
+        router.route(self._call("decompile", {"addr": "0x401000"}))
+        
+        assert mock_session_manager.process_manager.forward_request.call_count == 2
+    
+    def test_warmer_told_of_served_calls(self, mock_session_manager, mock_session):
+        """The warmer hears of forwarded and cached results, to prefetch and count hits"""
+        mock_session.generation = 0
+        mock_session_manager.get_current_session.return_value = mock_session
+        warmer = Mock(spec=CacheWarmer)
+        router = RequestRouter(mock_session_manager, result_cache=ResultCache(), warmer=warmer)
+        
+        router.route(self._call("decompile", {"addr": "0x401000"}))
+        router.route(self._call("decompile", {"addr": "0x401000"}))
+        
+        assert [c.kwargs["cached"] for c in warmer.served.call_args_list] == [False, True]
+        warmer.served.assert_called_with(mock_session, "decompile", {"addr": "0x401000"}, cached=True)
+    
+    def test_warm_session_answered_from_cache_while_reopening(self, mock_session_manager, mock_session):
+        """A call on a hibernated session is served from the cache, or refused, while it reopens"""
+        mock_session.generation = 0
+        mock_session.tier = "warm"
+        mock_session_manager.get_session.return_value = None
+        mock_session_manager.get_hibernated.return_value = mock_session
+        cache = ResultCache()
+        cache.put(mock_session.session_id, 0, "decompile", {"addr": "0x401000"}, {"content": [], "cached": True})
+        router = RequestRouter(mock_session_manager, result_cache=cache)
+        session = mock_session.session_id
+        
+        hit = router.route(self._call("decompile", {"addr": "0x401000", "session": session}))
+        miss = router.route(self._call("decompile", {"addr": "0x402000", "session": session}))
+        
+        assert hit["result"] == {"content": [], "cached": True}
+        assert miss["result"]["isError"] is True
+        assert "reopened in the background" in miss["result"]["content"][0]["text"]
+        mock_session_manager.wake_in_background.assert_called_with(session)
+        mock_session_manager.process_manager.forward_request.assert_not_called()
+
+
+class TestMap:
+    """Tests for the idalib_map tool"""
+    
+    def _map(self, inputs, meta=None):
+        params = {"name": "idalib_map", "arguments": {"inputs": inputs, "tool": "imports"}}
+        if meta:
+            params["_meta"] = meta
+        return {"jsonrpc": "2.0", "id": 9, "method": "tools/call", "params": params}
+    
+    def _router(self, mock_session_manager, mock_session, tmp_path):
+        for name in ("a.elf", "b.elf"):
+            (tmp_path / name).write_bytes(name.encode())
+        mock_session.generation = 0
+        mock_session_manager.max_processes = 2
+        mock_session_manager.content_hash.side_effect = lambda path: path
+        mock_session_manager.get_session_by_binary.return_value = None
+        mock_session_manager.open_session.return_value = mock_session
+        mock_session_manager.get_session.return_value = mock_session
+        return RequestRouter(mock_session_manager)
+    
+    def test_map_calls_tool_on_each_binary(self, mock_session_manager, mock_session, tmp_path):
+        """Every matched binary is opened, called and closed"""
+        router = self._router(mock_session_manager, mock_session, tmp_path)
+        
+        response = router.route(self._map([str(tmp_path / "*.elf")]))
+        
+        result = response["result"]["structuredContent"]
+        assert response["id"] == 9
+        assert result["count"] == 2 and result["failed"] == 0
+        assert mock_session_manager.process_manager.forward_request.call_count == 2
+        assert mock_session_manager.close_session.call_count == 2
+    
+    def test_results_streamed_with_progress_token(self, mock_session_manager, mock_session, tmp_path):
+        """Per-binary results are sent as progress notifications"""
+        router = self._router(mock_session_manager, mock_session, tmp_path)
+        notifications = []
+        
+        router.route(
+            self._map([str(tmp_path / "*.elf")], meta={"progressToken": "sweep"}),
+            notify=notifications.append,
+        )
+        
+        assert [n["params"]["progress"] for n in notifications] == [1, 2]
+        assert all(n["method"] == "notifications/progress" for n in notifications)
+        assert notifications[0]["params"]["progressToken"] == "sweep"
+        assert notifications[0]["params"]["total"] == 2
+    
+    def test_no_stream_without_progress_token(self, mock_session_manager, mock_session, tmp_path):
+        """Without a progress token, results only come in the response"""
+        router = self._router(mock_session_manager, mock_session, tmp_path)
+        notifications = []
+        
+        router.route(self._map([str(tmp_path / "*.elf")]), notify=notifications.append)
+        
+        assert notifications == []
+    
+    def test_no_match_is_error(self, mock_session_manager, mock_session, tmp_path):
+        """A pattern that matches nothing returns a tool error"""
+        router = self._router(mock_session_manager, mock_session, tmp_path)
+        
+        response = router.route(self._map([str(tmp_path / "*.exe")]))
+        
+        assert response["result"]["isError"] is True
+
+
+class TestDeadlines:
+    """Tests for client deadline handling"""
+    
+    def test_expired_deadline_rejected_on_admission(self, mock_session_manager, mock_session):
+        """A call arriving after its deadline gets a deadline-exceeded error"""
+        import time
+        
+        mock_session_manager.get_current_session.return_value = mock_session
+        router = RequestRouter(mock_session_manager)
+        
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {
+                "name": "decompile",
+                "arguments": {"addr": "0x401000"},
+                "_meta": {"deadline": time.time() - 5},
+            }
+        }
         
         response = router.route(request)
         
+        assert response["error"]["code"] == RequestRouter.DEADLINE_EXCEEDED
+        mock_session_manager.process_manager.forward_request.assert_not_called()
+    
+    def test_deadline_passed_to_child_request(self, mock_session_manager, mock_session):
+        """The client's remaining budget is passed on to forward_request"""
+        mock_session_manager.get_current_session.return_value = mock_session
+        router = RequestRouter(mock_session_manager)
+        
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {
+                "name": "decompile",
+                "arguments": {"addr": "0x401000"},
+                "_meta": {"timeout": 120},
+            }
+        }
+        
+        router.route(request)
+        
+        deadline = mock_session_manager.process_manager.forward_request.call_args.kwargs["deadline"]
+        assert 0 < deadline.remaining() <= 120
+    
+    def test_deadline_exceeded_from_child(self, mock_session_manager, mock_session):
+        """A deadline hit while waiting on the child maps to the distinct error"""
+        from ida_pro_proxy_mcp.cancellation import DeadlineExceededError
+        
+        mock_session_manager.get_current_session.return_value = mock_session
+        mock_session_manager.process_manager.forward_request.side_effect = DeadlineExceededError("late")
+        router = RequestRouter(mock_session_manager)
+        
+        request = {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {"name": "decompile", "arguments": {"addr": "0x401000"}, "_meta": {"timeout": 1}},
+        }
+        
+        response = router.route(request)
+        
+        assert response["error"]["code"] == RequestRouter.DEADLINE_EXCEEDED
+
+
+class TestHedging:
+    """Tests for hedging read-only calls to replicas"""
+    
+    def _session_with_replica(self):
+        from ida_pro_proxy_mcp.models import ReplicaInfo
+        
+        session = ProxySession.create("/path/to/test.elf", 8745, "abc12")
+        session.replicas.append(ReplicaInfo(port=8746, ida_session_id="def34", work_dir="/tmp/x"))
+        return session
+    
+    def _router(self, mock_session_manager, session, primary_delay):
+        import time
+        
+        def forward(port, request, **kwargs):
+            if port == session.process_port:
+                time.sleep(primary_delay)
+            return {"jsonrpc": "2.0", "id": request["id"], "result": {"port": port}}
+        
+        mock_session_manager.get_current_session.return_value = session
+        mock_session_manager.process_manager.forward_request.side_effect = forward
+        mock_session_manager.process_manager.queue_depth.return_value = 0
+        router = RequestRouter(mock_session_manager, hedging=True, hedge_min_samples=1)
+        router.metrics.latency.observe("decompile", 0.05)
+        return router
+    
+    def _decompile(self):
+        return {
+            "jsonrpc": "2.0",
+            "id": 1,
+            "method": "tools/call",
+            "params": {"name": "decompile", "arguments": {"addr": "0x401000"}},
+        }
+    
+    def test_slow_primary_hedged_to_replica(self, mock_session_manager):
+        """A primary slower than p95 is hedged and the replica's answer wins"""
+        session = self._session_with_replica()
+        router = self._router(mock_session_manager, session, primary_delay=0.5)
+        
+        response = router.route(self._decompile())
+        
+        assert response["result"]["port"] == 8746
+        assert router.metrics.get("hedges_sent") == 1
+        assert router.metrics.get("hedge_wins") == 1
+    
+    def test_fast_primary_not_hedged(self, mock_session_manager):
+        """A primary answering within p95 is not hedged"""
+        session = self._session_with_replica()
+        router = self._router(mock_session_manager, session, primary_delay=0)
+        
+        response = router.route(self._decompile())
+        
+        assert response["result"]["port"] == 8745
+        assert router.metrics.get("hedge_eligible") == 1
+        assert router.metrics.get("hedges_sent") == 0
+    
+    def test_mutating_tool_not_hedged(self, mock_session_manager):
+        """Tools that modify the database are never hedged"""
+        session = self._session_with_replica()
+        router = self._router(mock_session_manager, session, primary_delay=0.2)
+        router.metrics.latency.observe("rename", 0.01)
+        request = self._decompile()
+        request["params"]["name"] = "rename"
+        
+        response = router.route(request)
+        
+        assert response["result"]["port"] == 8745
+        assert router.metrics.get("hedge_eligible") == 0
+    
+    def test_stale_replica_not_hedged_to_after_write(self, mock_session_manager):
+        """After a write, a slow read waits for the primary instead of the replica's old database"""
+        session = self._session_with_replica()
+        router = self._router(mock_session_manager, session, primary_delay=0.3)
+        mock_session_manager.bump_generation.side_effect = (
+            lambda session_id: setattr(session, "generation", session.generation + 1)
+        )
+        rename = self._decompile()
+        rename["params"] = {"name": "rename", "arguments": {"batch": {}}}
+        router.route(rename)
+        
+        response = router.route(self._decompile())
+        
+        assert session.generation == 1
+        assert response["result"]["port"] == 8745
+        assert router.metrics.get("hedges_sent") == 0
+    
+    def test_caller_token_released(self, mock_session_manager):
+        """A hedged call leaves nothing registered on the caller's cancel token"""
+        from ida_pro_proxy_mcp.cancellation import CancelToken
+        
+        session = self._session_with_replica()
+        router = self._router(mock_session_manager, session, primary_delay=0.5)
+        token = CancelToken()
+        
+        router.route(self._decompile(), cancel_token=token)
+        
+        assert router.metrics.get("hedges_sent") == 1
+        assert token._callbacks == []
+
+
+class TestLookup:
+    """Tests for the idalib_lookup tool"""
+    
+    def _lookup(self, arguments):
+        return {
+            "jsonrpc": "2.0",
+            "id": 5,
+            "method": "tools/call",
+            "params": {"name": "idalib_lookup", "arguments": arguments},
+        }
+    
+    def test_lookup_served_from_index(self, mock_session_manager):
+        """Lookups are answered by the index without forwarding"""
+        mock_session_manager.index = Mock(spec=FunctionIndex)
+        mock_session_manager.index.lookup.return_value = {
+            "matches": [{"name": "main", "kind": "function", "addr": "0x1000"}],
+            "count": 1,
+            "truncated": False,
+            "pending": [],
+        }
+        router = RequestRouter(mock_session_manager)
+        
+        response = router.route(self._lookup({"prefix": "ma", "kinds": ["function"]}))
+        
+        assert response["result"]["structuredContent"]["count"] == 1
+        mock_session_manager.index.lookup.assert_called_once_with(
+            name=None, prefix="ma", pattern=None, kinds=["function"],
+            include_closed=True, limit=1000,
+        )
+        mock_session_manager.process_manager.forward_request.assert_not_called()
+    
+    def test_lookup_disabled(self, mock_session_manager):
+        """Without an index, lookups fail with a tool error"""
+        mock_session_manager.index = None
+        router = RequestRouter(mock_session_manager)
+        
+        response = router.route(self._lookup({"name": "main"}))
+        
         assert response["result"]["isError"] is True
-        result_text = response["result"]["content"][0]["text"]
-        assert "no longer available" in result_text
-        # Session should be closed
-        mock_session_manager.close_session.assert_called_with("test.elf-abc12")
+    
+    def test_session_summary_of_current_session(self, mock_session_manager, mock_session):
+        """session_summary returns the current session's summary"""
+        mock_session_manager.get_current_session.return_value = mock_session
+        mock_session_manager.summarize.return_value = {"function_count": 12}
+        router = RequestRouter(mock_session_manager)
+        
+        response = router.route({
+            "jsonrpc": "2.0",
+            "id": 6,
+            "method": "tools/call",
+            "params": {"name": "session_summary", "arguments": {"refresh": True}},
+        })
+        
+        assert response["result"]["structuredContent"] == {"function_count": 12}
+        mock_session_manager.summarize.assert_called_once_with(mock_session.session_id, refresh=True)
+    
+    def test_similar_resolves_current_session(self, mock_session_manager, mock_session):
+        """idalib_similar searches from the current session's binary"""
+        mock_session.content_hash = "hash1"
+        mock_session_manager.get_current_session.return_value = mock_session
+        similarity = Mock(spec=SimilarityIndex)
+        similarity.similar.return_value = {"function": {}, "matches": [], "count": 0, "pending": []}
+        router = RequestRouter(mock_session_manager, similarity=similarity)
+        request = self._lookup({"addr": "0x401000", "top_k": 3})
+        request["params"]["name"] = "idalib_similar"
+        
+        response = router.route(request)
+        
+        assert response["result"]["structuredContent"]["count"] == 0
+        similarity.similar.assert_called_once_with(
+            "hash1", addr=0x401000, name=None, top_k=3, min_similarity=0.5, include_closed=True,
+        )
+
+
+class TestElfTools:
+    """Tests for the elf_* tools answered by the proxy"""
+    
+    def _call(self, name, arguments):
+        return {
+            "jsonrpc": "2.0",
+            "id": 6,
+            "method": "tools/call",
+            "params": {"name": name, "arguments": arguments},
+        }
+    
+    def test_session_binary_read_without_forwarding(self, mock_session_manager, mock_session, make_elf):
+        """Without a path, the session's binary is read and no process is used"""
+        mock_session.binary_path = str(make_elf("a.elf", b"\x90" * 16, imports=["gets"]))
+        mock_session_manager.get_current_session.return_value = mock_session
+        router = RequestRouter(mock_session_manager)
+        
+        response = router.route(self._call("elf_imports", {}))
+        
+        assert response["result"]["structuredContent"]["count"] == 1
+        mock_session_manager.process_manager.forward_request.assert_not_called()
+    
+    def test_bad_arguments_reported(self, mock_session_manager, make_elf):
+        """Unknown arguments and unreadable files are tool errors"""
+        router = RequestRouter(mock_session_manager)
+        path = str(make_elf("a.elf", b"\x90" * 16))
+        
+        unknown = router.route(self._call("elf_info", {"path": path, "bogus": 1}))
+        missing = router.route(self._call("elf_info", {"path": path + ".missing"}))
+        
+        assert unknown["result"]["isError"] is True
+        assert missing["result"]["isError"] is True
+    
+    def test_scan_defaults_to_open_sessions(self, mock_session_manager, make_elf):
+        """idalib_scan without inputs scans the binaries of the open sessions"""
+        path = str(make_elf("a.elf", b"\x90\xc3"))
+        mock_session_manager.list_sessions.return_value = [{"binary_path": path}]
+        router = RequestRouter(mock_session_manager)
+        
+        response = router.route(self._call("idalib_scan", {"patterns": [{"hex": "90 C3"}]}))
+        
+        result = response["result"]["structuredContent"]
+        assert (result["scanned"], result["matched"]) == (1, 1)
+        assert result["results"][0]["matches"][0]["addr"] == "0x400000"
@@ -0,0 +1,108 @@
+"""Tests for scanning binaries for byte patterns and strings"""
+
+import pytest
+import re
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.cancellation import CancelToken
+from ida_pro_proxy_mcp.scan import Scanner, compile_patterns, parse_hex, scan_file
+
+
+CODE = b"\x90\x90\x48\x8b\x05\x10\x20\x30\x40\xe8\x00\x00\x00\x00\xc3"
+
+
+class TestPatterns:
+    """Tests for compiling patterns"""
+    
+    def test_hex_wildcards(self):
+        """Whole-byte and nibble wildcards match any value there"""
+        regex = re.compile(parse_hex("48 8B ?? 1? ?0"), re.DOTALL)
+        
+        assert regex.search(b"\x48\x8b\x05\x10\x20")
+        assert regex.search(b"\x48\x8b\x0a\x1f\x30")
+        assert not regex.search(b"\x48\x8b\x05\x20\x20")
+        assert not regex.search(b"\x48\x8b\x05\x10\x21")
+    
+    def test_compact_hex(self):
+        """Signatures without spaces are split into bytes"""
+        assert parse_hex("488b??") == parse_hex("48 8b ??")
+    
+    def test_invalid_patterns_rejected(self):
+        """Malformed specifications are errors"""
+        for spec in ({"hex": "4G"}, {"regex": "("}, {"string": "a", "hex": "41"}, {}):
+            with pytest.raises(ValueError):
+                compile_patterns([spec])
+
+
+class TestScanFile:
+    """Tests for scanning one file"""
+    
+    def test_matches_mapped_to_addresses(self, make_elf):
+        """ELF matches get the virtual address they are loaded at"""
+        path = make_elf("a.elf", CODE, rodata=b"\0password\0")
+        patterns = compile_patterns([{"hex": "E8 ?? ?? ?? ?? C3", "name": "call-ret"}, {"string": "password"}])
+        
+        result = scan_file(str(path), patterns, max_matches=10)
+        
+        assert [(m["pattern"], m["offset"], m["addr"]) for m in result["matches"]] == [
+            ("call-ret", 0x1000 + 9, "0x400009"),
+            ("string:password", 0x1000 + len(CODE) + 1, hex(0x400000 + len(CODE) + 1)),
+        ]
+    
+    def test_wide_strings_and_regex(self, tmp_path):
+        """UTF-16LE strings and regexes match in any file"""
+        path = tmp_path / "blob.bin"
+        path.write_bytes(b"xx" + "admin".encode("utf-16-le") + b"..user=root;")
+        patterns = compile_patterns([{"string": "admin", "wide": True}, {"regex": r"user=\w+"}])
+        
+        result = scan_file(str(path), patterns, max_matches=10)
+        
+        assert [(m["offset"], m["addr"]) for m in result["matches"]] == [(2, None), (14, None)]
+    
+    def test_max_matches_truncates(self, tmp_path):
+        """At most max_matches matches are reported per pattern"""
+        path = tmp_path / "blob.bin"
+        path.write_bytes(b"\xcc" * 10)
+        
+        result = scan_file(str(path), compile_patterns([{"hex": "CC"}]), max_matches=3)
+        
+        assert len(result["matches"]) == 3
+        assert result["truncated"] is True
+
+
+class TestScanner:
+    """Tests for scanning many files"""
+    
+    def test_parallel_results_in_input_order(self, make_elf):
+        """Files scanned by worker processes come back in input order"""
+        paths = [str(make_elf(f"{i}.elf", CODE * (i + 1))) for i in range(3)]
+        scanner = Scanner(workers=2)
+        scanner.PARALLEL_THRESHOLD = 0
+        streamed = []
+        try:
+            results = scanner.scan(paths, compile_patterns([{"hex": "C3"}]), on_result=streamed.append)
+        finally:
+            scanner.close()
+        
+        assert [r["binary"] for r in results] == paths
+        assert [len(r["matches"]) for r in results] == [1, 2, 3]
+        assert len(streamed) == 3
+    
+    def test_cancelled_scan_skips_files(self, make_elf):
+        """After cancellation, files not yet scanned are reported as skipped"""
+        token = CancelToken()
+        token.cancel("client went away")
+        path = str(make_elf("a.elf", CODE))
+        
+        results = Scanner(workers=1).scan([path], compile_patterns([{"hex": "C3"}]), cancel_token=token)
+        
+        assert "Cancelled" in results[0]["error"]
+    
+    def test_missing_file_reported(self, tmp_path):
+        """Unreadable files get an error instead of failing the scan"""
+        results = Scanner(workers=1).scan([str(tmp_path / "missing")], compile_patterns([{"hex": "C3"}]))
+        
+        assert "error" in results[0]
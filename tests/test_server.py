@@ -0,0 +1,160 @@
+"""Tests for ProxyMcpServer lifecycle"""
+
+import io
+import threading
+import time
+from pathlib import Path
+from unittest.mock import Mock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.models import ProxyConfig
+from ida_pro_proxy_mcp.server import ActiveRequests, EventStream, ProxyHttpHandler, ProxyMcpServer
+from ida_pro_proxy_mcp.session_manager import SessionManager
+
+
+def make_server(**config):
+    """Create a server whose session manager is a mock"""
+    server = ProxyMcpServer(ProxyConfig(**config))
+    server.session_manager = Mock(spec=SessionManager)
+    server.session_manager.list_sessions.return_value = [{"session_id": "test.elf-abc12"}]
+    server.session_manager.session_count = 1
+    return server
+
+
+class TestActiveRequests:
+    """Tests for in-flight request tracking"""
+    
+    def test_wait_idle(self):
+        """wait_idle returns once the last request finishes"""
+        active = ActiveRequests()
+        
+        def request():
+            with active:
+                time.sleep(0.2)
+        
+        thread = threading.Thread(target=request)
+        thread.start()
+        time.sleep(0.05)
+        
+        assert active.count == 1
+        assert active.wait_idle(timeout=0.01) is False
+        assert active.wait_idle(timeout=5) is True
+        thread.join()
+
+
+class TestEventStream:
+    """Tests for streaming messages as server-sent events"""
+    
+    def test_headers_sent_once_with_first_message(self):
+        """The first message sends the SSE headers; each message is one event"""
+        handler = Mock()
+        handler.wfile = io.BytesIO()
+        stream = EventStream(handler)
+        
+        assert not stream.started
+        stream.send({"jsonrpc": "2.0", "method": "notifications/progress"})
+        stream.send({"jsonrpc": "2.0", "id": 1, "result": {}})
+        
+        handler.send_response.assert_called_once_with(200)
+        handler.send_header.assert_any_call("Content-Type", "text/event-stream")
+        events = handler.wfile.getvalue().decode().split("\n\n")
+        assert events[0].startswith("event: message\ndata: {")
+        assert '"id": 1' in events[1]
+        assert handler.close_connection is True
+
+
+class TestDrain:
+    """Tests for graceful drain"""
+    
+    def test_drain_finishes_in_flight_then_shuts_down(self):
+        """Draining refuses new calls, waits for running ones and checkpoints"""
+        server = make_server(drain_grace=5)
+        in_flight_done = threading.Event()
+        
+        def request():
+            with server.active_requests:
+                time.sleep(0.3)
+            in_flight_done.set()
+        
+        threading.Thread(target=request).start()
+        time.sleep(0.05)
+        server.drain()
+        
+        assert server.router.admitting is False
+        assert server.drain_status()["state"] == "draining"
+        assert server._shutdown_done.wait(timeout=5)
+        assert in_flight_done.is_set()
+        
+        status = server.drain_status()
+        assert status["state"] == "stopped"
+        assert status["checkpoints"] == {"test.elf-abc12": "saved"}
+        server.session_manager.checkpoint_session.assert_called_once()
+        server.session_manager.close_all.assert_called_once()
+    
+    def test_drain_gives_up_after_grace(self):
+        """A call outliving the grace period doesn't block shutdown"""
+        server = make_server(drain_grace=0)
+        release = threading.Event()
+        
+        def request():
+            with server.active_requests:
+                release.wait(timeout=5)
+        
+        threading.Thread(target=request).start()
+        time.sleep(0.05)
+        server.drain()
+        
+        assert server._shutdown_done.wait(timeout=5)
+        release.set()
+    
+    def test_failed_checkpoint_reported(self):
+        """A failed checkpoint is reported but doesn't stop the drain"""
+        server = make_server(drain_grace=5)
+        server.session_manager.checkpoint_session.side_effect = RuntimeError("disk full")
+        
+        server.drain()
+        
+        assert server._shutdown_done.wait(timeout=5)
+        assert server.drain_status()["checkpoints"]["test.elf-abc12"].startswith("failed")
+
+
+class TestAdminEndpoints:
+    """Tests for access to the unauthenticated admin endpoints"""
+    
+    def _handler(self, server, path, client):
+        """Create a handler for a request to path from client, without a socket"""
+        handler = ProxyHttpHandler.__new__(ProxyHttpHandler)
+        handler.proxy_server = server
+        handler.path = path
+        handler.client_address = (client, 50000)
+        handler.send_error = Mock()
+        handler._send_json = Mock()
+        return handler
+    
+    def test_off_by_default(self):
+        """Without admin_endpoints the admin paths don't exist, even for local clients"""
+        server = make_server()
+        server.drain = Mock()
+        
+        handler = self._handler(server, "/admin/drain", "127.0.0.1")
+        handler.do_POST()
+        
+        handler.send_error.assert_called_once_with(404, "Not Found")
+        server.drain.assert_not_called()
+    
+    def test_remote_client_refused(self):
+        """With admin_endpoints only loopback clients may drain the proxy"""
+        server = make_server(admin_endpoints=True)
+        server.drain = Mock()
+        
+        handler = self._handler(server, "/admin/drain", "192.0.2.7")
+        handler.do_POST()
+        handler.send_error.assert_called_once_with(403, "Forbidden")
+        server.drain.assert_not_called()
+        
+        for client in ("127.0.0.1", "::1", "::ffff:127.0.0.1"):
+            handler = self._handler(server, "/admin/status", client)
+            handler.do_GET()
+            handler._send_json.assert_called_once()
@@ -1,15 +1,25 @@
 """Tests for SessionManager with LRU"""
 
+import os
 import pytest
 import tempfile
+import threading
+import time
 from pathlib import Path
-from unittest.mock import Mock, MagicMock, patch
+from unittest.mock import Mock, MagicMock, PropertyMock, patch
 
 import sys
 sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
 
+from ida_pro_proxy_mcp.func_index import FunctionIndex
+from ida_pro_proxy_mcp.journal import SessionJournal
+from ida_pro_proxy_mcp.memory import MIB, MemoryUsage
+from ida_pro_proxy_mcp.result_cache import ResultCache
 from ida_pro_proxy_mcp.session_manager import SessionManager
 from ida_pro_proxy_mcp.process_manager import ProcessManager
+from ida_pro_proxy_mcp.rebalancer import Rebalancer
+from ida_pro_proxy_mcp.summary import BinarySummarizer
+from ida_pro_proxy_mcp.watcher import FileWatcher
 
 
 @pytest.fixture
@@ -17,6 +27,7 @@ def mock_process_manager():
     """Create a mock ProcessManager"""
     manager = Mock(spec=ProcessManager)
     manager.process_count = 0
+    manager.active_ports = []
     
     def start_process_side_effect(*args, **kwargs):
         manager.process_count += 1
@@ -95,6 +106,56 @@ class TestSessionOpen:
         
         with pytest.raises(FileNotFoundError):
             manager.open_session("/nonexistent/path/to/binary.elf")
+    
+    def test_failed_open_releases_reservation(self, mock_process_manager, temp_binary):
+        """An open failing in any way frees the port and lets the next open of the content proceed"""
+        manager = SessionManager(max_processes=1, process_manager=mock_process_manager)
+        ok = mock_process_manager.forward_request.return_value
+        mock_process_manager.forward_request.return_value = {
+            "jsonrpc": "2.0", "id": 1, "result": {"content": [{"type": "text", "text": "IDA crashed"}]},
+        }
+        
+        with pytest.raises(RuntimeError, match="IDA crashed"):
+            manager.open_session(str(temp_binary))
+        mock_process_manager.set_session_class.side_effect = OSError("cgroup gone")
+        with pytest.raises(OSError):
+            manager.open_session(str(temp_binary))
+        mock_process_manager.set_session_class.side_effect = None
+        mock_process_manager.forward_request.return_value = ok
+        
+        session = manager.open_session(str(temp_binary))
+        
+        assert manager.get_session(session.session_id) is session
+    
+    def test_process_start_outside_lock(self, mock_process_manager, tmp_path):
+        """Other calls go on while an open waits for its new process to start"""
+        first, second = tmp_path / "first", tmp_path / "second"
+        first.write_bytes(b"\x01" * 16)
+        second.write_bytes(b"\x02" * 16)
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(first))
+        starting, release = threading.Event(), threading.Event()
+        start = mock_process_manager.start_process.side_effect
+        
+        def slow_start(*args, **kwargs):
+            starting.set()
+            release.wait(5)
+            return start(*args, **kwargs)
+        mock_process_manager.start_process.side_effect = slow_start
+        opener = threading.Thread(target=manager.open_session, args=(str(second),))
+        opener.start()
+        try:
+            assert starting.wait(5)
+            found = []
+            lookup = threading.Thread(target=lambda: found.append(manager.get_session(session.session_id)))
+            lookup.start()
+            lookup.join(5)
+            
+            assert found == [session]
+        finally:
+            release.set()
+            opener.join(5)
+        assert manager.session_count == 2
 
 
 class TestLRUEviction:
@@ -294,3 +355,971 @@ class TestProcessCountInvariant:
         
         # Final count should be max_processes
         assert manager.session_count == max_procs
+
+
+class TestSessionRestore:
+    """Tests for restoring sessions onto replacement processes"""
+    
+    def test_restore_keeps_session_id(self, mock_process_manager, temp_binary):
+        """Restoring moves the session to a new process under the same ID"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        old_port = session.process_port
+        
+        restored = manager.restore_session(session.session_id)
+        
+        assert restored.session_id == session.session_id
+        assert mock_process_manager.start_process.call_count == 2
+        assert restored.restoring is False
+        assert manager.get_session(session.session_id) is restored
+        mock_process_manager.stop_process.assert_any_call(old_port)
+    
+    def test_restore_failure_drops_session(self, mock_process_manager, temp_binary):
+        """A session that cannot be reopened is dropped"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        mock_process_manager.forward_request.side_effect = RuntimeError("boom")
+        
+        with pytest.raises(RuntimeError, match="Failed to restore"):
+            manager.restore_session(session.session_id)
+        
+        assert manager.get_session(session.session_id) is None
+        assert manager.get_current_session() is None
+    
+    def test_wedged_process_triggers_restore(self, mock_process_manager, temp_binary):
+        """The breaker's wedged callback restores the owning session"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        old_port = session.process_port
+        
+        with patch('ida_pro_proxy_mcp.session_manager.threading.Thread') as mock_thread:
+            mock_process_manager.on_wedged(old_port)
+            target = mock_thread.call_args.kwargs["target"]
+        target()
+        
+        mock_process_manager.stop_process.assert_any_call(old_port)
+        assert mock_process_manager.start_process.call_count == 2
+        assert manager.get_session(session.session_id) is not None
+    
+    def test_concurrent_restore_waits_for_first(self, mock_process_manager, temp_binary):
+        """A second restore request waits for the one in progress"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        opened = threading.Event()
+        release = threading.Event()
+        original_open = manager._open_binary_on_port
+        
+        def slow_open(*args):
+            opened.set()
+            release.wait(timeout=5)
+            return original_open(*args)
+        
+        manager._open_binary_on_port = slow_open
+        first = threading.Thread(target=manager.restore_session, args=(session.session_id,))
+        first.start()
+        assert opened.wait(timeout=5)
+        
+        results = []
+        second = threading.Thread(
+            target=lambda: results.append(manager.restore_session(session.session_id))
+        )
+        second.start()
+        release.set()
+        first.join(timeout=5)
+        second.join(timeout=5)
+        
+        assert results == [session]
+        assert mock_process_manager.start_process.call_count == 2
+    
+    def test_restore_prefers_idle_process(self, mock_process_manager, temp_binary):
+        """Restoring takes an idle spare process instead of starting one"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        mock_process_manager.active_ports = [9999]
+        mock_process_manager.is_draining.return_value = False
+        
+        restored = manager.restore_session(session.session_id)
+        
+        assert restored.process_port == 9999
+        assert mock_process_manager.start_process.call_count == 1
+
+class TestConcurrentOpen:
+    """Tests for opening binaries from several threads"""
+    
+    def test_pinned_session_not_evicted(self, mock_process_manager, tmp_path):
+        """Eviction skips pinned sessions and takes the next least recently used"""
+        paths = []
+        for i in range(3):
+            path = tmp_path / f"bin{i}"
+            path.write_bytes(b"binary" + bytes([i]))
+            paths.append(str(path))
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        oldest = manager.open_session(paths[0], pin=True)
+        newer = manager.open_session(paths[1])
+        
+        manager.open_session(paths[2])
+        
+        assert manager.get_session(oldest.session_id) is oldest
+        assert manager.get_session(newer.session_id) is None
+    
+    def test_background_session_evicted_first(self, mock_process_manager, tmp_path):
+        """A sweep's session goes before an older interactive one"""
+        paths = []
+        for i in range(3):
+            path = tmp_path / f"bin{i}"
+            path.write_bytes(b"binary" + bytes([i]))
+            paths.append(str(path))
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        interactive = manager.open_session(paths[0])
+        background = manager.open_session(paths[1], session_class="background")
+        mock_process_manager.set_session_class.assert_called_with(background.process_port, "background")
+        
+        manager.open_session(paths[2])
+        
+        assert manager.get_session(interactive.session_id) is interactive
+        assert manager.get_session(background.session_id) is None
+    
+    def test_no_eviction_when_all_pinned(self, mock_process_manager, tmp_path):
+        """With every session pinned, opening another binary fails"""
+        paths = []
+        for i in range(3):
+            path = tmp_path / f"bin{i}"
+            path.write_bytes(b"binary" + bytes([i]))
+            paths.append(str(path))
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        manager.open_session(paths[0], pin=True)
+        manager.open_session(paths[1], pin=True)
+        
+        with pytest.raises(RuntimeError):
+            manager.open_session(paths[2])
+    
+    def test_open_does_not_hold_lock(self, mock_process_manager, temp_binary, tmp_path):
+        """Other sessions stay usable while a binary is being opened"""
+        other = tmp_path / "other.bin"
+        other.write_bytes(b"other")
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        existing = manager.open_session(str(other))
+        opening = threading.Event()
+        release = threading.Event()
+        response = mock_process_manager.forward_request.return_value
+        
+        def slow_open(*args, **kwargs):
+            opening.set()
+            release.wait(timeout=5)
+            return response
+        
+        mock_process_manager.forward_request.side_effect = slow_open
+        thread = threading.Thread(target=manager.open_session, args=(str(temp_binary),))
+        thread.start()
+        assert opening.wait(timeout=5)
+        
+        assert manager.get_session(existing.session_id) is existing
+        release.set()
+        thread.join(timeout=5)
+        assert manager.session_count == 2
+    
+    def test_same_content_opened_once(self, mock_process_manager, temp_binary):
+        """Concurrent opens of one binary share a single open"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        release = threading.Event()
+        response = mock_process_manager.forward_request.return_value
+        
+        def slow_open(*args, **kwargs):
+            release.wait(timeout=5)
+            return response
+        
+        mock_process_manager.forward_request.side_effect = slow_open
+        sessions = []
+        threads = [
+            threading.Thread(target=lambda: sessions.append(manager.open_session(str(temp_binary))))
+            for _ in range(2)
+        ]
+        for thread in threads:
+            thread.start()
+        release.set()
+        for thread in threads:
+            thread.join(timeout=5)
+        
+        assert sessions[0] is sessions[1]
+        assert mock_process_manager.forward_request.call_count == 1
+
+
+class TestContentIdentity:
+    """Tests for identifying sessions by binary content"""
+    
+    def test_same_content_other_path_reuses_session(self, mock_process_manager, tmp_path):
+        """A copy of an open binary maps to the existing session as an alias"""
+        original = tmp_path / "case1" / "firmware.bin"
+        copy = tmp_path / "case2" / "firmware.bin"
+        for path in (original, copy):
+            path.parent.mkdir()
+            path.write_bytes(b"firmware")
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        
+        session = manager.open_session(str(original))
+        again = manager.open_session(str(copy))
+        
+        assert again is session
+        assert session.aliases == [str(copy.resolve())]
+        assert mock_process_manager.start_process.call_count == 1
+        assert manager.get_session_by_binary(str(copy)) is session
+    
+    def test_changed_file_gets_fresh_session(self, mock_process_manager, tmp_path):
+        """A binary replaced in place is not served by its stale session"""
+        path = tmp_path / "firmware.bin"
+        path.write_bytes(b"firmware v1")
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        stale = manager.open_session(str(path))
+        
+        path.write_bytes(b"firmware v2")
+        st = path.stat()
+        os.utime(path, ns=(st.st_atime_ns, st.st_mtime_ns + 1_000_000))
+        fresh = manager.open_session(str(path))
+        
+        assert fresh is not stale
+        assert fresh.content_hash != stale.content_hash
+        assert manager.session_count == 1
+    
+    def test_close_forgets_aliases(self, mock_process_manager, tmp_path):
+        """Closing a session removes its aliases and content hash"""
+        original = tmp_path / "a.bin"
+        copy = tmp_path / "b.bin"
+        original.write_bytes(b"firmware")
+        copy.write_bytes(b"firmware")
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(original))
+        manager.open_session(str(copy))
+        
+        manager.close_session(session.session_id)
+        
+        assert manager.get_session_by_binary(str(copy)) is None
+        assert manager._hash_to_session == {}
+
+
+class TestFileChanges:
+    """Tests for reacting to binaries and databases changing on disk"""
+    
+    def _watched_manager(self, mock_process_manager):
+        watcher = Mock(spec=FileWatcher)
+        cache = ResultCache()
+        manager = SessionManager(
+            max_processes=2,
+            process_manager=mock_process_manager,
+            result_cache=cache,
+            watcher=watcher,
+        )
+        return manager, watcher, cache
+    
+    def test_open_watches_binary_and_database(self, mock_process_manager, temp_binary):
+        """Opening a session watches the binary and its database paths"""
+        manager, watcher, _ = self._watched_manager(mock_process_manager)
+        manager.open_session(str(temp_binary))
+        
+        watched = {c.args[0] for c in watcher.watch.call_args_list}
+        assert str(temp_binary.resolve()) in watched
+        assert str(temp_binary.resolve().with_suffix(".i64")) in watched
+    
+    def test_change_bumps_generation_and_invalidates(self, mock_process_manager, temp_binary):
+        """A changed binary invalidates the session's cached results"""
+        manager, _, cache = self._watched_manager(mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        cache.put(session.session_id, 0, "decompile", {"addr": "0x1"}, {"content": []})
+        
+        manager._on_file_changed(session.binary_path)
+        
+        assert session.generation == 1
+        assert cache.to_dict()["entries"] == 0
+    
+    def test_own_save_ignored(self, mock_process_manager, temp_binary):
+        """Database writes from the session's own checkpoint are not changes"""
+        manager, _, _ = self._watched_manager(mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        mock_process_manager.forward_request.return_value = {"jsonrpc": "2.0", "id": 1, "result": {}}
+        
+        manager.checkpoint_session(session.session_id)
+        manager._on_file_changed(str(Path(session.binary_path).with_suffix(".i64")))
+        
+        assert session.generation == 0
+    
+    def test_changed_alias_dropped(self, mock_process_manager, tmp_path):
+        """An alias whose file changed no longer maps to the session"""
+        original = tmp_path / "a.bin"
+        copy = tmp_path / "b.bin"
+        original.write_bytes(b"firmware")
+        copy.write_bytes(b"firmware")
+        manager, watcher, _ = self._watched_manager(mock_process_manager)
+        session = manager.open_session(str(original))
+        manager.open_session(str(copy))
+        
+        manager._on_file_changed(str(copy.resolve()))
+        
+        assert session.aliases == []
+        assert session.generation == 0
+        watcher.unwatch.assert_called_with(str(copy.resolve()))
+    
+    def test_close_unwatches(self, mock_process_manager, temp_binary):
+        """Closing a session stops watching its files"""
+        manager, watcher, _ = self._watched_manager(mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        
+        manager.close_session(session.session_id)
+        
+        assert manager._watched == {}
+        assert watcher.unwatch.call_count == 3
+
+
+class TestFunctionIndexHooks:
+    """Tests for keeping the function index in step with sessions"""
+    
+    def test_index_follows_session_lifecycle(self, mock_process_manager, temp_binary):
+        """Opening, changing and closing a session are reported to the index"""
+        index = Mock(spec=FunctionIndex)
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager, index=index)
+        
+        session = manager.open_session(str(temp_binary))
+        manager.bump_generation(session.session_id)
+        manager.close_session(session.session_id)
+        
+        index.session_opened.assert_called_once_with(session)
+        index.session_changed.assert_called_once_with(session)
+        index.session_closed.assert_called_once_with(session)
+
+
+class TestSummaries:
+    """Tests for gathering binary summaries at open time"""
+    
+    def test_summary_gathered_at_open_and_dropped_on_change(self, mock_process_manager, temp_binary):
+        """A new session gets a summary; a database change drops it until it is asked for again"""
+        summarizer = Mock(spec=BinarySummarizer)
+        summarizer.build.return_value = {"function_count": 3}
+        manager = SessionManager(
+            max_processes=2, process_manager=mock_process_manager, summarizer=summarizer
+        )
+        
+        session = manager.open_session(str(temp_binary))
+        assert session.summary == {"function_count": 3}
+        
+        manager.bump_generation(session.session_id)
+        assert session.summary is None
+        summarizer.invalidate.assert_called_once_with(session.content_hash)
+        
+        assert manager.summarize(session.session_id) == {"function_count": 3}
+        assert summarizer.build.call_count == 2
+    
+    def test_failed_summary_does_not_fail_open(self, mock_process_manager, temp_binary):
+        """The open succeeds without a summary if gathering it fails"""
+        summarizer = Mock(spec=BinarySummarizer)
+        summarizer.build.side_effect = RuntimeError("batch failed")
+        manager = SessionManager(
+            max_processes=2, process_manager=mock_process_manager, summarizer=summarizer
+        )
+        
+        session = manager.open_session(str(temp_binary))
+        
+        assert session.summary is None
+        assert manager.get_session(session.session_id) is session
+
+
+class TestMemoryAdmission:
+    """Tests for admitting opens by memory"""
+    
+    @pytest.fixture
+    def pss(self, mock_process_manager):
+        """PSS of each process; an open makes its process take 600 MiB"""
+        pss = {}
+        type(mock_process_manager).active_ports = PropertyMock(side_effect=lambda: list(pss))
+        mock_process_manager.is_draining.return_value = False
+        mock_process_manager.cgroup_usage.return_value = None
+        mock_process_manager.sample_memory.side_effect = (
+            lambda port, max_age=None: MemoryUsage(pss.get(port, 0), pss.get(port, 0), 0.0)
+        )
+        opened = mock_process_manager.forward_request.return_value
+        
+        def forward_request(port, request, timeout=None, **kwargs):
+            name = request["params"]["name"]
+            pss[port] = 600 * MIB if name == "idalib_open" else 100 * MIB
+            return opened
+        mock_process_manager.forward_request.side_effect = forward_request
+        return pss
+    
+    def _binaries(self, tmp_path, count):
+        paths = []
+        for i in range(count):
+            path = tmp_path / f"bin{i}"
+            path.write_bytes(b"binary" + bytes([i]))
+            paths.append(str(path))
+        return paths
+    
+    def test_lru_evicted_to_fit_budget(self, mock_process_manager, pss, tmp_path):
+        """An open that would exceed the budget evicts the LRU session and reuses its process"""
+        paths = self._binaries(tmp_path, 3)
+        manager = SessionManager(
+            max_processes=4, process_manager=mock_process_manager, memory_budget=1000 * MIB
+        )
+        first = manager.open_session(paths[0])
+        second = manager.open_session(paths[1])
+        assert first.memory == 600 * MIB
+        
+        third = manager.open_session(paths[2])
+        
+        assert manager.get_session(first.session_id) is None
+        assert manager.get_session(second.session_id) is second
+        assert third.process_port == first.process_port
+        assert mock_process_manager.process_count == 2
+        assert manager.memory_evictions == 1
+        assert manager.list_sessions()[0]["memory_mb"] == 600
+    
+    def test_refused_when_host_memory_short(self, mock_process_manager, pss, temp_binary):
+        """Without sessions to evict, an open that doesn't leave the reserve free is refused"""
+        manager = SessionManager(
+            max_processes=2, process_manager=mock_process_manager, memory_reserve=512 * MIB
+        )
+        
+        with patch("ida_pro_proxy_mcp.session_manager.mem_available", return_value=256 * MIB):
+            with pytest.raises(RuntimeError, match="Not enough memory"):
+                manager.open_session(str(temp_binary))
+        
+        assert manager.memory_refusals == 1
+        mock_process_manager.start_process.assert_not_called()
+    
+    def test_pending_open_counted(self, mock_process_manager, pss, tmp_path):
+        """The predicted memory of an open in progress counts against the budget"""
+        paths = self._binaries(tmp_path, 2)
+        manager = SessionManager(
+            max_processes=2, process_manager=mock_process_manager, memory_budget=100 * MIB
+        )
+        entered = threading.Event()
+        release = threading.Event()
+        opened = mock_process_manager.forward_request.return_value
+        
+        def slow_open(port, request, timeout=None, **kwargs):
+            entered.set()
+            release.wait(5)
+            return opened
+        mock_process_manager.forward_request.side_effect = slow_open
+        opener = threading.Thread(target=manager.open_session, args=(paths[0],))
+        opener.start()
+        try:
+            assert entered.wait(5)
+            with pytest.raises(RuntimeError, match="Not enough memory"):
+                manager.open_session(paths[1])
+        finally:
+            release.set()
+            opener.join(5)
+        
+        assert manager.memory_to_dict()["pending_mb"] == 0
+
+
+class TestPacking:
+    """Tests for packing small binaries into shared processes"""
+    
+    @pytest.fixture
+    def children(self, mock_process_manager):
+        """Children that hand out a new IDA session ID per open"""
+        type(mock_process_manager).active_ports = PropertyMock(
+            side_effect=lambda: [8745 + i for i in range(mock_process_manager.process_count)]
+        )
+        mock_process_manager.is_draining.return_value = False
+        mock_process_manager.queue_depth.return_value = 0
+        mock_process_manager.session_switches = 0
+        opens = []
+        
+        def forward_request(port, request, timeout=None, **kwargs):
+            name = request["params"]["name"]
+            if name == "idalib_open":
+                opens.append(port)
+            return {
+                "jsonrpc": "2.0",
+                "id": 1,
+                "result": {"success": True, "session": {"session_id": f"s{len(opens)}"}},
+            }
+        mock_process_manager.forward_request.side_effect = forward_request
+        return opens
+    
+    def _binaries(self, tmp_path, sizes):
+        paths = []
+        for i, size in enumerate(sizes):
+            path = tmp_path / f"bin{i}"
+            path.write_bytes(bytes([i]) * size)
+            paths.append(str(path))
+        return paths
+    
+    def test_small_binaries_share_a_process(self, mock_process_manager, children, tmp_path):
+        """Small binaries go to a shared process until it is full"""
+        paths = self._binaries(tmp_path, [16, 16, 16])
+        manager = SessionManager(
+            max_processes=4, process_manager=mock_process_manager,
+            pack_binary_size=MIB, pack_max_sessions=2, pack_max_load=3,
+        )
+        
+        sessions = [manager.open_session(path) for path in paths]
+        
+        assert [s.process_port for s in sessions] == [8745, 8745, 8746]
+        assert mock_process_manager.start_process.call_count == 2
+        assert [s["process_sessions"] for s in manager.list_sessions()] == [2, 2, 1]
+        assert manager.packed_opens == 1
+        assert manager.packing_to_dict()["processes"]["8745"]["sessions"] == [
+            sessions[0].session_id, sessions[1].session_id
+        ]
+    
+    def test_restore_leaves_shared_process_running(self, mock_process_manager, children, tmp_path):
+        """Restoring one packed session closes only its IDA session and keeps the others' process"""
+        paths = self._binaries(tmp_path, [16, 16])
+        manager = SessionManager(
+            max_processes=4, process_manager=mock_process_manager,
+            pack_binary_size=MIB, pack_max_sessions=2, pack_max_load=3,
+        )
+        first, second = [manager.open_session(path) for path in paths]
+        assert first.process_port == second.process_port == 8745
+        
+        manager.restore_session(first.session_id)
+        
+        mock_process_manager.stop_process.assert_not_called()
+        closes = [
+            (call.args[0], call.args[1]["params"]["arguments"]["session_id"])
+            for call in mock_process_manager.forward_request.call_args_list
+            if call.args[1]["params"]["name"] == "idalib_close"
+        ]
+        assert closes == [(8745, "s1")]
+        assert first.process_port == 8746
+        assert second.process_port == 8745
+        assert manager.port_sessions() == {8745: [second.session_id], 8746: [first.session_id]}
+    
+    def test_busy_process_not_packed(self, mock_process_manager, children, tmp_path):
+        """A process whose queued calls and recently used sessions reach the load bound takes no more"""
+        paths = self._binaries(tmp_path, [16, 16])
+        manager = SessionManager(
+            max_processes=4, process_manager=mock_process_manager,
+            pack_binary_size=MIB, pack_max_load=2,
+        )
+        mock_process_manager.queue_depth.return_value = 1
+        
+        first = manager.open_session(paths[0])
+        second = manager.open_session(paths[1])
+        
+        assert first.process_port != second.process_port
+        assert manager.packed_opens == 0
+    
+    def test_large_binary_evicts_whole_shared_process(self, mock_process_manager, children, tmp_path):
+        """A process shared by small binaries is reused only once all of them are evicted"""
+        paths = self._binaries(tmp_path, [16, 16, 4096])
+        manager = SessionManager(
+            max_processes=1, process_manager=mock_process_manager,
+            pack_binary_size=1024, pack_max_load=3,
+        )
+        small = [manager.open_session(path) for path in paths[:2]]
+        
+        large = manager.open_session(paths[2])
+        
+        assert all(manager.get_session(s.session_id) is None for s in small)
+        assert large.process_port == 8745
+        assert manager.packing_to_dict()["processes"]["8745"]["shared"] is False
+        closed = [
+            c.args[1]["params"]["arguments"]["session_id"]
+            for c in mock_process_manager.forward_request.call_args_list
+            if c.args[1]["params"]["name"] == "idalib_close"
+        ]
+        assert closed == ["s1", "s2"]
+
+
+class TestCheckpoint:
+    """Tests for saving session databases"""
+    
+    def test_checkpoint_sends_save(self, mock_process_manager, temp_binary):
+        """Checkpointing asks the session's process to save its database"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        
+        manager.checkpoint_session(session.session_id)
+        
+        call = mock_process_manager.forward_request.call_args
+        assert call.args[0] == session.process_port
+        assert call.args[1]["params"]["name"] == "idalib_save"
+    
+    def test_checkpoint_error_raised(self, mock_process_manager, temp_binary):
+        """A save the process reports as failed raises"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        mock_process_manager.forward_request.return_value = {
+            "jsonrpc": "2.0", "id": 1, "result": {"isError": True, "content": []}
+        }
+        
+        with pytest.raises(RuntimeError, match="idalib_save failed"):
+            manager.checkpoint_session(session.session_id)
+
+
+class TestJournal:
+    """Tests for journaling sessions and resuming them after a restart"""
+    
+    def _adopt_all(self, mock_process_manager):
+        def adopt(record, **kwargs):
+            info = MagicMock()
+            info.port = record["port"]
+            info.current_ida_session = record["current_ida_session"]
+            return info
+        mock_process_manager.adopt_process.side_effect = adopt
+    
+    def _journaled_manager(self, mock_process_manager, temp_binary, tmp_path):
+        journal = SessionJournal(str(tmp_path / "sessions.json"))
+        manager = SessionManager(
+            max_processes=2, process_manager=mock_process_manager, journal=journal
+        )
+        session = manager.open_session(str(temp_binary))
+        # What the real process manager would have journaled
+        mock_process_manager.export_processes.return_value = [{
+            "port": session.process_port,
+            "pid": 4242,
+            "binary_path": session.binary_path,
+            "started_at": "2026-01-01T00:00:00",
+            "current_ida_session": session.ida_session_id,
+            "is_default": False,
+        }]
+        manager.switch_session(session.session_id)
+        return journal, session
+    
+    def test_open_session_is_journaled(self, mock_process_manager, temp_binary, tmp_path):
+        """Opening a session writes it to the journal"""
+        mock_process_manager.export_processes.return_value = []
+        journal, session = self._journaled_manager(mock_process_manager, temp_binary, tmp_path)
+        
+        state = journal.read()
+        
+        assert state["current_session_id"] == session.session_id
+        assert state["sessions"][0]["process_port"] == session.process_port
+        assert state["processes"][0]["pid"] == 4242
+    
+    def test_resume_reattaches_running_child(self, mock_process_manager, temp_binary, tmp_path):
+        """A restarted manager resumes sessions on adopted children"""
+        mock_process_manager.export_processes.return_value = []
+        journal, session = self._journaled_manager(mock_process_manager, temp_binary, tmp_path)
+        self._adopt_all(mock_process_manager)
+        
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager, journal=journal)
+        resumed = manager.resume_from_journal()
+        
+        assert resumed == 1
+        restored = manager.get_current_session()
+        assert restored.session_id == session.session_id
+        assert restored.process_port == session.process_port
+        assert manager.get_session_by_binary(str(temp_binary)) is restored
+        assert mock_process_manager.start_process.call_count == 1
+    
+    def test_resume_reopens_session_of_dead_child(self, mock_process_manager, temp_binary, tmp_path):
+        """A session whose child is gone is reopened under the same ID"""
+        mock_process_manager.export_processes.return_value = []
+        journal, session = self._journaled_manager(mock_process_manager, temp_binary, tmp_path)
+        mock_process_manager.adopt_process.return_value = None
+        
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager, journal=journal)
+        with patch('ida_pro_proxy_mcp.session_manager.threading.Thread') as mock_thread:
+            resumed = manager.resume_from_journal()
+            kwargs = mock_thread.call_args.kwargs
+        kwargs["target"](*kwargs["args"])
+        
+        assert resumed == 0
+        assert mock_process_manager.start_process.call_count == 2
+        assert manager.get_session(session.session_id).restoring is False
+
+
+class TestReplicas:
+    """Tests for read-only session replicas"""
+    
+    def test_add_replica_uses_private_copy(self, mock_process_manager, temp_binary):
+        """A replica opens a private copy of the binary on another process"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        
+        replica = manager.add_replica(session.session_id)
+        
+        assert replica is not None
+        assert replica.port != session.process_port
+        assert session.replicas == [replica]
+        opened_path = mock_process_manager.forward_request.call_args.args[1]["params"]["arguments"]["input_path"]
+        assert opened_path.startswith(replica.work_dir)
+        assert Path(opened_path).read_bytes() == temp_binary.read_bytes()
+    
+    def test_add_replica_never_evicts(self, mock_process_manager, temp_binary):
+        """No replica is added when the pool is full"""
+        manager = SessionManager(max_processes=1, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        
+        assert manager.add_replica(session.session_id) is None
+        assert manager.session_count == 1
+    
+    def test_close_session_removes_replica_copy(self, mock_process_manager, temp_binary):
+        """Closing a session closes its replicas and deletes their copies"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        replica = manager.add_replica(session.session_id)
+        
+        manager.close_session(session.session_id)
+        
+        assert not Path(replica.work_dir).exists()
+    
+    def test_replica_process_start_outside_lock(self, mock_process_manager, temp_binary):
+        """Sessions can be looked up while a replica waits for its new process"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        starting, release = threading.Event(), threading.Event()
+        start = mock_process_manager.start_process.side_effect
+        
+        def slow_start(*args, **kwargs):
+            starting.set()
+            release.wait(5)
+            return start(*args, **kwargs)
+        mock_process_manager.start_process.side_effect = slow_start
+        adding = threading.Thread(target=manager.add_replica, args=(session.session_id,))
+        adding.start()
+        try:
+            assert starting.wait(5)
+            found = []
+            lookup = threading.Thread(target=lambda: found.append(manager.get_session(session.session_id)))
+            lookup.start()
+            lookup.join(5)
+            
+            assert found == [session]
+        finally:
+            release.set()
+            adding.join(5)
+        assert [replica.port for replica in session.replicas] == [8746]
+    
+    def test_write_drops_stale_replica(self, mock_process_manager, temp_binary):
+        """A replica opened before a write is no longer used and gets closed"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        replica = manager.add_replica(session.session_id)
+        
+        manager.bump_generation(session.session_id)
+        
+        assert session.replicas == []
+        deadline = time.monotonic() + 5
+        while Path(replica.work_dir).exists() and time.monotonic() < deadline:
+            time.sleep(0.01)
+        assert not Path(replica.work_dir).exists()
+
+
+class TestMigration:
+    """Tests for moving sessions between processes"""
+    
+    @pytest.fixture
+    def children(self, mock_process_manager):
+        """Children that hand out a new IDA session ID per open and record every call"""
+        type(mock_process_manager).active_ports = PropertyMock(
+            side_effect=lambda: [8745 + i for i in range(mock_process_manager.process_count)]
+        )
+        mock_process_manager.is_draining.return_value = False
+        mock_process_manager.queue_depth.return_value = 0
+        mock_process_manager.session_switches = 0
+        calls = []
+        
+        def forward_request(port, request, timeout=None, **kwargs):
+            name = request["params"]["name"]
+            calls.append((port, name, request["params"]["arguments"]))
+            opens = sum(1 for call in calls if call[1] == "idalib_open")
+            return {
+                "jsonrpc": "2.0",
+                "id": 1,
+                "result": {"success": True, "session": {"session_id": f"s{opens}"}},
+            }
+        mock_process_manager.forward_request.side_effect = forward_request
+        return calls
+    
+    def test_migrate_switches_process(self, mock_process_manager, children, temp_binary):
+        """The session moves to a private copy on a new process and is closed on the old one"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        
+        migrated = manager.migrate_session(session.session_id)
+        
+        assert migrated is session
+        assert (session.process_port, session.ida_session_id) == (8746, "s2")
+        assert [(port, name) for port, name, _ in children] == [
+            (8745, "idalib_open"), (8745, "idalib_save"), (8746, "idalib_open"), (8745, "idalib_close"),
+        ]
+        assert children[2][2]["input_path"].startswith(session.work_dir)
+        assert children[3][2] == {"session_id": "s1"}
+        assert manager.port_sessions() == {8746: [session.session_id]}
+        assert manager.migrations == 1
+        
+        work_dir = session.work_dir
+        manager.close_session(session.session_id)
+        assert not Path(work_dir).exists()
+    
+    def test_old_session_closed_once_its_calls_finish(self, mock_process_manager, children, temp_binary):
+        """A call routed to the old process before the switch keeps its IDA session until it ends"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        route = manager.route(session)
+        assert route.__enter__() == (8745, "s1")
+        migration = threading.Thread(target=manager.migrate_session, args=(session.session_id,))
+        
+        migration.start()
+        migration.join(timeout=0.5)
+        
+        assert migration.is_alive()
+        with manager.route(session) as new_route:
+            assert new_route == (8746, "s2")
+        assert "idalib_close" not in [name for _, name, _ in children]
+        route.__exit__(None, None, None)
+        migration.join(timeout=5)
+        assert children[-1] == (8745, "idalib_close", {"session_id": "s1"})
+    
+    def test_rebalancing_start_doesnt_block_routing(self, mock_process_manager, children, tmp_path):
+        """While a rebalancing move waits for its new process, calls to other sessions are routed"""
+        paths = []
+        for i, size in enumerate([16, 16, 2 * MIB]):
+            path = tmp_path / f"bin{i}"
+            path.write_bytes(bytes([i]) * size)
+            paths.append(str(path))
+        manager = SessionManager(
+            max_processes=3, process_manager=mock_process_manager,
+            pack_binary_size=MIB, pack_max_sessions=2, pack_max_load=10,
+        )
+        first, second, alone = [manager.open_session(path) for path in paths]
+        assert (first.process_port, second.process_port, alone.process_port) == (8745, 8745, 8746)
+        mock_process_manager.queue_depth.side_effect = {8745: 6, 8746: 0}.get
+        starting, release = threading.Event(), threading.Event()
+        start = mock_process_manager.start_process.side_effect
+        
+        def slow_start(*args, **kwargs):
+            starting.set()
+            release.wait(5)
+            return start(*args, **kwargs)
+        mock_process_manager.start_process.side_effect = slow_start
+        rebalancer = Rebalancer(manager, interval=3600, threshold=2.0)
+        ticking = threading.Thread(target=rebalancer.tick)
+        ticking.start()
+        try:
+            assert starting.wait(5)
+            routed = []
+            
+            def route():
+                with manager.route(alone) as key:
+                    routed.append(key)
+            routing = threading.Thread(target=route)
+            routing.start()
+            routing.join(5)
+            
+            assert routed == [(8746, "s3")]
+        finally:
+            release.set()
+            ticking.join(5)
+            rebalancer.close()
+        assert {first.process_port, second.process_port} == {8745, 8747}
+        assert rebalancer.migrations == 1
+    
+    def test_write_during_copy_aborts(self, mock_process_manager, children, temp_binary):
+        """A call that may modify the database while the copy opens abandons the migration"""
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(temp_binary))
+        forward = mock_process_manager.forward_request.side_effect
+        
+        def forward_request(port, request, timeout=None, **kwargs):
+            if request["params"]["name"] == "idalib_open" and port == 8746:
+                manager.begin_write(session.session_id)
+            return forward(port, request, timeout, **kwargs)
+        mock_process_manager.forward_request.side_effect = forward_request
+        
+        with pytest.raises(RuntimeError, match="modified"):
+            manager.migrate_session(session.session_id)
+        
+        assert (session.process_port, session.ida_session_id) == (8745, "s1")
+        assert not session.migrating
+        assert children[-1] == (8746, "idalib_close", {"session_id": "s2"})
+        mock_process_manager.stop_process.assert_called_once_with(8746)
+        assert manager.migration_failures == 1
+    
+    def test_checkpoint_copies_database_back(self, mock_process_manager, children, tmp_path):
+        """After a migration, a save brings the database next to the binary up to date"""
+        binary = tmp_path / "target"
+        binary.write_bytes(b"\x7fELF")
+        binary.with_suffix(".i64").write_bytes(b"old")
+        manager = SessionManager(max_processes=2, process_manager=mock_process_manager)
+        session = manager.open_session(str(binary))
+        manager.migrate_session(session.session_id)
+        copy = Path(session.work_dir) / "target.i64"
+        assert copy.read_bytes() == b"old"
+        
+        copy.write_bytes(b"new")
+        manager.checkpoint_session(session.session_id)
+        
+        assert binary.with_suffix(".i64").read_bytes() == b"new"
+
+
+class TestHibernation:
+    """Tests for keeping evicted sessions warm or cold"""
+    
+    @pytest.fixture
+    def children(self, mock_process_manager):
+        """Children that hand out a new IDA session ID per open and record every call"""
+        type(mock_process_manager).active_ports = PropertyMock(
+            side_effect=lambda: [8745 + i for i in range(mock_process_manager.process_count)]
+        )
+        mock_process_manager.is_draining.return_value = False
+        mock_process_manager.queue_depth.return_value = 0
+        mock_process_manager.session_switches = 0
+        calls = []
+        
+        def forward_request(port, request, timeout=None, **kwargs):
+            calls.append(request["params"]["name"])
+            return {
+                "jsonrpc": "2.0",
+                "id": 1,
+                "result": {"success": True, "session": {"session_id": f"s{calls.count('idalib_open')}"}},
+            }
+        mock_process_manager.forward_request.side_effect = forward_request
+        return calls
+    
+    def _binaries(self, tmp_path, count):
+        paths = []
+        for i in range(count):
+            path = tmp_path / f"bin{i}"
+            path.write_bytes(bytes([i]) * 16)
+            paths.append(str(path))
+        return paths
+    
+    def test_evicted_session_kept_warm(self, mock_process_manager, children, tmp_path):
+        """An evicted session is saved, keeps its cached results, and comes back under its ID"""
+        paths = self._binaries(tmp_path, 2)
+        cache = ResultCache()
+        manager = SessionManager(
+            max_processes=1, process_manager=mock_process_manager, result_cache=cache, warm_sessions=2,
+        )
+        first = manager.open_session(paths[0])
+        cache.put(first.session_id, first.generation, "decompile", {"addr": "0x10"}, {"content": []})
+        
+        manager.open_session(paths[1])
+        
+        assert children[:4] == ["idalib_open", "idalib_save", "idalib_close", "idalib_open"]
+        assert manager.get_session(first.session_id) is None
+        assert manager.get_hibernated(first.session_id) is first
+        assert [s["tier"] for s in manager.list_sessions()] == ["hot", "warm"]
+        assert cache.get(first.session_id, first.generation, "decompile", {"addr": "0x10"}) is not None
+        
+        reopened = manager.wake_session(first.session_id)
+        
+        assert reopened is first
+        assert first.tier == "hot"
+        assert manager.get_session(first.session_id) is first
+        assert manager.hibernation_to_dict()["wakes"] == 1
+    
+    def test_oldest_warm_session_turns_cold(self, mock_process_manager, children, tmp_path):
+        """Past warm_sessions, the oldest hibernated session loses its results and summary"""
+        paths = self._binaries(tmp_path, 3)
+        cache = ResultCache()
+        manager = SessionManager(
+            max_processes=1, process_manager=mock_process_manager, result_cache=cache, warm_sessions=1,
+        )
+        first = manager.open_session(paths[0])
+        first.summary = {"functions": 1}
+        cache.put(first.session_id, first.generation, "decompile", {"addr": "0x10"}, {"content": []})
+        second = manager.open_session(paths[1])
+        
+        manager.open_session(paths[2])
+        
+        assert (first.tier, second.tier) == ("cold", "warm")
+        assert first.summary is None
+        assert cache.get(first.session_id, first.generation, "decompile", {"addr": "0x10"}) is None
+        assert manager.hibernation_to_dict()["cold"] == 1
+        assert manager.close_session(first.session_id)
+        assert manager.get_hibernated(first.session_id) is None
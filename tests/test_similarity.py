@@ -0,0 +1,131 @@
+"""Tests for function similarity search"""
+
+import hashlib
+import os
+import pytest
+import random
+from pathlib import Path
+from unittest.mock import Mock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.func_index import FUNCTION, BinaryIndex, FunctionIndex, SymbolTable
+from ida_pro_proxy_mcp.similarity import SimilarityIndex, fingerprint, similarity
+
+
+def _functions(seed, count=8, size=96):
+    rng = random.Random(seed)
+    return [bytes(rng.randrange(256) for _ in range(size)) for _ in range(count)]
+
+
+def _entry(path, funcs, vaddr=0x400000, session_id="s1"):
+    symbols = []
+    addr = vaddr
+    for i, code in enumerate(funcs):
+        symbols.append((f"sub_{i}", addr, len(code), ""))
+        addr += len(code)
+    return BinaryIndex(
+        content_hash=hashlib.sha256(Path(path).read_bytes()).hexdigest(),
+        binary_path=str(path),
+        session_id=session_id,
+        generation=0,
+        tables={FUNCTION: SymbolTable(symbols)},
+    )
+
+
+@pytest.fixture
+def corpus(make_elf):
+    """Two builds sharing a lightly patched function, and an unrelated binary"""
+    base = _functions(1)
+    patched = list(base)
+    patched[3] = patched[3][:40] + b"\xcc\xcc" + patched[3][42:]
+    paths = [
+        make_elf("v1.elf", b"".join(base)),
+        make_elf("v2.elf", b"".join(patched)),
+        make_elf("other.elf", b"".join(_functions(2))),
+    ]
+    return [_entry(paths[0], base), _entry(paths[1], patched, session_id=None),
+            _entry(paths[2], _functions(2), session_id="s3")]
+
+
+@pytest.fixture
+def index(corpus):
+    """Create a similarity index over the corpus, fingerprinted synchronously"""
+    function_index = Mock(spec=FunctionIndex)
+    function_index.entries.return_value = corpus
+    index = SimilarityIndex(function_index, workers=1)
+    for entry in corpus:
+        index._build(entry)
+    yield index
+    index.close()
+
+
+class TestFingerprint:
+    """Tests for MinHash fingerprints"""
+    
+    def test_similar_bytes_score_high(self):
+        """A small patch keeps most of the fingerprint; unrelated bytes share none"""
+        code = os.urandom(300)
+        patched = code[:100] + os.urandom(8) + code[108:]
+        
+        assert similarity(fingerprint(code), fingerprint(patched)) > 0.7
+        assert similarity(fingerprint(code), fingerprint(os.urandom(300))) < 0.2
+    
+    def test_short_function_densified(self):
+        """Short functions still fill every value"""
+        values = fingerprint(os.urandom(20))
+        
+        assert len(values) == 64
+        assert 0xFFFFFFFF not in values
+
+
+class TestSimilarityIndex:
+    """Tests for top-k queries"""
+    
+    def test_patched_variant_found(self, index, corpus):
+        """The patched copy of a function ranks first across binaries"""
+        result = index.similar(corpus[0].content_hash, name="sub_3")
+        
+        best = result["matches"][0]
+        assert best["binary"] == corpus[1].binary_path
+        assert best["name"] == "sub_3"
+        assert best["similarity"] > 0.7
+        assert all(m["binary"] != corpus[2].binary_path for m in result["matches"])
+    
+    def test_closed_binaries_excluded_on_request(self, index, corpus):
+        """Binaries no longer open can be left out"""
+        result = index.similar(corpus[0].content_hash, addr=0x400000 + 3 * 96, include_closed=False)
+        
+        assert result["function"]["name"] == "sub_3"
+        assert result["count"] == 0
+    
+    def test_unknown_function_rejected(self, index, corpus):
+        """Querying a function that was not fingerprinted is an error"""
+        with pytest.raises(ValueError):
+            index.similar(corpus[0].content_hash, addr=0x123)
+    
+    def test_refresh_reuses_unchanged(self, index, corpus, caplog):
+        """Refreshing a binary's index only fingerprints changed functions"""
+        caplog.set_level("INFO")
+        
+        index._build(corpus[0])
+        
+        assert "(8 reused)" in caplog.text
+    
+    def test_parallel_matches_serial(self, corpus):
+        """Fingerprints from the worker processes equal in-process ones"""
+        function_index = Mock(spec=FunctionIndex)
+        function_index.entries.return_value = corpus
+        serial = SimilarityIndex(function_index, workers=1)
+        parallel = SimilarityIndex(function_index, workers=2)
+        parallel.PARALLEL_THRESHOLD = 1
+        try:
+            serial._build(corpus[0])
+            parallel._build(corpus[0])
+            
+            assert parallel._binaries[corpus[0].content_hash].values == \
+                serial._binaries[corpus[0].content_hash].values
+        finally:
+            serial.close()
+            parallel.close()
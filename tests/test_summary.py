@@ -0,0 +1,117 @@
+"""Tests for binary summaries"""
+
+import json
+import pytest
+from pathlib import Path
+from unittest.mock import Mock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.models import ProxySession
+from ida_pro_proxy_mcp.process_manager import ProcessManager
+from ida_pro_proxy_mcp.summary import BinarySummarizer
+
+
+def _response(data, error=False):
+    result = {"content": [{"type": "text", "text": json.dumps(data)}]}
+    if error:
+        result["isError"] = True
+    return {"jsonrpc": "2.0", "id": 0, "result": result}
+
+
+CHILD_RESULTS = {
+    "list_funcs": [{"data": [
+        {"name": "main", "addr": "0x401000", "size": "0x40"},
+        {"name": "parse_config", "addr": "0x401040", "size": "0x200"},
+        {"name": "sub_401240", "addr": "0x401240", "size": "0x10"},
+    ], "next_offset": None}],
+    "entrypoints": [{"name": "_start", "addr": "0x400ff0"}],
+    "imports": {"data": [
+        {"imported_name": "printf", "module": "libc.so.6", "addr": "0x403000"},
+        {"imported_name": "fopen", "module": "libc.so.6", "addr": "0x403008"},
+        {"imported_name": "SSL_read", "module": "libssl.so.3", "addr": "0x403010"},
+    ], "next_offset": None},
+    "strings": [{"data": [
+        {"addr": "0x402000", "string": "hello"},
+        {"addr": "0x402010", "string": "/etc/app.conf"},
+        {"addr": "0x402020", "string": "bad password for %s"},
+    ], "next_offset": None}],
+}
+
+
+@pytest.fixture
+def process_manager():
+    """Mock process manager answering the summary batch"""
+    manager = Mock(spec=ProcessManager)
+    
+    def forward_batch(port, requests, timeout=None, ida_session=None):
+        return [_response(CHILD_RESULTS[r["params"]["name"]]) for r in requests]
+    manager.forward_batch.side_effect = forward_batch
+    return manager
+
+
+@pytest.fixture
+def session(make_elf):
+    """Session of a small ELF binary"""
+    path = make_elf("app.elf", b"\x90" * 64, needed=["libc.so.6"])
+    session = ProxySession.create(str(path), 8745, "abcd")
+    session.content_hash = "hash-1"
+    return session
+
+
+class TestBinarySummarizer:
+    """Tests for gathering and caching summaries"""
+    
+    def test_summary_built_from_one_batch(self, process_manager, session):
+        """Functions, entry points, imports and strings come from a single batch"""
+        summarizer = BinarySummarizer(process_manager)
+        
+        summary = summarizer.build(session)
+        
+        process_manager.forward_batch.assert_called_once()
+        assert summary["function_count"] == 3
+        assert summary["largest_functions"][0] == {"name": "parse_config", "addr": "0x401040", "size": 0x200}
+        assert summary["entry_points"] == [{"name": "_start", "addr": "0x400ff0"}]
+        assert summary["import_count"] == 3
+        assert summary["import_modules"] == {"libc.so.6": 2, "libssl.so.3": 1}
+        assert [s["string"] for s in summary["interesting_strings"]] == [
+            "/etc/app.conf", "bad password for %s"
+        ]
+        assert summary["file"]["needed"] == ["libc.so.6"]
+        assert ".text" in [s["name"] for s in summary["file"]["sections"]]
+        assert "errors" not in summary
+    
+    def test_summary_cached_by_content_hash(self, process_manager, session):
+        """A session with the same content reuses the summary without a child call"""
+        summarizer = BinarySummarizer(process_manager)
+        summarizer.build(session)
+        
+        reopened = ProxySession.create(session.binary_path, 8746, "ef01")
+        reopened.content_hash = session.content_hash
+        summarizer.build(reopened)
+        
+        assert process_manager.forward_batch.call_count == 1
+        assert summarizer.to_dict()["hits"] == 1
+        
+        summarizer.invalidate(session.content_hash)
+        summarizer.build(reopened)
+        assert process_manager.forward_batch.call_count == 2
+    
+    def test_failed_part_reported_and_not_cached(self, process_manager, session):
+        """A tool that fails is listed in errors and the summary is gathered again next time"""
+        def forward_batch(port, requests, timeout=None, ida_session=None):
+            return [
+                _response("no strings", error=True) if r["params"]["name"] == "strings"
+                else _response(CHILD_RESULTS[r["params"]["name"]])
+                for r in requests
+            ]
+        process_manager.forward_batch.side_effect = forward_batch
+        summarizer = BinarySummarizer(process_manager)
+        
+        summary = summarizer.build(session)
+        summarizer.build(session)
+        
+        assert set(summary["errors"]) == {"strings"}
+        assert summary["function_count"] == 3
+        assert process_manager.forward_batch.call_count == 2
@@ -0,0 +1,244 @@
+"""Tests for idle-time cache warming"""
+
+import json
+import threading
+import time
+import pytest
+from pathlib import Path
+from unittest.mock import Mock
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.func_index import EXPORT, FUNCTION, IMPORT, BinaryIndex, FunctionIndex, SymbolTable
+from ida_pro_proxy_mcp.models import ProxySession
+from ida_pro_proxy_mcp.process_manager import ProcessManager
+from ida_pro_proxy_mcp.result_cache import ResultCache
+from ida_pro_proxy_mcp.session_manager import SessionManager
+from ida_pro_proxy_mcp.warmer import CacheWarmer
+
+
+def _response(data):
+    return {"jsonrpc": "2.0", "id": 1, "result": {"content": [{"type": "text", "text": json.dumps(data)}]}}
+
+
+# Callees and callers of the functions in the index fixture
+CALL_GRAPH = {
+    0x1000: ([{"addr": "0x1100", "type": "internal"}, {"addr": "0x3000", "type": "external"}], [{"addr": "0x1700"}]),
+    0x1200: ([], []),
+}
+
+
+def _call_graph_batch(port, requests, timeout=None, cancel_token=None, ida_session=None):
+    responses = []
+    for request in requests:
+        name = request["params"]["name"]
+        addr = int(request["params"]["arguments"]["addrs"], 16)
+        callees, callers = CALL_GRAPH.get(addr, ([], []))
+        responses.append(_response([{"addr": hex(addr), name: callees if name == "callees" else callers}]))
+    return responses
+
+
+def _wait_for(condition):
+    deadline = time.monotonic() + 5
+    while not condition() and time.monotonic() < deadline:
+        time.sleep(0.02)
+    return condition()
+
+
+@pytest.fixture
+def session():
+    """Current session whose binary has been indexed"""
+    session = ProxySession.create("/samples/app.elf", 8745, "abcd")
+    session.content_hash = "hash-1"
+    return session
+
+
+@pytest.fixture
+def index():
+    """Function index with an entry point, a caller of gets and two other functions"""
+    index = Mock(spec=FunctionIndex)
+    index.get.return_value = BinaryIndex(
+        content_hash="hash-1",
+        binary_path="/samples/app.elf",
+        session_id="app.elf-abcd",
+        generation=0,
+        tables={
+            FUNCTION: SymbolTable([
+                ("main", 0x1000, 0x40, ""),
+                ("read_line", 0x1100, 0x20, ""),
+                ("big", 0x1200, 0x400, ""),
+                ("small", 0x1700, 0x10, ""),
+            ]),
+            EXPORT: SymbolTable([("main", 0x1000, 0x40, "")]),
+            IMPORT: SymbolTable([("gets", 0x3000, 0, "libc.so.6"), ("puts", 0x3008, 0, "libc.so.6")]),
+        },
+        built_at=1.0,
+    )
+    return index
+
+
+@pytest.fixture
+def session_manager():
+    """Session manager with an idle process"""
+    manager = Mock(spec=SessionManager)
+    manager.process_manager = Mock(spec=ProcessManager)
+    manager.process_manager.queue_depth.return_value = 0
+    manager.process_manager.is_draining.return_value = False
+    manager.get_current_session.return_value = None
+    manager.process_manager.forward_batch.side_effect = _call_graph_batch
+    return manager
+
+
+@pytest.fixture
+def warmer(session_manager, index):
+    """Create a warmer that starts as soon as the process is idle"""
+    warmer = CacheWarmer(session_manager, ResultCache(), index)
+    warmer.IDLE_DELAY = 0
+    yield warmer
+    warmer.close()
+
+
+class TestCacheWarmer:
+    """Tests for warming the result cache"""
+    
+    def test_plan_order(self, warmer, session_manager, session):
+        """Entry points go first, then callers of dangerous imports, then by size"""
+        session_manager.process_manager.forward_request.return_value = _response(
+            [{"addr": "0x3000", "xrefs": [{"addr": "0x1110", "type": "code"}]}]
+        )
+        
+        plan = warmer._build_plan(session, warmer.index.get("hash-1"))
+        
+        assert plan == [0x1000, 0x1100, 0x1200, 0x1700]
+        request = session_manager.process_manager.forward_request.call_args.args[1]
+        assert request["params"]["arguments"] == {"addrs": ["0x3000"]}
+    
+    def test_idle_process_warms_cache(self, warmer, session_manager, session):
+        """While the current session's process is idle, its functions are decompiled into the cache"""
+        def forward_request(port, request, timeout=None, cancel_token=None, deadline=None, ida_session=None):
+            if request["params"]["name"] == "xrefs_to":
+                return _response([])
+            return _response({"code": f"// {request['params']['arguments']['addr']}"})
+        session_manager.process_manager.forward_request.side_effect = forward_request
+        session_manager.get_current_session.return_value = session
+        
+        deadline = time.monotonic() + 5
+        while warmer.warmed < 4 and time.monotonic() < deadline:
+            time.sleep(0.05)
+        
+        assert warmer.warmed == 4
+        cached = warmer.result_cache.get(session.session_id, 0, "decompile", {"addr": "0x1200"})
+        assert "0x1200" in cached["content"][0]["text"]
+    
+    def test_real_call_preempts_warming(self, warmer, session_manager, session):
+        """A call queueing behind a warming call cancels it"""
+        def forward_request(port, request, timeout=None, cancel_token=None, deadline=None, ida_session=None):
+            while not cancel_token.cancelled:
+                time.sleep(0.01)
+            raise RuntimeError("cancelled")
+        session_manager.process_manager.forward_request.side_effect = forward_request
+        session_manager.process_manager.queue_depth.return_value = 2
+        
+        started = time.monotonic()
+        assert warmer._warm(session, 0x1000, "warm") == "preempted"
+        
+        assert time.monotonic() - started < 1
+        assert warmer.preempted == 1
+        assert warmer.result_cache.get(session.session_id, 0, "decompile", {"addr": "0x1000"}) is None
+    
+    def test_real_call_preempts_planning(self, warmer, session_manager, session):
+        """A call queueing behind the lookup of dangerous imports' callers cancels it and the plan"""
+        def forward_request(port, request, timeout=None, cancel_token=None, deadline=None, ida_session=None):
+            while not cancel_token.cancelled:
+                time.sleep(0.01)
+            raise RuntimeError("cancelled")
+        session_manager.process_manager.forward_request.side_effect = forward_request
+        session_manager.process_manager.queue_depth.return_value = 2
+        
+        started = time.monotonic()
+        assert warmer._build_plan(session, warmer.index.get("hash-1")) is None
+        
+        assert time.monotonic() - started < 1
+        assert warmer.preempted == 1
+
+
+class TestPrefetch:
+    """Tests for prefetching the neighbours of decompiled functions"""
+    
+    @pytest.fixture
+    def prefetcher(self, session_manager, index, session):
+        """Create a warmer that only prefetches"""
+        session_manager.get_session.return_value = session
+        warmer = CacheWarmer(session_manager, ResultCache(), index, limit=0, prefetch_depth=1)
+        yield warmer
+        warmer.close()
+    
+    def test_callees_then_callers_prefetched(self, prefetcher, session_manager, session):
+        """A decompile by name prefetches the internal callees, then the callers, one call away"""
+        decompiled = []
+        def forward_request(port, request, timeout=None, cancel_token=None, deadline=None, ida_session=None):
+            decompiled.append(request["params"]["arguments"]["addr"])
+            return _response({"code": "..."})
+        session_manager.process_manager.forward_request.side_effect = forward_request
+        
+        prefetcher.served(session, "decompile", {"addr": "main"}, cached=False)
+        
+        assert _wait_for(lambda: prefetcher.prefetched == 2)
+        assert decompiled == ["0x1100", "0x1700"]
+        # The neighbours themselves are a second call away
+        session_manager.process_manager.forward_batch.assert_called_once()
+        assert prefetcher.result_cache.get(session.session_id, 0, "decompile", {"addr": "0x1700"}) is not None
+    
+    def test_hits_and_waste_counted(self, prefetcher, session_manager, session):
+        """A prefetched result read by an agent is a hit; one that goes stale unread is waste"""
+        session_manager.process_manager.forward_request.return_value = _response({"code": "..."})
+        prefetcher.served(session, "decompile", {"addr": "0x1000"}, cached=False)
+        assert _wait_for(lambda: prefetcher.prefetched == 2)
+        
+        prefetcher.served(session, "decompile", {"addr": "0x1100"}, cached=True)
+        session.generation = 1
+        prefetcher._sweep()
+        
+        stats = prefetcher.to_dict()
+        assert stats["prefetch_hits"] == 1
+        assert stats["prefetch_wasted"] == 1
+    
+    def test_next_decompile_replaces_queued_prefetches(self, prefetcher, session_manager, session):
+        """Prefetches still queued when the agent moves on are cancelled"""
+        release = threading.Event()
+        decompiled = []
+        def forward_request(port, request, timeout=None, cancel_token=None, deadline=None, ida_session=None):
+            decompiled.append(request["params"]["arguments"]["addr"])
+            release.wait(5)
+            return _response({"code": "..."})
+        session_manager.process_manager.forward_request.side_effect = forward_request
+        
+        prefetcher.served(session, "decompile", {"addr": "0x1000"}, cached=False)
+        assert _wait_for(lambda: decompiled == ["0x1100"])
+        prefetcher.served(session, "decompile", {"addr": "0x1200"}, cached=False)
+        release.set()
+        
+        assert _wait_for(lambda: session_manager.process_manager.forward_batch.call_count == 2)
+        assert _wait_for(lambda: prefetcher.to_dict()["prefetch_queued"] == 0)
+        assert decompiled == ["0x1100"]
+        assert prefetcher.prefetch_cancelled == 1
+    
+    def test_real_call_preempts_call_graph_lookup(self, prefetcher, session_manager, session):
+        """A call queueing behind a call-graph lookup cancels it; the prefetch stays queued"""
+        def forward_batch(port, requests, timeout=None, cancel_token=None, ida_session=None):
+            while not cancel_token.cancelled:
+                time.sleep(0.01)
+            raise RuntimeError("cancelled")
+        session_manager.process_manager.forward_batch.side_effect = forward_batch
+        session_manager.process_manager.queue_depth.return_value = 3
+        
+        started = time.monotonic()
+        assert prefetcher._neighbours(session, 0x1000) is None
+        
+        assert time.monotonic() - started < 1
+        assert prefetcher.preempted == 1
+        # Learned again once the process is idle
+        session_manager.process_manager.forward_batch.side_effect = _call_graph_batch
+        session_manager.process_manager.queue_depth.return_value = 0
+        assert prefetcher._neighbours(session, 0x1000) == [0x1100, 0x1700]
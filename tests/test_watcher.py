@@ -0,0 +1,75 @@
+"""Tests for FileWatcher"""
+
+import os
+import pytest
+import threading
+from pathlib import Path
+
+import sys
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+from ida_pro_proxy_mcp.watcher import FileWatcher
+
+
+@pytest.fixture
+def watcher():
+    """Create a FileWatcher, skipping where inotify is unavailable"""
+    watcher = FileWatcher()
+    if not watcher.available:
+        pytest.skip("inotify not available")
+    yield watcher
+    watcher.close()
+
+
+def _recorder():
+    changed = []
+    event = threading.Event()
+    
+    def callback(path):
+        changed.append(path)
+        event.set()
+    return changed, event, callback
+
+
+class TestFileWatcher:
+    """Tests for watching files with inotify"""
+    
+    def test_write_reported(self, watcher, tmp_path):
+        """Rewriting a watched file calls its callback"""
+        path = tmp_path / "firmware.bin"
+        path.write_bytes(b"v1")
+        changed, event, callback = _recorder()
+        watcher.watch(str(path), callback)
+        
+        path.write_bytes(b"v2")
+        
+        assert event.wait(timeout=5)
+        assert changed[0] == str(path)
+    
+    def test_replace_by_rename_reported(self, watcher, tmp_path):
+        """A file replaced by rename is still followed"""
+        path = tmp_path / "firmware.bin"
+        path.write_bytes(b"v1")
+        changed, event, callback = _recorder()
+        watcher.watch(str(path), callback)
+        
+        tmp = tmp_path / "firmware.tmp"
+        tmp.write_bytes(b"v2")
+        os.replace(tmp, path)
+        
+        assert event.wait(timeout=5)
+        assert str(path) in changed
+    
+    def test_unwatched_and_other_files_ignored(self, watcher, tmp_path):
+        """Files not watched, or no longer watched, don't call back"""
+        path = tmp_path / "firmware.bin"
+        other = tmp_path / "notes.txt"
+        path.write_bytes(b"v1")
+        changed, event, callback = _recorder()
+        watcher.watch(str(path), callback)
+        watcher.unwatch(str(path))
+        
+        path.write_bytes(b"v2")
+        other.write_text("x")
+        
+        assert not event.wait(timeout=0.5)